@@ -0,0 +1,374 @@
+/**
+ * shared driver of the benchmarks in this directory.
+ *
+ * every workload file defines one struct with a name and a static
+ *   template<class Map, class Row> size_t run(Map& m, size_t n, timer& t)
+ *   that prepares m, brackets the measured part with t.start() / t.stop()
+ *   and returns the number of operations done in between.
+ * main<Workload>() runs it for every element type, size and container,
+ *   each case in a child process so that one case's heap never shows up in the
+ *   peak RSS of the next, and prints the containers of a case side by side.
+ */
+#ifndef SJTU_BENCH_HPP
+#define SJTU_BENCH_HPP
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <new>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#define SJTU_BENCH_FORK
+#endif
+#if defined(__GNUC__) || defined(__clang__)
+#define SJTU_BENCH_NOINLINE __attribute__((noinline))
+#else
+#define SJTU_BENCH_NOINLINE
+#endif
+
+#include "map.hpp"
+#include "btree_map.hpp"
+#include "flat_map.hpp"
+#include "linked_hashmap.hpp"
+#include "class-bint.hpp"
+#include "class-matrix.hpp"
+
+namespace bench {
+
+	/**
+	 * counters kept by the replaced global operator new / delete below.
+	 * each block carries its size in a header, so live bytes are exact.
+	 */
+	struct alloc_counters {
+		unsigned long long allocs = 0;
+		unsigned long long bytes = 0;
+		long long live = 0;
+	};
+	inline alloc_counters& counters() {
+		static alloc_counters c;
+		return c;
+	}
+	//块前面的头 记下大小 按16对齐 后面交出去的对象也就按16对齐
+	struct alignas(16) block_header {
+		size_t size;
+	};
+	//malloc和free只在这两个不内联的函数里 operator delete内联进调用处以后
+	//编译器也看不到free的是operator new拿到的块 不会报new和delete不配对
+	SJTU_BENCH_NOINLINE inline block_header* raw_allocate(size_t size) noexcept {
+		block_header* h = static_cast<block_header*>(std::malloc(sizeof(block_header) + size));
+		if (h) h->size = size;
+		return h;
+	}
+	SJTU_BENCH_NOINLINE inline void raw_free(block_header* h) noexcept {
+		std::free(h);
+	}
+	//失败时返回nullptr
+	inline void* counted_allocate(size_t size) noexcept {
+		block_header* h = raw_allocate(size);
+		if (!h) return nullptr;
+		alloc_counters& c = counters();
+		c.allocs++;
+		c.bytes += size;
+		c.live += (long long)size;
+		return h + 1;
+	}
+
+	class timer {
+	private:
+		std::chrono::steady_clock::time_point begin;
+		alloc_counters at_start;
+	public:
+		double seconds = 0;
+		unsigned long long allocs = 0, bytes = 0;
+
+		void start() {
+			at_start = counters();
+			begin = std::chrono::steady_clock::now();
+		}
+		void stop() {
+			seconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+			allocs += counters().allocs - at_start.allocs;
+			bytes += counters().bytes - at_start.bytes;
+		}
+	};
+
+	/**
+	 * the element types. key(i) is strictly increasing in i, so workloads can
+	 *   make sequential or shuffled key sequences from indices.
+	 * max_n caps the size for heavy values: a Bint holds 8 KB however small it is.
+	 */
+	struct int_row {
+		typedef int key_type;
+		typedef int mapped_type;
+		static constexpr const char* name = "int";
+		static constexpr size_t max_n = 10000000;
+		static key_type key(size_t i) { return (int)i; }
+		static mapped_type value(size_t i) { return (int)i; }
+	};
+	struct string_row {
+		typedef std::string key_type;
+		typedef std::string mapped_type;
+		static constexpr const char* name = "string";
+		static constexpr size_t max_n = 1000000;
+		//补零到固定长度 字典序和数值序一致 也超出了短字符串优化的长度
+		static key_type key(size_t i) {
+			char buf[32];
+			std::snprintf(buf, sizeof(buf), "bench-key-%012zu", i);
+			return buf;
+		}
+		static mapped_type value(size_t i) { return key(i); }
+	};
+	struct bint_row {
+		typedef int key_type;
+		typedef Util::Bint mapped_type;
+		static constexpr const char* name = "Bint";
+		static constexpr size_t max_n = 10000;
+		static key_type key(size_t i) { return (int)i; }
+		static mapped_type value(size_t i) { return Util::Bint((long long)i * 1000003); }
+	};
+	struct matrix_row {
+		typedef int key_type;
+		typedef Diamond::Matrix<int> mapped_type;
+		static constexpr const char* name = "Matrix";
+		static constexpr size_t max_n = 1000000;
+		static key_type key(size_t i) { return (int)i; }
+		static mapped_type value(size_t i) { return mapped_type(4, 4, (int)i); }
+	};
+
+	//0..n-1打乱 种子固定 每个容器看到同样的顺序
+	inline std::vector<size_t> shuffled(size_t n, unsigned seed = 20230501) {
+		std::vector<size_t> v(n);
+		for (size_t i = 0; i < n; i++) v[i] = i;
+		std::shuffle(v.begin(), v.end(), std::mt19937_64(seed));
+		return v;
+	}
+
+	//所有容器都有try_emplace find erase(iterator) 只有取key的写法要统一
+	template<class Map, class K, class V>
+	void put(Map& m, const K& key, const V& value) {
+		m.try_emplace(key, value);
+	}
+	template<class Map, class K>
+	bool erase_key(Map& m, const K& key) {
+		auto it = m.find(key);
+		if (it == m.end()) return false;
+		m.erase(it);
+		return true;
+	}
+	template<class Row, class Map>
+	void fill(Map& m, size_t n) {
+		std::vector<size_t> order = shuffled(n);
+		for (size_t i : order) put(m, Row::key(i * 2), Row::value(i));
+	}
+
+	//flat_map逐个插入每次要挪O(n)个元素 整体从区间构造 和它的用法一致
+	template<class Row, class K, class V>
+	void fill(sjtu::flat_map<K, V>& m, size_t n) {
+		std::vector<size_t> order = shuffled(n);
+		std::vector<sjtu::pair<K, V>> v;
+		v.reserve(n);
+		for (size_t i : order) v.push_back(sjtu::pair<K, V>(Row::key(i * 2), Row::value(i)));
+		m = sjtu::flat_map<K, V>(v.begin(), v.end());
+	}
+	//在随机位置逐个插入的workload把flat_map_max设小 更大的n不跑flat_map
+	template<class Workload, class = void>
+	struct flat_map_limit {
+		static constexpr size_t value = (size_t)-1;
+	};
+	template<class Workload>
+	struct flat_map_limit<Workload, decltype((void)Workload::flat_map_max)> {
+		static constexpr size_t value = Workload::flat_map_max;
+	};
+
+	struct result {
+		double ns_per_op;
+		double allocs_per_op;
+		double bytes_per_op;
+		double live_mb;//结束时容器还占着的堆
+		double peak_rss_mb;
+		bool ok;
+	};
+
+	inline double peak_rss_mb() {
+#ifdef SJTU_BENCH_FORK
+		struct rusage u;
+		getrusage(RUSAGE_SELF, &u);
+#ifdef __APPLE__
+		return u.ru_maxrss / 1048576.0;
+#else
+		return u.ru_maxrss / 1024.0;
+#endif
+#else
+		return 0;
+#endif
+	}
+
+	template<class Workload, class Row, class Map>
+	result measure(size_t n) {
+		timer t;
+		long long live_before = counters().live;
+		Map* m = new Map();
+		size_t ops = Workload::template run<Map, Row>(*m, n, t);
+		result r;
+		if (!ops) ops = 1;
+		r.ns_per_op = t.seconds * 1e9 / ops;
+		r.allocs_per_op = (double)t.allocs / ops;
+		r.bytes_per_op = (double)t.bytes / ops;
+		r.live_mb = (counters().live - live_before) / 1048576.0;
+		r.peak_rss_mb = peak_rss_mb();
+		r.ok = true;
+		delete m;
+		return r;
+	}
+
+	//子进程里跑一个case 结果从管道传回来 没有fork就直接在本进程里跑
+	template<class Workload, class Row, class Map>
+	result isolated(size_t n) {
+#ifdef SJTU_BENCH_FORK
+		int fd[2];
+		if (pipe(fd) == 0) {
+			std::fflush(stdout);
+			pid_t pid = fork();
+			if (pid == 0) {
+				close(fd[0]);
+				result r = measure<Workload, Row, Map>(n);
+				ssize_t w = write(fd[1], &r, sizeof(r));
+				_exit(w == (ssize_t)sizeof(r) ? 0 : 1);
+			}
+			close(fd[1]);
+			result r;
+			bool got = pid > 0 && read(fd[0], &r, sizeof(r)) == (ssize_t)sizeof(r);
+			close(fd[0]);
+			if (pid > 0) waitpid(pid, nullptr, 0);
+			if (!got) {
+				std::memset(&r, 0, sizeof(r));
+				r.ok = false;
+			}
+			return r;
+		}
+#endif
+		return measure<Workload, Row, Map>(n);
+	}
+
+	inline void print_header(const char* workload) {
+		std::printf("%-18s %-7s %9s  %-22s %10s %8s %10s %9s %9s\n", workload, "type", "n", "container",
+			"ns/op", "allocs", "bytes/op", "live MB", "peak MB");
+	}
+	inline void print_row(const char* workload, const char* type, size_t n, const char* container, const result& r, double base_ns) {
+		if (!r.ok) {
+			std::printf("%-18s %-7s %9zu  %-22s %10s\n", workload, type, n, container, "failed");
+			return;
+		}
+		std::printf("%-18s %-7s %9zu  %-22s %10.1f %8.2f %10.1f %9.1f %9.1f", workload, type, n, container,
+			r.ns_per_op, r.allocs_per_op, r.bytes_per_op, r.live_mb, r.peak_rss_mb);
+		if (base_ns > 0) std::printf("  x%.2f", r.ns_per_op / base_ns);
+		std::printf("\n");
+	}
+
+	struct options {
+		std::vector<size_t> sizes{1000, 10000, 100000, 1000000, 10000000};
+		size_t max_n = 0;//0表示用每种类型自己的上限
+		std::string types = "int,string,Bint,Matrix";
+	};
+	inline options parse(int argc, char** argv) {
+		options o;
+		for (int i = 1; i < argc; i++) {
+			if (!std::strcmp(argv[i], "--max") && i + 1 < argc) o.max_n = std::strtoull(argv[++i], nullptr, 10);
+			else if (!std::strcmp(argv[i], "--types") && i + 1 < argc) o.types = argv[++i];
+			else if (!std::strcmp(argv[i], "--sizes") && i + 1 < argc) {
+				o.sizes.clear();
+				for (char* p = argv[++i]; *p;) {
+					o.sizes.push_back(std::strtoull(p, &p, 10));
+					if (*p == ',') p++;
+					else break;
+				}
+			}
+			else {
+				std::fprintf(stderr, "usage: %s [--sizes 1000,100000] [--types int,string,Bint,Matrix] [--max N]\n", argv[0]);
+				std::exit(2);
+			}
+		}
+		return o;
+	}
+
+	//ordered的两组和hash的两组分开比 x后面是相对第一个std容器的倍数
+	template<class Workload, class Row>
+	void run_row(const options& o) {
+		typedef typename Row::key_type K;
+		typedef typename Row::mapped_type V;
+		if (("," + o.types + ",").find(std::string(",") + Row::name + ",") == std::string::npos) return;
+		for (size_t n : o.sizes) {
+			if (n > (o.max_n ? o.max_n : Row::max_n)) continue;
+			result base = isolated<Workload, Row, std::map<K, V>>(n);
+			print_row(Workload::name, Row::name, n, "std::map", base, 0);
+			print_row(Workload::name, Row::name, n, "sjtu::map", isolated<Workload, Row, sjtu::map<K, V>>(n), base.ns_per_op);
+			print_row(Workload::name, Row::name, n, "sjtu::btree_map", isolated<Workload, Row, sjtu::btree_map<K, V>>(n), base.ns_per_op);
+			if (n <= flat_map_limit<Workload>::value)
+				print_row(Workload::name, Row::name, n, "sjtu::flat_map", isolated<Workload, Row, sjtu::flat_map<K, V>>(n), base.ns_per_op);
+			base = isolated<Workload, Row, std::unordered_map<K, V>>(n);
+			print_row(Workload::name, Row::name, n, "std::unordered_map", base, 0);
+			print_row(Workload::name, Row::name, n, "sjtu::linked_hashmap", isolated<Workload, Row, sjtu::linked_hashmap<K, V>>(n), base.ns_per_op);
+		}
+	}
+
+	template<class Workload>
+	int main(int argc, char** argv) {
+		options o = parse(argc, argv);
+		print_header(Workload::name);
+		run_row<Workload, int_row>(o);
+		run_row<Workload, string_row>(o);
+		run_row<Workload, bint_row>(o);
+		run_row<Workload, matrix_row>(o);
+		return 0;
+	}
+
+}
+
+//每个benchmark是单独一个翻译单元的程序 所以可以在头文件里替换全局的new和delete
+//nothrow版本也要换 std::stable_sort的临时缓冲区是用它拿的 却由这里的delete释放
+void* operator new(size_t size) {
+	void* p = bench::counted_allocate(size);
+	if (!p) throw std::bad_alloc();
+	return p;
+}
+void* operator new(size_t size, const std::nothrow_t&) noexcept {
+	return bench::counted_allocate(size);
+}
+void operator delete(void* p) noexcept {
+	if (!p) return;
+	bench::block_header* h = static_cast<bench::block_header*>(p) - 1;
+	bench::counters().live -= (long long)h->size;
+	bench::raw_free(h);
+}
+void operator delete(void* p, const std::nothrow_t&) noexcept {
+	operator delete(p);
+}
+void* operator new[](size_t size) {
+	return operator new(size);
+}
+void operator delete[](void* p) noexcept {
+	operator delete(p);
+}
+void* operator new[](size_t size, const std::nothrow_t&) noexcept {
+	return bench::counted_allocate(size);
+}
+void operator delete[](void* p, const std::nothrow_t&) noexcept {
+	operator delete(p);
+}
+void operator delete(void* p, size_t) noexcept {
+	operator delete(p);
+}
+void operator delete[](void* p, size_t) noexcept {
+	operator delete(p);
+}
+
+#endif
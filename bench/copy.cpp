@@ -0,0 +1,23 @@
+/**
+ * copy construction of a container holding n elements; ns/op is per element.
+ */
+#include "bench.hpp"
+
+struct copy {
+	static constexpr const char* name = "copy";
+
+	template<class Map, class Row>
+	static size_t run(Map& m, size_t n, bench::timer& t) {
+		bench::fill<Row>(m, n);
+		t.start();
+		Map* c = new Map(m);
+		t.stop();
+		size_t len = c->size();
+		delete c;
+		return len;
+	}
+};
+
+int main(int argc, char** argv) {
+	return bench::main<copy>(argc, argv);
+}
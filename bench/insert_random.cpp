@@ -0,0 +1,31 @@
+/**
+ * n insertions of distinct keys in random order into an empty container.
+ */
+#include "bench.hpp"
+
+struct insert_random {
+	static constexpr const char* name = "insert_random";
+	//flat_map每次插入删除都挪动后面的元素 n再大就是平方级了
+	static constexpr size_t flat_map_max = 100000;
+
+	template<class Map, class Row>
+	static size_t run(Map& m, size_t n, bench::timer& t) {
+		std::vector<size_t> order = bench::shuffled(n);
+		std::vector<typename Row::key_type> keys;
+		std::vector<typename Row::mapped_type> values;
+		keys.reserve(n);
+		values.reserve(n);
+		for (size_t i : order) {
+			keys.push_back(Row::key(i));
+			values.push_back(Row::value(i));
+		}
+		t.start();
+		for (size_t i = 0; i < n; i++) bench::put(m, keys[i], values[i]);
+		t.stop();
+		return n;
+	}
+};
+
+int main(int argc, char** argv) {
+	return bench::main<insert_random>(argc, argv);
+}
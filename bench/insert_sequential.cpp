@@ -0,0 +1,28 @@
+/**
+ * n insertions of distinct keys in ascending order into an empty container.
+ */
+#include "bench.hpp"
+
+struct insert_sequential {
+	static constexpr const char* name = "insert_sequential";
+
+	template<class Map, class Row>
+	static size_t run(Map& m, size_t n, bench::timer& t) {
+		std::vector<typename Row::key_type> keys;
+		std::vector<typename Row::mapped_type> values;
+		keys.reserve(n);
+		values.reserve(n);
+		for (size_t i = 0; i < n; i++) {
+			keys.push_back(Row::key(i));
+			values.push_back(Row::value(i));
+		}
+		t.start();
+		for (size_t i = 0; i < n; i++) bench::put(m, keys[i], values[i]);
+		t.stop();
+		return n;
+	}
+};
+
+int main(int argc, char** argv) {
+	return bench::main<insert_sequential>(argc, argv);
+}
@@ -0,0 +1,29 @@
+/**
+ * full traversals of a container holding n elements, at least 10M elements visited in total.
+ */
+#include "bench.hpp"
+
+struct iterate {
+	static constexpr const char* name = "iterate";
+
+	template<class K>
+	static size_t weight(const K& k) { return (size_t)k; }
+	static size_t weight(const std::string& k) { return k.size(); }
+
+	template<class Map, class Row>
+	static size_t run(Map& m, size_t n, bench::timer& t) {
+		bench::fill<Row>(m, n);
+		size_t passes = n >= 10000000 ? 1 : 10000000 / n;
+		size_t sum = 0;
+		t.start();
+		for (size_t p = 0; p < passes; p++)
+			for (auto it = m.begin(); it != m.end(); ++it) sum += weight(it->first);
+		t.stop();
+		//sum参与返回值 循环不会被优化掉
+		return sum == (size_t)-1 ? 0 : passes * n;
+	}
+};
+
+int main(int argc, char** argv) {
+	return bench::main<iterate>(argc, argv);
+}
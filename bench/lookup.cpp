@@ -0,0 +1,26 @@
+/**
+ * n random lookups in a container holding n elements, built before the timer starts.
+ *   half of the keys are present. the read-mostly case flat_map is made for.
+ */
+#include "bench.hpp"
+
+struct lookup {
+	static constexpr const char* name = "lookup";
+	template<class Map, class Row>
+	static size_t run(Map& m, size_t n, bench::timer& t) {
+		bench::fill<Row>(m, n);
+		std::mt19937_64 rng(11);
+		std::vector<typename Row::key_type> keys;
+		keys.reserve(n);
+		for (size_t i = 0; i < n; i++) keys.push_back(Row::key(rng() % (2 * n)));
+		size_t found = 0;
+		t.start();
+		for (size_t i = 0; i < n; i++) found += m.find(keys[i]) != m.end();
+		t.stop();
+		return found == (size_t)-1 ? 0 : n;
+	}
+};
+
+int main(int argc, char** argv) {
+	return bench::main<lookup>(argc, argv);
+}
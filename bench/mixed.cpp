@@ -0,0 +1,39 @@
+/**
+ * n random operations on a container holding n elements:
+ *   half lookups (hits and misses alike), a quarter erasures, a quarter insertions.
+ */
+#include "bench.hpp"
+
+struct mixed {
+	static constexpr const char* name = "mixed";
+	//flat_map每次插入删除都挪动后面的元素 n再大就是平方级了
+	static constexpr size_t flat_map_max = 100000;
+
+	template<class Map, class Row>
+	static size_t run(Map& m, size_t n, bench::timer& t) {
+		//fill放的是偶数下标 奇数下标一定找不到
+		bench::fill<Row>(m, n);
+		std::mt19937_64 rng(7);
+		std::vector<unsigned char> op(n);
+		std::vector<typename Row::key_type> keys;
+		keys.reserve(n);
+		for (size_t i = 0; i < n; i++) {
+			op[i] = (unsigned char)(rng() & 3);
+			keys.push_back(Row::key(rng() % (2 * n)));
+		}
+		typename Row::mapped_type value = Row::value(1);
+		size_t found = 0;
+		t.start();
+		for (size_t i = 0; i < n; i++) {
+			if (op[i] < 2) found += m.find(keys[i]) != m.end();
+			else if (op[i] == 2) found += bench::erase_key(m, keys[i]);
+			else bench::put(m, keys[i], value);
+		}
+		t.stop();
+		return found == (size_t)-1 ? 0 : n;
+	}
+};
+
+int main(int argc, char** argv) {
+	return bench::main<mixed>(argc, argv);
+}
@@ -0,0 +1,298 @@
+/**
+ * a thread-safe linked_hashmap, split into independently locked shards
+ */
+#ifndef SJTU_CONCURRENT_LINKEDHASHMAP_HPP
+#define SJTU_CONCURRENT_LINKEDHASHMAP_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <shared_mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+#include "linked_hashmap.hpp"
+
+namespace sjtu {
+	/**
+	 * a hash map that many threads may use at once, keeping the global insertion order.
+	 *
+	 * the keys are spread over a power-of-two number of shards, each a linked_hashmap
+	 *   behind its own reader-writer lock: lookups take the shard's lock shared, updates
+	 *   take it exclusively, and operations on different shards never wait for each other.
+	 * appending to the insertion order costs one atomic increment: every element remembers
+	 *   its sequence number, and iteration merges the shards by it.
+	 *
+	 * nothing hands out references or iterators into the map, since another thread could
+	 *   erase the element at any time. values are copied out (at), or accessed through
+	 *   a callback that runs while the shard is locked (find, update).
+	 *   callbacks must not call back into the same map.
+	 *
+	 * iteration (for_each, snapshot) is snapshot consistent: it read-locks every shard
+	 *   first, so it sees exactly the elements present at one moment, in insertion order,
+	 *   while writers wait until it is done. snapshot() copies them into a plain
+	 *   linked_hashmap to keep the locks short when the work per element is long.
+	 */
+	template<
+		class Key,
+		class T,
+		class Hash = std::hash<Key>,
+		class Equal = std::equal_to<Key>,
+		class Storage = chained_storage,
+		class Allocator = std::allocator<pair<const Key, T>>
+	> class concurrent_linked_hashmap {
+	public:
+		typedef pair<const Key, T> value_type;
+		typedef linked_hashmap<Key, T, Hash, Equal, Storage, Allocator> snapshot_type;
+	private:
+		//每个元素记下自己是第几个插入的 遍历时按它把各个分片归并起来
+		struct slot {
+			unsigned long long seq;
+			T value;
+
+			template<class... Args>
+			slot(unsigned long long s, Args&&... args) : seq(s), value(std::forward<Args>(args)...) {}
+		};
+		typedef typename std::allocator_traits<Allocator>::template rebind_alloc<pair<const Key, slot>> slot_allocator;
+		typedef linked_hashmap<Key, slot, Hash, Equal, Storage, slot_allocator> shard_map;
+		//各占一条缓存行 相邻分片的锁不会互相干扰
+		struct alignas(64) shard {
+			mutable std::shared_mutex lock;
+			shard_map map;
+		};
+
+		shard* shards;
+		size_t mask;
+		int shift;//分片号取打散后hash的最高几位 和分片内部用的低位错开
+		std::atomic<unsigned long long> next_seq;
+		std::atomic<size_t> len;
+
+		static size_t default_shards() {
+			size_t n = std::thread::hardware_concurrency() * 4;
+			return n ? n : 16;
+		}
+		shard& shard_of(const Key& key) const {
+			unsigned long long h = (unsigned long long)Hash()(key) * 0x9E3779B97F4A7C15ull;
+			return shards[shift < 64 ? (size_t)(h >> shift) : 0];
+		}
+		//按分片下标从小到大依次加锁 几个线程同时锁全部分片也不会死锁
+		void lock_all_shared() const {
+			for (size_t i = 0; i <= mask; i++) shards[i].lock.lock_shared();
+		}
+		void unlock_all_shared() const {
+			for (size_t i = 0; i <= mask; i++) shards[i].lock.unlock_shared();
+		}
+		template<class Fn>
+		void merge_shards(Fn& fn) const {
+			typedef typename shard_map::const_iterator cursor;
+			typedef std::pair<unsigned long long, size_t> head;//(序号, 分片)
+			std::vector<cursor> cur;
+			cur.reserve(mask + 1);
+			std::priority_queue<head, std::vector<head>, std::greater<head>> heap;
+			for (size_t i = 0; i <= mask; i++) {
+				cur.push_back(shards[i].map.cbegin());
+				if (cur[i] != shards[i].map.cend()) heap.push(head(cur[i]->second.seq, i));
+			}
+			while (!heap.empty()) {
+				size_t i = heap.top().second;
+				heap.pop();
+				fn(cur[i]->first, static_cast<const T&>(cur[i]->second.value));
+				if (++cur[i] != shards[i].map.cend()) heap.push(head(cur[i]->second.seq, i));
+			}
+		}
+
+		template<class... Args>
+		bool emplace_in(shard& s, const Key& key, Args&&... args) {
+			std::unique_lock<std::shared_mutex> guard(s.lock);
+			//key已经在的话这个序号就空着不用 顺序只看大小 不要求连续
+			if (!s.map.try_emplace(key, next_seq.fetch_add(1, std::memory_order_relaxed), std::forward<Args>(args)...).second)
+				return false;
+			len.fetch_add(1, std::memory_order_relaxed);
+			return true;
+		}
+
+	public:
+		/**
+		 * shard_count is rounded up to a power of two;
+		 *   0 picks four shards per hardware thread.
+		 */
+		explicit concurrent_linked_hashmap(size_t shard_count = 0) : next_seq(0), len(0) {
+			if (shard_count == 0) shard_count = default_shards();
+			size_t n = 1;
+			int bits = 0;
+			while (n < shard_count) {
+				n <<= 1;
+				bits++;
+			}
+			shards = new shard[n];
+			mask = n - 1;
+			shift = 64 - bits;
+		}
+		concurrent_linked_hashmap(const concurrent_linked_hashmap&) = delete;
+		concurrent_linked_hashmap& operator=(const concurrent_linked_hashmap&) = delete;
+		~concurrent_linked_hashmap() {
+			delete[] shards;
+		}
+
+		/**
+		 * returns a copy of the mapped value of key.
+		 * throw index_out_of_bound if such key does not exist.
+		 */
+		T at(const Key& key) const {
+			shard& s = shard_of(key);
+			std::shared_lock<std::shared_mutex> guard(s.lock);
+			return s.map.at(key).value;
+		}
+		/**
+		 * the number of elements with key, 0 or 1.
+		 */
+		size_t count(const Key& key) const {
+			shard& s = shard_of(key);
+			std::shared_lock<std::shared_mutex> guard(s.lock);
+			return s.map.count(key);
+		}
+		/**
+		 * calls fn(const T&) on the mapped value of key while its shard is read-locked.
+		 * returns whether key was found.
+		 */
+		template<class Fn>
+		bool find(const Key& key, Fn fn) const {
+			shard& s = shard_of(key);
+			std::shared_lock<std::shared_mutex> guard(s.lock);
+			typename shard_map::const_iterator it = s.map.find(key);
+			if (it == s.map.cend()) return false;
+			fn(static_cast<const T&>(it->second.value));
+			return true;
+		}
+		/**
+		 * calls fn(T&) on the mapped value of key while its shard is write-locked,
+		 *   so read-modify-write updates are atomic. returns whether key was found.
+		 */
+		template<class Fn>
+		bool update(const Key& key, Fn fn) {
+			shard& s = shard_of(key);
+			std::unique_lock<std::shared_mutex> guard(s.lock);
+			typename shard_map::iterator it = s.map.find(key);
+			if (it == s.map.end()) return false;
+			fn(it->second.value);
+			return true;
+		}
+
+		/**
+		 * inserts value if its key is absent; returns whether it was inserted.
+		 * re-inserting a key does not change its place in the insertion order.
+		 */
+		bool insert(const value_type& value) {
+			return emplace_in(shard_of(value.first), value.first, value.second);
+		}
+		bool insert(value_type&& value) {
+			return emplace_in(shard_of(value.first), value.first, std::move(value.second));
+		}
+		/**
+		 * inserts (key, T(args...)) if key is absent; otherwise args are left untouched.
+		 */
+		template<class... Args>
+		bool try_emplace(const Key& key, Args&&... args) {
+			return emplace_in(shard_of(key), key, std::forward<Args>(args)...);
+		}
+		/**
+		 * assigns obj to the mapped value of key, inserting it if key is absent.
+		 * returns true if an insertion took place.
+		 */
+		template<class M>
+		bool insert_or_assign(const Key& key, M&& obj) {
+			shard& s = shard_of(key);
+			std::unique_lock<std::shared_mutex> guard(s.lock);
+			typename shard_map::iterator it = s.map.find(key);
+			if (it != s.map.end()) {
+				it->second.value = std::forward<M>(obj);
+				return false;
+			}
+			s.map.try_emplace(key, next_seq.fetch_add(1, std::memory_order_relaxed), std::forward<M>(obj));
+			len.fetch_add(1, std::memory_order_relaxed);
+			return true;
+		}
+		/**
+		 * removes key if present; returns the number of elements removed (0 or 1).
+		 */
+		size_t erase(const Key& key) {
+			shard& s = shard_of(key);
+			std::unique_lock<std::shared_mutex> guard(s.lock);
+			typename shard_map::iterator it = s.map.find(key);
+			if (it == s.map.end()) return 0;
+			s.map.erase(it);
+			len.fetch_sub(1, std::memory_order_relaxed);
+			return 1;
+		}
+		/**
+		 * removes every element; the shards are emptied one after another.
+		 */
+		void clear() {
+			for (size_t i = 0; i <= mask; i++) {
+				std::unique_lock<std::shared_mutex> guard(shards[i].lock);
+				len.fetch_sub(shards[i].map.size(), std::memory_order_relaxed);
+				shards[i].map.clear();
+			}
+		}
+
+		/**
+		 * the number of elements. with concurrent writers this is only a recent value.
+		 */
+		size_t size() const {
+			return len.load(std::memory_order_relaxed);
+		}
+		bool empty() const {
+			return size() == 0;
+		}
+		size_t shard_count() const {
+			return mask + 1;
+		}
+
+		/**
+		 * calls fn(const Key&, const T&) for every element in insertion order,
+		 *   on a consistent snapshot: all shards stay read-locked until fn has seen
+		 *   every element, so writers wait for the whole traversal.
+		 */
+		template<class Fn>
+		void for_each(Fn fn) const {
+			lock_all_shared();
+			try {
+				merge_shards(fn);
+			}
+			catch (...) {
+				unlock_all_shared();
+				throw;
+			}
+			unlock_all_shared();
+		}
+		/**
+		 * copies a consistent snapshot into a linked_hashmap, in insertion order.
+		 * the shards are only locked while copying; the result can be iterated
+		 *   and modified freely afterwards.
+		 */
+		snapshot_type snapshot() const {
+			snapshot_type result;
+			lock_all_shared();
+			try {
+				result.reserve(len.load(std::memory_order_relaxed));
+				auto copy = [&result](const Key& key, const T& value) {
+					result.try_emplace(key, value);
+				};
+				merge_shards(copy);
+			}
+			catch (...) {
+				unlock_all_shared();
+				throw;
+			}
+			unlock_all_shared();
+			return result;
+		}
+	};
+
+}
+
+#endif
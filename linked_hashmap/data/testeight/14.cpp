@@ -0,0 +1,69 @@
+#include "concurrent_linked_hashmap.hpp"
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+typedef sjtu::concurrent_linked_hashmap<int, std::string> cmap;
+
+int main() {
+	//	test: single-threaded behaviour and insertion order across shards
+	cmap map(8);
+	std::cout << map.shard_count() << " " << map.empty() << std::endl;
+	for (int i = 0; i < 1000; i++) map.insert(sjtu::pair<const int, std::string>(i * 7919 % 1000, std::to_string(i)));
+	std::cout << map.size() << " " << map.insert(sjtu::pair<const int, std::string>(0, "x")) << " " << map.at(0) << std::endl;
+	map.insert_or_assign(0, std::string("zero"));
+	map.update(1, [](std::string &v) { v += "!"; });
+	std::string seen;
+	std::cout << map.find(1, [&](const std::string &v) { seen = v; }) << " " << seen << " " << map.find(-1, [&](const std::string &) {}) << std::endl;
+	std::cout << map.erase(5) << " " << map.erase(5) << " " << map.count(5) << " " << map.size() << std::endl;
+	try {
+		map.at(5);
+	} catch (...) {
+		std::cout << "at throws" << std::endl;
+	}
+	int n = 0;
+	bool ordered = true;
+	map.for_each([&](const int &key, const std::string &value) {
+		if (n < 5) std::cout << key << ":" << value << " ";
+		if (key == 5) ordered = false;
+		n++;
+	});
+	std::cout << std::endl << n << " " << ordered << std::endl;
+	//	test: concurrent writers keep their own order, readers never see torn values
+	cmap shared;
+	const int THREADS = 8, PER = 20000;
+	std::vector<std::thread> pool;
+	for (int t = 0; t < THREADS; t++) {
+		pool.emplace_back([&shared, t]() {
+			for (int i = 0; i < PER; i++) {
+				shared.try_emplace(t * PER + i, std::to_string(t));
+				if (i % 3 == 0) shared.erase(t * PER + i / 2);
+				shared.find((t + 1) % THREADS * PER + i, [](const std::string &v) {
+					if (v.size() != 1) std::cout << "torn" << std::endl;
+				});
+			}
+		});
+	}
+	for (auto &th : pool) th.join();
+	std::vector<int> last(THREADS, -1);
+	bool fine = true;
+	size_t total = 0;
+	shared.for_each([&](const int &key, const std::string &value) {
+		int t = key / PER;
+		if (value != std::to_string(t) || key <= last[t]) fine = false;
+		last[t] = key;
+		total++;
+	});
+	std::cout << fine << " " << (total == shared.size()) << std::endl;
+	//	test: snapshot is a plain linked_hashmap in the same order
+	auto snap = shared.snapshot();
+	auto it = snap.cbegin();
+	fine = snap.size() == total;
+	shared.for_each([&](const int &key, const std::string &) {
+		if (it == snap.cend() || it->first != key) fine = false;
+		else ++it;
+	});
+	shared.clear();
+	std::cout << fine << " " << shared.size() << " " << snap.size() << std::endl;
+}
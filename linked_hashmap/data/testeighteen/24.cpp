@@ -0,0 +1,87 @@
+#include "linked_hashmap.hpp"
+#include <iostream>
+#include <cassert>
+#include <string>
+
+//	a hash and an equality with state: keys are equal when equal modulo m
+class ModHash {
+public:
+	int m;
+	explicit ModHash(int m = 1000000007) : m(m) {}
+	size_t operator () (int x) const {
+		return std::hash<int>()(x % m);
+	}
+};
+class ModEqual {
+public:
+	int m;
+	explicit ModEqual(int m = 1000000007) : m(m) {}
+	bool operator () (int lhs, int rhs) const {
+		return lhs % m == rhs % m;
+	}
+};
+
+template<class Map>
+void print(const Map &m) {
+	std::cout << m.size() << " mod " << m.key_eq().m << ":";
+	for (auto it = m.cbegin(); it != m.cend(); ++it) std::cout << " " << it->first << "=" << it->second;
+	std::cout << std::endl;
+}
+
+template<class Map>
+void run(void) {
+	//	test: the functors passed in are the ones used
+	Map a(ModHash(10), ModEqual(10)), b;
+	for (int i = 0; i < 25; ++i) {
+		a[i] += i;
+		b[i] += i;
+	}
+	print(a);
+	std::cout << b.size() << " " << a.count(123) << b.count(123) << " " << a.hash_function().m << std::endl;
+	//	test: copies, assignments, moves and swaps carry them along
+	Map c(a);
+	c[33] += 1;
+	print(c);
+	Map d;
+	d = a;
+	d.erase(d.find(7));
+	print(d);
+	Map e(std::move(d));
+	e.swap(b);
+	std::cout << e.size() << " " << b.size() << " " << b.key_eq().m << " " << b.count(17) << std::endl;
+	b = std::move(e);
+	std::cout << b.size() << " " << b.key_eq().m << std::endl;
+}
+
+template<class Map>
+bool same(const Map &a, const Map &b) {
+	if (a.size() != b.size()) return false;
+	for (auto p = a.cbegin(), q = b.cbegin(); p != a.cend(); ++p, ++q)
+		if (p->first != q->first || p->second != q->second) return false;
+	return true;
+}
+
+void tester(void) {
+	run<sjtu::linked_hashmap<int, int, ModHash, ModEqual>>();
+	run<sjtu::linked_hashmap<int, int, ModHash, ModEqual, sjtu::compact_storage>>();
+	//	test: a compact table of plain values is copied as a whole, holes included
+	sjtu::linked_hashmap<int, int, std::hash<int>, std::equal_to<int>, sjtu::compact_storage> m;
+	for (int i = 0; i < 5000; ++i) m[i] = i * 2;
+	for (int i = 0; i < 5000; i += 3) m.erase(m.find(i));
+	sjtu::linked_hashmap<int, int, std::hash<int>, std::equal_to<int>, sjtu::compact_storage> n(m), o;
+	o = m;
+	bool ok = same(m, n) && same(m, o);
+	for (int i = 0; i < 5000; ++i) {
+		if (n.count(i) != (i % 3 != 0)) ok = false;
+		n[i + 5000] = i;
+	}
+	for (int i = 1; i < 5000; i += 3) o.erase(o.find(i));
+	std::cout << ok << " " << n.size() << " " << o.size() << " " << m.size() << " " << n.at(7) << std::endl;
+	//	test: empty functors cost no space
+	std::cout << (sizeof(sjtu::linked_hashmap<int, int>) < sizeof(sjtu::linked_hashmap<int, int, ModHash, ModEqual>)) << std::endl;
+}
+
+int main(void) {
+	tester();
+	return 0;
+}
@@ -0,0 +1,83 @@
+#include "linked_hashmap.hpp"
+#include <iostream>
+#include <cassert>
+#include <string>
+#include <string_view>
+
+//	hashes std::string, string_view and const char* the same way, so all of them can look up
+struct StringHash {
+	typedef void is_transparent;
+	size_t operator () (std::string_view s) const {
+		return std::hash<std::string_view>()(s);
+	}
+};
+
+//	counts the strings built by the tests
+static int built = 0;
+struct Name {
+	std::string s;
+	Name(const char *p) : s(p) {
+		built++;
+	}
+	Name(const Name &other) : s(other.s) {
+		built++;
+	}
+};
+struct NameHash {
+	typedef void is_transparent;
+	size_t operator () (const Name &n) const {
+		return StringHash()(n.s);
+	}
+	size_t operator () (std::string_view s) const {
+		return StringHash()(s);
+	}
+};
+struct NameEqual {
+	typedef void is_transparent;
+	bool operator () (const Name &a, const Name &b) const {
+		return a.s == b.s;
+	}
+	bool operator () (std::string_view a, const Name &b) const {
+		return a == b.s;
+	}
+	bool operator () (const Name &a, std::string_view b) const {
+		return a.s == b;
+	}
+};
+
+template<class Map>
+void run(const char *title) {
+	Map map;
+	const char *names[] = {"alice", "bob", "carol", "dave", "eve"};
+	for (int i = 0; i < 5; ++i) map.insert(typename Map::value_type(Name(names[i]), i));
+	int before = built;
+	const Map &cmap = map;
+	std::string_view buf = "to: carol, from: eve";
+	std::cout << title << " " << map.at(buf.substr(4, 5)) << " " << cmap.at(buf.substr(17, 3)) << " " << map.count(std::string_view("bob"))
+		<< " " << cmap.count(std::string_view("bo")) << " " << map.contains(std::string_view("dave")) << " " << cmap.contains(std::string_view("")) << std::endl;
+	std::cout << map.find(std::string_view("alice"))->second << " " << (map.find(std::string_view("zed")) == map.end())
+		<< " " << cmap.find(std::string_view("eve"))->first.s << std::endl;
+	try {
+		map.at(std::string_view("mallory"));
+	} catch (...) {
+		std::cout << "at throws" << std::endl;
+	}
+	std::cout << built - before << " " << map.count(Name("bob")) << std::endl;
+}
+
+void tester(void) {
+	run<sjtu::linked_hashmap<Name, int, NameHash, NameEqual>>("chained");
+	run<sjtu::linked_hashmap<Name, int, NameHash, NameEqual, sjtu::compact_storage>>("compact");
+	//	test: std::string keys with std::equal_to<>, and a plain map still taking keys only
+	sjtu::linked_hashmap<std::string, int, StringHash, std::equal_to<>> words;
+	words["apple"] = 1;
+	words["banana"] = 2;
+	std::cout << words.count("apple") << " " << words.at(std::string_view("banana")) << " " << words.contains("cherry") << std::endl;
+	sjtu::linked_hashmap<std::string, int> plain;
+	plain["apple"] = 3;
+	std::cout << plain.count("apple") << " " << plain.contains("pear") << std::endl;
+}
+
+int main(void) {
+	tester();
+}
@@ -0,0 +1,116 @@
+#include "linked_hashmap.hpp"
+#include <iostream>
+#include <sstream>
+#include <string>
+
+struct Value {
+	long long a;
+	double b;
+};
+
+struct Unmixed : sjtu::default_hashmap_policy {
+	static constexpr bool mix_hash = false;
+};
+struct Seeded : sjtu::default_hashmap_policy {
+	static constexpr bool random_seed = true;
+};
+
+typedef sjtu::linked_hashmap<int, Value> Chained;
+typedef sjtu::linked_hashmap<int, Value, std::hash<int>, std::equal_to<int>, sjtu::compact_storage> Compact;
+
+template<class A, class B>
+bool same(const A &a, const B &b) {
+	if (a.size() != b.size()) return false;
+	auto p = a.cbegin();
+	for (auto q = b.cbegin(); q != b.cend(); ++p, ++q)
+		if (p->first != q->first || p->second.a != q->second.a || p->second.b != q->second.b) return false;
+	for (auto q = b.cbegin(); q != b.cend(); ++q)
+		if (a.find(q->first) == a.cend() || a.at(q->first).a != q->second.a) return false;
+	return a.count(-1) == 0;
+}
+
+template<class Map>
+void fill(Map &m, int n) {
+	for (int i = 0; i < n; ++i) m[(int)((i * 7919LL) % 1000003)] = Value{i * 3LL, i * 0.5};
+	for (int i = 0; i < n; i += 5) m.erase(m.find((int)((i * 7919LL) % 1000003)));
+}
+
+template<class Map>
+bool throws(Map &m, std::istream &in) {
+	try {
+		m.load(in);
+	}
+	catch (sjtu::runtime_error &) {
+		return true;
+	}
+	return false;
+}
+
+void tester(void) {
+	//	test: a round trip keeps the order, the buckets and the seed
+	Chained a;
+	fill(a, 100000);
+	a.set_hash_seed(42);
+	std::stringstream s;
+	a.save(s);
+	Chained b;
+	b.load(s);
+	std::cout << b.size() << " " << same(a, b) << " " << (b.bucket_count() == a.bucket_count()) << " " << b.hash_seed() << std::endl;
+	//	test: several maps in one stream, across engines and policies
+	std::stringstream t;
+	a.save(t);
+	sjtu::linked_hashmap<int, Value, std::hash<int>, std::equal_to<int>, sjtu::chained_storage,
+		std::allocator<sjtu::pair<const int, Value>>, Unmixed> raw;
+	fill(raw, 3000);
+	raw.save(t);
+	sjtu::linked_hashmap<int, Value, std::hash<int>, std::equal_to<int>, sjtu::chained_storage,
+		std::allocator<sjtu::pair<const int, Value>>, Seeded> seeded;
+	fill(seeded, 5000);
+	seeded.save(t);
+	Compact c;
+	c.load(t);
+	std::cout << same(c, a) << " " << c.hash_seed();
+	c.load(t);
+	std::cout << " " << same(c, raw) << " " << c.hash_seed();
+	b.load(t);
+	std::cout << " " << same(b, seeded) << " " << (b.hash_seed() == seeded.hash_seed()) << std::endl;
+	std::stringstream u;
+	c[-5] = Value{1, 2};
+	c.save(u);
+	b.load(u);
+	std::cout << same(b, c) << " " << b.cbegin()->first << " " << b.at(-5).b << std::endl;
+	//	test: empty maps
+	std::stringstream e;
+	Chained().save(e);
+	Compact().save(e);
+	b.load(e);
+	c.load(e);
+	std::cout << b.size() << " " << c.size() << " " << (b.begin() == b.end()) << std::endl;
+	//	test: a bounded map keeps only the newest elements
+	std::stringstream f;
+	a.save(f);
+	Chained lru;
+	int evicted = 0;
+	lru.set_max_size(10);
+	lru.set_eviction_callback([&](Chained::value_type &) { evicted++; });
+	lru.load(f);
+	auto tenth = a.cend();
+	for (int i = 0; i < 10; ++i) --tenth;
+	std::cout << lru.size() << " " << evicted << " " << (lru.cbegin()->first == tenth->first) << std::endl;
+	//	test: foreign and truncated streams
+	std::stringstream bad;
+	sjtu::linked_hashmap<int, int> other;
+	other[1] = 1;
+	other.save(bad);
+	std::cout << throws(b, bad) << " " << b.size();
+	std::string data = s.str();
+	std::stringstream cut(data.substr(0, data.size() - 7));
+	std::cout << " " << throws(b, cut) << " " << b.size();
+	std::stringstream cut2(data.substr(0, 20));
+	std::cout << " " << throws(c, cut2) << " " << c.size() << std::endl;
+}
+
+int main(void) {
+	tester();
+	return 0;
+}
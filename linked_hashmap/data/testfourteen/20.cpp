@@ -0,0 +1,111 @@
+#include "linked_hashmap.hpp"
+#include <iostream>
+#include <cassert>
+#include <string>
+
+class Integer {
+public:
+	static int counter;
+	int val;
+
+	Integer(int val) : val(val) {
+		counter++;
+	}
+
+	Integer(const Integer &rhs) {
+		val = rhs.val;
+		counter++;
+	}
+
+	Integer& operator = (const Integer &rhs) {
+		assert(false);
+	}
+
+	~Integer() {
+		counter--;
+	}
+};
+
+int Integer::counter = 0;
+
+class Equal {
+public:
+	bool operator () (const Integer &lhs, const Integer &rhs) const {
+		return lhs.val == rhs.val;
+	}
+};
+class Hash {
+public:
+	unsigned int operator () (const Integer &lhs) const {
+		return std::hash<int>()(lhs.val);
+	}
+};
+#include <vector>
+#include <list>
+
+template<class Map>
+void run(void) {
+	Map m;
+	std::vector<Integer> keys;
+	std::vector<size_t> counts;
+	//	test: an empty map finds nothing
+	for (int i = 0; i < 40; ++i) keys.push_back(Integer(i));
+	m.count_batch(keys.begin(), keys.end(), std::back_inserter(counts));
+	size_t found = 0;
+	for (size_t c : counts) found += c;
+	std::cout << counts.size() << " " << found << std::endl;
+	//	test: batches of every length against single lookups, hits and misses mixed
+	for (int i = 0; i < 5000; ++i) m[Integer(i * 3)] = std::to_string(i);
+	for (int i = 0; i < 5000; i += 4) m.erase(m.find(Integer(i * 3)));
+	bool same = true;
+	for (int len : {1, 15, 16, 17, 33, 1000}) {
+		keys.clear();
+		for (int i = 0; i < len; ++i) keys.push_back(Integer((i * 7919) % 15100 - 50));
+		std::vector<typename Map::iterator> out(len, m.end());
+		auto e = m.find_batch(keys.begin(), keys.end(), out.begin());
+		if (e != out.end()) same = false;
+		for (int i = 0; i < len; ++i) if (out[i] != m.find(keys[i])) same = false;
+		counts.clear();
+		m.count_batch(keys.begin(), keys.end(), std::back_inserter(counts));
+		for (int i = 0; i < len; ++i) if (counts[i] != m.count(keys[i])) same = false;
+	}
+	std::cout << same << std::endl;
+	//	test: const map, list iterators, results in input order
+	const Map &cm = m;
+	std::list<Integer> lk;
+	lk.push_back(Integer(30));
+	lk.push_back(Integer(31));
+	lk.push_back(Integer(0));
+	lk.push_back(Integer(14997));
+	std::vector<typename Map::const_iterator> co;
+	cm.find_batch(lk.begin(), lk.end(), std::back_inserter(co));
+	for (auto &it : co) {
+		if (it == cm.cend()) std::cout << "end ";
+		else std::cout << it->second << " ";
+	}
+	std::cout << std::endl;
+}
+
+void tester(void) {
+	run<sjtu::linked_hashmap<Integer, std::string, Hash, Equal>>();
+	run<sjtu::linked_hashmap<Integer, std::string, Hash, Equal, sjtu::compact_storage>>();
+	//	test: hits of the non-const form move to the back in access order
+	sjtu::linked_hashmap<Integer, int, Hash, Equal> lru;
+	for (int i = 0; i < 5; ++i) lru[Integer(i)] = i;
+	lru.set_access_order(true);
+	std::vector<Integer> keys;
+	keys.push_back(Integer(1));
+	keys.push_back(Integer(7));
+	keys.push_back(Integer(0));
+	std::vector<sjtu::linked_hashmap<Integer, int, Hash, Equal>::iterator> out;
+	lru.find_batch(keys.begin(), keys.end(), std::back_inserter(out));
+	std::cout << (out[1] == lru.end());
+	for (auto it = lru.begin(); it != lru.end(); ++it) std::cout << " " << it->second;
+	std::cout << std::endl;
+}
+
+int main(void) {
+	tester();
+	std::cout << Integer::counter << std::endl;
+	return 0;
+}
@@ -0,0 +1,120 @@
+#include "linked_hashmap.hpp"
+#include <iostream>
+#include <cassert>
+#include <string>
+
+class Integer {
+public:
+	static int counter;
+	int val;
+
+	Integer(int val) : val(val) {
+		counter++;
+	}
+
+	Integer(const Integer &rhs) {
+		val = rhs.val;
+		counter++;
+	}
+
+	Integer& operator = (const Integer &rhs) {
+		assert(false);
+	}
+
+	~Integer() {
+		counter--;
+	}
+};
+
+int Integer::counter = 0;
+
+class Equal {
+public:
+	bool operator () (const Integer &lhs, const Integer &rhs) const {
+		return lhs.val == rhs.val;
+	}
+};
+class Hash {
+public:
+	unsigned int operator () (const Integer &lhs) const {
+		return std::hash<int>()(lhs.val);
+	}
+};
+
+
+typedef sjtu::linked_hashmap<Integer, std::string, Hash, Equal> lru_map;
+
+void print(const lru_map &m) {
+	for (lru_map::const_iterator it = m.cbegin(); it != m.cend(); ++it) std::cout << it->first.val << " ";
+	std::cout << std::endl;
+}
+
+void tester(void) {
+	//	test: access order moves hits to the back
+	lru_map m;
+	m.set_access_order(true);
+	for (int i = 0; i < 6; ++i) m.insert(sjtu::pair<const Integer, std::string>(Integer(i), std::to_string(i)));
+	m.find(Integer(2));
+	m.at(Integer(0));
+	m[Integer(4)] += "!";
+	m.insert(sjtu::pair<const Integer, std::string>(Integer(1), "x"));
+	m.count(Integer(3));
+	static_cast<const lru_map &>(m).find(Integer(5));
+	print(m);
+	std::cout << m.at(Integer(4)) << " " << m.at(Integer(1)) << " " << m.max_size() << std::endl;
+	//	test: a bounded map evicts from the front and reports every victim
+	std::string evicted;
+	m.set_eviction_callback([&evicted](sjtu::pair<const Integer, std::string> &v) {
+		evicted += std::to_string(v.first.val) + ":" + v.second + " ";
+	});
+	m.set_max_size(4);
+	std::cout << evicted << "| " << m.size() << " " << m.max_size() << std::endl;
+	print(m);
+	for (int i = 10; i < 14; ++i) {
+		m.try_emplace(Integer(i), std::to_string(i));
+		m.at(Integer(4));
+	}
+	std::cout << evicted << std::endl;
+	print(m);
+	//	test: copies keep the policy, insertion order without access order
+	lru_map c(m);
+	c.insert_or_assign(Integer(20), std::string("20"));
+	print(c);
+	lru_map fifo;
+	fifo.set_max_size(3);
+	for (int i = 0; i < 5; ++i) fifo[Integer(i)] = "v";
+	fifo.find(Integer(2));
+	fifo[Integer(7)];
+	print(fifo);
+	//	test: a throwing callback keeps the victim
+	lru_map t;
+	t.set_max_size(2);
+	t.set_eviction_callback([](sjtu::pair<const Integer, std::string> &v) {
+		if (v.first.val == 0) throw 1;
+	});
+	t[Integer(0)], t[Integer(1)];
+	try {
+		t[Integer(2)];
+	} catch (int) {
+		std::cout << "callback threw " << t.size() << std::endl;
+	}
+	t.set_eviction_callback(nullptr);
+	t.set_max_size(1);
+	print(t);
+	//	test: a long run against the bound
+	lru_map big;
+	big.set_access_order(true);
+	big.set_max_size(1000);
+	int hits = 0;
+	for (int i = 0; i < 100000; ++i) {
+		int k = (i & 1) ? i * 7919 % 3000 : i * 31 % 500;
+		if (big.find(Integer(k)) != big.end()) hits++;
+		else big[Integer(k)] = "v";
+	}
+	std::cout << hits << " " << big.size() << std::endl;
+}
+
+int main(void) {
+	tester();
+	std::cout << Integer::counter << std::endl;
+}
@@ -0,0 +1,136 @@
+#include "linked_hashmap.hpp"
+#include <iostream>
+#include <cassert>
+#include <string>
+
+class Integer {
+public:
+	static int counter;
+	int val;
+
+	Integer(int val) : val(val) {
+		counter++;
+	}
+
+	Integer(const Integer &rhs) {
+		val = rhs.val;
+		counter++;
+	}
+
+	Integer& operator = (const Integer &rhs) {
+		assert(false);
+	}
+
+	~Integer() {
+		counter--;
+	}
+};
+
+int Integer::counter = 0;
+
+class Equal {
+public:
+	bool operator () (const Integer &lhs, const Integer &rhs) const {
+		return lhs.val == rhs.val;
+	}
+};
+class Hash {
+public:
+	unsigned int operator () (const Integer &lhs) const {
+		return std::hash<int>()(lhs.val);
+	}
+};
+#include <vector>
+
+template<class Map>
+void print(Map &m) {
+	std::cout << m.size() << ":";
+	for (auto it = m.begin(); it != m.end(); ++it) std::cout << " " << it->first.val;
+	std::cout << std::endl;
+}
+
+template<class Map>
+bool check(const Map &m, int from, int to, int step) {
+	size_t n = 0;
+	for (int i = from; i < to; i += step) {
+		if (!m.count(Integer(i)) || m.at(Integer(i)) != std::to_string(i)) return false;
+		n++;
+	}
+	return n == m.size();
+}
+
+template<class Map>
+void run(void) {
+	typedef sjtu::pair<const Integer, std::string> value;
+	Map m;
+	for (int i = 0; i < 20; ++i) m[Integer(i)] = std::to_string(i);
+	//	test: range erase over the insertion order
+	auto a = m.begin(), b = m.begin();
+	for (int i = 0; i < 3; ++i) ++a;
+	for (int i = 0; i < 7; ++i) ++b;
+	m.erase(a, b);
+	m.erase(m.begin(), m.begin());
+	print(m);
+	b = m.begin();
+	for (int i = 0; i < 10; ++i) ++b;
+	m.erase(b, m.end());
+	print(m);
+	//	test: pop_front takes the oldest element
+	m.pop_front();
+	m.pop_front();
+	m[Integer(50)] = "50";
+	print(m);
+	//	test: erase_if in one pass
+	size_t n = m.erase_if([](const value &v) { return v.first.val % 2 == 0; });
+	std::cout << n << " ";
+	print(m);
+	m.erase(m.begin(), m.end());
+	try {
+		m.pop_front();
+	}
+	catch (sjtu::container_is_empty) {
+		std::cout << "empty ";
+	}
+	print(m);
+	//	test: foreign iterators
+	Map other;
+	other[Integer(1)] = "1";
+	try {
+		m.erase(other.begin(), other.end());
+	}
+	catch (sjtu::invalid_iterator) {
+		std::cout << "invalid" << std::endl;
+	}
+	//	test: expiring the oldest elements of a large map, with auto shrinking
+	Map big;
+	big.set_auto_shrink(true);
+	for (int i = 0; i < 100000; ++i) big[Integer(i)] = std::to_string(i);
+	for (int i = 0; i < 30000; ++i) big.pop_front();
+	auto c = big.begin();
+	for (int i = 0; i < 30000; ++i) ++c;
+	big.erase(big.begin(), c);
+	bool ok = check(big, 60000, 100000, 1);
+	big.erase_if([](value &v) { return v.first.val % 4 != 0; });
+	ok = ok && check(big, 60000, 100000, 4);
+	for (int i = 0; i < 5000; ++i) big[Integer(i * 4)] = std::to_string(i * 4);
+	big.erase_if([](const value &v) { return v.first.val >= 60000; });
+	std::cout << ok << " " << check(big, 0, 20000, 4) << std::endl;
+}
+
+void tester(void) {
+	run<sjtu::linked_hashmap<Integer, std::string, Hash, Equal>>();
+	run<sjtu::linked_hashmap<Integer, std::string, Hash, Equal, sjtu::compact_storage>>();
+	//	test: erase in the middle of an incremental rehash
+	sjtu::linked_hashmap<Integer, std::string, Hash, Equal> m;
+	m.set_incremental_rehash(true);
+	for (int i = 0; i < 1537; ++i) m[Integer(i)] = std::to_string(i);
+	m.erase_if([](const sjtu::pair<const Integer, std::string> &v) { return v.first.val % 3 != 0; });
+	for (int i = 0; i < 100; ++i) m.pop_front();
+	std::cout << check(m, 300, 1537, 3) << std::endl;
+}
+
+int main(void) {
+	tester();
+	std::cout << Integer::counter << std::endl;
+	return 0;
+}
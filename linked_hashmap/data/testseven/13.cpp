@@ -0,0 +1,200 @@
+#include "linked_hashmap.hpp"
+#include <iostream>
+#include <cassert>
+#include <string>
+#include <new>
+
+class Integer {
+public:
+	static int counter;
+	int val;
+
+	Integer(int val) : val(val) {
+		counter++;
+	}
+
+	Integer(const Integer &rhs) {
+		val = rhs.val;
+		counter++;
+	}
+
+	Integer& operator = (const Integer &rhs) {
+		assert(false);
+	}
+
+	~Integer() {
+		counter--;
+	}
+};
+
+int Integer::counter = 0;
+
+class Equal {
+public:
+	bool operator () (const Integer &lhs, const Integer &rhs) const {
+		return lhs.val == rhs.val;
+	}
+};
+class Hash {
+public:
+	unsigned int operator () (const Integer &lhs) const {
+		return std::hash<int>()(lhs.val);
+	}
+};
+
+typedef sjtu::linked_hashmap<Integer, std::string, Hash, Equal, sjtu::compact_storage> compact_map;
+
+const int mod = 23333;
+int cur = 3, factor = 233;
+inline int getNum() {
+	cur = 1ll * cur * factor % mod;
+	return cur;
+}
+
+void tester(void) {
+	compact_map map;
+	assert(map.empty() && map.size() == 0);
+	compact_map::iterator stale = map.begin();
+	for (int i = 0; i < 100000; ++i) {
+		int x = getNum();
+		if (map.count(Integer(x))) {
+			map.erase(map.find(Integer(x)));
+		}
+		else {
+			map[Integer(x)] = std::to_string(i);
+		}
+	}
+	// end() must not move while the entry array grows
+	assert(stale == map.end());
+	std::cout << map.size() << std::endl;
+	long long sum = 0;
+	int cnt = 0;
+	for (compact_map::const_iterator it = map.cbegin(); it != map.cend(); ++it, ++cnt) {
+		sum = (sum * 31 + it->first.val + (long long)it->second.size()) % 1000000007;
+	}
+	std::cout << cnt << " " << sum << std::endl;
+	compact_map::iterator it = map.end();
+	for (int i = 0; i < 10; ++i) {
+		--it;
+		std::cout << it->first.val << " " << it->second << " ";
+	}
+	std::cout << std::endl;
+	compact_map copy(map);
+	map.clear();
+	std::cout << map.size() << " " << copy.size() << std::endl;
+	map = copy;
+	int ok = 0;
+	try { --map.begin(); } catch (...) { ok++; }
+	try { ++map.end(); } catch (...) { ok++; }
+	try { map.erase(copy.begin()); } catch (...) { ok++; }
+	try { map.at(Integer(-1)); } catch (...) { ok++; }
+	std::cout << ok << std::endl;
+	for (int i = 0; i < mod; ++i) {
+		if (copy.count(Integer(i))) copy.erase(copy.find(Integer(i)));
+	}
+	std::cout << copy.size() << " " << (copy.begin() == copy.end()) << std::endl;
+}
+
+//	holes are never squeezed out behind a held iterator
+void iterators_survive(void) {
+	compact_map map;
+	for (int i = 0; i < 6; ++i) map[Integer(i)] = "v" + std::to_string(i);
+	map.erase(map.find(Integer(1)));
+	map.erase(map.find(Integer(3)));
+	compact_map::iterator five = map.find(Integer(5)), zero = map.begin();
+	for (int i = 6; i < 5000; ++i) map[Integer(i)] = "v" + std::to_string(i);
+	std::cout << five->first.val << five->second << " " << zero->first.val << zero->second << " ";
+	++five;
+	std::cout << five->first.val << " ";
+	map.set_auto_shrink(true);
+	for (int i = 10; i < 5000; ++i) map.erase(map.find(Integer(i)));
+	std::cout << map.size() << " " << zero->second << " ";
+	--five;
+	std::cout << five->first.val << five->second << " ";
+	for (int i = 100; i < 200; ++i) map[Integer(i)] = "w";
+	int n = 0;
+	for (compact_map::iterator it = zero; it != map.end(); ++it) n++;
+	std::cout << n << " " << (--map.end())->first.val << std::endl;
+	//	compact squeezes the holes out
+	size_t before = map.memory_usage();
+	map.compact();
+	std::cout << (map.memory_usage() < before) << " " << map.size() << " " << map.begin()->first.val << " " << map.at(Integer(150)) << std::endl;
+}
+
+//	throws from the fail_at-th allocation on
+int allocations = 0, fail_at = -1;
+template<class U>
+struct failing_allocator {
+	typedef U value_type;
+	failing_allocator() {}
+	template<class V> failing_allocator(const failing_allocator<V> &) {}
+	U *allocate(size_t n) {
+		if (++allocations == fail_at) throw std::bad_alloc();
+		return std::allocator<U>().allocate(n);
+	}
+	void deallocate(U *p, size_t n) { std::allocator<U>().deallocate(p, n); }
+	template<class V> bool operator == (const failing_allocator<V> &) const { return true; }
+	template<class V> bool operator != (const failing_allocator<V> &) const { return false; }
+};
+typedef sjtu::linked_hashmap<Integer, std::string, Hash, Equal, sjtu::compact_storage,
+	failing_allocator<sjtu::pair<const Integer, std::string>>> failing_map;
+
+bool intact(const failing_map &m, int n) {
+	int expect = 0, count = 0;
+	for (failing_map::const_iterator it = m.cbegin(); it != m.cend(); ++it, ++count, expect += 2)
+		if (it->first.val != expect || it->second != std::to_string(expect)) return false;
+	return count == n && m.count(Integer(2 * (n - 1))) == 1 && m.count(Integer(1)) == 0;
+}
+
+//	a failed rebuild leaves the table as it was
+void failed_rebuilds(void) {
+	for (int step = 0; step < 3; ++step)
+		for (int which = 1; which <= 2; ++which) {
+			failing_map m;
+			for (int i = 0; i < 100; ++i) m[Integer(i)] = std::to_string(i);
+			for (int i = 1; i < 100; i += 2) m.erase(m.find(Integer(i)));
+			failing_map other;
+			other[Integer(7)] = "7";
+			allocations = 0;
+			fail_at = which;
+			try {
+				if (step == 0) m.rehash(4096);
+				else if (step == 1) m.compact();
+				else other = m;
+				std::cout << "no throw ";
+			} catch (std::bad_alloc &) {
+				std::cout << "bad_alloc ";
+			}
+			fail_at = -1;
+			std::cout << intact(m, 50) << other.size() << " ";
+			m[Integer(1000)] = "x";
+			other = m;
+			std::cout << other.size() << " ";
+		}
+	std::cout << std::endl;
+}
+
+//	a map that keeps erasing and inserting stays as big as its contents
+void churn(void) {
+	compact_map map;
+	for (int i = 0; i < 10; ++i) map[Integer(i)] = std::to_string(i);
+	size_t start = map.memory_usage(), most = start;
+	for (int i = 10; i < 300000; ++i) {
+		map.pop_front();
+		map[Integer(i)] = std::to_string(i);
+		if (map.memory_usage() > most) most = map.memory_usage();
+	}
+	int expect = 300000 - 10;
+	bool ok = map.size() == 10;
+	for (compact_map::const_iterator it = map.cbegin(); it != map.cend(); ++it, ++expect)
+		ok = ok && it->first.val == expect && it->second == std::to_string(expect);
+	std::cout << ok << " " << (most <= 4 * start) << " " << map.count(Integer(299999)) << map.count(Integer(5)) << std::endl;
+}
+
+int main(void) {
+	tester();
+	iterators_survive();
+	failed_rebuilds();
+	churn();
+	std::cout << Integer::counter << std::endl;
+}
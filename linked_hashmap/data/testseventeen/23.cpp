@@ -0,0 +1,110 @@
+#include "linked_hashmap.hpp"
+#include <iostream>
+#include <cassert>
+#include <atomic>
+#include <string>
+
+//	elements are destroyed from several threads at once
+class Integer {
+public:
+	static std::atomic<int> counter;
+	int val;
+
+	Integer(int val) : val(val) {
+		counter++;
+	}
+
+	Integer(const Integer &rhs) {
+		val = rhs.val;
+		counter++;
+	}
+
+	Integer& operator = (const Integer &rhs) {
+		assert(false);
+	}
+
+	~Integer() {
+		counter--;
+	}
+};
+
+std::atomic<int> Integer::counter(0);
+
+class Equal {
+public:
+	bool operator () (const Integer &lhs, const Integer &rhs) const {
+		return lhs.val == rhs.val;
+	}
+};
+class Hash {
+public:
+	unsigned int operator () (const Integer &lhs) const {
+		return std::hash<int>()(lhs.val);
+	}
+};
+
+template<class Map>
+void run(Map &m) {
+	typedef sjtu::pair<const Integer, std::string> value;
+	//	test: every element is visited once, and the writes stick
+	std::atomic<long long> sum(0);
+	std::atomic<int> visits(0);
+	m.parallel_for_each([&](value &v) {
+		v.second += "!";
+		visits++;
+	}, 4);
+	const Map &cm = m;
+	cm.parallel_for_each([&](const value &v) {
+		sum += v.first.val;
+	});
+	long long want = 0;
+	bool marked = true;
+	for (auto it = cm.cbegin(); it != cm.cend(); ++it) {
+		want += it->first.val;
+		marked = marked && it->second.back() == '!';
+	}
+	std::cout << visits << " " << (sum == want) << " " << marked << std::endl;
+	//	test: an exception from fn reaches the caller
+	try {
+		m.parallel_for_each([](value &v) {
+			if (v.first.val == 999) throw sjtu::runtime_error();
+		}, 3);
+		std::cout << "no throw" << std::endl;
+	}
+	catch (sjtu::runtime_error) {
+		std::cout << "thrown" << std::endl;
+	}
+	//	test: parallel_clear, then the map is usable again
+	m.parallel_clear(4);
+	std::cout << m.size() << " " << (m.begin() == m.end()) << " " << m.count(Integer(5)) << std::endl;
+	for (int i = 0; i < 20; ++i) m[Integer(i)] = std::to_string(i);
+	std::cout << m.size() << " " << m.begin()->second << " " << m.at(Integer(19)) << std::endl;
+}
+
+void tester(void) {
+	sjtu::linked_hashmap<Integer, std::string, Hash, Equal> a;
+	for (int i = 0; i < 30000; ++i) a[Integer(i)] = std::to_string(i);
+	for (int i = 0; i < 30000; i += 3) a.erase(a.find(Integer(i)));
+	run(a);
+	//	test: halfway through an incremental rehash
+	sjtu::linked_hashmap<Integer, std::string, Hash, Equal> b;
+	b.set_incremental_rehash(true);
+	for (int i = 0; i < 1537; ++i) b[Integer(i)] = std::to_string(i);
+	run(b);
+	//	test: a small map without buckets
+	sjtu::linked_hashmap<Integer, std::string, Hash, Equal> c;
+	for (int i = 995; i < 1000; ++i) c[Integer(i)] = std::to_string(i);
+	run(c);
+	sjtu::linked_hashmap<Integer, std::string, Hash, Equal, sjtu::compact_storage> d;
+	for (int i = 0; i < 30000; ++i) d[Integer(i)] = std::to_string(i);
+	for (int i = 0; i < 30000; i += 3) d.erase(d.find(Integer(i)));
+	run(d);
+	sjtu::linked_hashmap<Integer, std::string, Hash, Equal, sjtu::compact_storage> e;
+	run(e);
+}
+
+int main(void) {
+	tester();
+	std::cout << Integer::counter << std::endl;
+	return 0;
+}
@@ -0,0 +1,120 @@
+#include "linked_hashmap.hpp"
+#include <iostream>
+#include <cassert>
+#include <string>
+
+class Integer {
+public:
+	static int counter;
+	int val;
+
+	Integer(int val) : val(val) {
+		counter++;
+	}
+
+	Integer(const Integer &rhs) {
+		val = rhs.val;
+		counter++;
+	}
+
+	Integer& operator = (const Integer &rhs) {
+		assert(false);
+	}
+
+	~Integer() {
+		counter--;
+	}
+};
+
+int Integer::counter = 0;
+
+class Equal {
+public:
+	bool operator () (const Integer &lhs, const Integer &rhs) const {
+		return lhs.val == rhs.val;
+	}
+};
+class Hash {
+public:
+	unsigned int operator () (const Integer &lhs) const {
+		return std::hash<int>()(lhs.val);
+	}
+};
+#include <vector>
+
+typedef sjtu::linked_hashmap<Integer, int, Hash, Equal> hmap;
+
+template<class Map>
+void print(const Map &m) {
+	std::cout << m.size() << " " << m.bucket_count() << ":";
+	for (auto it = m.cbegin(); it != m.cend(); ++it) std::cout << " " << it->first.val << "=" << it->second;
+	std::cout << std::endl;
+}
+
+void tester(void) {
+	//	test: no buckets up to 8 elements, the 9th insertion builds them
+	hmap m;
+	std::cout << m.bucket_count() << " " << m.load_factor() << " " << m.empty() << std::endl;
+	std::vector<int*> refs;
+	for (int i = 0; i < 8; ++i) refs.push_back(&(m[Integer(i * 5)] = i));
+	print(m);
+	std::cout << m.count(Integer(35)) << m.count(Integer(36)) << " " << m.at(Integer(10)) << std::endl;
+	m.insert(sjtu::pair<const Integer, int>(Integer(100), 8));
+	std::cout << m.size() << " " << (m.bucket_count() > 0) << std::endl;
+	//	test: references taken before the promotion still hold
+	bool same = true;
+	for (int i = 0; i < 8; ++i) if (refs[i] != &m.at(Integer(i * 5)) || *refs[i] != i) same = false;
+	std::cout << same << std::endl;
+	//	test: erase, reinsert, access order and eviction while small
+	hmap s;
+	for (int i = 0; i < 6; ++i) s[Integer(i)] = i * i;
+	s.erase(s.find(Integer(0)));
+	s.erase(s.find(Integer(3)));
+	s[Integer(3)] = 33;
+	s.set_access_order(true);
+	s.at(Integer(1));
+	s.set_max_size(4);
+	print(s);
+	try {
+		s.at(Integer(0));
+	}
+	catch (sjtu::index_out_of_bound) {
+		std::cout << "no 0" << std::endl;
+	}
+	//	test: reserve within the small limit keeps the map small, beyond it does not
+	hmap r;
+	r.reserve(8);
+	std::cout << r.bucket_count() << " ";
+	r.reserve(100);
+	std::cout << (r.bucket_count() >= 128) << std::endl;
+	//	test: copies, swap and move between small and large maps
+	hmap c(s), big;
+	for (int i = 0; i < 1000; ++i) big[Integer(i)] = -i;
+	print(c);
+	c.swap(big);
+	std::cout << c.size() << " " << big.size() << " " << big.bucket_count() << " " << (c.begin()->second == 0) << std::endl;
+	print(big);
+	hmap e;
+	e.swap(big);
+	std::cout << big.empty() << " " << (big.begin() == big.end()) << std::endl;
+	print(e);
+	hmap mv(std::move(e));
+	print(mv);
+	print(e);
+	e = mv;
+	e[Integer(50)] = 50;
+	print(e);
+	mv = std::move(c);
+	std::cout << mv.size() << " " << c.size() << std::endl;
+	//	test: clear keeps working either way
+	mv.clear();
+	e.clear();
+	for (int i = 0; i < 3; ++i) e[Integer(i)] = i;
+	print(e);
+}
+
+int main(void) {
+	tester();
+	std::cout << Integer::counter << std::endl;
+	return 0;
+}
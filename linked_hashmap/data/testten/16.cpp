@@ -0,0 +1,103 @@
+#include "linked_hashmap.hpp"
+#include <iostream>
+#include <cassert>
+#include <string>
+
+class Integer {
+public:
+	static int counter;
+	int val;
+
+	Integer(int val) : val(val) {
+		counter++;
+	}
+
+	Integer(const Integer &rhs) {
+		val = rhs.val;
+		counter++;
+	}
+
+	Integer& operator = (const Integer &rhs) {
+		assert(false);
+	}
+
+	~Integer() {
+		counter--;
+	}
+};
+
+int Integer::counter = 0;
+
+class Equal {
+public:
+	bool operator () (const Integer &lhs, const Integer &rhs) const {
+		return lhs.val == rhs.val;
+	}
+};
+class Hash {
+public:
+	unsigned int operator () (const Integer &lhs) const {
+		return std::hash<int>()(lhs.val);
+	}
+};
+
+
+typedef sjtu::linked_hashmap<Integer, int, Hash, Equal> hmap;
+typedef sjtu::pair<const Integer, int> value;
+
+//	every key present maps to its own value, and the list is in insertion order
+bool check(hmap &m, int from, int to) {
+	int expect = from;
+	for (hmap::iterator it = m.begin(); it != m.end(); ++it, ++expect)
+		if (it->first.val != expect || it->second != expect * 2) return false;
+	if (expect != to || (int)m.size() != to - from) return false;
+	for (int i = from - 5; i < to + 5; ++i)
+		if (m.count(Integer(i)) != (i >= from && i < to) || (i >= from && i < to && m.at(Integer(i)) != i * 2)) return false;
+	return true;
+}
+
+void tester(void) {
+	//	test: lookups while the buckets are halfway migrated
+	hmap m;
+	m.set_incremental_rehash(true);
+	size_t last = m.bucket_count();
+	int grows = 0;
+	bool ok = true;
+	for (int i = 0; i < 100000; ++i) {
+		m.insert(value(Integer(i), i * 2));
+		if (m.bucket_count() != last) {
+			last = m.bucket_count();
+			grows++;
+			ok = ok && check(m, 0, i + 1);
+		}
+		if (i % 997 == 0) ok = ok && m.count(Integer(i / 2)) && m.find(Integer(i + 1)) == m.end();
+	}
+	std::cout << ok << " " << grows << " " << m.bucket_count() << " " << check(m, 0, 100000) << std::endl;
+	//	test: copy, swap and clear in the middle of a migration
+	hmap n;
+	n.set_incremental_rehash(true);
+	for (int i = 0; i < 1537; ++i) n.insert(value(Integer(i), i * 2));
+	hmap c(n), d;
+	d = n;
+	hmap s;
+	s.swap(n);
+	std::cout << check(c, 0, 1537) << " " << check(d, 0, 1537) << " " << check(s, 0, 1537) << " " << n.empty() << std::endl;
+	s.clear();
+	for (int i = 0; i < 10; ++i) s.insert(value(Integer(i), i * 2));
+	std::cout << check(s, 0, 10) << std::endl;
+	//	test: shrinking is incremental too
+	m.set_auto_shrink(true);
+	for (int i = 0; i < 99000; ++i) {
+		hmap::iterator it = m.find(Integer(i));
+		m.erase(it);
+	}
+	std::cout << check(m, 99000, 100000) << " " << m.bucket_count() << std::endl;
+	m.set_incremental_rehash(false);
+	for (int i = 100000; i < 110000; ++i) m.insert(value(Integer(i), i * 2));
+	std::cout << check(m, 99000, 110000) << " " << m.bucket_count() << std::endl;
+}
+
+int main(void) {
+	tester();
+	std::cout << Integer::counter << std::endl;
+}
@@ -0,0 +1,125 @@
+#include "linked_hashmap.hpp"
+#include <iostream>
+#include <cassert>
+#include <string>
+
+class Integer {
+public:
+	static int counter;
+	int val;
+
+	Integer(int val) : val(val) {
+		counter++;
+	}
+
+	Integer(const Integer &rhs) {
+		val = rhs.val;
+		counter++;
+	}
+
+	Integer& operator = (const Integer &rhs) {
+		assert(false);
+	}
+
+	~Integer() {
+		counter--;
+	}
+};
+
+int Integer::counter = 0;
+
+class Equal {
+public:
+	bool operator () (const Integer &lhs, const Integer &rhs) const {
+		return lhs.val == rhs.val;
+	}
+};
+class Hash {
+public:
+	unsigned int operator () (const Integer &lhs) const {
+		return std::hash<int>()(lhs.val);
+	}
+};
+
+struct Unmixed : sjtu::default_hashmap_policy {
+	static constexpr bool stats = true;
+	static constexpr bool mix_hash = false;
+};
+struct Seeded : sjtu::hashmap_stats_policy {
+	static constexpr bool random_seed = true;
+};
+
+//	keys 0, 1 << 16, 2 << 16, ...: std::hash<int> is the identity, so without
+//	mixing they all share bucket 0 of any table smaller than 65536
+template<class Map>
+void strided(Map &m, int n) {
+	for (int i = 0; i < n; ++i) m.insert(sjtu::pair<Integer, int>(Integer(i << 16), i));
+}
+
+template<class Map>
+bool check(const Map &m, int n) {
+	if ((int)m.size() != n) return false;
+	int i = 0;
+	for (auto it = m.cbegin(); it != m.cend(); ++it, ++i)
+		if (it->first.val != (i << 16) || it->second != i) return false;
+	for (i = 0; i < n; ++i)
+		if (m.at(Integer(i << 16)) != i) return false;
+	return m.count(Integer(1)) == 0;
+}
+
+void tester(void) {
+	//	the same keys with and without the mixing stage
+	{
+		sjtu::linked_hashmap<Integer, int, Hash, Equal, sjtu::chained_storage,
+			std::allocator<sjtu::pair<const Integer, int>>, Unmixed> raw;
+		strided(raw, 600);
+		std::cout << raw.stats().max_chain << std::endl;
+		sjtu::linked_hashmap<Integer, int, Hash, Equal, sjtu::chained_storage,
+			std::allocator<sjtu::pair<const Integer, int>>, sjtu::hashmap_stats_policy> mixed;
+		strided(mixed, 600);
+		std::cout << (mixed.stats().max_chain <= 8) << " " << check(mixed, 600) << std::endl;
+	}
+	//	reseeding keeps the order and every key reachable, copies keep the seed
+	{
+		sjtu::linked_hashmap<Integer, int, Hash, Equal> m;
+		std::cout << m.hash_seed() << std::endl;
+		strided(m, 3000);
+		m.set_hash_seed(12345);
+		std::cout << m.hash_seed() << " " << check(m, 3000) << std::endl;
+		sjtu::linked_hashmap<Integer, int, Hash, Equal> c(m);
+		std::cout << c.hash_seed() << " " << check(c, 3000) << std::endl;
+		m.set_incremental_rehash(true);
+		strided(m, 6000);
+		m.set_hash_seed(7);
+		std::cout << check(m, 6000) << std::endl;
+		c = m;
+		std::cout << c.hash_seed() << " " << check(c, 6000) << std::endl;
+	}
+	//	random seeds differ between maps and still index correctly
+	{
+		sjtu::linked_hashmap<Integer, int, Hash, Equal, sjtu::chained_storage,
+			std::allocator<sjtu::pair<const Integer, int>>, Seeded> a, b;
+		std::cout << (a.hash_seed() != b.hash_seed()) << std::endl;
+		strided(a, 2000);
+		std::cout << (a.stats().max_chain <= 8) << " " << check(a, 2000) << std::endl;
+		a.swap(b);
+		std::cout << check(b, 2000) << " " << a.size() << std::endl;
+	}
+	//	compact storage
+	{
+		sjtu::linked_hashmap<Integer, int, Hash, Equal, sjtu::compact_storage> m;
+		strided(m, 3000);
+		for (int i = 0; i < 3000; i += 3) m.erase(m.find(Integer(i << 16)));
+		m.set_hash_seed(99);
+		std::cout << m.hash_seed() << " " << m.size() << " " << m.at(Integer(1 << 16)) << " " << m.count(Integer(0)) << std::endl;
+		sjtu::linked_hashmap<Integer, int, Hash, Equal, sjtu::compact_storage> c;
+		c = m;
+		std::cout << c.hash_seed() << " " << (c.cbegin()->first.val >> 16) << std::endl;
+	}
+}
+
+int main(void) {
+	tester();
+	std::cout << Integer::counter << std::endl;
+	return 0;
+}
@@ -0,0 +1,93 @@
+#include "linked_hashmap.hpp"
+#include <iostream>
+#include <cassert>
+#include <string>
+
+class Integer {
+public:
+	static int counter;
+	int val;
+
+	Integer(int val) : val(val) {
+		counter++;
+	}
+
+	Integer(const Integer &rhs) {
+		val = rhs.val;
+		counter++;
+	}
+
+	Integer& operator = (const Integer &rhs) {
+		assert(false);
+	}
+
+	~Integer() {
+		counter--;
+	}
+};
+
+int Integer::counter = 0;
+
+class Equal {
+public:
+	bool operator () (const Integer &lhs, const Integer &rhs) const {
+		return lhs.val == rhs.val;
+	}
+};
+class Hash {
+public:
+	unsigned int operator () (const Integer &lhs) const {
+		return std::hash<int>()(lhs.val);
+	}
+};
+
+
+//	a deliberately bad hash: every key lands in one of 4 chains
+class BadHash {
+public:
+	unsigned int operator () (const Integer &lhs) const {
+		return lhs.val % 4;
+	}
+};
+
+//	sequential keys fill the compact table evenly only without the mixing stage
+struct UnmixedStats : sjtu::hashmap_stats_policy {
+	static constexpr bool mix_hash = false;
+};
+
+template<class Map>
+void run(const char *title) {
+	Map map;
+	for (int i = 0; i < 3000; ++i) map[Integer(i)] = std::to_string(i);
+	map.reset_stats();
+	for (int i = 0; i < 6000; ++i) map.count(Integer(i));
+	sjtu::hashmap_stats s = map.stats();
+	std::cout << title << " lookups " << s.lookups << " probes/lookup<=2 " << (s.probes <= 2 * s.lookups)
+		<< " max_chain " << (s.max_chain >= 1) << " avg>=1 " << (s.average_chain >= 1) << " allocs " << s.node_allocations << std::endl;
+	map.reset_stats();
+	for (int i = 3000; i < 12000; ++i) map[Integer(i)] = "x";
+	s = map.stats();
+	std::cout << "rehashes>0 " << (s.rehashes > 0) << " allocs " << s.node_allocations << std::endl;
+}
+
+void tester(void) {
+	run<sjtu::linked_hashmap<Integer, std::string, Hash, Equal, sjtu::chained_storage,
+		std::allocator<sjtu::pair<const Integer, std::string>>, sjtu::hashmap_stats_policy>>("chained");
+	run<sjtu::linked_hashmap<Integer, std::string, Hash, Equal, sjtu::compact_storage,
+		std::allocator<sjtu::pair<const Integer, std::string>>, UnmixedStats>>("compact");
+	//	test: long chains show up in the numbers
+	sjtu::linked_hashmap<Integer, int, BadHash, Equal, sjtu::chained_storage,
+		std::allocator<sjtu::pair<const Integer, int>>, sjtu::hashmap_stats_policy> bad;
+	for (int i = 0; i < 400; ++i) bad[Integer(i)] = i;
+	bad.reset_stats();
+	bad.count(Integer(1000));
+	sjtu::hashmap_stats s = bad.stats();
+	std::cout << s.lookups << " " << s.probes << " " << s.max_chain << " " << s.average_chain << std::endl;
+	//	test: without the policy a map is unchanged
+	std::cout << (sizeof(sjtu::linked_hashmap<Integer, int, Hash, Equal>) < sizeof(bad)) << std::endl;
+}
+
+int main(void) {
+	tester();
+	std::cout << Integer::counter << std::endl;
+}
@@ -0,0 +1,112 @@
+#include "linked_hashmap.hpp"
+#include <iostream>
+#include <cassert>
+#include <string>
+
+class Integer {
+public:
+	static int counter;
+	int val;
+
+	Integer(int val) : val(val) {
+		counter++;
+	}
+
+	Integer(const Integer &rhs) {
+		val = rhs.val;
+		counter++;
+	}
+
+	Integer& operator = (const Integer &rhs) {
+		assert(false);
+	}
+
+	~Integer() {
+		counter--;
+	}
+};
+
+int Integer::counter = 0;
+
+class Equal {
+public:
+	bool operator () (const Integer &lhs, const Integer &rhs) const {
+		return lhs.val == rhs.val;
+	}
+};
+class Hash {
+public:
+	unsigned int operator () (const Integer &lhs) const {
+		return std::hash<int>()(lhs.val);
+	}
+};
+template<class Map>
+bool check(const Map &m, int from, int to, int step) {
+	size_t n = 0;
+	int last = from - 1;
+	for (auto it = m.cbegin(); it != m.cend(); ++it, ++n) {
+		if (it->first.val <= last || (it->first.val - from) % step || it->second != std::to_string(it->first.val)) return false;
+		last = it->first.val;
+	}
+	for (int i = from; i < to; i += step)
+		if (m.count(Integer(i)) == 0) return false;
+	return n == (size_t)((to - from + step - 1) / step);
+}
+
+template<class Map>
+void run(void) {
+	Map m;
+	m.compact();
+	m.shrink_to_fit();
+	std::cout << m.size() << " ";
+	//	test: erasing frees neither buckets nor nodes, shrink_to_fit and compact do
+	m.reserve(200000);
+	for (int i = 0; i < 100000; ++i) m[Integer(i)] = std::to_string(i);
+	size_t full = m.memory_usage(), buckets = m.bucket_count();
+	for (int i = 0; i < 100000; ++i)
+		if (i % 100) m.erase(m.find(Integer(i)));
+	size_t churned = m.memory_usage();
+	m.shrink_to_fit();
+	std::cout << (churned == full) << " " << (m.bucket_count() < buckets) << " ";
+	m.compact();
+	std::cout << (m.memory_usage() * 20 < full) << " " << check(m, 0, 100000, 100) << std::endl;
+	//	test: still usable, and the reserved capacity is forgotten
+	for (int i = 50; i < 100000; i += 100) m[Integer(i)] = std::to_string(i);
+	for (int i = 0; i < 100000; i += 100) m.erase(m.find(Integer(i)));
+	m.set_auto_shrink(true);
+	std::cout << check(m, 50, 100000, 100) << " " << m.begin()->first.val << " " << (m.bucket_count() < buckets) << std::endl;
+	//	test: a map shrunk to a few elements
+	while (m.size() > 5) m.pop_front();
+	m.shrink_to_fit();
+	m.compact();
+	std::cout << check(m, 99550, 100000, 100) << " " << m.size() << std::endl;
+	for (int i = 0; i < 1000; ++i) m[Integer(i)] = std::to_string(i);
+	m.erase_if([](const sjtu::pair<const Integer, std::string> &v) { return v.first.val < 1000 && v.first.val % 2; });
+	m.compact();
+	std::cout << m.size() << " " << m.count(Integer(998)) << " " << m.count(Integer(999)) << std::endl;
+}
+
+void tester(void) {
+	run<sjtu::linked_hashmap<Integer, std::string, Hash, Equal>>();
+	run<sjtu::linked_hashmap<Integer, std::string, Hash, Equal, sjtu::compact_storage>>();
+	//	test: compact in the middle of an incremental rehash
+	sjtu::linked_hashmap<Integer, std::string, Hash, Equal> m;
+	m.set_incremental_rehash(true);
+	for (int i = 0; i < 1537; ++i) m[Integer(i)] = std::to_string(i);
+	m.compact();
+	std::cout << check(m, 0, 1537, 1) << " " << m.bucket_count() << std::endl;
+	//	test: a small map gives its bucket array back, references survive
+	for (int i = 0; i < 1530; ++i) m.pop_front();
+	std::string &ref = m.at(Integer(1533));
+	m.shrink_to_fit();
+	std::cout << check(m, 1530, 1537, 1) << " " << m.bucket_count() << " " << (&ref == &m.at(Integer(1533))) << std::endl;
+	m[Integer(0)] = "0";
+	m[Integer(1)] = "1";
+	std::cout << m.size() << " " << m.bucket_count() << " " << m.at(Integer(1536)) << std::endl;
+}
+
+int main(void) {
+	tester();
+	std::cout << Integer::counter << std::endl;
+	return 0;
+}
@@ -0,0 +1,97 @@
+#include "intrusive_linked_hashmap.hpp"
+#include <iostream>
+#include <cassert>
+#include <string>
+#include <vector>
+
+//	a session sits in two tables at once: by id and by user name
+class Session {
+public:
+	int id;
+	std::string user;
+	sjtu::intrusive_hashmap_hook by_id, by_user;
+	Session(int id, std::string user) : id(id), user(user) {}
+};
+
+typedef sjtu::intrusive_linked_hashmap<int, Session, &Session::id, &Session::by_id> IdTable;
+typedef sjtu::intrusive_linked_hashmap<std::string, Session, &Session::user, &Session::by_user> UserTable;
+
+template<class Table>
+void print(const Table &t) {
+	std::cout << t.size() << ":";
+	for (auto it = t.cbegin(); it != t.cend(); ++it) std::cout << " " << it->id << "/" << it->user;
+	std::cout << std::endl;
+}
+
+void tester(void) {
+	std::vector<Session> sessions;
+	const char *names[] = { "ann", "bob", "cat", "dan", "ann", "eve", "bob", "fay" };
+	for (int i = 0; i < 8; ++i) sessions.push_back(Session(10 - i, names[i]));
+	IdTable ids;
+	UserTable users;
+	//	test: insertion order, duplicates of a key stay out
+	for (int i = 0; i < 8; ++i) std::cout << ids.insert(sessions[i]).second;
+	for (int i = 0; i < 8; ++i) std::cout << users.insert(sessions[i]).second;
+	std::cout << " " << ids.bucket_count() << std::endl;
+	print(ids);
+	print(users);
+	std::cout << (&ids.at(7) == &sessions[3]) << " " << users.find("eve")->id << " " << users.count("bob") << " " << ids.contains(11) << " " << sessions[4].by_user.is_linked() << std::endl;
+	try {
+		users.insert(sessions[0]);
+	}
+	catch (sjtu::runtime_error) {
+		std::cout << "linked" << std::endl;
+	}
+	try {
+		ids.at(11);
+	}
+	catch (sjtu::index_out_of_bound) {
+		std::cout << "absent" << std::endl;
+	}
+	//	test: erase by iterator, by key and by element; the element keeps its other links
+	ids.erase(ids.begin());
+	ids.erase(5);
+	users.erase(sessions[1]);
+	users.erase(users.iterator_to(sessions[7]));
+	std::cout << ids.erase(5) << " " << sessions[0].by_id.is_linked() << " " << sessions[0].by_user.is_linked() << std::endl;
+	print(ids);
+	print(users);
+	//	test: erased elements go back in at the end
+	ids.insert(sessions[0]);
+	users.insert(sessions[1]);
+	print(ids);
+	print(users);
+	auto it = ids.end();
+	--it;
+	std::cout << it->id << " " << (--it)->id << std::endl;
+	//	test: move and swap keep the links valid, clearing unlinks
+	IdTable moved(std::move(ids));
+	IdTable other;
+	other.swap(moved);
+	print(ids);
+	print(other);
+	other.clear();
+	std::cout << other.size() << " " << sessions[2].by_id.is_linked() << " " << sessions[2].by_user.is_linked() << std::endl;
+	//	test: a large table grows, and with reserve it never has to
+	std::vector<Session> many;
+	for (int i = 0; i < 100000; ++i) many.push_back(Session(i, ""));
+	IdTable big;
+	for (int i = 0; i < 100000; ++i) big.insert(many[i]);
+	for (int i = 0; i < 100000; i += 2) big.erase(many[i]);
+	bool ok = big.size() == 50000;
+	int last = -1;
+	for (auto &s : big) {
+		ok = ok && s.id > last && s.id % 2 == 1 && big.count(s.id);
+		last = s.id;
+	}
+	IdTable reserved;
+	reserved.reserve(100000);
+	size_t buckets = reserved.bucket_count();
+	for (int i = 0; i < 100000; i += 2) reserved.insert(many[i]);
+	std::cout << ok << " " << big.begin()->id << " " << (buckets == reserved.bucket_count()) << " " << reserved.size() << std::endl;
+}
+
+int main(void) {
+	tester();
+	return 0;
+}
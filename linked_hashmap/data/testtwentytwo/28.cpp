@@ -0,0 +1,107 @@
+#include "linked_hashmap.hpp"
+#include <iostream>
+#include <cassert>
+#include <string>
+
+class Integer {
+public:
+	static int counter;
+	int val;
+
+	Integer(int val) : val(val) {
+		counter++;
+	}
+
+	Integer(const Integer &rhs) {
+		val = rhs.val;
+		counter++;
+	}
+
+	Integer& operator = (const Integer &rhs) {
+		assert(false);
+	}
+
+	~Integer() {
+		counter--;
+	}
+};
+
+int Integer::counter = 0;
+
+class Equal {
+public:
+	bool operator () (const Integer &lhs, const Integer &rhs) const {
+		return lhs.val == rhs.val;
+	}
+};
+class Hash {
+public:
+	unsigned int operator () (const Integer &lhs) const {
+		return std::hash<int>()(lhs.val);
+	}
+};
+
+typedef sjtu::linked_hashmap<Integer, std::string, Hash, Equal> chained_map;
+typedef sjtu::linked_hashmap<Integer, std::string, Hash, Equal, sjtu::compact_storage> compact_map;
+
+template<class Map>
+bool in_order(const Map &m, int n) {
+	int expect = 0;
+	for (auto it = m.cbegin(); it != m.cend(); ++it, ++expect)
+		if (it->first.val != expect || it->second != std::to_string(expect)) return false;
+	return expect == n;
+}
+
+template<class Map>
+void rehashing(void) {
+	Map m;
+	//	a small map has no buckets until rehash asks for some
+	for (int i = 0; i < 5; ++i) m[Integer(i)] = std::to_string(i);
+	size_t small = m.bucket_count();
+	m.rehash(100);
+	std::cout << (small <= 16) << " " << m.bucket_count() << " " << in_order(m, 5) << " " << m.at(Integer(3)) << std::endl;
+	for (int i = 5; i < 1000; ++i) m[Integer(i)] = std::to_string(i);
+	//	growing keeps the order and every element
+	m.rehash(5000);
+	std::cout << m.bucket_count() << " " << in_order(m, 1000) << " " << (m.load_factor() < 0.25) << " ";
+	//	never fewer buckets than the elements need
+	m.rehash(1);
+	std::cout << m.bucket_count() << " " << (m.load_factor() <= 0.75) << " " << in_order(m, 1000) << " ";
+	for (int i = 0; i < 1000; ++i)
+		if (m.count(Integer(i)) != 1) std::cout << "lost " << i << " ";
+	std::cout << m.count(Integer(1000)) << std::endl;
+	//	the requested count is the floor for automatic shrinking
+	m.rehash(4096);
+	m.set_auto_shrink(true);
+	for (int i = 999; i >= 10; --i) m.erase(m.find(Integer(i)));
+	std::cout << m.bucket_count() << " " << in_order(m, 10) << " ";
+	m.rehash(0);
+	for (int i = 9; i >= 1; --i) m.erase(m.find(Integer(i)));
+	std::cout << (m.bucket_count() < 4096) << " " << in_order(m, 1) << " ";
+	m.clear();
+	m.rehash(64);
+	for (int i = 0; i < 40; ++i) m[Integer(i)] = std::to_string(i);
+	std::cout << m.bucket_count() << " " << in_order(m, 40) << std::endl;
+}
+
+void nodes_stay(void) {
+	//	chained nodes do not move, so iterators survive a rehash
+	chained_map m;
+	for (int i = 0; i < 100; ++i) m[Integer(i)] = std::to_string(i);
+	chained_map::iterator it = m.find(Integer(42));
+	const std::string *addr = &it->second;
+	m.rehash(8192);
+	std::cout << it->second << " " << (addr == &m.at(Integer(42))) << " ";
+	++it;
+	std::cout << it->first.val << " ";
+	m.rehash(1);
+	--it;
+	std::cout << it->first.val << " " << m.bucket_count() << std::endl;
+}
+
+int main(void) {
+	rehashing<chained_map>();
+	rehashing<compact_map>();
+	nodes_stay();
+	std::cout << Integer::counter << std::endl;
+}
@@ -0,0 +1,433 @@
+/**
+ * implement a linked_hashmap over elements that carry their own links
+ */
+#ifndef SJTU_INTRUSIVE_LINKEDHASHMAP_HPP
+#define SJTU_INTRUSIVE_LINKEDHASHMAP_HPP
+
+ // only for std::equal_to<T> and std::hash<T>
+#include <functional>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <memory>
+#include <type_traits>
+#include "utility.hpp"
+#include "exceptions.hpp"
+#include "linked_hashmap.hpp"
+
+namespace sjtu {
+
+	/**
+	 * the links an element embeds to sit in an intrusive_linked_hashmap: the chain
+	 *   of its bucket and the insertion list, plus the cached hash of its key.
+	 * a hook can be in one map at a time. an element may embed several hooks and sit
+	 *   in as many maps at once, each map naming its own hook.
+	 * copying an element does not copy its links: the copy starts outside every map.
+	 */
+	class intrusive_hashmap_hook {
+		template<class Key, class T, Key T::* KeyField, intrusive_hashmap_hook T::* Hook,
+			class Hash, class Equal, class Allocator>
+		friend class intrusive_linked_hashmap;
+
+		size_t hash;
+		intrusive_hashmap_hook* next;//同一个桶里的下一个
+		intrusive_hashmap_hook** link;//桶链上指向自己的那个指针 摘下时不用找前驱
+		intrusive_hashmap_hook* before, * after;//插入顺序 不在map里时before是nullptr
+	public:
+		intrusive_hashmap_hook() noexcept : hash(0), next(nullptr), link(nullptr), before(nullptr), after(nullptr) {}
+		intrusive_hashmap_hook(const intrusive_hashmap_hook&) noexcept : intrusive_hashmap_hook() {}
+		intrusive_hashmap_hook& operator=(const intrusive_hashmap_hook&) noexcept {
+			return *this;
+		}
+		/**
+		 * whether the element is in a map through this hook.
+		 */
+		bool is_linked() const noexcept {
+			return before != nullptr;
+		}
+	};
+
+	/**
+	 * a hash map of elements the caller owns, keyed by the member KeyField and
+	 *   linked through their member Hook, iterated in insertion order.
+	 *
+	 * the layout is that of linked_hashmap with chained_storage, the hook standing
+	 *   in for the node: full hashes cached, O(1) unlinking through the back pointer,
+	 *   a power of two of buckets doubled at LOAD_FACTOR. inserting links the element
+	 *   itself, so the only allocation is the bucket array when it grows; reserve()
+	 *   makes insert allocation-free. nothing is ever copied.
+	 * the map does not own its elements. an element must stay alive, and its key
+	 *   unchanged, for as long as it is linked; erase() or clear() unlinks it, and
+	 *   the destructor unlinks them all. iterators dereference to the elements.
+	 */
+	template<
+		class Key,
+		class T,
+		Key T::* KeyField,
+		intrusive_hashmap_hook T::* Hook,
+		class Hash = std::hash<Key>,
+		class Equal = std::equal_to<Key>,
+		class Allocator = std::allocator<T>
+	> class intrusive_linked_hashmap : private functor_holder<Hash, 0>, private functor_holder<Equal, 1> {
+	public:
+		typedef T value_type;
+		typedef Key key_type;
+	private:
+		typedef intrusive_hashmap_hook hook;
+		typedef typename std::allocator_traits<Allocator>::template rebind_alloc<hook*> bucket_allocator;
+		typedef std::allocator_traits<bucket_allocator> bucket_traits;
+
+		static constexpr float LOAD_FACTOR = 0.75;
+		static constexpr size_t MIN_CAPACITY = 16;
+
+		bucket_allocator alloc;
+		hook** cont;//第一次插入时才分配 之前是nullptr capacity是0
+		size_t capacity;
+		size_t len;
+		//两个哨兵就是成员本身
+		hook head, tail;
+
+		const Hash& hasher() const noexcept {
+			return functor_holder<Hash, 0>::functor();
+		}
+		const Equal& equal() const noexcept {
+			return functor_holder<Equal, 1>::functor();
+		}
+		//hook在T里的偏移 拿一个凑好对齐的假地址算 不会真的去读它
+		static size_t hook_offset() noexcept {
+			const uintptr_t fake = alignof(T) * 64;
+			const T* p = reinterpret_cast<const T*>(fake);
+			return reinterpret_cast<uintptr_t>(&(p->*Hook)) - fake;
+		}
+		static T* owner(hook* h) noexcept {
+			return reinterpret_cast<T*>(reinterpret_cast<char*>(h) - hook_offset());
+		}
+		//和linked_hashmap一样混合一次 std::hash对整数是恒等映射 低位不够散
+		size_t hash_of(const Key& k) const {
+			return hash_mix(hasher()(k));
+		}
+		size_t bucket(size_t h) const {
+			return h & (capacity - 1);
+		}
+		hook* locate(const Key& k, size_t h) const {
+			if (!cont) return nullptr;
+			hook* p = cont[bucket(h)];
+			while (p && (p->hash != h || !equal()(k, owner(p)->*KeyField))) p = p->next;
+			return p;
+		}
+		void chain(hook* p) {
+			hook** b = cont + bucket(p->hash);
+			p->next = *b;
+			if (*b) (*b)->link = &p->next;
+			p->link = b;
+			*b = p;
+		}
+		//桶数组换成newcap个桶 沿着插入顺序重新挂 新数组分配失败时什么都不变
+		void rebuild(size_t newcap) {
+			size_t c = MIN_CAPACITY;
+			while (c < newcap) c <<= 1;
+			if (c == capacity) return;
+			hook** b = bucket_traits::allocate(alloc, c);
+			for (size_t i = 0; i < c; i++) b[i] = nullptr;
+			if (cont) bucket_traits::deallocate(alloc, cont, capacity);
+			cont = b;
+			capacity = c;
+			for (hook* p = head.after; p != &tail; p = p->after) chain(p);
+		}
+		static size_t buckets_for(size_t n) {
+			return (size_t)((double)n / LOAD_FACTOR) + 1;
+		}
+		void unlink(hook* p) noexcept {
+			*p->link = p->next;
+			if (p->next) p->next->link = p->link;
+			p->before->after = p->after;
+			p->after->before = p->before;
+			p->next = p->before = p->after = nullptr;
+			p->link = nullptr;
+			len--;
+		}
+		void unlinkAll() noexcept {
+			for (hook* p = head.after, * q; p != &tail; p = q) {
+				q = p->after;
+				p->next = p->before = p->after = nullptr;
+				p->link = nullptr;
+			}
+			for (size_t i = 0; i < capacity; i++) cont[i] = nullptr;
+			head.after = &tail;
+			tail.before = &head;
+			len = 0;
+		}
+		//other的桶和元素整个接过来 other留下一张空表 桶里的link指向堆上的数组 不用改
+		void takeOver(intrusive_linked_hashmap& other) noexcept {
+			cont = other.cont;
+			capacity = other.capacity;
+			len = other.len;
+			if (len) {
+				head.after = other.head.after;
+				head.after->before = &head;
+				tail.before = other.tail.before;
+				tail.before->after = &tail;
+			}
+			else {
+				head.after = &tail;
+				tail.before = &head;
+			}
+			other.cont = nullptr;
+			other.capacity = other.len = 0;
+			other.head.after = &other.tail;
+			other.tail.before = &other.head;
+		}
+
+		template<bool Const>
+		class basic_iterator {
+			friend class intrusive_linked_hashmap;
+			template<bool> friend class basic_iterator;
+			typedef typename std::conditional<Const, const intrusive_linked_hashmap*, intrusive_linked_hashmap*>::type map_pointer;
+			map_pointer f;
+			hook* ptr;
+			basic_iterator(map_pointer ff, hook* pp) : f(ff), ptr(pp) {}
+		public:
+			using difference_type = std::ptrdiff_t;
+			using value_type = typename std::conditional<Const, const T, T>::type;
+			using pointer = value_type*;
+			using reference = value_type&;
+			using iterator_category = std::bidirectional_iterator_tag;
+
+			basic_iterator() : f(nullptr), ptr(nullptr) {}
+			//iterator可以转成const_iterator
+			template<bool C, class = typename std::enable_if<Const && !C>::type>
+			basic_iterator(const basic_iterator<C>& other) : f(other.f), ptr(other.ptr) {}
+
+			basic_iterator& operator++() {
+				if (!f || ptr == &f->tail) throw invalid_iterator();
+				ptr = ptr->after;
+				return *this;
+			}
+			basic_iterator operator++(int) {
+				basic_iterator tmp = *this;
+				++*this;
+				return tmp;
+			}
+			basic_iterator& operator--() {
+				if (!f || ptr->before == &f->head) throw invalid_iterator();
+				ptr = ptr->before;
+				return *this;
+			}
+			basic_iterator operator--(int) {
+				basic_iterator tmp = *this;
+				--*this;
+				return tmp;
+			}
+			/**
+			 * throw invalid_iterator at end().
+			 */
+			reference operator*() const {
+				if (!f || ptr == &f->tail) throw invalid_iterator();
+				return *owner(ptr);
+			}
+			pointer operator->() const {
+				return &**this;
+			}
+			template<bool C>
+			bool operator==(const basic_iterator<C>& rhs) const {
+				return ptr == rhs.ptr;
+			}
+			template<bool C>
+			bool operator!=(const basic_iterator<C>& rhs) const {
+				return ptr != rhs.ptr;
+			}
+		};
+
+	public:
+		typedef basic_iterator<false> iterator;
+		typedef basic_iterator<true> const_iterator;
+
+		intrusive_linked_hashmap() : intrusive_linked_hashmap(Hash()) {}
+		explicit intrusive_linked_hashmap(const Hash& hash, const Equal& eq = Equal())
+			: functor_holder<Hash, 0>(hash), functor_holder<Equal, 1>(eq), cont(nullptr), capacity(0), len(0) {
+			head.after = &tail;
+			tail.before = &head;
+		}
+		//元素只能挂在一张表上 不能复制
+		intrusive_linked_hashmap(const intrusive_linked_hashmap&) = delete;
+		intrusive_linked_hashmap& operator=(const intrusive_linked_hashmap&) = delete;
+		intrusive_linked_hashmap(intrusive_linked_hashmap&& other) noexcept
+			: functor_holder<Hash, 0>(other), functor_holder<Equal, 1>(other), alloc(other.alloc) {
+			takeOver(other);
+		}
+		/**
+		 * unlinks the current elements, then takes over those of other.
+		 */
+		intrusive_linked_hashmap& operator=(intrusive_linked_hashmap&& other) {
+			if (&other == this) return *this;
+			unlinkAll();
+			swap(other);
+			return *this;
+		}
+		/**
+		 * unlinks every element; the elements themselves are left alone.
+		 */
+		~intrusive_linked_hashmap() {
+			unlinkAll();
+			if (cont) bucket_traits::deallocate(alloc, cont, capacity);
+		}
+		/**
+		 * exchanges the contents with other in O(1). the elements stay where they are, but
+		 *   iterators taken before remain tied to the map they came from and must not be
+		 *   used with either map afterwards; iterator_to() gives a new one.
+		 */
+		void swap(intrusive_linked_hashmap& other) {
+			intrusive_linked_hashmap tmp(std::move(other));
+			other.takeOver(*this);
+			takeOver(tmp);
+			std::swap(alloc, other.alloc);
+			functor_holder<Hash, 0>::swap_functor(other);
+			functor_holder<Equal, 1>::swap_functor(other);
+		}
+
+		iterator begin() {
+			return iterator(this, head.after);
+		}
+		const_iterator begin() const {
+			return const_iterator(this, head.after);
+		}
+		const_iterator cbegin() const {
+			return begin();
+		}
+		iterator end() {
+			return iterator(this, &tail);
+		}
+		const_iterator end() const {
+			return const_iterator(this, const_cast<hook*>(&tail));
+		}
+		const_iterator cend() const {
+			return end();
+		}
+		bool empty() const {
+			return len == 0;
+		}
+		size_t size() const {
+			return len;
+		}
+		/**
+		 * the number of buckets, 0 before the first insertion.
+		 */
+		size_t bucket_count() const {
+			return capacity;
+		}
+		float load_factor() const {
+			return capacity ? (float)len / capacity : 0;
+		}
+		/**
+		 * makes room for n elements: no insertion allocates until there are more.
+		 */
+		void reserve(size_t n) {
+			if (buckets_for(n) > capacity) rebuild(buckets_for(n));
+		}
+		Hash hash_function() const {
+			return hasher();
+		}
+		Equal key_eq() const {
+			return equal();
+		}
+
+		/**
+		 * links x at the back of the insertion order if no element has an equal key.
+		 * returns an iterator to x, or to the element that prevented the insertion
+		 *   (x is then left unlinked), and whether x was inserted.
+		 * allocates only when the bucket array has to grow; if that throws, nothing changes.
+		 * throw runtime_error if x is already linked through Hook, into this map or another.
+		 */
+		pair<iterator, bool> insert(T& x) {
+			hook* p = &(x.*Hook);
+			if (p->is_linked()) throw runtime_error();
+			size_t h = hash_of(x.*KeyField);
+			if (hook* q = locate(x.*KeyField, h)) return pair<iterator, bool>(iterator(this, q), false);
+			if (len + 1 > capacity * LOAD_FACTOR) rebuild(capacity ? capacity * 2 : MIN_CAPACITY);
+			p->hash = h;
+			chain(p);
+			p->before = tail.before;
+			p->after = &tail;
+			tail.before->after = p;
+			tail.before = p;
+			len++;
+			return pair<iterator, bool>(iterator(this, p), true);
+		}
+
+		/**
+		 * unlinks the element at pos in O(1) and returns the iterator after it.
+		 * throw invalid_iterator if pos is end() or belongs to another map.
+		 */
+		iterator erase(const_iterator pos) {
+			if (pos.f != this || pos.ptr == &tail) throw invalid_iterator();
+			hook* next = pos.ptr->after;
+			unlink(pos.ptr);
+			return iterator(this, next);
+		}
+		/**
+		 * unlinks the element with key k, if any. returns the number unlinked.
+		 */
+		size_t erase(const Key& k) {
+			hook* p = locate(k, hash_of(k));
+			if (!p) return 0;
+			unlink(p);
+			return 1;
+		}
+		/**
+		 * unlinks x, which must be linked into this map, in O(1) without hashing.
+		 * throw runtime_error if x is not linked through Hook at all.
+		 */
+		void erase(T& x) {
+			hook* p = &(x.*Hook);
+			if (!p->is_linked()) throw runtime_error();
+			unlink(p);
+		}
+		/**
+		 * unlinks every element in O(n). the bucket array is kept.
+		 */
+		void clear() {
+			unlinkAll();
+		}
+
+		/**
+		 * the iterator to x, which must be linked into this map. O(1).
+		 */
+		iterator iterator_to(T& x) {
+			return iterator(this, &(x.*Hook));
+		}
+		const_iterator iterator_to(const T& x) const {
+			return const_iterator(this, const_cast<hook*>(&(x.*Hook)));
+		}
+
+		iterator find(const Key& k) {
+			hook* p = locate(k, hash_of(k));
+			return iterator(this, p ? p : &tail);
+		}
+		const_iterator find(const Key& k) const {
+			hook* p = locate(k, hash_of(k));
+			return const_iterator(this, p ? p : const_cast<hook*>(&tail));
+		}
+		size_t count(const Key& k) const {
+			return locate(k, hash_of(k)) ? 1 : 0;
+		}
+		bool contains(const Key& k) const {
+			return locate(k, hash_of(k)) != nullptr;
+		}
+		/**
+		 * throw index_out_of_bound if k is absent.
+		 */
+		T& at(const Key& k) {
+			hook* p = locate(k, hash_of(k));
+			if (!p) throw index_out_of_bound();
+			return *owner(p);
+		}
+		const T& at(const Key& k) const {
+			hook* p = locate(k, hash_of(k));
+			if (!p) throw index_out_of_bound();
+			return *owner(p);
+		}
+	};
+
+}
+
+#endif
@@ -6,9 +6,20 @@
 
  // only for std::equal_to<T> and std::hash<T>
 #include <functional>
+#include <atomic>
+#include <chrono>
+#include <random>
 #include <cstddef>
+#include <memory>
+#include <cstdint>
+#include <cstring>
+#include <istream>
+#include <ostream>
+#include <type_traits>
+#include <vector>
 #include "utility.hpp"
 #include "exceptions.hpp"
+#include "node_pool.hpp"
 
 namespace sjtu {
 	/**
@@ -19,14 +30,207 @@ namespace sjtu {
 	 *
 	 * Note that insertion order is not affected if a key is re-inserted
 	 * into the map.
+	 *
+	 * With chained_storage the list can also be kept in access order and the
+	 *   size bounded, which turns the map into an LRU cache:
+	 *   set_access_order(true) moves every element hit by a non-const lookup to
+	 *   the back in O(1), and set_max_size(n) evicts from the front once the map
+	 *   holds more than n elements, calling the eviction callback first.
+	 */
+
+	/**
+	 * storage policies of linked_hashmap, selected by the Storage template argument.
+	 *
+	 * chained_storage (default): every entry is a heap node, chained into its
+	 *   bucket and into the doubly-linked insertion list.
+	 * compact_storage: an open-addressing table of 32-bit slots indexing a dense
+	 *   entry array kept in insertion order, like CPython's compact dict.
+	 *   A lookup touches one small slot plus one entry and iteration is a linear
+	 *   scan, but growing the entry array moves the elements, so references and
+	 *   pointers into the map (not iterators) are invalidated by insert().
+	 *   Iterators hold entry positions, and erased entries stay behind as holes.
+	 *   rehash(), reserve(), shrink_to_fit(), compact() and set_hash_seed() squeeze
+	 *   the holes out and invalidate iterators. So does an insert() that finds the
+	 *   entry array full while more than half of it is holes, so that a map which
+	 *   keeps erasing and inserting stays proportional to size(); otherwise insert()
+	 *   and erase() keep every position.
+	 */
+	struct chained_storage {};
+	struct compact_storage {};
+
+	/**
+	 * the mixing stage between Hash and the table: the 64-bit finalizer of
+	 *   MurmurHash3 applied to h ^ seed. every output bit depends on every input bit,
+	 *   so keys whose hashes differ only in the high bits (std::hash is the identity
+	 *   on integers) still spread over a power-of-two table.
+	 * with a secret seed, which keys share a bucket can no longer be predicted from
+	 *   the keys alone. keys whose Hash values are equal still collide, whatever the seed.
+	 */
+	inline size_t hash_mix(size_t h, size_t seed = 0) {
+		unsigned long long x = (unsigned long long)h ^ (unsigned long long)seed;
+		x ^= x >> 33;
+		x *= 0xff51afd7ed558ccdull;
+		x ^= x >> 33;
+		x *= 0xc4ceb9fe1a85ec53ull;
+		x ^= x >> 33;
+		return (size_t)x;
+	}
+	/**
+	 * a fresh seed for hash_mix. the first call draws from std::random_device,
+	 *   later calls step from there, so every call returns a different value. thread-safe.
+	 */
+	inline size_t random_hash_seed() {
+		static std::atomic<unsigned long long> next(((unsigned long long)std::random_device()() << 32)
+			^ std::random_device()() ^ (unsigned long long)std::chrono::steady_clock::now().time_since_epoch().count());
+		return hash_mix((size_t)next.fetch_add(0x9E3779B97F4A7C15ull, std::memory_order_relaxed));
+	}
+
+	/**
+	 * compile-time switches of linked_hashmap, the template argument after Allocator.
+	 * derive from default_hashmap_policy and override only the flags you need.
+	 */
+	struct default_hashmap_policy {
+		// count lookups, probes, rehashes and allocations, read back with stats().
+		//   when off the counters are not even compiled in
+		static constexpr bool stats = false;
+		// pass every Hash() through hash_mix before it picks a bucket. turn off only
+		//   for a Hash whose low bits are already well distributed
+		static constexpr bool mix_hash = true;
+		// seed every new map with random_hash_seed() instead of 0, against inputs
+		//   chosen to collide. the seed does not change the iteration order
+		static constexpr bool random_seed = false;
+	};
+	struct hashmap_stats_policy : default_hashmap_policy {
+		static constexpr bool stats = true;
+	};
+	/**
+	 * what linked_hashmap::stats() returns. the counters run from construction or reset_stats().
+	 *
+	 * probes counts the keys inspected by all lookups (chained_storage: nodes of the
+	 *   chain, compact_storage: slots of the probe sequence). rehash_ns is the time spent
+	 *   rebuilding the bucket array, without the steps of an incremental rehash.
+	 * node_allocations counts the elements created, not the moves of a rebuild.
+	 * max_chain and average_chain are measured on each stats() call: the longest and the
+	 *   mean length of the non-empty chains, or for compact_storage the probe sequence
+	 *   lengths of the stored keys.
+	 */
+	struct hashmap_stats {
+		unsigned long long lookups = 0;
+		unsigned long long probes = 0;
+		unsigned long long rehashes = 0;
+		unsigned long long rehash_ns = 0;
+		unsigned long long node_allocations = 0;
+		size_t max_chain = 0;
+		double average_chain = 0;
+	};
+
+	/**
+	 * the stream format of linked_hashmap::save() and load().
+	 *
+	 * a 64-byte header, then one record per element in iteration order: the stored hash
+	 *   as 64 bits, then the bytes of pair<const Key, T> as they sit in memory.
+	 * the header records the element sizes and the byte order, which load() checks, and
+	 *   the bucket count and hash seed, so that load() sizes the table once and keeps the
+	 *   stored hashes instead of hashing every key again.
 	 */
+	struct hashmap_file_header {
+		char magic[8];
+		uint32_t version;
+		uint32_t byte_order;//按写入机器的字节序存的0x01020304
+		uint32_t key_size;
+		uint32_t mapped_size;
+		uint32_t entry_size;
+		uint32_t mixed;//存的hash是否经过了hash_mix
+		uint64_t seed;
+		uint64_t count;
+		uint64_t buckets;
+		unsigned char reserved[8];
+	};
+	static_assert(sizeof(hashmap_file_header) == 64, "the header is 64 bytes in the stream");
+
+	//两种存储共用的分块读写 一块64KB左右 流再大也只占一块的内存
+	template<class Key, class T>
+	class hashmap_records {
+	public:
+		typedef pair<const Key, T> value_type;
+		static_assert(std::is_trivially_copyable<Key>::value && std::is_trivially_copyable<T>::value,
+			"save and load need trivially copyable keys and values");
+		static constexpr size_t RECORD = sizeof(uint64_t) + sizeof(value_type);
+		static constexpr size_t CHUNK = 65536 / RECORD + 1;
+	private:
+		static constexpr uint32_t VERSION = 1;
+		static constexpr uint32_t ORDER_MARK = 0x01020304;
+		std::unique_ptr<char[]> buf;
+		size_t n;//块里的记录数
+		size_t left;//读的时候 流里还剩的记录数
+	public:
+		hashmap_file_header header;
+
+		hashmap_records() : buf(new char[CHUNK * RECORD]), n(0), left(0) {}
+		void start(std::ostream& out, size_t count, size_t buckets, bool mixed, size_t seed) {
+			std::memset(&header, 0, sizeof(header));
+			std::memcpy(header.magic, "SJTULHM", 8);
+			header.version = VERSION;
+			header.byte_order = ORDER_MARK;
+			header.key_size = sizeof(Key);
+			header.mapped_size = sizeof(T);
+			header.entry_size = sizeof(value_type);
+			header.mixed = mixed;
+			header.seed = seed;
+			header.count = count;
+			header.buckets = buckets;
+			out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+		}
+		void put(std::ostream& out, size_t h, const value_type& v) {
+			uint64_t h64 = h;
+			char* r = buf.get() + n * RECORD;
+			std::memcpy(r, &h64, sizeof(h64));
+			std::memcpy(r + sizeof(h64), &v, sizeof(value_type));
+			if (++n == CHUNK) flush(out);
+		}
+		void flush(std::ostream& out) {
+			if (n) out.write(buf.get(), (std::streamsize)(n * RECORD));
+			n = 0;
+			if (!out) throw runtime_error();
+		}
+		//读头并检查 不是同样类型写出的流就抛runtime_error
+		void open(std::istream& in) {
+			in.read(reinterpret_cast<char*>(&header), sizeof(header));
+			if (!in || std::memcmp(header.magic, "SJTULHM", 8) != 0 || header.version != VERSION
+				|| header.byte_order != ORDER_MARK || header.key_size != sizeof(Key)
+				|| header.mapped_size != sizeof(T) || header.entry_size != sizeof(value_type))
+				throw runtime_error();
+			left = (size_t)header.count;
+		}
+		//读下一块 返回其中的记录数 读完返回0 流提前结束就抛runtime_error
+		size_t next(std::istream& in) {
+			n = left < CHUNK ? left : CHUNK;
+			if (!n) return 0;
+			in.read(buf.get(), (std::streamsize)(n * RECORD));
+			if ((size_t)in.gcount() != n * RECORD) throw runtime_error();
+			left -= n;
+			return n;
+		}
+		size_t hash(size_t i) const {
+			uint64_t h64;
+			std::memcpy(&h64, buf.get() + i * RECORD, sizeof(h64));
+			return (size_t)h64;
+		}
+		//把第i条的值直接拷进结点的存储 value_type可平凡复制 拷完就是一个活的对象
+		void copy_value(size_t i, void* dst) const {
+			std::memcpy(dst, buf.get() + i * RECORD + sizeof(uint64_t), sizeof(value_type));
+		}
+	};
 
 	template<
 		class Key,
 		class T,
 		class Hash = std::hash<Key>,
-		class Equal = std::equal_to<Key>
-	> class linked_hashmap {
+		class Equal = std::equal_to<Key>,
+		class Storage = chained_storage,
+		class Allocator = std::allocator<pair<const Key, T>>,
+		class Policy = default_hashmap_policy
+	> class linked_hashmap : private functor_holder<Hash, 0>, private functor_holder<Equal, 1> {
 	public:
 		/**
 		 * the internal type of data.
@@ -35,22 +239,31 @@ namespace sjtu {
 		 */
 		typedef pair<const Key, T> value_type;
 	private:
+		//head tail两个哨兵只有node部分 真正的元素是value_node value就存在结点里
 		struct node {
-			value_type* data;
+			size_t hash;//完整的hash值 rehash和erase都不用再算 也能在比较key之前先筛掉
 			node* next, * before, * after;//next指向映射到相同位置的下一元素 before after是指向插入顺序前后的元素用于迭代
-			node() :data(nullptr), next(nullptr), before(nullptr), after(nullptr) {}
-			// 引用就不需要拷贝一份数据过来 const防止修改原值
-			node(const value_type& x, node* n = nullptr, node* b = nullptr, node* a = nullptr) :next(n), before(b), after(a) {
-				data = (value_type*)malloc(sizeof(value_type));
-				new(data) value_type(x.first, x.second);
-			}
-			~node() {
-				if (data) {
-					//对储存内容的对象手动调用析构函数
-					data->first.~Key();
-					data->second.~T();
-					free(data);
-				}
+			node** link;//桶链上指向自己的那个指针(桶头或者前一个结点的next) 摘下时不用找前驱
+			node() :hash(0), next(nullptr), before(nullptr), after(nullptr), link(nullptr) {}
+			node(size_t h, node* n, node* b, node* a) :hash(h), next(n), before(b), after(a), link(nullptr) {}
+			//只能在非哨兵结点上调用
+			value_type* data() {
+				return reinterpret_cast<value_type*>(static_cast<struct value_node*>(this)->storage);
+			}
+		};
+		struct value_node : node {
+			alignas(value_type) unsigned char storage[sizeof(value_type)];
+			//args原样转发给value_type的构造函数 直接在结点里构造
+			template<class... Args>
+			value_node(size_t h, Args&&... args) :node(h, nullptr, nullptr, nullptr) {
+				new(storage) value_type(std::forward<Args>(args)...);
+			}
+			//load用 调用者随后把值的字节拷进storage
+			struct raw_t {};
+			value_node(size_t h, raw_t) :node(h, nullptr, nullptr, nullptr) {}
+			~value_node() {
+				//对储存内容的对象手动调用析构函数
+				reinterpret_cast<value_type*>(storage)->~value_type();
 			}
 		};
 
@@ -64,40 +277,347 @@ namespace sjtu {
 			~BucketList() = default;
 			void insert(node* n) {
 				n->next = head;
-				head->next = n;
+				if (head) head->link = &n->next;
+				n->link = &head;
+				head = n;
 			}
-			void erase(const Key& k) {
-
-
+			//把结点n从它所在的链上摘下来 O(1) 不释放
+			static void erase(node* n) {
+				*n->link = n->next;
+				if (n->next) n->next->link = n->link;
 			}
 			//const函数 不修改成员状态或者调用非常函数
-			node* find(const Key& k) const {
+			//hash不同的结点直接跳过 只有hash相同才调用Equal
+			template<class K>
+			node* find(const K& k, size_t h, const Equal& eq) const {
 				node* p = head;
-				while (p && !Equal()(k, p->data->first))p = p->next;
+				while (p && (p->hash != h || !eq(k, p->data()->first)))p = p->next;
 				return p;
 			}
 
 		};
+		typedef typename std::allocator_traits<Allocator>::template rebind_alloc<BucketList> bucket_allocator;
+
+		//结点从pool里拿 删除时回到空闲链表 clear和析构时整块slab一起释放
+		typedef node_pool<value_node, Allocator> pool_type;
+		pool_type pool;
+		//不超过SMALL_MAX个元素时没有桶数组 cont是nullptr capacity是0 查找直接沿插入顺序扫
+		//第一次超过时才分配桶数组 之后只有shrink_to_fit会退回 结点一直在pool里 引用和迭代器都不受影响
 		BucketList* cont;
 		static constexpr float LOAD_FACTOR = 0.75;
+		static constexpr size_t MIN_CAPACITY = 1024;
+		static constexpr size_t SMALL_MAX = 8;
+		static constexpr size_t REHASH_STEP = 8;//渐进rehash时每次写操作搬的旧桶数
+		static constexpr size_t BATCH = 16;//批量查找时一起预取的key数
 		size_t capacity;
 		size_t len;
-		int capp;
+		size_t min_capacity;//reserve过的容量 自动缩容不会低于它
+		bool auto_shrink;
+		bool access_order;//查找命中时把结点挪到末尾 链表就变成访问顺序
+		size_t max_len;//0表示不限
+		std::function<void(value_type&)> on_evict;
+		bool incremental;
+		//渐进rehash时还没搬完的旧桶数组 不在迁移时是nullptr
+		//旧桶下标小于migrated的key都在新数组里 其余的都还在旧数组里 新插入的也一样
+		//所以新数组的桶在对应的旧桶搬过来时才需要清空 分配新数组不用整个扫一遍
+		BucketList* old_cont;
+		size_t old_capacity;
+		size_t migrated;
+		//两个哨兵就是成员本身 head tail一直指向它们 不单独分配
+		node head_end, tail_end;
 		node* head, * tail;//迭代用的将元素按照插入顺序储存的双链表 的两个哨兵
+		static constexpr bool STATS = Policy::stats;
+		//值不需要析构时 clear和析构不用沿链表走一遍
+		static constexpr bool TRIVIAL_DESTROY = std::is_trivially_destructible<value_type>::value;
+		struct NoStats {};
+		//查找是const函数 也要计数
+		mutable typename std::conditional<STATS, hashmap_stats, NoStats>::type counters;
+		size_t seed;
+
+		//Hash和Equal存在基类里 空的不占空间 也不用每次调用都现造一个
+		const Hash& hasher() const noexcept {
+			return functor_holder<Hash, 0>::functor();
+		}
+		const Equal& equal() const noexcept {
+			return functor_holder<Equal, 1>::functor();
+		}
+		//结点里存的和桶下标用的都是混合过的hash
+		template<class K>
+		size_t hash_of(const K& key) const {
+			if constexpr (Policy::mix_hash) return hash_mix(hasher()(key), seed);
+			else return hasher()(key);
+		}
 
-		//五个素数作为哈希表的容量 选素数碰撞概率小
-		static constexpr size_t mod[5] = { 1009,10007,100003,1000003,10000019 };
-		void resize() {
-			if (capp == 4)return;
-			capp++;
-			capacity = mod[capp];
-			//删除给cont分配的一对bucketlist的内存，node没有删除
-			delete[]cont;
-			cont = new BucketList[capacity];
+		//容量取2的幂 下标用 hash & (capacity - 1) 代替取模 每次扩容翻倍 没有上限
+		//低位够不够散由hash_mix保证
+		static size_t round_up(size_t x) {
+			size_t c = MIN_CAPACITY;
+			while (c < x) c <<= 1;
+			return c;
+		}
+		BucketList* new_buckets(size_t n, bool clear = true) {
+			bucket_allocator a(pool.get_allocator());
+			BucketList* b = std::allocator_traits<bucket_allocator>::allocate(a, n);
+			if (clear) for (size_t i = 0; i < n; i++) b[i].head = nullptr;
+			return b;
+		}
+		void delete_buckets(BucketList* b, size_t n) {
+			bucket_allocator a(pool.get_allocator());
+			std::allocator_traits<bucket_allocator>::deallocate(a, b, n);
+		}
+		template<class... Args>
+		node* create_node(size_t h, Args&&... args) {
+			if constexpr (STATS) counters.node_allocations++;
+			void* mem = pool.allocate();
+			try {
+				return new(mem) value_node(h, std::forward<Args>(args)...);
+			}
+			catch (...) {
+				pool.deallocate(mem);
+				throw;
+			}
+		}
+		void destroy_node(node* p) {
+			static_cast<value_node*>(p)->~value_node();
+			pool.deallocate(p);
+		}
+		//析构所有元素 然后把pool的slab整块还掉 不逐个释放结点
+		void destroy_all() {
+			if (!TRIVIAL_DESTROY)
+				for (node* p = head->after; p != tail; p = p->after)
+					static_cast<value_node*>(p)->~value_node();
+			pool.release();
+		}
+		//元素和结点都已经没了 桶和链表回到空表的样子
+		void forget_all() {
+			for (size_t i = 0; i < capacity; i++)cont[i].head = nullptr;
+			if (old_cont) {
+				delete_buckets(old_cont, old_capacity);
+				old_cont = nullptr;
+			}
+			head->after = tail;
+			tail->before = head;
+			len = 0;
+		}
+		//插入顺序的链表切成4 * threads段 每段交给一个线程 对每个结点调用fn
+		//结点大多按插入顺序从slab里分配 顺着链表走访存是连续的 比按桶走快得多
+		//切点要先串行走一遍链表找出来 只有一个线程时直接走
+		//fn可以析构结点里的值 下一个结点在调用fn之前就取好了
+		template<class Fn>
+		void parallel_nodes(size_t threads, Fn fn) const {
+			threads = thread_count(threads);
+			auto walk = [&fn](node* p, node* stop) {
+				for (node* q; p != stop; p = q) {
+					q = p->after;
+					fn(p);
+				}
+			};
+			if (threads == 1 || len <= SMALL_MAX) {
+				walk(head->after, tail);
+				return;
+			}
+			std::vector<node*> cuts;
+			size_t step = len / (4 * threads) + 1, k = 0;
+			for (node* p = head->after; p != tail; p = p->after)
+				if (k++ % step == 0) cuts.push_back(p);
+			cuts.push_back(tail);
+			parallel_run(cuts.size() - 1, threads, [&](size_t i) { walk(cuts[i], cuts[i + 1]); });
+		}
+		//新结点挂进桶里 接到插入顺序的末尾
+		void link_node(node* p) {
+			if (cont) {
+				rehash_step();
+				chain(p->hash).insert(p);
+			}
+			p->before = tail->before;
+			p->after = tail;
+			tail->before->after = p;
+			tail->before = p;
+			len++;
+		}
+		//只改前后指针 桶和迭代器都不受影响
+		void move_to_back(node* p) {
+			if (p->after == tail) return;
+			p->before->after = p->after;
+			p->after->before = p->before;
+			p->before = tail->before;
+			p->after = tail;
+			tail->before->after = p;
+			tail->before = p;
+		}
+		node* touch(node* p) {
+			if (access_order) move_to_back(p);
+			return p;
+		}
+		//从桶和链表里摘下结点并销毁 不用算hash也不用沿桶链找 O(1)
+		void erase_node(node* p) {
+			if (cont) {
+				BucketList::erase(p);
+				rehash_step();
+			}
+			p->before->after = p->after;
+			p->after->before = p->before;
+			destroy_node(p);
+			len--;
+		}
+		//超过max_len就从最早的一端淘汰 回调抛异常时那个元素留着
+		void evict_if_needed() {
+			while (max_len && len > max_len) {
+				node* p = head->after;
+				if (on_evict) on_evict(*p->data());
+				erase_node(p);
+			}
+		}
+		size_t bucket(size_t h) const {
+			return h & (capacity - 1);
+		}
+		//hash为h的元素所在的链 迁移中要看它的旧桶搬过没有
+		BucketList& chain(size_t h) const {
+			if (old_cont) {
+				size_t b = h & (old_capacity - 1);
+				if (b >= migrated) return old_cont[b];
+			}
+			return cont[bucket(h)];
+		}
+		//没有桶数组时整张表就是一条链 同样先比hash
+		template<class K>
+		node* scan(const K& key, size_t h) const {
 			for (node* p = head->after; p != tail; p = p->after) {
-				cont[Hash()(p->data->first) % capacity].insert(p);
+				if constexpr (STATS) counters.probes++;
+				if (p->hash == h && equal()(key, p->data()->first)) return p;
+			}
+			return nullptr;
+		}
+		template<class K>
+		node* locate(const K& key, size_t h) const {
+			if constexpr (STATS) counters.lookups++;
+			if (!cont) return scan(key, h);
+			if constexpr (STATS) {
+				node* p = chain(h).head;
+				for (; p; p = p->next) {
+					counters.probes++;
+					if (p->hash == h && equal()(key, p->data()->first)) break;
+				}
+				return p;
+			}
+			else return chain(h).find(key, h, equal());
+		}
+		//批量查找分三趟 先算一组key的hash并预取各自的桶 再读桶头预取链上第一个结点
+		//最后才逐个比较 前两趟的缓存缺失互相重叠 结果按输入顺序交给emit
+		template<class It, class Emit>
+		void locate_batch(It first, It last, Emit emit) const {
+			It keys[BATCH];
+			size_t h[BATCH];
+			if (!cont) {
+				for (; first != last; ++first) emit(locate(*first, hash_of(*first)));
+				return;
+			}
+			while (first != last) {
+				size_t n = 0;
+				for (; n < BATCH && first != last; ++first, ++n) {
+					keys[n] = first;
+					h[n] = hash_of(*first);
+					prefetch(&chain(h[n]));
+				}
+				for (size_t i = 0; i < n; i++)
+					if (node* p = chain(h[i]).head) prefetch(p);
+				for (size_t i = 0; i < n; i++) emit(locate(*keys[i], h[i]));
+			}
+		}
+		//把旧数组接下来的n个桶挂到新数组 搬完就释放旧数组
+		//旧桶i的元素只会去新桶 i, i + old_capacity, ... 先把它们清空
+		void rehash_step(size_t n = REHASH_STEP) {
+			for (; old_cont && n; n--) {
+				for (size_t j = migrated; j < capacity; j += old_capacity) cont[j].head = nullptr;
+				node* p = old_cont[migrated].head;
+				while (p) {
+					node* q = p->next;
+					cont[bucket(p->hash)].insert(p);
+					p = q;
+				}
+				old_cont[migrated].head = nullptr;
+				if (++migrated == old_capacity) {
+					delete_buckets(old_cont, old_capacity);
+					old_cont = nullptr;
+				}
+			}
+		}
+		void finish_rehash() {
+			if (old_cont) rehash_step(old_capacity - migrated);
+		}
+		//装下n个元素且负载不超过LOAD_FACTOR所需要的桶数
+		static size_t buckets_for(size_t n) {
+			return (size_t)((double)n / LOAD_FACTOR) + 1;
+		}
+		void resize(size_t newcap) {
+			if constexpr (STATS) {
+				std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+				size_t before = capacity;
+				rebuild(newcap);
+				if (capacity != before) {
+					counters.rehashes++;
+					counters.rehash_ns += (unsigned long long)std::chrono::duration_cast<std::chrono::nanoseconds>(
+						std::chrono::steady_clock::now() - t0).count();
+				}
+			}
+			else rebuild(newcap);
+		}
+		//把桶数组换成newcap个桶 node不动 只沿着插入顺序重新挂到新的桶里
+		//渐进模式下只换上新数组 旧数组留着 之后每次写操作搬一点
+		void rebuild(size_t newcap) {
+			newcap = round_up(newcap);
+			finish_rehash();
+			if (newcap == capacity) return;
+			if (incremental && cont) {
+				BucketList* b = new_buckets(newcap, false);
+				old_cont = cont;
+				old_capacity = capacity;
+				migrated = 0;
+				cont = b;
+				capacity = newcap;
+				return;
+			}
+			if (cont) delete_buckets(cont, capacity);
+			capacity = newcap;
+			cont = new_buckets(capacity);
+			for (node* p = head->after; p != tail; p = p->after) {
+				cont[bucket(p->hash)].insert(p);
+			}
+		}
+		//插入前调用 超过负载就扩容到两倍 小表超过SMALL_MAX时建桶数组
+		void grow_if_needed() {
+			if (!cont) {
+				if (len + 1 > SMALL_MAX) resize(min_capacity);
+			}
+			else if (len + 1 > capacity * LOAD_FACTOR) resize(capacity * 2);
+		}
+		//把[first, last]这段元素接到自己的哨兵之间 first为nullptr表示没有元素
+		void attach(node* first, node* last) {
+			if (!first) {
+				head->after = tail;
+				tail->before = head;
+				return;
+			}
+			head->after = first;
+			first->before = head;
+			tail->before = last;
+			last->after = tail;
+		}
+		//删除后调用 负载低于LOAD_FACTOR/4才缩到一半 留出滞后区间避免反复扩缩
+		void shrink_if_needed() {
+			if (!auto_shrink || capacity <= min_capacity) return;
+			if (len < capacity * (LOAD_FACTOR / 4)) {
+				size_t target = capacity / 2;
+				if (target < min_capacity) target = min_capacity;
+				resize(target);
+			}
+		}
+		//批量删除后一直缩到不再变 和逐个erase的结果一样
+		void shrink_after_erasing() {
+			for (size_t c = 0; c != capacity;) {
+				c = capacity;
+				shrink_if_needed();
 			}
-
 		}
 
 	public:
@@ -156,7 +676,7 @@ namespace sjtu {
 				if (ptr == f->tail)throw invalid_iterator();
 				node* pre = ptr;
 				ptr = ptr->after;
-				return iterator(f, ptr);
+				return iterator(f, pre);
 			}
 			/**
 			 * TODO ++iter
@@ -175,7 +695,7 @@ namespace sjtu {
 				if (ptr == f->head->after)throw invalid_iterator();
 				node* pre = ptr;
 				ptr = ptr->before;
-				return iterator(f, ptr);
+				return iterator(f, pre);
 			}
 			/**
 			 * TODO --iter
@@ -189,9 +709,9 @@ namespace sjtu {
 			 * a operator to check whether two iterators are same (pointing to the same memory).
 			 */
 			value_type& operator*() const {
-				if (!ptr->data)throw invalid_iterator();
+				if (ptr == f->tail || ptr == f->head)throw invalid_iterator();
 				//记得解引用
-				return *(this->ptr->data);
+				return *(this->ptr->data());
 			}
 			bool operator==(const iterator& rhs) const {
 				return f == rhs.f && ptr == rhs.ptr;
@@ -214,7 +734,7 @@ namespace sjtu {
 			 * See <http://kelvinh.github.io/blog/2013/11/20/overloading-of-member-access-operator-dash-greater-than-symbol-in-cpp/> for help.
 			 */
 			value_type* operator->() const noexcept {
-				return ptr->data;
+				return ptr->data();
 			}
 		};
 
@@ -275,8 +795,8 @@ namespace sjtu {
 			 */
 			 //第一个const表示返回值不可被修改 体现const iter 第二个const表示这个函数不会修改自己
 			const value_type& operator*() const {
-				if (!ptr->data) throw invalid_iterator();
-				return *(ptr->data);
+				if (ptr == f->tail || ptr == f->head) throw invalid_iterator();
+				return *(ptr->data());
 			}
 			bool operator==(const iterator& rhs) const {
 				return ptr == rhs.ptr && f == rhs.f;
@@ -299,36 +819,56 @@ namespace sjtu {
 			 * See <http://kelvinh.github.io/blog/2013/11/20/overloading-of-member-access-operator-dash-greater-than-symbol-in-cpp/> for help.
 			 */
 			const value_type* operator->() const noexcept {
-				return ptr->data;
+				return ptr->data();
 			}
 		};
 
 		/**
 		 * TODO two constructors
 		 */
-		linked_hashmap() {
+		linked_hashmap() : linked_hashmap(Hash()) {}
+		/**
+		 * an empty map hashing with a copy of hash and comparing keys with a copy of equal.
+		 */
+		explicit linked_hashmap(const Hash& hash, const Equal& equal = Equal())
+			: functor_holder<Hash, 0>(hash), functor_holder<Equal, 1>(equal) {
 			len = 0;
-			capp = 0;
-			capacity = mod[capp];
-			head = new node();
-			tail = new node();
+			capacity = 0;
+			min_capacity = MIN_CAPACITY;
+			auto_shrink = false;
+			access_order = false;
+			max_len = 0;
+			incremental = false;
+			old_cont = nullptr;
+			old_capacity = migrated = 0;
+			seed = Policy::random_seed ? random_hash_seed() : 0;
+			head = &head_end;
+			tail = &tail_end;
 			head->after = tail;
 			tail->before = head;
-			cont = new BucketList[capacity];
+			cont = nullptr;
 		}
-		linked_hashmap(const linked_hashmap& other) {
-			capp = other.capp;
+		linked_hashmap(const linked_hashmap& other)
+			: functor_holder<Hash, 0>(other), functor_holder<Equal, 1>(other), pool(other.pool), on_evict(other.on_evict) {
 			capacity = other.capacity;
+			min_capacity = other.min_capacity;
+			auto_shrink = other.auto_shrink;
+			access_order = other.access_order;
+			max_len = other.max_len;
+			incremental = other.incremental;
+			old_cont = nullptr;
+			old_capacity = migrated = 0;
+			seed = other.seed;
 			len = other.len;
-			cont = new BucketList[capacity];
-			head = new node();
-			tail = new node();
+			cont = other.cont ? new_buckets(capacity) : nullptr;
+			head = &head_end;
+			tail = &tail_end;
 			node* cur;
 			node* p;
-			for (p = other.head->after, cur = this->head; p != tail; p = p->after, cur = cur->after) {
-				size_t hashcode = Hash()(p->data->first) % capacity;
-				cur->after = new node(*(p->data), nullptr, cur, nullptr);
-				cont[hashcode].insert(cur->after);
+			for (p = other.head->after, cur = this->head; p != other.tail; p = p->after, cur = cur->after) {
+				cur->after = create_node(p->hash, *(p->data()));
+				cur->after->before = cur;
+				if (cont) cont[bucket(p->hash)].insert(cur->after);
 			}
 			cur->after = tail;
 			tail->before = cur;
@@ -340,39 +880,81 @@ namespace sjtu {
 		linked_hashmap& operator=(const linked_hashmap& other) {
 			if (&other == this)return *this;
 			clear();
-			delete[]cont;
+			if (cont) delete_buckets(cont, capacity);
+			functor_holder<Hash, 0>::operator=(other);
+			functor_holder<Equal, 1>::operator=(other);
 			capacity = other.capacity;
-			capp = other.capp;
+			min_capacity = other.min_capacity;
+			auto_shrink = other.auto_shrink;
+			access_order = other.access_order;
+			max_len = other.max_len;
+			on_evict = other.on_evict;
+			incremental = other.incremental;
+			seed = other.seed;
 			len = other.len;
-			cont = new BucketList[capacity];
+			cont = other.cont ? new_buckets(capacity) : nullptr;
 			node* p;
 			node* q;
-			p = other.head->next, q = head;
+			p = other.head->after, q = head;
 			while (p != other.tail) {
-				size_t hash = Hash()(p->data->first) % capacity;
-				q->after = new node(*(p->data), cont[hash].head, q);
-				cont[hash].head = q = q->after;
+				q->after = create_node(p->hash, *(p->data()));
+				q->after->before = q;
+				if (cont) cont[bucket(p->hash)].insert(q->after);
+				q = q->after;
 				p = p->after;
 			}
 			q->after = tail;
 			tail->before = q;
 			return *this;
 		}
+		//先造一个空的 再整个交换过来 other留下一个空表
+		linked_hashmap(linked_hashmap&& other) : linked_hashmap() {
+			swap(other);
+		}
+		linked_hashmap& operator=(linked_hashmap&& other) {
+			if (&other == this)return *this;
+			clear();
+			swap(other);
+			return *this;
+		}
+		/**
+		 * exchanges the contents with other in O(1).
+		 * the elements do not move, so references and pointers to them stay valid.
+		 *   iterators still reach their elements, but remain tied to the map they came
+		 *   from: stepping them, comparing them with the other map's iterators or passing
+		 *   them to either map is not allowed afterwards (erase throws invalid_iterator).
+		 */
+		void swap(linked_hashmap& other) {
+			//哨兵是成员 交换的是两边哨兵之间的元素
+			node* first = empty() ? nullptr : head->after, * last = tail->before;
+			node* other_first = other.empty() ? nullptr : other.head->after, * other_last = other.tail->before;
+			attach(other_first, other_last);
+			other.attach(first, last);
+			functor_holder<Hash, 0>::swap_functor(other);
+			functor_holder<Equal, 1>::swap_functor(other);
+			pool.swap(other.pool);
+			std::swap(cont, other.cont);
+			std::swap(capacity, other.capacity);
+			std::swap(len, other.len);
+			std::swap(min_capacity, other.min_capacity);
+			std::swap(auto_shrink, other.auto_shrink);
+			std::swap(access_order, other.access_order);
+			std::swap(max_len, other.max_len);
+			on_evict.swap(other.on_evict);
+			std::swap(incremental, other.incremental);
+			std::swap(old_cont, other.old_cont);
+			std::swap(old_capacity, other.old_capacity);
+			std::swap(migrated, other.migrated);
+			std::swap(seed, other.seed);
+		}
 
 		/**
 		 * TODO Destructors
 		 */
 		~linked_hashmap() {
-			delete[]cont;
-			node* p = head->after;
-			node* q;
-			while (p != tail) {
-				q = p;
-				p = p->after;
-				delete q;
-			}
-			delete head;
-			delete tail;
+			if (cont) delete_buckets(cont, capacity);
+			if (old_cont) delete_buckets(old_cont, old_capacity);
+			destroy_all();
 		}
 
 		/**
@@ -380,17 +962,34 @@ namespace sjtu {
 		 * access specified element with bounds checking
 		 * Returns a reference to the mapped value of the element with key equivalent to key.
 		 * If no such element exists, an exception of type `index_out_of_bound'
+		 * In access order the element also becomes the most recently used one.
 		 */
 		T& at(const Key& key) {
-			size_t hashcode = Hash()(key) % capacity;
-			node* p = cont[hashcode].find(key);
-			if (p) return p->data->second;
+			node* p = locate(key, hash_of(key));
+			if (p) return touch(p)->data()->second;
 			throw index_out_of_bound();
 		}
 		const T& at(const Key& key) const {
-			size_t hashcode = Hash()(key) % capacity;
-			node* p = cont[hashcode].find(key);
-			if (p) return p->data->second;
+			node* p = locate(key, hash_of(key));
+			if (p) return p->data()->second;
+			throw index_out_of_bound();
+		}
+		/**
+		 * the lookups taking a K instead of a Key (at, count, contains, find) only
+		 *   exist if both Hash and Equal have a member type is_transparent.
+		 *   Hash()(key) must then equal the hash of the equivalent Key, so that e.g.
+		 *   a string_view finds std::string keys without building a temporary Key.
+		 */
+		template<class K, class H = Hash, class E = Equal, class = typename H::is_transparent, class = typename E::is_transparent>
+		T& at(const K& key) {
+			node* p = locate(key, hash_of(key));
+			if (p) return touch(p)->data()->second;
+			throw index_out_of_bound();
+		}
+		template<class K, class H = Hash, class E = Equal, class = typename H::is_transparent, class = typename E::is_transparent>
+		const T& at(const K& key) const {
+			node* p = locate(key, hash_of(key));
+			if (p) return p->data()->second;
 			throw index_out_of_bound();
 		}
 
@@ -401,23 +1000,20 @@ namespace sjtu {
 		 *   performing an insertion if such key does not already exist.
 		 */
 		T& operator[](const Key& key) {
-			node* p = cont[Hash()(key) % capacity].find(key);
-			if (p) {
-				return p->data->second;
-			}
-			else {
-				//这里使用了iterator重载的-> 插入了一个默认值
-				return insert(value_type(key, T())).first->second;
-			}
+			//key不存在时才原地构造一个默认值
+			return try_emplace(key).first->second;
+		}
+		T& operator[](Key&& key) {
+			return try_emplace(std::move(key)).first->second;
 		}
 
 		/**
 		 * behave like at() throw index_out_of_bound if such key does not exist.
 		 */
 		const T& operator[](const Key& key) const {
-			node* p = cont[Hash()(key) % capacity].find(key);
+			node* p = locate(key, hash_of(key));
 			if (p) {
-				return p->data->second;
+				return p->data()->second;
 			}
 			else {
 				//这里使用了iterator重载的-> 插入了一个默认值
@@ -461,23 +1057,338 @@ namespace sjtu {
 			return len;
 		}
 
+		/**
+		 * returns the number of buckets currently in use.
+		 * 0 while the map is small: up to 8 elements are kept without a bucket array
+		 *   and looked up by a linear scan. the array is allocated on the 9th insertion.
+		 */
+		size_t bucket_count() const {
+			return capacity;
+		}
+
+		/**
+		 * returns size() / bucket_count(), or 0 without a bucket array.
+		 */
+		float load_factor() const {
+			return capacity ? (float)len / capacity : 0;
+		}
+
+		/**
+		 * sets the number of buckets to at least n (rounded up to a power of two),
+		 *   but never fewer than needed to hold size() elements under LOAD_FACTOR.
+		 * The value is also remembered as the floor for automatic shrinking.
+		 */
+		void rehash(size_t n) {
+			size_t need = buckets_for(len);
+			if (n < need) n = need;
+			min_capacity = n < MIN_CAPACITY ? MIN_CAPACITY : n;
+			resize(n);
+		}
+
+		/**
+		 * makes room for at least n elements without any further rehashing.
+		 * a small map reserving no more than 8 elements stays without buckets.
+		 */
+		void reserve(size_t n) {
+			if (!cont && n <= SMALL_MAX) return;
+			rehash(buckets_for(n));
+		}
+
+		/**
+		 * bytes of heap the map holds: the bucket arrays (both while an incremental
+		 *   rehash is under way) and every slab of the node pool, free slots left by
+		 *   erasures included. memory owned by the elements themselves is not counted.
+		 */
+		size_t memory_usage() const {
+			return pool.memory() + (capacity + (old_cont ? old_capacity : 0)) * sizeof(BucketList);
+		}
+
+		/**
+		 * shrinks the bucket array to the fewest buckets that hold size() elements
+		 *   under LOAD_FACTOR, and forgets the capacity reserved before. a map of no
+		 *   more than 8 elements gives its bucket array back altogether.
+		 * nodes stay where they are: iterators and references remain valid.
+		 */
+		void shrink_to_fit() {
+			finish_rehash();
+			min_capacity = MIN_CAPACITY;
+			if (len <= SMALL_MAX) {
+				if (cont) delete_buckets(cont, capacity);
+				cont = nullptr;
+				capacity = 0;
+				return;
+			}
+			resize(buckets_for(len));
+			finish_rehash();
+		}
+
+		/**
+		 * moves every element into one new block of nodes laid out in iteration order
+		 *   and gives the old slabs back, with the free slots left by erasures.
+		 *   iteration then reads memory in order again. O(n), no hash is recomputed.
+		 * invalidates all iterators, pointers and references. elements are moved if
+		 *   that cannot throw and copied otherwise; if a copy throws, nothing changes.
+		 */
+		void compact() {
+			finish_rehash();
+			if (!len) {
+				clear();
+				return;
+			}
+			pool_type fresh(pool.get_allocator());
+			char* block = static_cast<char*>(fresh.allocate_block(len));
+			if constexpr (STATS) counters.node_allocations += len;
+			auto at = [block](size_t i) { return reinterpret_cast<value_node*>(block + i * pool_type::STRIDE); };
+			size_t n = 0;
+			try {
+				for (node* p = head->after; p != tail; p = p->after, n++)
+					new(at(n)) value_node(p->hash, std::move_if_noexcept(*p->data()));
+			}
+			catch (...) {
+				while (n) at(--n)->~value_node();
+				throw;
+			}
+			//旧结点整块还掉 新结点按原来的顺序重新挂进链表和桶
+			destroy_all();
+			pool.swap(fresh);
+			forget_all();
+			for (size_t i = 0; i < n; i++) {
+				node* q = at(i);
+				if (cont) cont[bucket(q->hash)].insert(q);
+				q->before = tail->before;
+				q->after = tail;
+				tail->before->after = q;
+				tail->before = q;
+			}
+			len = n;
+		}
+
+		/**
+		 * if enabled, erase() halves the bucket array once the load drops
+		 *   below LOAD_FACTOR / 4 (never below the reserved capacity).
+		 * disabled by default.
+		 */
+		void set_auto_shrink(bool enable) {
+			auto_shrink = enable;
+			shrink_if_needed();
+		}
+
+		/**
+		 * the counters of a map whose Policy has stats (see hashmap_stats_policy).
+		 * the chain lengths are measured on each call, in O(bucket_count()).
+		 */
+		hashmap_stats stats() const {
+			static_assert(STATS, "stats needs a linked_hashmap with stats");
+			hashmap_stats s = counters;
+			size_t chains = 0, total = 0;
+			auto measure = [&](const BucketList& b) {
+				size_t n = 0;
+				for (node* p = b.head; p; p = p->next) n++;
+				if (!n) return;
+				chains++;
+				total += n;
+				if (n > s.max_chain) s.max_chain = n;
+			};
+			//小表算作一条链
+			if (!cont && len) {
+				chains = 1;
+				total = s.max_chain = len;
+			}
+			//迁移中 新数组里只有旧桶已经搬过的那些桶是初始化过的
+			for (size_t i = 0; i < capacity; i++)
+				if (!old_cont || (i & (old_capacity - 1)) < migrated) measure(cont[i]);
+			if (old_cont)
+				for (size_t i = migrated; i < old_capacity; i++) measure(old_cont[i]);
+			s.average_chain = chains ? (double)total / chains : 0;
+			return s;
+		}
+		void reset_stats() {
+			static_assert(STATS, "reset_stats needs a linked_hashmap with stats");
+			counters = hashmap_stats();
+		}
+
+		/**
+		 * if enabled, growing or shrinking the bucket array no longer relinks every
+		 *   element at once: the old array is kept next to the new one, and every
+		 *   insertion or erasure moves a few old buckets over. a lookup still reads
+		 *   one chain, in whichever array holds its bucket at the moment.
+		 *   no single operation then costs more than a few chains plus one allocation.
+		 * disabling it finishes a pending migration. disabled by default.
+		 */
+		void set_incremental_rehash(bool enable) {
+			incremental = enable;
+			if (!enable) finish_rehash();
+		}
+
+		/**
+		 * replaces the seed mixed into every hash (see hash_mix) and rehashes all elements
+		 *   in O(size()). only meaningful with Policy::mix_hash. the iteration order and all
+		 *   iterators stay as they are.
+		 * Hash must not throw here.
+		 */
+		void set_hash_seed(size_t s) {
+			finish_rehash();
+			seed = s;
+			for (size_t i = 0; i < capacity; i++) cont[i].head = nullptr;
+			for (node* p = head->after; p != tail; p = p->after) {
+				p->hash = hash_of(p->data()->first);
+				if (cont) cont[bucket(p->hash)].insert(p);
+			}
+		}
+		size_t hash_seed() const {
+			return seed;
+		}
+		/**
+		 * copies of the hash and the key equality the map was constructed with.
+		 */
+		Hash hash_function() const {
+			return hasher();
+		}
+		Equal key_eq() const {
+			return equal();
+		}
+
+		/**
+		 * if enabled, the non-const find(), at(), operator[] and the insert functions
+		 *   move the element they hit to the back, so iteration runs from the least
+		 *   to the most recently used element. const lookups and count() never reorder.
+		 * a moved element keeps its iterators, but an iteration running past it
+		 *   meets it again at the back.
+		 * disabled by default.
+		 */
+		void set_access_order(bool enable) {
+			access_order = enable;
+		}
+
+		/**
+		 * bounds the map to n elements, 0 meaning no bound.
+		 * whenever an insertion (or this call) leaves more than n elements,
+		 *   the front ones (the oldest, or the least recently used in access order)
+		 *   are passed to the eviction callback and erased.
+		 */
+		void set_max_size(size_t n) {
+			max_len = n;
+			evict_if_needed();
+		}
+		/**
+		 * the bound set by set_max_size(), or the largest size_t if there is none.
+		 */
+		size_t max_size() const {
+			return max_len ? max_len : SIZE_MAX;
+		}
+		/**
+		 * fn(value_type&) is called on every evicted element right before it is erased,
+		 *   and may move it out. if fn throws, that element stays in the map.
+		 */
+		void set_eviction_callback(std::function<void(value_type&)> fn) {
+			on_evict = std::move(fn);
+		}
+
 		/**
 		 * clears the contents
 		 */
 		void clear() {
-			for (size_t i = 0; i < capacity; i++)cont[i].head = nullptr;
-			node* p = head->next;
-			node* q;
-			while (p != tail) {
-				q = p;
-				p = p->after;
-				delete q;
+			destroy_all();
+			forget_all();
+		}
+		/**
+		 * clears the contents like clear(), running the destructors of the elements on
+		 *   up to threads threads (0: one per hardware thread), split into segments of
+		 *   the iteration order. meant for huge maps whose elements are costly to destroy.
+		 */
+		void parallel_clear(size_t threads = 0) {
+			if (!TRIVIAL_DESTROY)
+				parallel_nodes(threads, [](node* p) { static_cast<value_node*>(p)->~value_node(); });
+			pool.release();
+			forget_all();
+		}
+		/**
+		 * calls fn on every element from up to threads threads (0: one per hardware thread).
+		 * the iteration order is cut into 4 * threads segments, found in one pass over it,
+		 *   and each is walked by one thread. fn is shared by all threads and sees the
+		 *   elements concurrently, in no particular order. it must not insert or erase,
+		 *   and the iteration order is not changed.
+		 * the first exception thrown by fn is rethrown once all threads have stopped;
+		 *   some elements may not have been visited then.
+		 */
+		template<class Fn>
+		void parallel_for_each(Fn fn, size_t threads = 0) {
+			parallel_nodes(threads, [&fn](node* p) { fn(*p->data()); });
+		}
+		template<class Fn>
+		void parallel_for_each(Fn fn, size_t threads = 0) const {
+			parallel_nodes(threads, [&fn](node* p) { fn(*static_cast<const value_type*>(p->data())); });
+		}
+
+		/**
+		 * writes the elements to out in iteration order, in the binary format of
+		 *   hashmap_file_header, through a buffer of about 64 KB. Key and T must be
+		 *   trivially copyable. throws runtime_error if the stream fails.
+		 */
+		void save(std::ostream& out) const {
+			hashmap_records<Key, T> w;
+			w.start(out, len, capacity, Policy::mix_hash, seed);
+			for (node* p = head->after; p != tail; p = p->after) w.put(out, p->hash, *p->data());
+			w.flush(out);
+		}
+		/**
+		 * replaces the contents with a stream written by save() of a map with the same
+		 *   Key and T, reading it in chunks of about 64 KB.
+		 * the table is sized once, every chunk becomes one block of nodes, and the stored
+		 *   hashes are kept when the mixing policy matches (taking over the saved seed),
+		 *   so no key is hashed again. Hash has to give the same values as when saving.
+		 * throws runtime_error on a foreign or truncated stream; the map is then empty.
+		 */
+		void load(std::istream& in) {
+			hashmap_records<Key, T> r;
+			r.open(in);
+			clear();
+			bool rehash_keys = (bool)r.header.mixed != Policy::mix_hash;
+			if (!rehash_keys) seed = (size_t)r.header.seed;
+			size_t count = (size_t)r.header.count, want = (size_t)r.header.buckets;
+			if (want < buckets_for(count)) want = buckets_for(count);
+			if ((cont || count > SMALL_MAX) && round_up(want) != capacity) {
+				if (cont) delete_buckets(cont, capacity);
+				capacity = round_up(want);
+				cont = new_buckets(capacity);
 			}
-			head->after = tail;
-			tail->before = head;
-			len = 0;
+			try {
+				for (size_t n; (n = r.next(in));) {
+					char* block = static_cast<char*>(pool.allocate_block(n));
+					if constexpr (STATS) counters.node_allocations += n;
+					for (size_t i = 0; i < n; i++) {
+						value_node* p = new(block + i * pool_type::STRIDE) value_node(r.hash(i), typename value_node::raw_t());
+						r.copy_value(i, p->storage);
+						if (rehash_keys) p->hash = hash_of(p->data()->first);
+						if (cont) cont[bucket(p->hash)].insert(p);
+						p->before = tail->before;
+						p->after = tail;
+						tail->before->after = p;
+						tail->before = p;
+						len++;
+					}
+				}
+			}
+			catch (...) {
+				clear();
+				throw;
+			}
+			evict_if_needed();
 		}
 
+	private:
+		//key不存在时才用args构造结点 存在时什么都不构造
+		template<class... Args>
+		pair<iterator, bool> try_insert(const Key& key, size_t hashcode, Args&&... args) {
+			node* p = locate(key, hashcode);
+			if (p) return pair<iterator, bool>(iterator(this, touch(p)), false);
+			grow_if_needed();
+			p = create_node(hashcode, std::forward<Args>(args)...);
+			link_node(p);
+			evict_if_needed();
+			return pair<iterator, bool>(iterator(this, p), true);
+		}
+	public:
 		/**
 		 * insert an element.
 		 * return a pair, the first of the pair is
@@ -485,60 +1396,127 @@ namespace sjtu {
 		 *   the second one is true if insert successfully, or false.
 		 */
 		pair<iterator, bool> insert(const value_type& value) {
-			bool suc;
-			iterator it;
-			Key key = value.first;
-			T val = value.second;
-			size_t hashcode = Hash()(key) % capacity;
-			node* p = cont[hashcode].find(key);
-			if (!p) {
-				suc = false;
-				it = iterator(this, p);
+			return try_insert(value.first, hash_of(value.first), value);
+		}
+		pair<iterator, bool> insert(value_type&& value) {
+			return try_insert(value.first, hash_of(value.first), std::move(value));
+		}
+
+		/**
+		 * constructs the element from args and inserts it if its key is not present.
+		 * the element has to be built first to learn its key; it is destroyed again
+		 *   if the key turns out to be taken.
+		 */
+		template<class... Args>
+		pair<iterator, bool> emplace(Args&&... args) {
+			node* p = create_node(0, std::forward<Args>(args)...);
+			const Key& key = p->data()->first;
+			size_t hashcode;
+			node* q;
+			try {
+				hashcode = hash_of(key);
+				q = locate(key, hashcode);
+				if (!q) grow_if_needed();
 			}
-			else {
-				suc = true;
-				len++;
-				p = new node(value);
-				cont[hashcode].insert(p);
-				p->before = tail->before;
-				p->after = tail;
-				tail->before->after = p;
-				tail->before = p;
-				it = iterator(this, p);
+			catch (...) {
+				destroy_node(p);
+				throw;
 			}
-			return pair<iterator, bool>(it, suc);
+			if (q) {
+				destroy_node(p);
+				return pair<iterator, bool>(iterator(this, touch(q)), false);
+			}
+			p->hash = hashcode;
+			link_node(p);
+			evict_if_needed();
+			return pair<iterator, bool>(iterator(this, p), true);
+		}
+
+		/**
+		 * if key is absent, inserts value_type(key, T(args...)) built in place;
+		 *   otherwise does nothing, and args are left untouched.
+		 */
+		template<class... Args>
+		pair<iterator, bool> try_emplace(const Key& key, Args&&... args) {
+			return try_insert(key, hash_of(key), std::piecewise_construct,
+				std::forward_as_tuple(key), std::forward_as_tuple(std::forward<Args>(args)...));
+		}
+		template<class... Args>
+		pair<iterator, bool> try_emplace(Key&& key, Args&&... args) {
+			return try_insert(key, hash_of(key), std::piecewise_construct,
+				std::forward_as_tuple(std::move(key)), std::forward_as_tuple(std::forward<Args>(args)...));
+		}
+
+		/**
+		 * assigns obj to the mapped value of key, inserting it if key is absent.
+		 * the second of the returned pair is true if an insertion took place.
+		 */
+		template<class M>
+		pair<iterator, bool> insert_or_assign(const Key& key, M&& obj) {
+			pair<iterator, bool> p = try_emplace(key, std::forward<M>(obj));
+			if (!p.second) p.first->second = std::forward<M>(obj);
+			return p;
+		}
+		template<class M>
+		pair<iterator, bool> insert_or_assign(Key&& key, M&& obj) {
+			pair<iterator, bool> p = try_emplace(std::move(key), std::forward<M>(obj));
+			if (!p.second) p.first->second = std::forward<M>(obj);
+			return p;
 		}
 
 		/**
-		 * erase the element at pos.
+		 * erase the element at pos, in O(1): the key is neither hashed nor compared.
 		 *
 		 * throw if pos pointed to a bad element (pos == this->end() || pos points an element out of this)
 		 */
 		 //用.来访问迭代器的正常成员 用->来访问迭代器代表的值
 		void erase(iterator pos) {
 			if (pos.f != this || pos == end()) throw invalid_iterator();
-			pos.ptr->before->after = pos.ptr->after;
-			pos.ptr->after->before = pos.ptr->before;
-			size_t hashcode = Hash()(pos->first) % capacity;
-			node* p = cont[hashcode].head;
-			//空
-			if (!p)return;
-			else if (Equal()(cont[hashcode].head->data->first, pos->first)) {
-				cont[hashcode].head = p->next;
-			}
-			else {
-				node* q = p;
-				p = p->next;
-				while (p && !Equal()(p->data->first, pos->first)) {
-					p = p->next;
-					q = q->next;
-				}
-				if (!p)return;
-				q->next = p->next;
+			erase_node(pos.ptr);
+			shrink_if_needed();
+		}
+		/**
+		 * erases the elements from first up to, not including, last in iteration order,
+		 *   in O(1) each. last must not come before first.
+		 * throw invalid_iterator if either of them belongs to another map.
+		 */
+		void erase(iterator first, iterator last) {
+			if (first.f != this || last.f != this) throw invalid_iterator();
+			for (node* p = first.ptr, * q; p != last.ptr; p = q) {
+				q = p->after;
+				erase_node(p);
 			}
-			delete p;
+			shrink_after_erasing();
 		}
-
+		/**
+		 * erases the first element in iteration order: the oldest one, or the least
+		 *   recently used one in access order.
+		 * throw container_is_empty if the map is empty.
+		 */
+		void pop_front() {
+			if (empty()) throw container_is_empty();
+			erase_node(head->after);
+			shrink_if_needed();
+		}
+		/**
+		 * erases every element e for which pred(e) is true, in one pass along the
+		 *   iteration order without any lookup. returns the number erased.
+		 * if pred throws, the elements erased so far stay erased.
+		 */
+		template<class Pred>
+		size_t erase_if(Pred pred) {
+			size_t n = 0;
+			for (node* p = head->after, * q; p != tail; p = q) {
+				q = p->after;
+				if (pred(*p->data())) {
+					erase_node(p);
+					n++;
+				}
+			}
+			shrink_after_erasing();
+			return n;
+		}
+
 		/**
 		 * Returns the number of elements with key
 		 *   that compares equivalent to the specified argument,
@@ -546,7 +1524,7 @@ namespace sjtu {
 		 *     since this container does not allow duplicates.
 		 */
 		size_t count(const Key& key) const {
-			node* p = cont[Hash()(key) % capacity].find(key);
+			node* p = locate(key, hash_of(key));
 			if (p) {
 				return 1;
 			}
@@ -554,6 +1532,20 @@ namespace sjtu {
 				return 0;
 			}
 		}
+		template<class K, class H = Hash, class E = Equal, class = typename H::is_transparent, class = typename E::is_transparent>
+		size_t count(const K& key) const {
+			return locate(key, hash_of(key)) ? 1 : 0;
+		}
+		/**
+		 * whether an element with key equivalent to key exists. never reorders.
+		 */
+		bool contains(const Key& key) const {
+			return locate(key, hash_of(key)) != nullptr;
+		}
+		template<class K, class H = Hash, class E = Equal, class = typename H::is_transparent, class = typename E::is_transparent>
+		bool contains(const K& key) const {
+			return locate(key, hash_of(key)) != nullptr;
+		}
 
 		/**
 		 * Finds an element with key equivalent to key.
@@ -562,15 +1554,921 @@ namespace sjtu {
 		 *   If no such element is found, past-the-end (see end()) iterator is returned.
 		 */
 		iterator find(const Key& key) {
-			node* p = cont[Hash()(key) % capacity].find(key);
-			if (p)return iterator(this, p);
+			node* p = locate(key, hash_of(key));
+			if (p)return iterator(this, touch(p));
 			else return end();
 		}
 		const_iterator find(const Key& key) const {
-			node* p = cont[Hash()(key) % capacity].find(key);
+			node* p = locate(key, hash_of(key));
 			if (p)return const_iterator(this, p);
 			else return cend();
 		}
+		template<class K, class H = Hash, class E = Equal, class = typename H::is_transparent, class = typename E::is_transparent>
+		iterator find(const K& key) {
+			node* p = locate(key, hash_of(key));
+			if (p)return iterator(this, touch(p));
+			else return end();
+		}
+		template<class K, class H = Hash, class E = Equal, class = typename H::is_transparent, class = typename E::is_transparent>
+		const_iterator find(const K& key) const {
+			node* p = locate(key, hash_of(key));
+			if (p)return const_iterator(this, p);
+			else return cend();
+		}
+		/**
+		 * looks up every key of [first, last) and writes to out, in the same order,
+		 *   an iterator to its element or end(). returns out past the last one written.
+		 * the keys go in groups of 16: all of a group are hashed and their buckets
+		 *   prefetched before the first one is compared, so the cache misses of a
+		 *   group overlap. It must be a forward iterator.
+		 * the non-const form reorders hits in access order, like find().
+		 */
+		template<class It, class Out>
+		Out find_batch(It first, It last, Out out) {
+			locate_batch(first, last, [&](node* p) {
+				*out++ = p ? iterator(this, touch(p)) : end();
+			});
+			return out;
+		}
+		template<class It, class Out>
+		Out find_batch(It first, It last, Out out) const {
+			locate_batch(first, last, [&](node* p) {
+				*out++ = p ? const_iterator(this, p) : cend();
+			});
+			return out;
+		}
+		/**
+		 * like find_batch, but writes count(key) (0 or 1) for every key.
+		 */
+		template<class It, class Out>
+		Out count_batch(It first, It last, Out out) const {
+			locate_batch(first, last, [&](node* p) {
+				*out++ = (size_t)(p != nullptr);
+			});
+			return out;
+		}
+	};
+
+	template<class Key, class T, class Hash, class Equal, class Allocator, class Policy>
+	class linked_hashmap<Key, T, Hash, Equal, compact_storage, Allocator, Policy>
+		: private functor_holder<Hash, 0>, private functor_holder<Equal, 1> {
+	public:
+		typedef pair<const Key, T> value_type;
+	private:
+		//entries按插入顺序连续存放 删除只打标记 下标就是迭代器的位置
+		//插入删除引起的扩容缩容都不挪entry 只有rehash compact这类重建才把空洞挤掉
+		struct entry {
+			size_t hash;
+			bool alive;
+			alignas(value_type) unsigned char storage[sizeof(value_type)];
+			value_type* data() { return reinterpret_cast<value_type*>(storage); }
+			const value_type* data() const { return reinterpret_cast<const value_type*>(storage); }
+		};
+		//index里存entries的下标 EMPTY是从没用过的槽 DUMMY是删除留下的槽 探测时不能停在这里
+		typedef unsigned int slot_type;
+		static constexpr slot_type EMPTY = (slot_type)-1;
+		static constexpr slot_type DUMMY = (slot_type)-2;
+		static constexpr float LOAD_FACTOR = 0.75;
+		static constexpr size_t MIN_CAPACITY = 8;
+		//end()的位置 和哨兵结点一样不随插入移动
+		static constexpr size_t END = (size_t)-1;
+		static constexpr size_t BATCH = 16;
+
+		typedef typename std::allocator_traits<Allocator>::template rebind_alloc<entry> entry_allocator;
+		typedef typename std::allocator_traits<Allocator>::template rebind_alloc<slot_type> slot_allocator;
+
+		Allocator alloc;
+		slot_type* index;
+		size_t index_cap;//2的幂
+		int index_shift;//64 - log2(index_cap) 用乘法散列取高位
+		size_t filled;//index里不是EMPTY的槽 活着的加上DUMMY
+		entry* entries;
+		size_t entry_cap;
+		size_t used;//entries中用过的前缀长度 包含已删除的
+		size_t len;
+		size_t first;//第一个活着的entry 没有时等于END
+		size_t min_capacity;
+		bool auto_shrink;
+		static constexpr bool STATS = Policy::stats;
+		static constexpr bool TRIVIAL_DESTROY = std::is_trivially_destructible<value_type>::value;
+		//key和值都可平凡复制时 复制整张表就是照抄entries和index两块内存
+		static constexpr bool TRIVIAL_COPY = std::is_trivially_copyable<Key>::value && std::is_trivially_copyable<T>::value;
+		struct NoStats {};
+		mutable typename std::conditional<STATS, hashmap_stats, NoStats>::type counters;
+		size_t seed;
+
+		const Hash& hasher() const noexcept {
+			return functor_holder<Hash, 0>::functor();
+		}
+		const Equal& equal() const noexcept {
+			return functor_holder<Equal, 1>::functor();
+		}
+		template<class K>
+		size_t hash_of(const K& key) const {
+			if constexpr (Policy::mix_hash) return hash_mix(hasher()(key), seed);
+			else return hasher()(key);
+		}
+		//std::hash对整数是恒等映射 乘一个奇数后取高位 连续的key也能散开
+		size_t slot_of(size_t h) const {
+			return (size_t)(((unsigned long long)h * 0x9E3779B97F4A7C15ull) >> index_shift);
+		}
+		static size_t buckets_for(size_t n) {
+			return (size_t)((double)n / LOAD_FACTOR) + 1;
+		}
+		static size_t round_up(size_t n) {
+			size_t c = MIN_CAPACITY;
+			while (c < n) c <<= 1;
+			return c;
+		}
+		//返回存着key的槽 没有就返回index_cap
+		template<class K>
+		size_t lookup(const K& key, size_t h) const {
+			size_t mask = index_cap - 1;
+			if constexpr (STATS) counters.lookups++;
+			for (size_t i = slot_of(h);; i = (i + 1) & mask) {
+				slot_type s = index[i];
+				if constexpr (STATS) counters.probes++;
+				if (s == EMPTY) return index_cap;
+				if (s != DUMMY && entries[s].hash == h && equal()(entries[s].data()->first, key)) return i;
+			}
+		}
+		//和chained一样分三趟 先预取索引里的起始槽 再预取它指向的entry
+		template<class It, class Emit>
+		void lookup_batch(It first, It last, Emit emit) const {
+			It keys[BATCH];
+			size_t h[BATCH];
+			while (first != last) {
+				size_t n = 0;
+				for (; n < BATCH && first != last; ++first, ++n) {
+					keys[n] = first;
+					h[n] = hash_of(*first);
+					prefetch(index + slot_of(h[n]));
+				}
+				for (size_t i = 0; i < n; i++) {
+					slot_type s = index[slot_of(h[i])];
+					if (s != EMPTY && s != DUMMY) prefetch(entries + s);
+				}
+				for (size_t i = 0; i < n; i++) emit(lookup(*keys[i], h[i]));
+			}
+		}
+		//新entry放到探测序列上的第一个EMPTY或DUMMY
+		size_t free_slot(size_t h) const {
+			size_t mask = index_cap - 1;
+			size_t i = slot_of(h);
+			while (index[i] != EMPTY && index[i] != DUMMY) i = (i + 1) & mask;
+			return i;
+		}
+		//index里最多这么多个非EMPTY的槽 再多就要重新登记
+		size_t index_limit() const {
+			return (size_t)(index_cap * LOAD_FACTOR);
+		}
+		//分配newcap个全空的槽 旧的index由调用者处理
+		void allocate_index(size_t newcap) {
+			slot_allocator sa(alloc);
+			index = std::allocator_traits<slot_allocator>::allocate(sa, newcap);
+			index_cap = newcap;
+			index_shift = 64;
+			for (size_t c = newcap; c > 1; c >>= 1) index_shift--;
+			for (size_t i = 0; i < index_cap; i++) index[i] = EMPTY;
+			filled = 0;
+		}
+		//entries至少能放ecap项 复制一个带空洞的表时要用
+		//两块都拿到了才换上 抛异常时成员都不变 旧的两块由调用者还掉
+		void allocate(size_t newcap, size_t ecap = 0) {
+			size_t limit = (size_t)(newcap * LOAD_FACTOR);
+			size_t cap = limit < ecap ? ecap : limit;
+			entry_allocator ea(alloc);
+			entry* e = std::allocator_traits<entry_allocator>::allocate(ea, cap);
+			try {
+				allocate_index(newcap);
+			}
+			catch (...) {
+				free_entries(e, cap);
+				throw;
+			}
+			entries = e;
+			entry_cap = cap;
+			used = len = 0;
+			first = END;
+		}
+		void free_index(slot_type* p, size_t cap) {
+			slot_allocator sa(alloc);
+			std::allocator_traits<slot_allocator>::deallocate(sa, p, cap);
+		}
+		void free_index() {
+			free_index(index, index_cap);
+		}
+		void free_entries(entry* e, size_t cap) {
+			entry_allocator ea(alloc);
+			std::allocator_traits<entry_allocator>::deallocate(ea, e, cap);
+		}
+		void destroy_values() {
+			if (!TRIVIAL_DESTROY)
+				for (size_t i = first; i < used; i++)
+					if (entries[i].alive) entries[i].data()->~value_type();
+		}
+		void destroy() {
+			destroy_values();
+			free_entries(entries, entry_cap);
+			free_index();
+		}
+		//按other的容量分配 可平凡复制时连同删除留下的空洞一起照抄 否则逐个追加 空洞就挤掉了
+		void copy_from(const linked_hashmap& other) {
+			allocate(other.index_cap, TRIVIAL_COPY ? other.used : 0);
+			if constexpr (TRIVIAL_COPY) {
+				std::memcpy(index, other.index, index_cap * sizeof(slot_type));
+				if (other.used) std::memcpy(entries, other.entries, other.used * sizeof(entry));
+				filled = other.filled;
+				used = other.used;
+				len = other.len;
+				first = other.first;
+			}
+			else {
+				for (size_t i = other.first; i < other.used; i++)
+					if (other.entries[i].alive) append(other.entries[i].hash, *other.entries[i].data());
+			}
+		}
+		//entries按下标切成4 * threads段 每段交给一个线程 对活着的entry调用fn
+		template<class Fn>
+		void parallel_entries(size_t threads, Fn fn) const {
+			if (first == END) return;
+			threads = thread_count(threads);
+			size_t parts = 4 * threads, width = (used - first + parts - 1) / parts;
+			parallel_run(parts, threads, [&](size_t i) {
+				size_t lo = first + i * width, hi = lo + width < used ? lo + width : used;
+				for (size_t k = lo; k < hi; k++)
+					if (entries[k].alive) fn(entries[k]);
+			});
+		}
+		//在末尾追加一项 调用前保证used < entry_cap
+		template<class... Args>
+		entry* append(size_t h, Args&&... args) {
+			entry* e = entries + used;
+			new(e->data()) value_type(std::forward<Args>(args)...);
+			link_last(h);
+			return e;
+		}
+		//entries[used]里已经构造好了值 把它登记进索引
+		void link_last(size_t h) {
+			entry* e = entries + used;
+			e->hash = h;
+			e->alive = true;
+			size_t i = free_slot(h);
+			if (index[i] == EMPTY) filled++;
+			index[i] = (slot_type)used;
+			if (first == END) first = used;
+			used++;
+			len++;
+		}
+		//squeeze为真时重建并挤掉空洞 下标会变 否则entry不动 只重新登记索引
+		void resize(size_t newcap, bool squeeze = true) {
+			if constexpr (STATS) {
+				std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+				if (squeeze) rebuild(newcap);
+				else reindex(newcap);
+				counters.rehashes++;
+				counters.rehash_ns += (unsigned long long)std::chrono::duration_cast<std::chrono::nanoseconds>(
+					std::chrono::steady_clock::now() - t0).count();
+			}
+			else if (squeeze) rebuild(newcap);
+			else reindex(newcap);
+		}
+		size_t index_size_for(size_t newcap) const {
+			newcap = round_up(newcap < buckets_for(len) ? buckets_for(len) : newcap);
+			if (newcap > (size_t)DUMMY) throw runtime_error();
+			return newcap;
+		}
+		//换成newcap个槽 活着的entry按原顺序挤到新数组的前面 只用存下的hash 不重新算
+		void rebuild(size_t newcap) {
+			newcap = index_size_for(newcap);
+			entry* old = entries;
+			slot_type* oldindex = index;
+			size_t oldfirst = first, oldused = used, oldcap = entry_cap, oldindexcap = index_cap;
+			//新的两块都拿到了才还旧索引 分配失败时表原样不动
+			allocate(newcap);
+			free_index(oldindex, oldindexcap);
+			for (size_t i = oldfirst; i < oldused; i++) {
+				if (!old[i].alive) continue;
+				append(old[i].hash, std::move(*old[i].data()));
+				old[i].data()->~value_type();
+			}
+			free_entries(old, oldcap);
+		}
+		//换成newcap个槽 entry原地不动 活着的按存下的hash重新登记 DUMMY就清掉了
+		void reindex(size_t newcap) {
+			newcap = index_size_for(newcap);
+			slot_type* old = index;
+			size_t oldcap = index_cap;
+			allocate_index(newcap);
+			free_index(old, oldcap);
+			for (size_t i = first; i < used; i++)
+				if (entries[i].alive) {
+					index[free_slot(entries[i].hash)] = (slot_type)i;
+					filled++;
+				}
+		}
+		//entries换成能放cap项的数组 每项搬到同样的下标 空洞也原样留着
+		void move_entries(size_t cap) {
+			if (cap > (size_t)DUMMY) throw runtime_error();
+			entry_allocator ea(alloc);
+			entry* fresh = std::allocator_traits<entry_allocator>::allocate(ea, cap);
+			for (size_t i = 0; i < used; i++) {
+				fresh[i].hash = entries[i].hash;
+				fresh[i].alive = entries[i].alive;
+				if (!entries[i].alive) continue;
+				new(fresh[i].data()) value_type(std::move(*entries[i].data()));
+				entries[i].data()->~value_type();
+			}
+			free_entries(entries, entry_cap);
+			entries = fresh;
+			entry_cap = cap;
+		}
+		//entries用完时 空洞过半就原地重建把它们挤掉 下标会变 否则翻倍 下标不变
+		//index快满时重新登记 活着的多才翻倍 否则只是清掉DUMMY
+		void grow_if_needed() {
+			if (used == entry_cap) {
+				if (len * 2 < used) {
+					size_t need = buckets_for(len + 1);
+					resize(need < index_cap ? index_cap : need);
+					return;
+				}
+				move_entries(entry_cap * 2);
+			}
+			if (filled < index_limit()) return;
+			size_t target = len * 2 < index_limit() ? index_cap : index_cap * 2;
+			resize(target < min_capacity ? min_capacity : target, false);
+		}
+		void shrink_if_needed() {
+			if (!auto_shrink || index_cap <= min_capacity) return;
+			if (len < index_cap * (LOAD_FACTOR / 4)) {
+				size_t target = index_cap / 2;
+				resize(target < min_capacity ? min_capacity : target, false);
+			}
+		}
+		size_t next_alive(size_t i) const {
+			while (i < used && !entries[i].alive) i++;
+			return i < used ? i : END;
+		}
+		//索引里指向pos的槽一定在它hash的探测序列上 顺着找到换成DUMMY 不用比较key
+		//entry留在原地只打标记 之后的下标都不变
+		void erase_entry(size_t pos) {
+			entry& e = entries[pos];
+			size_t mask = index_cap - 1;
+			size_t i = slot_of(e.hash);
+			while (index[i] != (slot_type)pos) i = (i + 1) & mask;
+			index[i] = DUMMY;
+			e.data()->~value_type();
+			e.alive = false;
+			len--;
+			if (pos == first) first = next_alive(first);
+		}
+		//批量删除时最后才缩 一直缩到不再变
+		void shrink_after_erasing() {
+			for (size_t c = 0; c != index_cap;) {
+				c = index_cap;
+				shrink_if_needed();
+			}
+		}
+		size_t prev_alive(size_t i) const {
+			if (i == END) i = used;
+			do i--; while (!entries[i].alive);
+			return i;
+		}
+
+	public:
+		class const_iterator;
+		class iterator {
+			friend class linked_hashmap;
+		private:
+			linked_hashmap* f;
+			size_t pos;
+		public:
+			using difference_type = std::ptrdiff_t;
+			using value_type = typename linked_hashmap::value_type;
+			using pointer = value_type*;
+			using reference = value_type&;
+			using iterator_category = std::output_iterator_tag;
+
+			iterator(linked_hashmap* ff = nullptr, size_t pp = 0) :f(ff), pos(pp) {}
+			iterator(const iterator& other) :f(other.f), pos(other.pos) {}
+			iterator operator++(int) {
+				iterator tmp = *this;
+				++*this;
+				return tmp;
+			}
+			iterator& operator++() {
+				if (!f || pos == END) throw invalid_iterator();
+				pos = f->next_alive(pos + 1);
+				return *this;
+			}
+			iterator operator--(int) {
+				iterator tmp = *this;
+				--*this;
+				return tmp;
+			}
+			iterator& operator--() {
+				if (!f || pos == f->first) throw invalid_iterator();
+				pos = f->prev_alive(pos);
+				return *this;
+			}
+			value_type& operator*() const {
+				if (!f || pos == END) throw invalid_iterator();
+				return *f->entries[pos].data();
+			}
+			bool operator==(const iterator& rhs) const {
+				return f == rhs.f && pos == rhs.pos;
+			}
+			bool operator==(const const_iterator& rhs) const {
+				return f == rhs.f && pos == rhs.pos;
+			}
+			bool operator!=(const iterator& rhs) const {
+				return f != rhs.f || pos != rhs.pos;
+			}
+			bool operator!=(const const_iterator& rhs) const {
+				return f != rhs.f || pos != rhs.pos;
+			}
+			value_type* operator->() const noexcept {
+				return f->entries[pos].data();
+			}
+		};
+
+		class const_iterator {
+			friend class linked_hashmap;
+		private:
+			const linked_hashmap* f;
+			size_t pos;
+		public:
+			const_iterator(const linked_hashmap* ff = nullptr, size_t pp = 0) :f(ff), pos(pp) {}
+			const_iterator(const const_iterator& other) :f(other.f), pos(other.pos) {}
+			const_iterator(const iterator& other) :f(other.f), pos(other.pos) {}
+			const_iterator operator++(int) {
+				const_iterator tmp = *this;
+				++*this;
+				return tmp;
+			}
+			const_iterator& operator++() {
+				if (!f || pos == END) throw invalid_iterator();
+				pos = f->next_alive(pos + 1);
+				return *this;
+			}
+			const_iterator operator--(int) {
+				const_iterator tmp = *this;
+				--*this;
+				return tmp;
+			}
+			const_iterator& operator--() {
+				if (!f || pos == f->first) throw invalid_iterator();
+				pos = f->prev_alive(pos);
+				return *this;
+			}
+			const value_type& operator*() const {
+				if (!f || pos == END) throw invalid_iterator();
+				return *f->entries[pos].data();
+			}
+			bool operator==(const iterator& rhs) const {
+				return f == rhs.f && pos == rhs.pos;
+			}
+			bool operator==(const const_iterator& rhs) const {
+				return f == rhs.f && pos == rhs.pos;
+			}
+			bool operator!=(const iterator& rhs) const {
+				return f != rhs.f || pos != rhs.pos;
+			}
+			bool operator!=(const const_iterator& rhs) const {
+				return f != rhs.f || pos != rhs.pos;
+			}
+			const value_type* operator->() const noexcept {
+				return f->entries[pos].data();
+			}
+		};
+
+		linked_hashmap() : linked_hashmap(Hash()) {}
+		explicit linked_hashmap(const Hash& hash, const Equal& equal = Equal())
+			: functor_holder<Hash, 0>(hash), functor_holder<Equal, 1>(equal) {
+			min_capacity = MIN_CAPACITY;
+			auto_shrink = false;
+			seed = Policy::random_seed ? random_hash_seed() : 0;
+			allocate(MIN_CAPACITY);
+		}
+		linked_hashmap(const linked_hashmap& other)
+			: functor_holder<Hash, 0>(other), functor_holder<Equal, 1>(other), alloc(other.alloc) {
+			min_capacity = other.min_capacity;
+			auto_shrink = other.auto_shrink;
+			seed = other.seed;
+			copy_from(other);
+		}
+		linked_hashmap& operator=(const linked_hashmap& other) {
+			if (&other == this) return *this;
+			//旧的两块留到新表分配好再还 分配失败时这里是一个空表
+			clear();
+			entry* olde = entries;
+			slot_type* oldi = index;
+			size_t oldecap = entry_cap, oldicap = index_cap;
+			functor_holder<Hash, 0>::operator=(other);
+			functor_holder<Equal, 1>::operator=(other);
+			min_capacity = other.min_capacity;
+			auto_shrink = other.auto_shrink;
+			seed = other.seed;
+			try {
+				copy_from(other);
+			}
+			catch (...) {
+				if (entries != olde) {
+					free_entries(olde, oldecap);
+					free_index(oldi, oldicap);
+				}
+				throw;
+			}
+			free_entries(olde, oldecap);
+			free_index(oldi, oldicap);
+			return *this;
+		}
+		linked_hashmap(linked_hashmap&& other) : linked_hashmap() {
+			swap(other);
+		}
+		linked_hashmap& operator=(linked_hashmap&& other) {
+			if (&other == this) return *this;
+			clear();
+			swap(other);
+			return *this;
+		}
+		~linked_hashmap() {
+			destroy();
+		}
+		void swap(linked_hashmap& other) {
+			functor_holder<Hash, 0>::swap_functor(other);
+			functor_holder<Equal, 1>::swap_functor(other);
+			std::swap(alloc, other.alloc);
+			std::swap(index, other.index);
+			std::swap(index_cap, other.index_cap);
+			std::swap(index_shift, other.index_shift);
+			std::swap(filled, other.filled);
+			std::swap(entries, other.entries);
+			std::swap(entry_cap, other.entry_cap);
+			std::swap(used, other.used);
+			std::swap(len, other.len);
+			std::swap(first, other.first);
+			std::swap(min_capacity, other.min_capacity);
+			std::swap(auto_shrink, other.auto_shrink);
+			std::swap(seed, other.seed);
+		}
+
+		T& at(const Key& key) {
+			size_t s = lookup(key, hash_of(key));
+			if (s == index_cap) throw index_out_of_bound();
+			return entries[index[s]].data()->second;
+		}
+		const T& at(const Key& key) const {
+			size_t s = lookup(key, hash_of(key));
+			if (s == index_cap) throw index_out_of_bound();
+			return entries[index[s]].data()->second;
+		}
+		template<class K, class H = Hash, class E = Equal, class = typename H::is_transparent, class = typename E::is_transparent>
+		T& at(const K& key) {
+			size_t s = lookup(key, hash_of(key));
+			if (s == index_cap) throw index_out_of_bound();
+			return entries[index[s]].data()->second;
+		}
+		template<class K, class H = Hash, class E = Equal, class = typename H::is_transparent, class = typename E::is_transparent>
+		const T& at(const K& key) const {
+			size_t s = lookup(key, hash_of(key));
+			if (s == index_cap) throw index_out_of_bound();
+			return entries[index[s]].data()->second;
+		}
+		T& operator[](const Key& key) {
+			return try_emplace(key).first->second;
+		}
+		T& operator[](Key&& key) {
+			return try_emplace(std::move(key)).first->second;
+		}
+		const T& operator[](const Key& key) const {
+			return at(key);
+		}
+
+		iterator begin() {
+			return iterator(this, first);
+		}
+		const_iterator cbegin() const {
+			return const_iterator(this, first);
+		}
+		iterator end() {
+			return iterator(this, END);
+		}
+		const_iterator cend() const {
+			return const_iterator(this, END);
+		}
+
+		bool empty() const {
+			return len == 0;
+		}
+		size_t size() const {
+			return len;
+		}
+		size_t bucket_count() const {
+			return index_cap;
+		}
+		float load_factor() const {
+			return (float)len / index_cap;
+		}
+		void rehash(size_t n) {
+			min_capacity = round_up(n);
+			resize(n);
+		}
+		void reserve(size_t n) {
+			rehash(buckets_for(n));
+		}
+		size_t memory_usage() const {
+			return index_cap * sizeof(slot_type) + entry_cap * sizeof(entry);
+		}
+		//重建时顺带挤掉删除留下的空洞
+		void shrink_to_fit() {
+			min_capacity = MIN_CAPACITY;
+			resize(buckets_for(len));
+		}
+		void compact() {
+			resize(index_cap);
+		}
+		void set_auto_shrink(bool enable) {
+			auto_shrink = enable;
+			shrink_if_needed();
+		}
+		hashmap_stats stats() const {
+			static_assert(STATS, "stats needs a linked_hashmap with stats");
+			hashmap_stats s = counters;
+			size_t mask = index_cap - 1, total = 0;
+			for (size_t i = 0; i < index_cap; i++) {
+				if (index[i] == EMPTY || index[i] == DUMMY) continue;
+				size_t n = ((i - slot_of(entries[index[i]].hash)) & mask) + 1;
+				total += n;
+				if (n > s.max_chain) s.max_chain = n;
+			}
+			s.average_chain = len ? (double)total / len : 0;
+			return s;
+		}
+		void reset_stats() {
+			static_assert(STATS, "reset_stats needs a linked_hashmap with stats");
+			counters = hashmap_stats();
+		}
+		//重算hash 再按新hash重建索引 顺带挤掉空洞
+		void set_hash_seed(size_t s) {
+			seed = s;
+			for (size_t i = first; i < used; i++)
+				if (entries[i].alive) entries[i].hash = hash_of(entries[i].data()->first);
+			rebuild(index_cap);
+		}
+		size_t hash_seed() const {
+			return seed;
+		}
+		/**
+		 * copies of the hash and the key equality the map was constructed with.
+		 */
+		Hash hash_function() const {
+			return hasher();
+		}
+		Equal key_eq() const {
+			return equal();
+		}
+
+		void clear() {
+			destroy_values();
+			for (size_t i = 0; i < index_cap; i++) index[i] = EMPTY;
+			filled = used = len = 0;
+			first = END;
+		}
+		/**
+		 * clears the contents like clear(), destroying the elements on up to threads
+		 *   threads (0: one per hardware thread), split by ranges of the entry array.
+		 */
+		void parallel_clear(size_t threads = 0) {
+			if (!TRIVIAL_DESTROY) parallel_entries(threads, [](entry& e) { e.data()->~value_type(); });
+			for (size_t i = 0; i < index_cap; i++) index[i] = EMPTY;
+			filled = used = len = 0;
+			first = END;
+		}
+		/**
+		 * calls fn on every element from up to threads threads, split by ranges of the
+		 *   entry array, i.e. by segments of the insertion order, without a pass to find
+		 *   them. same rules as the chained parallel_for_each.
+		 */
+		template<class Fn>
+		void parallel_for_each(Fn fn, size_t threads = 0) {
+			parallel_entries(threads, [&fn](entry& e) { fn(*e.data()); });
+		}
+		template<class Fn>
+		void parallel_for_each(Fn fn, size_t threads = 0) const {
+			parallel_entries(threads, [&fn](const entry& e) { fn(*e.data()); });
+		}
+
+		void save(std::ostream& out) const {
+			hashmap_records<Key, T> w;
+			w.start(out, len, index_cap, Policy::mix_hash, seed);
+			for (size_t i = first; i < used; i++)
+				if (entries[i].alive) w.put(out, entries[i].hash, *entries[i].data());
+			w.flush(out);
+		}
+		void load(std::istream& in) {
+			hashmap_records<Key, T> r;
+			r.open(in);
+			clear();
+			bool rehash_keys = (bool)r.header.mixed != Policy::mix_hash;
+			if (!rehash_keys) seed = (size_t)r.header.seed;
+			size_t count = (size_t)r.header.count, want = (size_t)r.header.buckets;
+			want = round_up(want < buckets_for(count) ? buckets_for(count) : want);
+			if (want > (size_t)DUMMY) throw runtime_error();
+			if (want != index_cap) {
+				entry* olde = entries;
+				slot_type* oldi = index;
+				size_t oldecap = entry_cap, oldicap = index_cap;
+				allocate(want);
+				free_entries(olde, oldecap);
+				free_index(oldi, oldicap);
+			}
+			try {
+				for (size_t n; (n = r.next(in));) {
+					for (size_t i = 0; i < n; i++) {
+						r.copy_value(i, entries[used].storage);
+						link_last(rehash_keys ? hash_of(entries[used].data()->first) : r.hash(i));
+					}
+					if constexpr (STATS) counters.node_allocations += n;
+				}
+			}
+			catch (...) {
+				clear();
+				throw;
+			}
+		}
+
+	private:
+		template<class... Args>
+		pair<iterator, bool> try_insert(const Key& key, size_t h, Args&&... args) {
+			size_t s = lookup(key, h);
+			if (s != index_cap) return pair<iterator, bool>(iterator(this, index[s]), false);
+			grow_if_needed();
+			append(h, std::forward<Args>(args)...);
+			if constexpr (STATS) counters.node_allocations++;
+			return pair<iterator, bool>(iterator(this, used - 1), true);
+		}
+	public:
+		pair<iterator, bool> insert(const value_type& value) {
+			return try_insert(value.first, hash_of(value.first), value);
+		}
+		pair<iterator, bool> insert(value_type&& value) {
+			return try_insert(value.first, hash_of(value.first), std::move(value));
+		}
+		//先在entries[used]里把值造出来才知道key 重复就再析构掉
+		template<class... Args>
+		pair<iterator, bool> emplace(Args&&... args) {
+			grow_if_needed();
+			value_type* v = new(entries[used].data()) value_type(std::forward<Args>(args)...);
+			size_t h, s;
+			try {
+				h = hash_of(v->first);
+				s = lookup(v->first, h);
+			}
+			catch (...) {
+				v->~value_type();
+				throw;
+			}
+			if (s != index_cap) {
+				v->~value_type();
+				return pair<iterator, bool>(iterator(this, index[s]), false);
+			}
+			link_last(h);
+			if constexpr (STATS) counters.node_allocations++;
+			return pair<iterator, bool>(iterator(this, used - 1), true);
+		}
+		template<class... Args>
+		pair<iterator, bool> try_emplace(const Key& key, Args&&... args) {
+			return try_insert(key, hash_of(key), std::piecewise_construct,
+				std::forward_as_tuple(key), std::forward_as_tuple(std::forward<Args>(args)...));
+		}
+		template<class... Args>
+		pair<iterator, bool> try_emplace(Key&& key, Args&&... args) {
+			return try_insert(key, hash_of(key), std::piecewise_construct,
+				std::forward_as_tuple(std::move(key)), std::forward_as_tuple(std::forward<Args>(args)...));
+		}
+		template<class M>
+		pair<iterator, bool> insert_or_assign(const Key& key, M&& obj) {
+			pair<iterator, bool> p = try_emplace(key, std::forward<M>(obj));
+			if (!p.second) p.first->second = std::forward<M>(obj);
+			return p;
+		}
+		template<class M>
+		pair<iterator, bool> insert_or_assign(Key&& key, M&& obj) {
+			pair<iterator, bool> p = try_emplace(std::move(key), std::forward<M>(obj));
+			if (!p.second) p.first->second = std::forward<M>(obj);
+			return p;
+		}
+
+		void erase(iterator pos) {
+			if (pos.f != this || pos.pos >= used || !entries[pos.pos].alive) throw invalid_iterator();
+			erase_entry(pos.pos);
+			shrink_if_needed();
+		}
+		/**
+		 * erases the elements from first up to, not including, last in iteration order.
+		 * throw invalid_iterator if either of them belongs to another map.
+		 */
+		void erase(iterator first_it, iterator last_it) {
+			if (first_it.f != this || last_it.f != this) throw invalid_iterator();
+			size_t hi = last_it.pos == END ? used : last_it.pos;
+			for (size_t i = first_it.pos; i < hi; i++)
+				if (entries[i].alive) erase_entry(i);
+			shrink_after_erasing();
+		}
+		/**
+		 * erases the first element in iteration order.
+		 * throw container_is_empty if the map is empty.
+		 */
+		void pop_front() {
+			if (!len) throw container_is_empty();
+			erase_entry(first);
+			shrink_if_needed();
+		}
+		/**
+		 * erases every element e for which pred(e) is true, in one pass over the entry
+		 *   array. returns the number erased.
+		 */
+		template<class Pred>
+		size_t erase_if(Pred pred) {
+			size_t n = 0;
+			for (size_t i = first; i < used; i++)
+				if (entries[i].alive && pred(*entries[i].data())) {
+					erase_entry(i);
+					n++;
+				}
+			shrink_after_erasing();
+			return n;
+		}
+
+		size_t count(const Key& key) const {
+			return lookup(key, hash_of(key)) == index_cap ? 0 : 1;
+		}
+		template<class K, class H = Hash, class E = Equal, class = typename H::is_transparent, class = typename E::is_transparent>
+		size_t count(const K& key) const {
+			return lookup(key, hash_of(key)) == index_cap ? 0 : 1;
+		}
+		bool contains(const Key& key) const {
+			return lookup(key, hash_of(key)) != index_cap;
+		}
+		template<class K, class H = Hash, class E = Equal, class = typename H::is_transparent, class = typename E::is_transparent>
+		bool contains(const K& key) const {
+			return lookup(key, hash_of(key)) != index_cap;
+		}
+
+		iterator find(const Key& key) {
+			size_t s = lookup(key, hash_of(key));
+			if (s == index_cap) return end();
+			return iterator(this, index[s]);
+		}
+		const_iterator find(const Key& key) const {
+			size_t s = lookup(key, hash_of(key));
+			if (s == index_cap) return cend();
+			return const_iterator(this, index[s]);
+		}
+		template<class K, class H = Hash, class E = Equal, class = typename H::is_transparent, class = typename E::is_transparent>
+		iterator find(const K& key) {
+			size_t s = lookup(key, hash_of(key));
+			if (s == index_cap) return end();
+			return iterator(this, index[s]);
+		}
+		template<class K, class H = Hash, class E = Equal, class = typename H::is_transparent, class = typename E::is_transparent>
+		const_iterator find(const K& key) const {
+			size_t s = lookup(key, hash_of(key));
+			if (s == index_cap) return cend();
+			return const_iterator(this, index[s]);
+		}
+		/**
+		 * looks up every key of [first, last) and writes to out, in the same order,
+		 *   an iterator to its element or end(). returns out past the last one written.
+		 * the keys go in groups of 16: all of a group are hashed and their slots
+		 *   prefetched, then the entries those slots point to, before the first one is
+		 *   compared, so the cache misses of a group overlap. It must be a forward iterator.
+		 */
+		template<class It, class Out>
+		Out find_batch(It first, It last, Out out) {
+			lookup_batch(first, last, [&](size_t s) {
+				*out++ = s == index_cap ? end() : iterator(this, index[s]);
+			});
+			return out;
+		}
+		template<class It, class Out>
+		Out find_batch(It first, It last, Out out) const {
+			lookup_batch(first, last, [&](size_t s) {
+				*out++ = s == index_cap ? cend() : const_iterator(this, index[s]);
+			});
+			return out;
+		}
+		/**
+		 * like find_batch, but writes count(key) (0 or 1) for every key.
+		 */
+		template<class It, class Out>
+		Out count_batch(It first, It last, Out out) const {
+			lookup_batch(first, last, [&](size_t s) {
+				*out++ = (size_t)(s != index_cap);
+			});
+			return out;
+		}
 	};
 
 }
@@ -0,0 +1,338 @@
+#ifndef SJTU_NODE_POOL_HPP
+#define SJTU_NODE_POOL_HPP
+
+#include <atomic>
+#include <cassert>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <utility>
+
+namespace sjtu {
+
+/**
+ * a slab allocator handing out raw storage for objects of type Node.
+ *
+ * Memory is taken from Allocator in slabs of growing size; freed slots go
+ * onto an intrusive free list and are reused before touching a new slab.
+ * release() gives every slab back at once, so a container can destroy
+ * its elements and then drop all of its nodes without freeing them one by one.
+ *
+ * Several pools can share their slabs (share_with), so that nodes may move
+ * from one container to another without being reallocated. Shared slabs are
+ * freed when the last pool using them lets go; until then a pool that is
+ * not unique() has to deallocate its nodes one by one.
+ *
+ * Pools sharing their slabs may be used from different threads, e.g. the two
+ * halves of a split map handed to two threads: while the slabs are shared,
+ * every call takes a mutex guarding the shared bookkeeping. A pool alone on
+ * its slabs takes no lock. One pool must still not be used by two threads at once.
+ *
+ * The pool only manages storage: constructing and destroying the Node
+ * objects is up to the caller.
+ */
+template<class Node, class Allocator = std::allocator<Node>>
+class node_pool {
+private:
+	union slot {
+		slot* next;
+		alignas(Node) unsigned char storage[sizeof(Node)];
+	};
+	//每块slab的第0个slot存块头 后面才是可分配的slot
+	struct slab_header {
+		slot* next_slab;
+		size_t count;
+	};
+	union slab_slot {
+		slab_header header;
+		slot item;
+	};
+	typedef typename std::allocator_traits<Allocator>::template rebind_alloc<slab_slot> slab_allocator;
+	typedef std::allocator_traits<slab_allocator> slab_traits;
+
+	//slab真正的主人 可以被几个pool共用 合并之后旧的core只留一个forward指向新的
+	struct core {
+		slab_allocator alloc;
+		slab_slot* slabs;//最新的slab 通过header.next_slab串起来
+		slot* free_list;
+		slot* free_tail;
+		size_t cursor;//最新slab中下一个没用过的位置
+		size_t capacity;//所有slab一共有多少个slot
+		size_t in_use;
+		std::atomic<size_t> refs;//指向它的pool个数 加上forward到它的旧core个数
+		std::atomic<core*> forward;
+		//refs大于1时 共用它的pool可能在别的线程里 读写上面的字段都要先拿这个锁
+		std::mutex lock;
+
+		explicit core(const slab_allocator& a)
+			: alloc(a), slabs(nullptr), free_list(nullptr), free_tail(nullptr),
+			cursor(0), capacity(0), in_use(0), refs(1), forward(nullptr) {}
+	};
+	typedef typename std::allocator_traits<Allocator>::template rebind_alloc<core> core_allocator;
+	typedef std::allocator_traits<core_allocator> core_traits;
+
+	static constexpr size_t MIN_SLAB = 16;
+	static constexpr size_t MAX_SLAB = 8192;
+
+	slab_allocator alloc;
+	mutable core* c;//第一次分配时才创建 跳过forward只是换个指针 所以const函数里也可以改
+
+	static void free_slabs(core* k) noexcept {
+		while (k->slabs) {
+			slab_slot* next = reinterpret_cast<slab_slot*>(k->slabs[0].header.next_slab);
+			slab_traits::deallocate(k->alloc, k->slabs, k->slabs[0].header.count + 1);
+			k->slabs = next;
+		}
+		k->free_list = k->free_tail = nullptr;
+		k->cursor = k->capacity = k->in_use = 0;
+	}
+	//放掉对k的一个引用 没人用了就释放 再顺着forward往下放
+	static void drop(core* k) noexcept {
+		while (k && k->refs.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+			core* next = k->forward.load(std::memory_order_acquire);
+			free_slabs(k);
+			core_allocator ca(k->alloc);
+			core_traits::destroy(ca, k);
+			core_traits::deallocate(ca, k, 1);
+			k = next;
+		}
+	}
+	//跳过已经合并掉的core 顺便把引用挪到最终的core上
+	//c还握着旧core的引用 旧core又握着next的引用 所以next这时一定还在
+	core* target() const noexcept {
+		core* next;
+		while (c && (next = c->forward.load(std::memory_order_acquire))) {
+			next->refs.fetch_add(1, std::memory_order_relaxed);
+			drop(c);
+			c = next;
+		}
+		return c;
+	}
+	core* get() {
+		if (!target()) {
+			core_allocator ca(alloc);
+			core* k = core_traits::allocate(ca, 1);
+			core_traits::construct(ca, k, alloc);
+			c = k;
+		}
+		return c;
+	}
+	//拿到最终的core 共用时锁上 锁到的可能刚被别的线程合并掉 那就跟着forward再来
+	//refs是1时只有这个pool指向它 别的线程不会来改 也不会把它合并掉
+	struct access {
+		core* k;
+		bool held;
+		explicit access(const node_pool& p) : k(p.target()), held(false) {
+			while (k && k->refs.load(std::memory_order_acquire) > 1) {
+				k->lock.lock();
+				if (!k->forward.load(std::memory_order_acquire)) {
+					held = true;
+					return;
+				}
+				k->lock.unlock();
+				k = p.target();
+			}
+		}
+		~access() {
+			if (held) k->lock.unlock();
+		}
+		access(const access&) = delete;
+		access& operator=(const access&) = delete;
+	};
+	static void new_slab(core* k) {
+		size_t n = k->slabs ? k->slabs[0].header.count * 2 : MIN_SLAB;
+		if (n > MAX_SLAB) n = MAX_SLAB;
+		slab_slot* s = slab_traits::allocate(k->alloc, n + 1);
+		s[0].header.next_slab = reinterpret_cast<slot*>(k->slabs);
+		s[0].header.count = n;
+		k->slabs = s;
+		k->cursor = 1;
+		k->capacity += n;
+	}
+	static void push_free(core* k, slot* s) noexcept {
+		s->next = k->free_list;
+		if (!k->free_list) k->free_tail = s;
+		k->free_list = s;
+	}
+	//把from的slab和空闲链表全部并到to里 from只留一个forward 调用时两个core都已锁上
+	static void merge_into(core* from, core* to) noexcept {
+		//from当前slab里还没用过的slot放进空闲链表 to的cursor继续用to自己的slab
+		if (from->slabs)
+			for (size_t i = from->cursor; i <= from->slabs[0].header.count; i++)
+				push_free(from, &from->slabs[i].item);
+		if (from->free_list) {
+			from->free_tail->next = to->free_list;
+			if (!to->free_list) to->free_tail = from->free_tail;
+			to->free_list = from->free_list;
+		}
+		if (from->slabs) {
+			//from的slab接在to的当前slab后面
+			slab_slot* last = from->slabs;
+			while (last[0].header.next_slab) last = reinterpret_cast<slab_slot*>(last[0].header.next_slab);
+			if (to->slabs) {
+				last[0].header.next_slab = to->slabs[0].header.next_slab;
+				to->slabs[0].header.next_slab = reinterpret_cast<slot*>(from->slabs);
+			}
+			else {
+				to->slabs = from->slabs;
+				to->cursor = to->slabs[0].header.count + 1;
+			}
+		}
+		to->capacity += from->capacity;
+		to->in_use += from->in_use;
+		from->slabs = nullptr;
+		from->free_list = from->free_tail = nullptr;
+		from->cursor = from->capacity = from->in_use = 0;
+		to->refs.fetch_add(1, std::memory_order_relaxed);
+		from->forward.store(to, std::memory_order_release);
+	}
+
+public:
+	node_pool() : alloc(), c(nullptr) {}
+	explicit node_pool(const Allocator& a) : alloc(a), c(nullptr) {}
+	//复制容器时新容器用自己的pool 不共享slab
+	node_pool(const node_pool& other) : alloc(other.alloc), c(nullptr) {}
+	node_pool(node_pool&& other) noexcept : alloc(std::move(other.alloc)), c(other.c) {
+		other.c = nullptr;
+	}
+	node_pool& operator=(const node_pool&) = delete;
+	~node_pool() {
+		drop(target());
+	}
+
+	void* allocate() {
+		get();
+		access a(*this);
+		core* k = a.k;
+		if (k->free_list) {
+			slot* s = k->free_list;
+			k->free_list = s->next;
+			if (!k->free_list) k->free_tail = nullptr;
+			k->in_use++;
+			return s->storage;
+		}
+		if (!k->slabs || k->cursor > k->slabs[0].header.count) new_slab(k);
+		k->in_use++;
+		return k->slabs[k->cursor++].item.storage;
+	}
+
+	/**
+	 * hands out storage for n nodes lying next to each other in a slab of their own:
+	 *   node i starts at static_cast<char*>(block) + i * STRIDE.
+	 * the slots can be given back one by one through deallocate() like any other node,
+	 * and the slab is freed by release().
+	 */
+	void* allocate_block(size_t n) {
+		get();
+		access a(*this);
+		core* k = a.k;
+		slab_slot* s = slab_traits::allocate(k->alloc, n + 1);
+		s[0].header.count = n;
+		//挂在当前slab后面 不影响cursor所指的那块
+		if (k->slabs) {
+			s[0].header.next_slab = k->slabs[0].header.next_slab;
+			k->slabs[0].header.next_slab = reinterpret_cast<slot*>(s);
+		}
+		else {
+			s[0].header.next_slab = nullptr;
+			k->slabs = s;
+			k->cursor = n + 1;
+		}
+		k->capacity += n;
+		k->in_use += n;
+		return s[1].item.storage;
+	}
+	static constexpr size_t STRIDE = sizeof(slab_slot);
+
+	void deallocate(void* p) noexcept {
+		access a(*this);
+		push_free(a.k, reinterpret_cast<slot*>(p));
+		a.k->in_use--;
+	}
+
+	/**
+	 * gives every slab back to the allocator.
+	 * all nodes must already be destroyed (or simply abandoned).
+	 * if the slabs are shared, this pool only lets go of them: its own nodes
+	 *   have to be deallocated before, since the other pools still use the slabs.
+	 */
+	void release() noexcept {
+		if (!target()) return;
+		if (c->refs.load(std::memory_order_acquire) == 1) free_slabs(c);
+		else {
+			drop(c);
+			c = nullptr;
+		}
+	}
+
+	/**
+	 * makes this pool and other use the same slabs, merging them if needed,
+	 *   so that a node allocated by either one may be deallocated by either one.
+	 * both allocators must compare equal. afterwards the two pools, and every pool
+	 *   already sharing with either of them, lock the shared bookkeeping on each call.
+	 */
+	void share_with(node_pool& other) {
+		assert(alloc == other.alloc);
+		for (;;) {
+			core* mine = target();
+			core* theirs = other.target();
+			if (mine && mine == theirs) return;
+			if (!mine && !theirs) mine = get();
+			if (!mine) {
+				c = theirs;
+				theirs->refs.fetch_add(1, std::memory_order_relaxed);
+				return;
+			}
+			if (!theirs) {
+				other.c = mine;
+				mine->refs.fetch_add(1, std::memory_order_relaxed);
+				return;
+			}
+			//别的线程可能正在把其中一个合并掉 锁上之后都没有forward才能合并
+			std::unique_lock<std::mutex> a(mine->lock, std::defer_lock), b(theirs->lock, std::defer_lock);
+			std::lock(a, b);
+			if (mine->forward.load(std::memory_order_acquire) || theirs->forward.load(std::memory_order_acquire)) continue;
+			merge_into(theirs, mine);
+			b.unlock();
+			a.unlock();
+			other.target();
+			return;
+		}
+	}
+
+	// whether no other pool shares the slabs of this one
+	bool unique() const noexcept {
+		return !target() || c->refs.load(std::memory_order_acquire) == 1;
+	}
+
+	void swap(node_pool& other) noexcept {
+		std::swap(alloc, other.alloc);
+		std::swap(c, other.c);
+	}
+
+	// number of nodes currently handed out, by every pool sharing the slabs
+	size_t size() const noexcept {
+		access a(*this);
+		return a.k ? a.k->in_use : 0;
+	}
+	// number of node slots owned, handed out or not
+	size_t capacity() const noexcept {
+		access a(*this);
+		return a.k ? a.k->capacity : 0;
+	}
+	// bytes taken from the allocator: every slab with its header slot, and the bookkeeping
+	size_t memory() const noexcept {
+		access a(*this);
+		if (!a.k) return 0;
+		size_t n = sizeof(core);
+		for (slab_slot* s = a.k->slabs; s; s = reinterpret_cast<slab_slot*>(s[0].header.next_slab))
+			n += (s[0].header.count + 1) * STRIDE;
+		return n;
+	}
+
+	Allocator get_allocator() const { return Allocator(alloc); }
+};
+
+}
+
+#endif
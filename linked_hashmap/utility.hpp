@@ -2,26 +2,123 @@
 #define SJTU_UTILITY_HPP
 
 #include <utility>
+#include <tuple>
+#include <atomic>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
 
 namespace sjtu {
 
 template<class T1, class T2>
 class pair {
+private:
+	template<class Tuple1, class Tuple2, size_t... I1, size_t... I2>
+	pair(Tuple1 &x, Tuple2 &y, std::index_sequence<I1...>, std::index_sequence<I2...>)
+		: first(std::forward<std::tuple_element_t<I1, Tuple1>>(std::get<I1>(x))...),
+		  second(std::forward<std::tuple_element_t<I2, Tuple2>>(std::get<I2>(y))...) {}
 public:
 	T1 first;
 	T2 second;
 	constexpr pair() : first(), second() {}
 	pair(const pair &other) = default;
 	pair(pair &&other) = default;
+	// pair<const Key, T> stays non-assignable because of its const member
+	pair &operator=(const pair &other) = default;
+	pair &operator=(pair &&other) = default;
 	pair(const T1 &x, const T2 &y) : first(x), second(y) {}
 	template<class U1, class U2>
-	pair(U1 &&x, U2 &&y) : first(x), second(y) {}
+	pair(U1 &&x, U2 &&y) : first(std::forward<U1>(x)), second(std::forward<U2>(y)) {}
 	template<class U1, class U2>
 	pair(const pair<U1, U2> &other) : first(other.first), second(other.second) {}
 	template<class U1, class U2>
-	pair(pair<U1, U2> &&other) : first(other.first), second(other.second) {}
+	pair(pair<U1, U2> &&other) : first(std::move(other.first)), second(std::move(other.second)) {}
+	// builds first and second in place from the two argument tuples
+	template<class... Args1, class... Args2>
+	pair(std::piecewise_construct_t, std::tuple<Args1...> x, std::tuple<Args2...> y)
+		: pair(x, y, std::index_sequence_for<Args1...>(), std::index_sequence_for<Args2...>()) {}
 };
 
+// asks the cache to start loading the line holding p; a no-op where the compiler has no builtin
+inline void prefetch(const void *p) {
+#if defined(__GNUC__) || defined(__clang__)
+	__builtin_prefetch(p);
+#else
+	(void)p;
+#endif
+}
+
+// holds a function object such as a comparator or a hash for the container deriving
+//   from it, taking no space when the object is empty (empty base optimization).
+//   Tag keeps two holders of the same type apart in one class.
+template<class F, int Tag = 0, bool = std::is_empty<F>::value && !std::is_final<F>::value>
+class functor_holder : private F {
+public:
+	functor_holder() : F() {}
+	explicit functor_holder(const F &f) : F(f) {}
+	const F &functor() const noexcept { return *this; }
+	void swap_functor(functor_holder &) noexcept {}
+};
+template<class F, int Tag>
+class functor_holder<F, Tag, false> {
+	F f;
+public:
+	functor_holder() : f() {}
+	explicit functor_holder(const F &f) : f(f) {}
+	const F &functor() const noexcept { return f; }
+	void swap_functor(functor_holder &other) {
+		using std::swap;
+		swap(f, other.f);
+	}
+};
+
+// the number of threads meant by a threads argument: 0 means one per hardware thread
+inline size_t thread_count(size_t threads) {
+	if (threads) return threads;
+	size_t n = std::thread::hardware_concurrency();
+	return n ? n : 1;
+}
+
+// runs fn(0), ..., fn(parts - 1) on up to thread_count(threads) threads, the calling one
+//   included, handing the parts out one at a time. once fn throws, no further parts are
+//   started; the first exception is rethrown after every thread has finished.
+//   if a thread cannot be started, the others do its share.
+template<class Fn>
+void parallel_run(size_t parts, size_t threads, Fn fn) {
+	threads = thread_count(threads);
+	if (threads > parts) threads = parts;
+	if (threads <= 1) {
+		for (size_t i = 0; i < parts; i++) fn(i);
+		return;
+	}
+	std::atomic<size_t> next(0);
+	std::exception_ptr error;
+	std::mutex lock;
+	auto work = [&]() {
+		for (size_t i; (i = next.fetch_add(1)) < parts;) {
+			try {
+				fn(i);
+			}
+			catch (...) {
+				std::lock_guard<std::mutex> g(lock);
+				if (!error) error = std::current_exception();
+				next.store(parts);
+			}
+		}
+	};
+	std::vector<std::thread> workers;
+	try {
+		workers.reserve(threads - 1);
+		for (size_t i = 1; i < threads; i++) workers.emplace_back(work);
+	}
+	catch (...) {}
+	work();
+	for (std::thread &t : workers) t.join();
+	if (error) std::rethrow_exception(error);
+}
+
 }
 
 #endif
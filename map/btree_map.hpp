@@ -0,0 +1,1059 @@
+/**
+ * implement a container like std::map, stored in a B+ tree
+ */
+#ifndef SJTU_BTREE_MAP_HPP
+#define SJTU_BTREE_MAP_HPP
+
+ // only for std::less<T>
+#include <functional>
+#include <cstddef>
+#include <iterator>
+#include <new>
+#include <algorithm>
+#include "utility.hpp"
+#include "exceptions.hpp"
+#include "node_pool.hpp"
+#include "key_search.hpp"
+#include <cassert>
+
+namespace sjtu {
+
+    /**
+     * an ordered map with the interface of sjtu::map, kept in a B+ tree.
+     *
+     * every node takes about NODE_BYTES bytes: the elements of a leaf and the keys of an
+     *   inner node lie next to each other, so a lookup reads a few cache lines per level
+     *   and the tree is only a few levels high. the leaves are linked from left to right,
+     *   so iterating walks over contiguous arrays.
+     * best suited to small keys that are cheap to compare and copy, such as int or long long.
+     *
+     * unlike sjtu::map, elements move inside and between nodes as the tree changes:
+     *   insert and erase invalidate every iterator, pointer and reference into the map.
+     *   erase returns an iterator to the following element so that a loop can go on.
+     * elements and keys are moved with their move constructors, which should not throw.
+     */
+    template<
+        class Key,
+        class T,
+        class Compare = std::less<Key>,
+        class Allocator = std::allocator<pair<const Key, T>>
+    > class btree_map {
+    public:
+        typedef pair<const Key, T> value_type;
+        class iterator;
+        class const_iterator;
+    private:
+        static constexpr size_t NODE_BYTES = 256;
+        static constexpr size_t slotsFor(size_t each) {
+            return NODE_BYTES / each < 4 ? 4 : NODE_BYTES / each;
+        }
+        //叶子存value 内部结点存分隔key和孩子指针 个数都按NODE_BYTES算
+        static constexpr size_t LEAF_SLOTS = slotsFor(sizeof(value_type));
+        static constexpr size_t INNER_SLOTS = slotsFor(sizeof(Key) + sizeof(void*));
+        //非根结点少于这么多就向兄弟借或者合并
+        static constexpr size_t LEAF_MIN = LEAF_SLOTS / 2;
+        static constexpr size_t INNER_MIN = INNER_SLOTS / 2;
+        //std::less比较整数key时 结点内的查找换成向量比较计数 见key_search.hpp
+        typedef key_search<Key, Compare> search_type;
+        static constexpr bool VECTOR_SEARCH = search_type::vectorized;
+
+        struct InnerNode;
+        struct NodeBase {
+            InnerNode* parent;
+            unsigned short pos;//在父结点child[]里的下标
+            unsigned short count;//叶子是value个数 内部结点是key个数 孩子比key多一个
+            bool leaf;
+
+            explicit NodeBase(bool _leaf) : parent(nullptr), pos(0), count(0), leaf(_leaf) {}
+        };
+        struct LeafNode : NodeBase {
+            LeafNode* prev;
+            LeafNode* next;
+            alignas(value_type) unsigned char storage[LEAF_SLOTS * sizeof(value_type)];
+
+            LeafNode() : NodeBase(true), prev(nullptr), next(nullptr) {}
+
+            inline value_type* data() noexcept { return reinterpret_cast<value_type*>(storage); }
+            inline const Key& key(size_t i) noexcept { return data()[i].first; }
+        };
+        //child[i]里的key都小于key(i) child[i+1]里的都不小于key(i)
+        //删除不会更新分隔key 所以它不一定还在树里
+        struct InnerNode : NodeBase {
+            alignas(Key) unsigned char storage[INNER_SLOTS * sizeof(Key)];
+            NodeBase* child[INNER_SLOTS + 1];
+
+            InnerNode() : NodeBase(false) {}
+
+            inline Key* keys() noexcept { return reinterpret_cast<Key*>(storage); }
+            inline Key& key(size_t i) noexcept { return keys()[i]; }
+        };
+
+        typedef node_pool<LeafNode, Allocator> leaf_pool_type;
+        typedef node_pool<InnerNode, Allocator> inner_pool_type;
+        leaf_pool_type leafPool;
+        inner_pool_type innerPool;
+        NodeBase* root;//空树是nullptr
+        LeafNode* head;//最左的叶子
+        LeafNode* tail;//最右的叶子
+        size_t len;
+
+        LeafNode* newLeaf() {
+            return new(leafPool.allocate()) LeafNode();
+        }
+        InnerNode* newInner() {
+            return new(innerPool.allocate()) InnerNode();
+        }
+        void freeLeaf(LeafNode* n) noexcept {
+            n->~LeafNode();
+            leafPool.deallocate(n);
+        }
+        void freeInner(InnerNode* n) noexcept {
+            n->~InnerNode();
+            innerPool.deallocate(n);
+        }
+
+        //把from处的对象搬到to处的未构造内存
+        template<class U>
+        static void relocate(U* to, U* from) {
+            new(to) U(std::move(*from));
+            from->~U();
+        }
+        //把[first,last)整体搬到以to开头的位置 两段可以重叠
+        template<class U>
+        static void moveRange(U* first, U* last, U* to) {
+            if (to < first) {
+                for (; first != last; ++first, ++to) relocate(to, first);
+            }
+            else {
+                to += last - first;
+                while (last != first) relocate(--to, --last);
+            }
+        }
+        //p的child[from..to]换了位置 重新记下它们的父结点和下标
+        static void adopt(InnerNode* p, size_t from, size_t to) noexcept {
+            for (size_t i = from; i <= to; i++) {
+                p->child[i]->parent = p;
+                p->child[i]->pos = (unsigned short)i;
+            }
+        }
+
+        //结点里是二分 第一个不小于key的value
+        //整数key的叶子不二分 一个一个数比key小的 循环里没有依赖key的分支
+        static size_t leafLowerBound(LeafNode* n, const Key& key) {
+            if constexpr (VECTOR_SEARCH) {
+                size_t c = 0;
+                for (size_t i = 0; i < n->count; i++) c += n->key(i) < key;
+                return c;
+            }
+            size_t lo = 0, hi = n->count;
+            while (lo < hi) {
+                size_t mid = (lo + hi) / 2;
+                if (Compare()(n->key(mid), key)) lo = mid + 1;
+                else hi = mid;
+            }
+            return lo;
+        }
+        //第一个大于key的value
+        static size_t leafUpperBound(LeafNode* n, const Key& key) {
+            if constexpr (VECTOR_SEARCH) {
+                size_t c = 0;
+                for (size_t i = 0; i < n->count; i++) c += !(key < n->key(i));
+                return c;
+            }
+            size_t lo = 0, hi = n->count;
+            while (lo < hi) {
+                size_t mid = (lo + hi) / 2;
+                if (Compare()(key, n->key(mid))) hi = mid;
+                else lo = mid + 1;
+            }
+            return lo;
+        }
+        //key所在的孩子 就是第一个大于key的分隔key的下标
+        //内部结点的key是连续的 可以直接用向量比较
+        static size_t childIndex(InnerNode* n, const Key& key) {
+            if constexpr (VECTOR_SEARCH) return search_type::count_not_greater(n->keys(), n->count, key);
+            size_t lo = 0, hi = n->count;
+            while (lo < hi) {
+                size_t mid = (lo + hi) / 2;
+                if (Compare()(key, n->key(mid))) hi = mid;
+                else lo = mid + 1;
+            }
+            return lo;
+        }
+        //只能在非空树上调用
+        LeafNode* findLeaf(const Key& key) const {
+            NodeBase* p = root;
+            while (!p->leaf) {
+                InnerNode* q = static_cast<InnerNode*>(p);
+                p = q->child[childIndex(q, key)];
+            }
+            return static_cast<LeafNode*>(p);
+        }
+        LeafNode* find(const Key& key, size_t& index) const {
+            if (!root) return nullptr;
+            LeafNode* leaf = findLeaf(key);
+            index = leafLowerBound(leaf, key);
+            if (index < leaf->count && !Compare()(key, leaf->key(index))) return leaf;
+            return nullptr;
+        }
+        //下标走到叶子末尾就换到下一个叶子的开头 最后一个叶子后面是end()
+        static void normalize(LeafNode*& leaf, size_t& index) noexcept {
+            if (leaf && index == leaf->count) {
+                leaf = leaf->next;
+                index = 0;
+            }
+        }
+        LeafNode* lowerBound(const Key& key, size_t& index) const {
+            index = 0;
+            if (!root) return nullptr;
+            LeafNode* leaf = findLeaf(key);
+            index = leafLowerBound(leaf, key);
+            normalize(leaf, index);
+            return leaf;
+        }
+        LeafNode* upperBound(const Key& key, size_t& index) const {
+            index = 0;
+            if (!root) return nullptr;
+            LeafNode* leaf = findLeaf(key);
+            index = leafUpperBound(leaf, key);
+            normalize(leaf, index);
+            return leaf;
+        }
+
+        //析构所有value和key 结点不逐个释放 直接把两个pool的slab整块还掉
+        //树只有几层 内部结点递归就够了
+        void destroyInner(NodeBase* node) noexcept {
+            if (node->leaf) return;
+            InnerNode* p = static_cast<InnerNode*>(node);
+            for (size_t i = 0; i < p->count; i++) p->key(i).~Key();
+            for (size_t i = 0; i <= p->count; i++) destroyInner(p->child[i]);
+        }
+        void destroyAll() noexcept {
+            if (!root) return;
+            for (LeafNode* leaf = head; leaf; leaf = leaf->next)
+                for (size_t i = 0; i < leaf->count; i++) leaf->data()[i].~value_type();
+            destroyInner(root);
+            leafPool.release();
+            innerPool.release();
+            root = head = tail = nullptr;
+            len = 0;
+        }
+
+        //按顺序追加到最右边 复制整棵树用 叶子都是满的
+        void copyFrom(const btree_map& other) {
+            for (LeafNode* leaf = other.head; leaf; leaf = leaf->next)
+                for (size_t i = 0; i < leaf->count; i++) {
+                    const value_type& v = leaf->data()[i];
+                    if (root) insertAt(tail, tail->count, v);
+                    else insertFirst(v);
+                }
+        }
+
+        template<class... Args>
+        LeafNode* insertFirst(Args&&... args) {
+            LeafNode* leaf = newLeaf();
+            try {
+                new(leaf->data()) value_type(std::forward<Args>(args)...);
+            }
+            catch (...) {
+                freeLeaf(leaf);
+                throw;
+            }
+            leaf->count = 1;
+            root = head = tail = leaf;
+            len = 1;
+            return leaf;
+        }
+
+        template<class... Args>
+        pair<iterator, bool> insertUnique(const Key& key, Args&&... args) {
+            if (!root) return pair<iterator, bool>(iterator(this, insertFirst(std::forward<Args>(args)...), 0), true);
+            LeafNode* leaf = findLeaf(key);
+            size_t i = leafLowerBound(leaf, key);
+            if (i < leaf->count && !Compare()(key, leaf->key(i)))
+                return pair<iterator, bool>(iterator(this, leaf, i), false);
+            return pair<iterator, bool>(insertAt(leaf, i, std::forward<Args>(args)...), true);
+        }
+
+        //hint后面紧挨着的位置能放下key就不从根往下找
+        //叶子开头不能直接放 分隔key可能已经被删掉了 不知道key该进左边的叶子还是这一个
+        template<class... Args>
+        pair<iterator, bool> insertUniqueHint(LeafNode* hint, size_t index, const Key& key, Args&&... args) {
+            if (root) {
+                if (!hint) {
+                    if (Compare()(tail->key(tail->count - 1), key))
+                        return pair<iterator, bool>(insertAt(tail, tail->count, std::forward<Args>(args)...), true);
+                }
+                else if (index > 0 && Compare()(hint->key(index - 1), key) && Compare()(key, hint->key(index)))
+                    return pair<iterator, bool>(insertAt(hint, index, std::forward<Args>(args)...), true);
+            }
+            return insertUnique(key, std::forward<Args>(args)...);
+        }
+
+        //在leaf的第i个位置构造新value
+        template<class... Args>
+        iterator insertAt(LeafNode* leaf, size_t i, Args&&... args) {
+            if (leaf->count == LEAF_SLOTS) return splitInsert(leaf, i, std::forward<Args>(args)...);
+            value_type* d = leaf->data();
+            moveRange(d + i, d + leaf->count, d + i + 1);
+            try {
+                new(d + i) value_type(std::forward<Args>(args)...);
+            }
+            catch (...) {
+                moveRange(d + i + 1, d + leaf->count + 1, d + i);
+                throw;
+            }
+            leaf->count++;
+            len++;
+            return iterator(this, leaf, i);
+        }
+
+        //叶子满了要分裂
+        //新value 新分隔key 分裂要用到的结点都先准备好 之后调整树的时候不会再抛异常
+        template<class... Args>
+        iterator splitInsert(LeafNode* leaf, size_t i, Args&&... args) {
+            alignas(value_type) unsigned char valueBuf[sizeof(value_type)];
+            value_type* v = new(valueBuf) value_type(std::forward<Args>(args)...);
+            //一直在最右边追加就让左边留满 新叶子只放新value 一直在最左边插入反过来
+            size_t at = LEAF_SLOTS / 2;
+            if (leaf == tail && i == LEAF_SLOTS) at = LEAF_SLOTS;
+            else if (leaf == head && i == 0) at = 0;
+            bool toRight = i > at || at == LEAF_SLOTS;
+            //右边叶子的第一个value就是分隔key
+            alignas(Key) unsigned char keyBuf[sizeof(Key)];
+            Key* sep;
+            try {
+                sep = new(keyBuf) Key(toRight && i == at ? v->first : leaf->key(at));
+            }
+            catch (...) {
+                v->~value_type();
+                throw;
+            }
+            //从leaf往上 满的内部结点各要一个新结点 一直满到根还要一个新根
+            LeafNode* right = nullptr;
+            InnerNode* spare = nullptr;//用parent串起来
+            try {
+                right = newLeaf();
+                for (InnerNode* p = leaf->parent; !p || p->count == INNER_SLOTS; p = p->parent) {
+                    InnerNode* q = newInner();
+                    q->parent = spare;
+                    spare = q;
+                    if (!p) break;
+                }
+            }
+            catch (...) {
+                if (right) freeLeaf(right);
+                while (spare) {
+                    InnerNode* q = spare;
+                    spare = q->parent;
+                    freeInner(q);
+                }
+                sep->~Key();
+                v->~value_type();
+                throw;
+            }
+            value_type* d = leaf->data();
+            moveRange(d + at, d + leaf->count, right->data());
+            right->count = (unsigned short)(leaf->count - at);
+            leaf->count = (unsigned short)at;
+            right->prev = leaf;
+            right->next = leaf->next;
+            if (leaf->next) leaf->next->prev = right;
+            else tail = right;
+            leaf->next = right;
+
+            LeafNode* target = toRight ? right : leaf;
+            size_t j = toRight ? i - at : i;
+            d = target->data();
+            moveRange(d + j, d + target->count, d + j + 1);
+            relocate(d + j, v);
+            target->count++;
+            len++;
+            insertSeparator(leaf, sep, right, spare, at == LEAF_SLOTS);
+            return iterator(this, target, j);
+        }
+
+        //left分裂出了right 把分隔key放进父结点 父结点满了就接着往上分裂
+        //key指向的对象会被搬走 spare里是事先分配好的结点 正好够用
+        void insertSeparator(NodeBase* left, Key* key, NodeBase* right, InnerNode* spare, bool append) noexcept {
+            alignas(Key) unsigned char buf[sizeof(Key)];
+            Key* up = reinterpret_cast<Key*>(buf);
+            while (true) {
+                InnerNode* p = left->parent;
+                if (!p) {
+                    //根分裂了 树长高一层
+                    p = spare;
+                    spare = spare->parent;
+                    p->parent = nullptr;
+                    relocate(p->keys(), key);
+                    p->child[0] = left;
+                    p->child[1] = right;
+                    p->count = 1;
+                    adopt(p, 0, 1);
+                    root = p;
+                    return;
+                }
+                size_t j = left->pos;
+                if (p->count < INNER_SLOTS) {
+                    insertKey(p, j, key, right);
+                    return;
+                }
+                //p也满了 p留下前mid个key 第mid个上移 后面的给新结点q 然后把key放进该去的那一半
+                //追加时留满左边 q只拿到最后一个孩子和新的key
+                InnerNode* q = spare;
+                spare = spare->parent;
+                q->parent = nullptr;
+                size_t mid = append ? INNER_SLOTS - 1 : INNER_SLOTS / 2;
+                Key* k = p->keys();
+                moveRange(k + mid + 1, k + p->count, q->keys());
+                std::copy(p->child + mid + 1, p->child + p->count + 1, q->child);
+                q->count = (unsigned short)(p->count - mid - 1);
+                adopt(q, 0, q->count);
+                relocate(up, k + mid);
+                p->count = (unsigned short)mid;
+                if (j <= mid) insertKey(p, j, key, right);
+                else insertKey(q, j - mid - 1, key, right);
+                //上移的key放到刚空出来的位置 继续往上
+                std::swap(key, up);
+                left = p;
+                right = q;
+            }
+        }
+        //在p的第j个key处插入key 它右边的孩子是right
+        static void insertKey(InnerNode* p, size_t j, Key* key, NodeBase* right) noexcept {
+            Key* k = p->keys();
+            moveRange(k + j, k + p->count, k + j + 1);
+            relocate(k + j, key);
+            std::copy_backward(p->child + j + 1, p->child + p->count + 1, p->child + p->count + 2);
+            p->child[j + 1] = right;
+            p->count++;
+            adopt(p, j + 1, p->count);
+        }
+
+        //析构leaf的第i个value 后面的往前挪
+        static void removeValue(LeafNode* leaf, size_t i) {
+            value_type* d = leaf->data();
+            d[i].~value_type();
+            moveRange(d + i + 1, d + leaf->count, d + i);
+            leaf->count--;
+        }
+        //删掉leaf的第i个value 返回它后面那个value的位置
+        //向兄弟借value要复制一个新的分隔key 这是唯一可能抛异常的地方 所以最先做
+        iterator eraseAt(LeafNode* leaf, size_t i) {
+            if (leaf == root || leaf->count > LEAF_MIN) {
+                removeValue(leaf, i);
+                len--;
+                if (leaf->count == 0) {
+                    freeLeaf(leaf);
+                    root = head = tail = nullptr;
+                }
+                return makeIterator(leaf, i);
+            }
+            InnerNode* p = leaf->parent;
+            size_t j = leaf->pos;
+            LeafNode* l = j > 0 ? static_cast<LeafNode*>(p->child[j - 1]) : nullptr;
+            LeafNode* r = j < p->count ? static_cast<LeafNode*>(p->child[j + 1]) : nullptr;
+            if (l && l->count > LEAF_MIN) {
+                //借左边的最后一个 它变成新的分隔key
+                Key sep(l->key(l->count - 1));
+                removeValue(leaf, i);
+                value_type* d = leaf->data();
+                moveRange(d, d + leaf->count, d + 1);
+                relocate(d, l->data() + l->count - 1);
+                l->count--;
+                leaf->count++;
+                replaceKey(p, j - 1, std::move(sep));
+                len--;
+                return makeIterator(leaf, i + 1);
+            }
+            if (r && r->count > LEAF_MIN) {
+                //借右边的第一个 右边的第二个变成新的分隔key
+                Key sep(r->key(1));
+                removeValue(leaf, i);
+                value_type* d = r->data();
+                relocate(leaf->data() + leaf->count, d);
+                moveRange(d + 1, d + r->count, d);
+                r->count--;
+                leaf->count++;
+                replaceKey(p, j, std::move(sep));
+                len--;
+                return makeIterator(leaf, i);
+            }
+            //两边都借不到 和一个兄弟合并 父结点少一个key
+            removeValue(leaf, i);
+            len--;
+            if (l) {
+                size_t at = l->count;
+                mergeLeaves(l, leaf);
+                p->key(j - 1).~Key();
+                removeSeparator(p, j - 1);
+                return makeIterator(l, at + i);
+            }
+            mergeLeaves(leaf, r);
+            p->key(j).~Key();
+            removeSeparator(p, j);
+            return makeIterator(leaf, i);
+        }
+        static void replaceKey(InnerNode* p, size_t j, Key&& key) {
+            p->key(j).~Key();
+            new(&p->key(j)) Key(std::move(key));
+        }
+        //把b的value都接到a后面 释放b
+        void mergeLeaves(LeafNode* a, LeafNode* b) noexcept {
+            moveRange(b->data(), b->data() + b->count, a->data() + a->count);
+            a->count += b->count;
+            a->next = b->next;
+            if (b->next) b->next->prev = a;
+            else tail = a;
+            freeLeaf(b);
+        }
+        //p的第k个key已经析构或者搬走了 去掉这个位置和它右边的孩子 再往上调整
+        void removeSeparator(InnerNode* p, size_t k) noexcept {
+            while (true) {
+                Key* keys = p->keys();
+                moveRange(keys + k + 1, keys + p->count, keys + k);
+                std::copy(p->child + k + 2, p->child + p->count + 1, p->child + k + 1);
+                p->count--;
+                adopt(p, k + 1, p->count);
+                if (p == root) {
+                    //根只剩一个孩子 树矮一层
+                    if (p->count == 0) {
+                        root = p->child[0];
+                        root->parent = nullptr;
+                        root->pos = 0;
+                        freeInner(p);
+                    }
+                    return;
+                }
+                if (p->count >= INNER_MIN) return;
+                InnerNode* g = p->parent;
+                size_t j = p->pos;
+                InnerNode* l = j > 0 ? static_cast<InnerNode*>(g->child[j - 1]) : nullptr;
+                InnerNode* r = j < g->count ? static_cast<InnerNode*>(g->child[j + 1]) : nullptr;
+                if (l && l->count > INNER_MIN) {
+                    //绕着g转一下 g的key下来 l的最后一个key上去 l的最后一个孩子给p
+                    Key* pk = p->keys();
+                    moveRange(pk, pk + p->count, pk + 1);
+                    relocate(pk, &g->key(j - 1));
+                    relocate(&g->key(j - 1), &l->key(l->count - 1));
+                    std::copy_backward(p->child, p->child + p->count + 1, p->child + p->count + 2);
+                    p->child[0] = l->child[l->count];
+                    l->count--;
+                    p->count++;
+                    adopt(p, 0, p->count);
+                    return;
+                }
+                if (r && r->count > INNER_MIN) {
+                    Key* rk = r->keys();
+                    relocate(&p->key(p->count), &g->key(j));
+                    relocate(&g->key(j), rk);
+                    moveRange(rk + 1, rk + r->count, rk);
+                    p->child[p->count + 1] = r->child[0];
+                    std::copy(r->child + 1, r->child + r->count + 1, r->child);
+                    p->count++;
+                    r->count--;
+                    adopt(p, p->count, p->count);
+                    adopt(r, 0, r->count);
+                    return;
+                }
+                //合并 g的分隔key下来夹在中间
+                if (l) {
+                    mergeInner(l, g, j - 1, p);
+                    k = j - 1;
+                }
+                else {
+                    mergeInner(p, g, j, r);
+                    k = j;
+                }
+                p = g;
+            }
+        }
+        void mergeInner(InnerNode* a, InnerNode* g, size_t k, InnerNode* b) noexcept {
+            size_t n = a->count;
+            relocate(&a->key(n), &g->key(k));
+            moveRange(b->keys(), b->keys() + b->count, a->keys() + n + 1);
+            std::copy(b->child, b->child + b->count + 1, a->child + n + 1);
+            a->count = (unsigned short)(n + 1 + b->count);
+            adopt(a, n + 1, a->count);
+            freeInner(b);
+        }
+
+    public:
+        class iterator {
+            friend class btree_map;
+        private:
+            btree_map* tree;
+            LeafNode* leaf;//end()是nullptr
+            size_t index;
+        public:
+            typedef std::ptrdiff_t difference_type;
+            typedef typename btree_map::value_type value_type;
+            typedef value_type* pointer;
+            typedef value_type& reference;
+            typedef std::bidirectional_iterator_tag iterator_category;
+
+            iterator() : tree(nullptr), leaf(nullptr), index(0) {}
+            iterator(btree_map* _t, LeafNode* _l, size_t _i) : tree(_t), leaf(_l), index(_i) {}
+            iterator(const iterator& other) = default;
+            iterator& operator=(const iterator& other) = default;
+
+            iterator operator++(int) {
+                iterator cur = *this;
+                ++*this;
+                return cur;
+            }
+            iterator& operator++() {
+                if (!leaf) throw invalid_iterator();
+                if (++index == leaf->count) {
+                    leaf = leaf->next;
+                    index = 0;
+                }
+                return *this;
+            }
+            iterator operator--(int) {
+                iterator cur = *this;
+                --*this;
+                return cur;
+            }
+            iterator& operator--() {
+                if (!tree) throw invalid_iterator();
+                if (!leaf) {
+                    if (!tree->tail) throw invalid_iterator();
+                    leaf = tree->tail;
+                    index = leaf->count - 1;
+                }
+                else if (index > 0) index--;
+                else {
+                    if (!leaf->prev) throw invalid_iterator();
+                    leaf = leaf->prev;
+                    index = leaf->count - 1;
+                }
+                return *this;
+            }
+            value_type& operator*() const {
+                if (!leaf) throw invalid_iterator();
+                return leaf->data()[index];
+            }
+            value_type* operator->() const noexcept {
+                return leaf->data() + index;
+            }
+            bool operator==(const iterator& rhs) const {
+                return tree == rhs.tree && leaf == rhs.leaf && index == rhs.index;
+            }
+            bool operator==(const const_iterator& rhs) const {
+                return tree == rhs.tree && leaf == rhs.leaf && index == rhs.index;
+            }
+            bool operator!=(const iterator& rhs) const {
+                return !(*this == rhs);
+            }
+            bool operator!=(const const_iterator& rhs) const {
+                return !(*this == rhs);
+            }
+        };
+        class const_iterator {
+            friend class btree_map;
+        private:
+            const btree_map* tree;
+            LeafNode* leaf;
+            size_t index;
+        public:
+            typedef std::ptrdiff_t difference_type;
+            typedef const typename btree_map::value_type value_type;
+            typedef value_type* pointer;
+            typedef value_type& reference;
+            typedef std::bidirectional_iterator_tag iterator_category;
+
+            const_iterator() : tree(nullptr), leaf(nullptr), index(0) {}
+            const_iterator(const btree_map* _t, LeafNode* _l, size_t _i) : tree(_t), leaf(_l), index(_i) {}
+            const_iterator(const const_iterator& other) = default;
+            const_iterator(const iterator& other) : tree(other.tree), leaf(other.leaf), index(other.index) {}
+            const_iterator& operator=(const const_iterator& other) = default;
+
+            const_iterator operator++(int) {
+                const_iterator cur = *this;
+                ++*this;
+                return cur;
+            }
+            const_iterator& operator++() {
+                if (!leaf) throw invalid_iterator();
+                if (++index == leaf->count) {
+                    leaf = leaf->next;
+                    index = 0;
+                }
+                return *this;
+            }
+            const_iterator operator--(int) {
+                const_iterator cur = *this;
+                --*this;
+                return cur;
+            }
+            const_iterator& operator--() {
+                if (!tree) throw invalid_iterator();
+                if (!leaf) {
+                    if (!tree->tail) throw invalid_iterator();
+                    leaf = tree->tail;
+                    index = leaf->count - 1;
+                }
+                else if (index > 0) index--;
+                else {
+                    if (!leaf->prev) throw invalid_iterator();
+                    leaf = leaf->prev;
+                    index = leaf->count - 1;
+                }
+                return *this;
+            }
+            const value_type& operator*() const {
+                if (!leaf) throw invalid_iterator();
+                return leaf->data()[index];
+            }
+            const value_type* operator->() const noexcept {
+                return leaf->data() + index;
+            }
+            bool operator==(const iterator& rhs) const {
+                return tree == rhs.tree && leaf == rhs.leaf && index == rhs.index;
+            }
+            bool operator==(const const_iterator& rhs) const {
+                return tree == rhs.tree && leaf == rhs.leaf && index == rhs.index;
+            }
+            bool operator!=(const iterator& rhs) const {
+                return !(*this == rhs);
+            }
+            bool operator!=(const const_iterator& rhs) const {
+                return !(*this == rhs);
+            }
+        };
+    private:
+        iterator makeIterator(LeafNode* leaf, size_t index) {
+            if (!root) return end();
+            normalize(leaf, index);
+            return iterator(this, leaf, index);
+        }
+    public:
+        btree_map() : root(nullptr), head(nullptr), tail(nullptr), len(0) {}
+        btree_map(const btree_map& other)
+            : leafPool(other.leafPool), innerPool(other.innerPool), root(nullptr), head(nullptr), tail(nullptr), len(0) {
+            try {
+                copyFrom(other);
+            }
+            catch (...) {
+                destroyAll();
+                throw;
+            }
+        }
+        /**
+         * builds the map from [first, last), which may be unsorted and contain duplicates;
+         *   of equal keys the first one is kept.
+         * each element is inserted with end() as hint, so sorted input is appended without descending.
+         */
+        template<class InputIt>
+        btree_map(InputIt first, InputIt last) : btree_map() {
+            for (; first != last; ++first) insert(cend(), *first);
+        }
+        btree_map(btree_map&& other) noexcept
+            : leafPool(std::move(other.leafPool)), innerPool(std::move(other.innerPool)),
+            root(other.root), head(other.head), tail(other.tail), len(other.len) {
+            other.root = other.head = other.tail = nullptr;
+            other.len = 0;
+        }
+        btree_map& operator=(const btree_map& other) {
+            if (this == &other) return *this;
+            clear();
+            copyFrom(other);
+            return *this;
+        }
+        btree_map& operator=(btree_map&& other) noexcept {
+            if (this == &other) return *this;
+            clear();
+            swap(other);
+            return *this;
+        }
+        /**
+         * exchanges the contents with other in O(1).
+         */
+        void swap(btree_map& other) noexcept {
+            leafPool.swap(other.leafPool);
+            innerPool.swap(other.innerPool);
+            std::swap(root, other.root);
+            std::swap(head, other.head);
+            std::swap(tail, other.tail);
+            std::swap(len, other.len);
+        }
+        ~btree_map() {
+            destroyAll();
+        }
+        /**
+         * access specified element with bounds checking.
+         * throw index_out_of_bound if such key does not exist.
+         */
+        T& at(const Key& key) {
+            size_t i;
+            LeafNode* leaf = find(key, i);
+            if (leaf) return leaf->data()[i].second;
+            throw index_out_of_bound();
+        }
+        const T& at(const Key& key) const {
+            size_t i;
+            LeafNode* leaf = find(key, i);
+            if (leaf) return leaf->data()[i].second;
+            throw index_out_of_bound();
+        }
+        /**
+         * access specified element, inserting T() if such key does not already exist.
+         */
+        T& operator[](const Key& key) {
+            return try_emplace(key).first->second;
+        }
+        T& operator[](Key&& key) {
+            return try_emplace(std::move(key)).first->second;
+        }
+        /**
+         * behave like at() throw index_out_of_bound if such key does not exist.
+         */
+        const T& operator[](const Key& key) const {
+            return at(key);
+        }
+        iterator begin() {
+            return iterator(this, head, 0);
+        }
+        const_iterator cbegin() const {
+            return const_iterator(this, head, 0);
+        }
+        iterator end() {
+            return iterator(this, nullptr, 0);
+        }
+        const_iterator cend() const {
+            return const_iterator(this, nullptr, 0);
+        }
+        bool empty() const {
+            return len == 0;
+        }
+        size_t size() const {
+            return len;
+        }
+        /**
+         * clears the contents; the nodes are given back slab by slab.
+         */
+        void clear() {
+            destroyAll();
+        }
+        /**
+         * insert an element.
+         * return a pair, the first of the pair is
+         *   the iterator to the new element (or the element that prevented the insertion),
+         *   the second one is true if insert successfully, or false.
+         */
+        pair<iterator, bool> insert(const value_type& value) {
+            return insertUnique(value.first, value);
+        }
+        pair<iterator, bool> insert(value_type&& value) {
+            return insertUnique(value.first, std::move(value));
+        }
+        /**
+         * insert value right before hint without descending from the root
+         *   if it belongs there (or after the last element when hint is end());
+         *   otherwise this is an ordinary insert.
+         * returns an iterator to the inserted element, or to the element that prevented the insertion.
+         */
+        iterator insert(const_iterator hint, const value_type& value) {
+            if (hint.tree != this) throw invalid_iterator();
+            return insertUniqueHint(hint.leaf, hint.index, value.first, value).first;
+        }
+        iterator insert(const_iterator hint, value_type&& value) {
+            if (hint.tree != this) throw invalid_iterator();
+            return insertUniqueHint(hint.leaf, hint.index, value.first, std::move(value)).first;
+        }
+        /**
+         * constructs the element from args and inserts it if its key is not present.
+         * the element is built aside first to learn its key, then moved into its leaf.
+         */
+        template<class... Args>
+        pair<iterator, bool> emplace(Args&&... args) {
+            alignas(value_type) unsigned char buf[sizeof(value_type)];
+            value_type* v = new(buf) value_type(std::forward<Args>(args)...);
+            try {
+                pair<iterator, bool> p = insertUnique(v->first, std::move(*v));
+                v->~value_type();
+                return p;
+            }
+            catch (...) {
+                v->~value_type();
+                throw;
+            }
+        }
+        template<class... Args>
+        iterator emplace_hint(const_iterator hint, Args&&... args) {
+            if (hint.tree != this) throw invalid_iterator();
+            alignas(value_type) unsigned char buf[sizeof(value_type)];
+            value_type* v = new(buf) value_type(std::forward<Args>(args)...);
+            try {
+                iterator it = insertUniqueHint(hint.leaf, hint.index, v->first, std::move(*v)).first;
+                v->~value_type();
+                return it;
+            }
+            catch (...) {
+                v->~value_type();
+                throw;
+            }
+        }
+        /**
+         * if key is absent, inserts value_type(key, T(args...)) built in place;
+         *   otherwise does nothing, and args are left untouched.
+         */
+        template<class... Args>
+        pair<iterator, bool> try_emplace(const Key& key, Args&&... args) {
+            return insertUnique(key, std::piecewise_construct,
+                std::forward_as_tuple(key), std::forward_as_tuple(std::forward<Args>(args)...));
+        }
+        template<class... Args>
+        pair<iterator, bool> try_emplace(Key&& key, Args&&... args) {
+            return insertUnique(key, std::piecewise_construct,
+                std::forward_as_tuple(std::move(key)), std::forward_as_tuple(std::forward<Args>(args)...));
+        }
+        template<class M>
+        pair<iterator, bool> insert_or_assign(const Key& key, M&& obj) {
+            pair<iterator, bool> p = try_emplace(key, std::forward<M>(obj));
+            if (!p.second) p.first->second = std::forward<M>(obj);
+            return p;
+        }
+        template<class M>
+        pair<iterator, bool> insert_or_assign(Key&& key, M&& obj) {
+            pair<iterator, bool> p = try_emplace(std::move(key), std::forward<M>(obj));
+            if (!p.second) p.first->second = std::forward<M>(obj);
+            return p;
+        }
+        /**
+         * erase the element at pos and return an iterator to the element after it.
+         *
+         * throw if pos pointed to a bad element (pos == this->end() || pos points an element out of this)
+         */
+        iterator erase(iterator pos) {
+            if (pos.tree != this || !pos.leaf) throw invalid_iterator();
+            return eraseAt(pos.leaf, pos.index);
+        }
+        /**
+         * removes the element with key equivalent to key, if any.
+         * returns the number of elements removed (0 or 1).
+         */
+        size_t erase(const Key& key) {
+            size_t i;
+            LeafNode* leaf = find(key, i);
+            if (!leaf) return 0;
+            eraseAt(leaf, i);
+            return 1;
+        }
+        /**
+         * removes the elements in [first, last) and returns an iterator to the element
+         *   that followed them; erasing everything is the same as clear().
+         *
+         * throw invalid_iterator if first or last does not belong to this map.
+         */
+        iterator erase(const_iterator first, const_iterator last) {
+            if (first.tree != this || last.tree != this) throw invalid_iterator();
+            if (first.leaf == head && first.index == 0 && !last.leaf) {
+                clear();
+                return end();
+            }
+            //删除会挪动元素 所以每次按剩下的个数数
+            size_t n = 0;
+            for (const_iterator it = first; it != last; ++it) n++;
+            iterator it(this, first.leaf, first.index);
+            while (n--) it = eraseAt(it.leaf, it.index);
+            return it;
+        }
+        /**
+         * Returns the number of elements with key
+         *   that compares equivalent to the specified argument,
+         *   which is either 1 or 0
+         *     since this container does not allow duplicates.
+         */
+        size_t count(const Key& key) const {
+            size_t i;
+            return find(key, i) ? 1 : 0;
+        }
+        /**
+         * Finds an element with key equivalent to key.
+         *   If no such element is found, past-the-end (see end()) iterator is returned.
+         */
+        iterator find(const Key& key) {
+            size_t i;
+            LeafNode* leaf = find(key, i);
+            if (leaf) return iterator(this, leaf, i);
+            return end();
+        }
+        const_iterator find(const Key& key) const {
+            size_t i;
+            LeafNode* leaf = find(key, i);
+            if (leaf) return const_iterator(this, leaf, i);
+            return cend();
+        }
+        /**
+         * returns an iterator to the first element whose key is not less than key,
+         *   or end() if there is none.
+         */
+        iterator lower_bound(const Key& key) {
+            size_t i;
+            LeafNode* leaf = lowerBound(key, i);
+            return iterator(this, leaf, i);
+        }
+        const_iterator lower_bound(const Key& key) const {
+            size_t i;
+            LeafNode* leaf = lowerBound(key, i);
+            return const_iterator(this, leaf, i);
+        }
+        /**
+         * returns an iterator to the first element whose key is greater than key,
+         *   or end() if there is none.
+         */
+        iterator upper_bound(const Key& key) {
+            size_t i;
+            LeafNode* leaf = upperBound(key, i);
+            return iterator(this, leaf, i);
+        }
+        const_iterator upper_bound(const Key& key) const {
+            size_t i;
+            LeafNode* leaf = upperBound(key, i);
+            return const_iterator(this, leaf, i);
+        }
+        /**
+         * returns [lower_bound(key), upper_bound(key)), which holds at most one element.
+         */
+        pair<iterator, iterator> equal_range(const Key& key) {
+            iterator lo = lower_bound(key);
+            iterator hi = lo;
+            if (lo.leaf && !Compare()(key, lo->first)) ++hi;
+            return pair<iterator, iterator>(lo, hi);
+        }
+        pair<const_iterator, const_iterator> equal_range(const Key& key) const {
+            const_iterator lo = lower_bound(key);
+            const_iterator hi = lo;
+            if (lo.leaf && !Compare()(key, lo->first)) ++hi;
+            return pair<const_iterator, const_iterator>(lo, hi);
+        }
+        /**
+         * calls fn(value) for every element whose key lies in [lo, hi), in ascending order.
+         * scans the leaves directly, without iterator objects or their bounds checks.
+         * fn must not insert into or erase from this map.
+         */
+        template<class Fn>
+        void for_each_in_range(const Key& lo, const Key& hi, Fn fn) {
+            size_t i;
+            for (LeafNode* leaf = lowerBound(lo, i); leaf; leaf = leaf->next, i = 0)
+                for (; i < leaf->count; i++) {
+                    if (!Compare()(leaf->key(i), hi)) return;
+                    fn(leaf->data()[i]);
+                }
+        }
+        template<class Fn>
+        void for_each_in_range(const Key& lo, const Key& hi, Fn fn) const {
+            size_t i;
+            for (LeafNode* leaf = lowerBound(lo, i); leaf; leaf = leaf->next, i = 0)
+                for (; i < leaf->count; i++) {
+                    if (!Compare()(leaf->key(i), hi)) return;
+                    fn(static_cast<const value_type&>(leaf->data()[i]));
+                }
+        }
+    };
+
+}
+
+#endif
@@ -0,0 +1,413 @@
+/**
+ * implement an ordered map whose readers never take a lock
+ */
+#ifndef SJTU_CONCURRENT_MAP_HPP
+#define SJTU_CONCURRENT_MAP_HPP
+
+ // only for std::less<T>
+#include <functional>
+#include <atomic>
+#include <climits>
+#include <cstddef>
+#include <mutex>
+#include <thread>
+#include <new>
+#include "utility.hpp"
+#include "exceptions.hpp"
+#include "node_pool.hpp"
+
+namespace sjtu {
+
+    /**
+     * an ordered map for read-mostly data shared between threads.
+     *
+     * readers (at, count, find, for_each) take no lock and never wait for writers:
+     *   the tree is immutable once published. a writer copies the nodes on the path it
+     *   changes (an AVL tree without parent pointers, so only O(log n) nodes are copied),
+     *   then swaps in the new root with one atomic store. writers are serialized by a mutex.
+     * replaced nodes are reclaimed by epochs: a reader announces the epoch in which it
+     *   started in a per-thread slot, and a node retired in epoch e is freed only once
+     *   every announced epoch is later than e, i.e. no reader can still be looking at it.
+     * elements themselves are allocated once and shared by all versions of their node,
+     *   so path copying never copies a key or a value.
+     *
+     * values are only reachable while a read is in progress, so there are no iterators:
+     *   a value is copied out (at) or handed to a callback (find, for_each).
+     *   for_each sees one consistent version of the whole map, however long it takes.
+     * at most READER_SLOTS threads read at the same moment; more readers spin until
+     *   a slot is free. callbacks must not write to the same map.
+     */
+    template<
+        class Key,
+        class T,
+        class Compare = std::less<Key>,
+        class Allocator = std::allocator<pair<const Key, T>>
+    > class concurrent_map {
+    public:
+        typedef pair<const Key, T> value_type;
+        static constexpr size_t READER_SLOTS = 64;
+    private:
+        //发布之后left right value height都不再改 读者只看这几个
+        //后面几项只有持锁的写者用 读者碰不到
+        struct Node {
+            const Node* left;
+            const Node* right;
+            value_type* value;
+            int height;
+            bool ownsValue;//删掉或者换掉value时由最后一个持有它的旧结点负责释放
+            Node* nextFresh;//这次写新建的结点 出异常时全部释放
+            Node* nextRetired;
+            unsigned long long retireEpoch;
+        };
+        //一次写操作里新建的和被替换下来的结点
+        struct Batch {
+            Node* fresh = nullptr;
+            Node* retired = nullptr;
+            Node* retiredTail = nullptr;
+        };
+        struct alignas(64) ReaderSlot {
+            std::atomic<unsigned long long> epoch;
+        };
+        static constexpr unsigned long long IDLE = ULLONG_MAX;
+
+        node_pool<Node, Allocator> nodePool;
+        node_pool<value_type, Allocator> valuePool;
+        std::atomic<const Node*> root;
+        std::atomic<size_t> len;
+        std::atomic<unsigned long long> epoch;
+        mutable ReaderSlot readers[READER_SLOTS];
+        std::mutex writeLock;
+        //按retireEpoch从小到大排着
+        Node* retiredHead;
+        Node* retiredTail;
+
+        //读者占一个槽 写下自己开始时的epoch 每个线程从自己固定的槽开始找
+        size_t pin() const {
+            static thread_local size_t start = std::hash<std::thread::id>()(std::this_thread::get_id());
+            for (size_t i = start % READER_SLOTS; ; i = (i + 1) % READER_SLOTS) {
+                unsigned long long idle = IDLE;
+                if (readers[i].epoch.compare_exchange_strong(idle, epoch.load()))
+                    return i;
+            }
+        }
+        class ReadGuard {
+            const concurrent_map* m;
+            size_t slot;
+        public:
+            explicit ReadGuard(const concurrent_map* _m) : m(_m), slot(_m->pin()) {}
+            ~ReadGuard() {
+                m->readers[slot].epoch.store(IDLE, std::memory_order_release);
+            }
+        };
+
+        const Node* findNode(const Key& key) const {
+            const Node* n = root.load();
+            while (n) {
+                if (Compare()(key, n->value->first)) n = n->left;
+                else if (Compare()(n->value->first, key)) n = n->right;
+                else return n;
+            }
+            return nullptr;
+        }
+
+        static int height(const Node* n) noexcept {
+            return n ? n->height : 0;
+        }
+        const Node* make(const Node* l, value_type* v, const Node* r, Batch& b) {
+            Node* n = new(nodePool.allocate()) Node();
+            n->left = l;
+            n->right = r;
+            n->value = v;
+            n->height = 1 + (height(l) > height(r) ? height(l) : height(r));
+            n->ownsValue = false;
+            n->nextFresh = b.fresh;
+            b.fresh = n;
+            return n;
+        }
+        //被新版本替换下来的结点 等所有可能看到它的读者走了再释放
+        static void retire(const Node* node, Batch& b) noexcept {
+            Node* n = const_cast<Node*>(node);
+            n->nextRetired = nullptr;
+            if (b.retiredTail) b.retiredTail->nextRetired = n;
+            else b.retired = n;
+            b.retiredTail = n;
+        }
+        //用l v r拼出一个结点 两边高度差超过1就旋转 拆开的旧结点都退休
+        const Node* balance(const Node* l, value_type* v, const Node* r, Batch& b) {
+            int hl = height(l), hr = height(r);
+            if (hl > hr + 1) {
+                retire(l, b);
+                if (height(l->left) >= height(l->right))
+                    return make(l->left, l->value, make(l->right, v, r, b), b);
+                const Node* lr = l->right;
+                retire(lr, b);
+                return make(make(l->left, l->value, lr->left, b), lr->value, make(lr->right, v, r, b), b);
+            }
+            if (hr > hl + 1) {
+                retire(r, b);
+                if (height(r->right) >= height(r->left))
+                    return make(make(l, v, r->left, b), r->value, r->right, b);
+                const Node* rl = r->left;
+                retire(rl, b);
+                return make(make(l, v, rl->left, b), rl->value, make(rl->right, r->value, r->right, b), b);
+            }
+            return make(l, v, r, b);
+        }
+        //key不在树里时插入v key已经在时把它的value换成v
+        const Node* insert(const Node* n, value_type* v, Batch& b) {
+            if (!n) return make(nullptr, v, nullptr, b);
+            retire(n, b);
+            if (Compare()(v->first, n->value->first)) return balance(insert(n->left, v, b), n->value, n->right, b);
+            if (Compare()(n->value->first, v->first)) return balance(n->left, n->value, insert(n->right, v, b), b);
+            const_cast<Node*>(n)->ownsValue = true;
+            return make(n->left, v, n->right, b);
+        }
+        const Node* removeMin(const Node* n, value_type*& min, Batch& b) {
+            retire(n, b);
+            if (!n->left) {
+                min = n->value;
+                return n->right;
+            }
+            return balance(removeMin(n->left, min, b), n->value, n->right, b);
+        }
+        //只在key确实存在时调用
+        const Node* remove(const Node* n, const Key& key, Batch& b) {
+            retire(n, b);
+            if (Compare()(key, n->value->first)) return balance(remove(n->left, key, b), n->value, n->right, b);
+            if (Compare()(n->value->first, key)) return balance(n->left, n->value, remove(n->right, key, b), b);
+            const_cast<Node*>(n)->ownsValue = true;
+            if (!n->left) return n->right;
+            if (!n->right) return n->left;
+            value_type* min;
+            const Node* r = removeMin(n->right, min, b);
+            return balance(n->left, min, r, b);
+        }
+        static void retireAll(const Node* n, Batch& b) noexcept {
+            if (!n) return;
+            retireAll(n->left, b);
+            retireAll(n->right, b);
+            const_cast<Node*>(n)->ownsValue = true;
+            retire(n, b);
+        }
+
+        template<class... Args>
+        value_type* newValue(Args&&... args) {
+            void* mem = valuePool.allocate();
+            try {
+                return new(mem) value_type(std::forward<Args>(args)...);
+            }
+            catch (...) {
+                valuePool.deallocate(mem);
+                throw;
+            }
+        }
+        void freeValue(value_type* v) noexcept {
+            v->~value_type();
+            valuePool.deallocate(v);
+        }
+        void freeNode(Node* n) noexcept {
+            if (n->ownsValue) freeValue(n->value);
+            n->~Node();
+            nodePool.deallocate(n);
+        }
+        //还没发布就出了异常 新建的结点全部释放 旧版本一点没动
+        //旧结点上改过的ownsValue也要改回去 它们还在树里
+        void abandon(Batch& b) noexcept {
+            for (Node* n = b.retired; n; n = n->nextRetired) n->ownsValue = false;
+            while (b.fresh) {
+                Node* n = b.fresh;
+                b.fresh = n->nextFresh;
+                n->~Node();
+                nodePool.deallocate(n);
+            }
+        }
+        //换上新的根 这次替换下来的结点记在当前epoch里 然后epoch加一
+        //之后才开始读的读者拿到的epoch更大 也一定看到新的根
+        void publish(const Node* newRoot, Batch& b) noexcept {
+            root.store(newRoot);
+            unsigned long long e = epoch.fetch_add(1);
+            for (Node* n = b.retired; n; n = n->nextRetired) n->retireEpoch = e;
+            if (b.retired) {
+                if (retiredTail) retiredTail->nextRetired = b.retired;
+                else retiredHead = b.retired;
+                retiredTail = b.retiredTail;
+            }
+            reclaim();
+        }
+        //还在读的读者里最早的epoch之前退休的结点都没人看得到了
+        void reclaim() noexcept {
+            unsigned long long oldest = IDLE;
+            for (size_t i = 0; i < READER_SLOTS; i++) {
+                unsigned long long e = readers[i].epoch.load();
+                if (e < oldest) oldest = e;
+            }
+            while (retiredHead && retiredHead->retireEpoch < oldest) {
+                Node* n = retiredHead;
+                retiredHead = n->nextRetired;
+                freeNode(n);
+            }
+            if (!retiredHead) retiredTail = nullptr;
+        }
+        void destroyTree(const Node* n) noexcept {
+            if (!n) return;
+            destroyTree(n->left);
+            destroyTree(n->right);
+            Node* m = const_cast<Node*>(n);
+            m->ownsValue = true;
+            freeNode(m);
+        }
+
+        //持锁时调用 value已经造好 失败时由这里释放
+        //key已经在的话换掉原来的value
+        bool insertValue(value_type* v) {
+            Batch b;
+            try {
+                bool present = findNode(v->first) != nullptr;
+                publish(insert(root.load(), v, b), b);
+                if (!present) len.fetch_add(1);
+                return !present;
+            }
+            catch (...) {
+                abandon(b);
+                freeValue(v);
+                throw;
+            }
+        }
+
+    public:
+        concurrent_map() : root(nullptr), len(0), epoch(0), retiredHead(nullptr), retiredTail(nullptr) {
+            for (size_t i = 0; i < READER_SLOTS; i++) readers[i].epoch.store(IDLE);
+        }
+        concurrent_map(const concurrent_map&) = delete;
+        concurrent_map& operator=(const concurrent_map&) = delete;
+        /**
+         * no other thread may use the map any more.
+         */
+        ~concurrent_map() {
+            while (retiredHead) {
+                Node* n = retiredHead;
+                retiredHead = n->nextRetired;
+                freeNode(n);
+            }
+            destroyTree(root.load());
+        }
+
+        /**
+         * returns a copy of the mapped value of key.
+         * throw index_out_of_bound if such key does not exist.
+         */
+        T at(const Key& key) const {
+            ReadGuard guard(this);
+            const Node* n = findNode(key);
+            if (!n) throw index_out_of_bound();
+            return n->value->second;
+        }
+        size_t count(const Key& key) const {
+            ReadGuard guard(this);
+            return findNode(key) ? 1 : 0;
+        }
+        /**
+         * calls fn(const value_type&) on the element with key, if any; returns whether it was found.
+         * the element stays alive until fn returns, even if a writer erases it meanwhile.
+         */
+        template<class Fn>
+        bool find(const Key& key, Fn fn) const {
+            ReadGuard guard(this);
+            const Node* n = findNode(key);
+            if (!n) return false;
+            fn(static_cast<const value_type&>(*(n->value)));
+            return true;
+        }
+        /**
+         * calls fn(const value_type&) for every element in ascending order.
+         * all of them belong to the version that was current when for_each started.
+         */
+        template<class Fn>
+        void for_each(Fn fn) const {
+            ReadGuard guard(this);
+            //没有parent指针 用栈做中序遍历 AVL树高不超过1.44log(n)
+            const Node* stack[96];
+            size_t top = 0;
+            const Node* n = root.load();
+            while (n || top) {
+                while (n) {
+                    stack[top++] = n;
+                    n = n->left;
+                }
+                n = stack[--top];
+                fn(static_cast<const value_type&>(*(n->value)));
+                n = n->right;
+            }
+        }
+        /**
+         * the number of elements; with concurrent writers only a recent value.
+         */
+        size_t size() const {
+            return len.load();
+        }
+        bool empty() const {
+            return size() == 0;
+        }
+
+        /**
+         * inserts value if its key is absent; returns whether it was inserted.
+         */
+        bool insert(const value_type& value) {
+            std::lock_guard<std::mutex> guard(writeLock);
+            if (findNode(value.first)) return false;
+            return insertValue(newValue(value));
+        }
+        bool insert(value_type&& value) {
+            std::lock_guard<std::mutex> guard(writeLock);
+            if (findNode(value.first)) return false;
+            return insertValue(newValue(std::move(value)));
+        }
+        /**
+         * inserts value_type(key, T(args...)) if key is absent; otherwise args are left untouched.
+         */
+        template<class... Args>
+        bool try_emplace(const Key& key, Args&&... args) {
+            std::lock_guard<std::mutex> guard(writeLock);
+            if (findNode(key)) return false;
+            return insertValue(newValue(std::piecewise_construct,
+                std::forward_as_tuple(key), std::forward_as_tuple(std::forward<Args>(args)...)));
+        }
+        /**
+         * sets the mapped value of key to obj, inserting key if it is absent.
+         * the old element is replaced by a new one, readers still holding it are unaffected.
+         * returns true if an insertion took place.
+         */
+        template<class M>
+        bool insert_or_assign(const Key& key, M&& obj) {
+            std::lock_guard<std::mutex> guard(writeLock);
+            return insertValue(newValue(key, std::forward<M>(obj)));
+        }
+        /**
+         * removes key if present; returns the number of elements removed (0 or 1).
+         */
+        size_t erase(const Key& key) {
+            std::lock_guard<std::mutex> guard(writeLock);
+            if (!findNode(key)) return 0;
+            Batch b;
+            try {
+                publish(remove(root.load(), key, b), b);
+            }
+            catch (...) {
+                abandon(b);
+                throw;
+            }
+            len.fetch_sub(1);
+            return 1;
+        }
+        void clear() {
+            std::lock_guard<std::mutex> guard(writeLock);
+            Batch b;
+            retireAll(root.load(), b);
+            publish(nullptr, b);
+            len.store(0);
+        }
+    };
+
+}
+
+#endif
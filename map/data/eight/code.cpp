@@ -0,0 +1,133 @@
+#include "map.hpp"
+#include <iostream>
+#include <cassert>
+#include <string>
+#include <iterator>
+#include <thread>
+
+class Integer {
+public:
+	static int counter;
+	int val;
+
+	Integer(int val) : val(val) {
+		counter++;
+	}
+
+	Integer(const Integer &rhs) {
+		val = rhs.val;
+		counter++;
+	}
+
+	Integer& operator = (const Integer &rhs) {
+		assert(false);
+	}
+
+	~Integer() {
+		counter--;
+	}
+};
+
+int Integer::counter = 0;
+
+class Compare {
+public:
+	bool operator () (const Integer &lhs, const Integer &rhs) const {
+		return lhs.val < rhs.val;
+	}
+};
+
+typedef sjtu::map<Integer, std::string, Compare> map_type;
+
+void print(const map_type &map) {
+	std::cout << map.size() << ":";
+	for (auto it = map.cbegin(); it != map.cend(); ++it) std::cout << " " << it->first.val;
+	std::cout << std::endl;
+}
+
+void tester(void) {
+	map_type a, b;
+	for (int i = 0; i < 10; ++i) a[Integer(i * 2)] = "a";
+	for (int i = 0; i < 10; ++i) b[Integer(i * 3)] = "b";
+	//	test: extract(), insert(node_type)
+	map_type::node_type nh = a.extract(Integer(4));
+	std::cout << nh.empty() << " " << nh.key().val << " " << nh.mapped() << std::endl;
+	std::cout << a.extract(Integer(5)).empty() << std::endl;
+	nh.mapped() = "moved";
+	auto res = b.insert(std::move(nh));
+	std::cout << res.inserted << " " << res.position->second << " " << res.node.empty() << " " << nh.empty() << std::endl;
+	res = b.insert(a.extract(a.find(Integer(6))));
+	std::cout << res.inserted << " " << res.position->second << " " << res.node.mapped() << std::endl;
+	a.insert(a.end(), std::move(res.node));
+	print(a);
+	print(b);
+	//	test: merge()
+	a.merge(b);
+	print(a);
+	print(b);
+	//	test: split(), join()
+	map_type high = a.split(Integer(10));
+	print(a);
+	print(high);
+	map_type top = high.split(Integer(25));
+	print(top);
+	a.join(high);
+	a.join(top);
+	print(a);
+	std::cout << high.empty() << " " << top.empty() << std::endl;
+	try {
+		b.join(a);
+		b[Integer(1)] = "x";
+		b.join(a);
+		std::cout << "no exception" << std::endl;
+	} catch (sjtu::runtime_error &) {
+		std::cout << "runtime_error" << std::endl;
+	}
+	print(b);
+	//	test: large split and join keep the tree usable
+	map_type big;
+	for (int i = 0; i < 100000; ++i) big.insert(big.end(), sjtu::pair<const Integer, std::string>(Integer(i), ""));
+	long long check = 0;
+	for (int q = 1; q < 1000; ++q) {
+		map_type part = big.split(Integer(q * 97));
+		check += part.size() + big.size() + part.cbegin()->first.val;
+		big.join(part);
+	}
+	std::cout << check << " " << big.size() << std::endl;
+	for (int i = 0; i < 100000; i += 2) big.erase(big.find(Integer(i)));
+	std::cout << big.size() << " " << big.cbegin()->first.val << std::endl;
+}
+
+//	test: the two halves of a split share their slabs and are used from two threads
+void threads() {
+	sjtu::map<int, int> low;
+	for (int i = 0; i < 200000; ++i) low[i] = i;
+	sjtu::map<int, int> high = low.split(100000);
+	auto work = [](sjtu::map<int, int>* m, int from, int extra) {
+		for (int round = 0; round < 5; ++round) {
+			for (int i = from; i < from + 100000; i += 2) m->erase(m->find(i));
+			for (int i = from; i < from + 100000; i += 2) (*m)[i] = round;
+		}
+		for (int i = extra; i < extra + 50000; ++i) (*m)[i] = 1;
+	};
+	std::thread t(work, &high, 100000, 200000);
+	work(&low, 0, -50000);
+	t.join();
+	std::cout << low.size() << " " << high.size() << " ";
+	low.join(high);
+	long long sum = 0;
+	int prev = low.cbegin()->first - 1;
+	bool sorted = true;
+	for (auto it = low.cbegin(); it != low.cend(); ++it) {
+		if (it->first <= prev) sorted = false;
+		prev = it->first;
+		sum += it->second;
+	}
+	std::cout << low.size() << " " << sorted << " " << sum << std::endl;
+}
+
+int main(void) {
+	tester();
+	std::cout << Integer::counter << std::endl;
+	threads();
+}
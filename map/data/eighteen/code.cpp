@@ -0,0 +1,70 @@
+#include "map.hpp"
+#include <iostream>
+#include <cassert>
+#include <string>
+
+//	a comparator with state: orders the keys up or down
+class Order {
+public:
+	bool down;
+	explicit Order(bool down = false) : down(down) {}
+	bool operator () (int lhs, int rhs) const {
+		return down ? rhs < lhs : lhs < rhs;
+	}
+};
+
+typedef sjtu::map<int, std::string, Order> omap;
+
+void print(const omap &m) {
+	std::cout << m.size() << (m.key_comp().down ? " down:" : " up:");
+	for (auto it = m.cbegin(); it != m.cend(); ++it) std::cout << " " << it->first;
+	std::cout << std::endl;
+}
+
+void tester(void) {
+	//	test: the comparator passed in is the one used
+	omap d(Order(true)), u;
+	for (int i = 0; i < 6; ++i) {
+		d[i] = std::to_string(i);
+		u[i] = std::to_string(i);
+	}
+	print(d);
+	print(u);
+	std::cout << d.count(3) << " " << d.lower_bound(3)->first << " " << d.upper_bound(3)->first << std::endl;
+	//	test: copies, assignments, moves and swaps carry the comparator along
+	omap c(d);
+	c[10] = "10";
+	print(c);
+	omap a;
+	a = d;
+	a[-1] = "-1";
+	print(a);
+	omap m(std::move(a));
+	print(m);
+	m.swap(u);
+	print(m);
+	print(u);
+	u = std::move(m);
+	print(u);
+	//	test: split keeps the ordering of the original
+	omap r = c.split(3);
+	print(c);
+	print(r);
+	//	test: an empty comparator costs no space
+	std::cout << (sizeof(sjtu::map<int, int>) < sizeof(sjtu::map<int, int, Order>)) << std::endl;
+	//	test: trivially destructible values are still cleared properly
+	sjtu::map<int, int> t;
+	for (int i = 0; i < 1000; ++i) t[i] = i;
+	t.clear();
+	t[1] = 2;
+	sjtu::map<int, int> s;
+	for (int i = 0; i < 1000; ++i) s[i] = i;
+	t.merge(s);
+	t.clear();
+	std::cout << t.size() << " " << s.size() << " " << s.cbegin()->first << std::endl;
+}
+
+int main(void) {
+	tester();
+	return 0;
+}
@@ -0,0 +1,127 @@
+#include "persistent_map.hpp"
+#include <map>
+#include <vector>
+#include <iostream>
+#include <cassert>
+#include <string>
+
+class Integer {
+public:
+	static int counter;
+	int val;
+
+	Integer(int val) : val(val) {
+		counter++;
+	}
+
+	Integer(const Integer &rhs) {
+		val = rhs.val;
+		counter++;
+	}
+
+	Integer& operator = (const Integer &rhs) {
+		assert(false);
+	}
+
+	~Integer() {
+		counter--;
+	}
+};
+
+int Integer::counter = 0;
+
+class Compare {
+public:
+	bool operator () (const Integer &lhs, const Integer &rhs) const {
+		return lhs.val < rhs.val;
+	}
+};
+
+typedef sjtu::persistent_map<Integer, std::string, Compare> pmap;
+typedef sjtu::pair<const Integer, std::string> value;
+
+//	compares a snapshot (or map) element by element with a std::map model
+template<class M>
+bool same(const M &m, const std::map<int, std::string> &model) {
+	if (m.size() != model.size()) return false;
+	auto it = model.begin();
+	bool ok = true;
+	m.for_each([&](const value &v) {
+		if (it == model.end() || it->first != v.first.val || it->second != v.second) ok = false;
+		else ++it;
+	});
+	if (!ok) return false;
+	it = model.begin();
+	for (auto p = m.cbegin(); p != m.cend(); ++p, ++it)
+		if (p->first.val != it->first || p->second != it->second) return false;
+	return true;
+}
+
+void tester(void) {
+	//	test: the basic operations
+	pmap map;
+	for (int i = 0; i < 1000; ++i) map.insert(value(Integer(i * 7 % 1000), std::to_string(i)));
+	std::cout << map.size() << " " << map.insert(value(Integer(7), "x")).second << " " << map.at(Integer(7)) << std::endl;
+	std::cout << map.insert_or_assign(Integer(7), std::string("seven")).second << " " << map[Integer(7)] << std::endl;
+	map[Integer(1000)] = "new";
+	std::cout << map.size() << " " << map.erase(Integer(3)) << " " << map.erase(Integer(3)) << " " << map.count(Integer(3)) << std::endl;
+	try {
+		map.at(Integer(3));
+	} catch (...) {
+		std::cout << "at throws" << std::endl;
+	}
+	auto it = map.lower_bound(Integer(3));
+	std::cout << it->first.val << " " << (--it)->first.val << " " << map.upper_bound(Integer(999))->first.val << std::endl;
+	it = map.cend();
+	std::cout << (--it)->first.val << " " << (map.find(Integer(3)) == map.cend()) << std::endl;
+	try {
+		--map.cbegin();
+	} catch (...) {
+		std::cout << "-- begin throws" << std::endl;
+	}
+	//	test: snapshots stay frozen while the map keeps changing
+	std::map<int, std::string> model;
+	for (auto p = map.cbegin(); p != map.cend(); ++p) model[p->first.val] = p->second;
+	std::vector<pmap::snapshot_type> snaps;
+	std::vector<std::map<int, std::string>> models;
+	unsigned k = 1;
+	for (int round = 0; round < 40; ++round) {
+		snaps.push_back(map.snapshot());
+		models.push_back(model);
+		for (int i = 0; i < 300; ++i) {
+			k = k * 1103515245u + 12345u;
+			int key = (int)(k >> 8) % 1500;
+			if (k % 3 == 0) {
+				map.erase(Integer(key));
+				model.erase(key);
+			}
+			else if (k % 3 == 1) {
+				map.insert_or_assign(Integer(key), std::to_string(round));
+				model[key] = std::to_string(round);
+			}
+			else {
+				map[Integer(key)] += "+";
+				model[key] += "+";
+			}
+		}
+		if (round % 8 == 3) snaps.erase(snaps.begin()), models.erase(models.begin());
+	}
+	bool ok = same(map, model);
+	for (size_t i = 0; i < snaps.size(); ++i) ok = ok && same(snaps[i], models[i]);
+	std::cout << ok << " " << snaps.size() << " " << map.size() << std::endl;
+	//	test: copies of maps and snapshots share nodes, and a map can restart from a snapshot
+	pmap copy = map;
+	copy.clear();
+	pmap back(snaps[0]);
+	back.erase(Integer(0));
+	models[0].erase(0);
+	std::cout << same(map, model) << " " << copy.empty() << " " << same(back, models[0]) << " " << same(snaps[1], models[1]) << std::endl;
+	pmap::snapshot_type s = map.snapshot();
+	map.clear();
+	std::cout << s.size() << " " << s.at(Integer(model.begin()->first)) << " " << s.count(Integer(1500)) << " " << map.empty() << std::endl;
+}
+
+int main(void) {
+	tester();
+	std::cout << Integer::counter << std::endl;
+}
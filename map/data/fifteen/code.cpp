@@ -0,0 +1,97 @@
+#include "map.hpp"
+#include "mapped_map.hpp"
+#include <iostream>
+#include <cstdio>
+#include <string>
+
+struct Point {
+	double x, y;
+	int id;
+};
+
+const char *path = "fifteen.map.tmp";
+
+template<class F>
+bool throws(F f) {
+	try {
+		f();
+	}
+	catch (sjtu::runtime_error &) {
+		return true;
+	}
+	catch (sjtu::index_out_of_bound &) {
+		return true;
+	}
+	return false;
+}
+
+void tester(void) {
+	sjtu::map<int, Point> m;
+	for (int i = 0; i < 100000; ++i) {
+		int k = (int)((i * 7919LL) % 100000) * 2;
+		m[k] = Point{k * 0.5, -k * 0.25, i};
+	}
+	m.save(path);
+	//	test: every key and every gap, in the same order
+	sjtu::mapped_map<int, Point> v = sjtu::map<int, Point>::open_mapped(path);
+	std::cout << v.size() << " " << v.empty() << std::endl;
+	bool same = true;
+	auto it = m.cbegin();
+	for (auto p = v.begin(); p != v.end(); ++p, ++it)
+		if (p->first != it->first || p->second.id != it->second.id || p->second.x != it->second.x) same = false;
+	for (int k = -3; k < 200003; ++k) {
+		auto p = v.find(k);
+		if ((k >= 0 && k < 200000 && k % 2 == 0) != (p != v.end())) same = false;
+		if (p != v.end() && p->second.id != m.at(k).id) same = false;
+		if (v.count(k) != m.count(k)) same = false;
+	}
+	std::cout << same << std::endl;
+	std::cout << v.lower_bound(7)->first << " " << v.upper_bound(8)->first << " "
+		<< (v.lower_bound(199999) == v.end()) << " " << v.at(1000).y << std::endl;
+	std::cout << throws([&] { v.at(1); }) << std::endl;
+	//	test: back into a mutable map
+	sjtu::map<int, Point> back = v.to_map();
+	back.erase(back.find(0));
+	back[1] = Point{0, 0, -1};
+	std::cout << back.size() << " " << back.begin()->first << " " << v.begin()->first << std::endl;
+	//	test: moved, the view keeps the mapping
+	sjtu::mapped_map<int, Point> w(std::move(v));
+	std::cout << v.size() << " " << w.size() << " " << w.at(199998).id << std::endl;
+	//	test: an empty map
+	sjtu::map<int, Point> empty;
+	empty.save(path);
+	sjtu::mapped_map<int, Point> e(path);
+	std::cout << e.size() << " " << (e.begin() == e.end()) << " " << (e.find(0) == e.end()) << std::endl;
+	//	test: files that do not hold such a map
+	m.save(path);
+	std::cout << throws([] { sjtu::mapped_map<int, double> bad(path); })
+		<< throws([] { sjtu::mapped_map<int, Point> bad("no/such/file"); });
+	std::FILE *f = std::fopen(path, "r+b");
+	std::fseek(f, 0, SEEK_SET);
+	std::fputc('X', f);
+	std::fclose(f);
+	std::cout << throws([] { sjtu::mapped_map<int, Point> bad(path); });
+	m.save(path);
+	f = std::fopen(path, "ab");
+	std::fclose(f);
+	{
+		//	cut off the last element
+		std::FILE *in = std::fopen(path, "rb");
+		std::fseek(in, 0, SEEK_END);
+		long n = std::ftell(in);
+		std::fseek(in, 0, SEEK_SET);
+		std::string data(n, 0);
+		size_t got = std::fread(&data[0], 1, n, in);
+		std::fclose(in);
+		std::FILE *out = std::fopen(path, "wb");
+		std::fwrite(data.data(), 1, got - 1, out);
+		std::fclose(out);
+	}
+	std::cout << throws([] { sjtu::mapped_map<int, Point> bad(path); }) << std::endl;
+}
+
+int main(void) {
+	tester();
+	std::remove(path);
+	return 0;
+}
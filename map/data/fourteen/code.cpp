@@ -0,0 +1,98 @@
+#include "map.hpp"
+#include <iostream>
+#include <cassert>
+#include <string>
+#include <string_view>
+
+class Integer {
+public:
+	static int counter, created;
+	int val;
+
+	Integer(int val) : val(val) {
+		counter++;
+		created++;
+	}
+
+	Integer(const Integer &rhs) {
+		val = rhs.val;
+		counter++;
+		created++;
+	}
+
+	Integer& operator = (const Integer &rhs) {
+		assert(false);
+	}
+
+	~Integer() {
+		counter--;
+	}
+};
+
+int Integer::counter = 0, Integer::created = 0;
+
+class Compare {
+public:
+	bool operator () (const Integer &lhs, const Integer &rhs) const {
+		return lhs.val < rhs.val;
+	}
+};
+#include <vector>
+#include <list>
+
+void tester(void) {
+	sjtu::map<Integer, int, Compare> m;
+	//	test: an empty map finds nothing
+	std::vector<Integer> keys;
+	for (int i = 0; i < 100; ++i) keys.push_back(Integer(i));
+	std::vector<size_t> counts;
+	m.count_batch(keys.begin(), keys.end(), std::back_inserter(counts));
+	size_t found = 0;
+	for (size_t c : counts) found += c;
+	std::cout << counts.size() << " " << found << std::endl;
+	//	test: batches of every length against single lookups, hits and misses mixed
+	for (int i = 0; i < 5000; ++i) m[Integer(i * 3)] = i;
+	bool same = true;
+	for (int len : {1, 15, 16, 17, 33, 1000}) {
+		keys.clear();
+		for (int i = 0; i < len; ++i) keys.push_back(Integer((i * 7919) % 15100 - 50));
+		std::vector<sjtu::map<Integer, int, Compare>::iterator> out(len, m.end());
+		auto e = m.find_batch(keys.begin(), keys.end(), out.begin());
+		if (e != out.end()) same = false;
+		for (int i = 0; i < len; ++i) if (out[i] != m.find(keys[i])) same = false;
+		counts.clear();
+		m.count_batch(keys.begin(), keys.end(), std::back_inserter(counts));
+		for (int i = 0; i < len; ++i) if (counts[i] != m.count(keys[i])) same = false;
+	}
+	std::cout << same << std::endl;
+	//	test: const map, list iterators, results in input order
+	const sjtu::map<Integer, int, Compare> &cm = m;
+	std::list<Integer> lk;
+	lk.push_back(Integer(30));
+	lk.push_back(Integer(31));
+	lk.push_back(Integer(0));
+	lk.push_back(Integer(14997));
+	std::vector<sjtu::map<Integer, int, Compare>::const_iterator> co;
+	cm.find_batch(lk.begin(), lk.end(), std::back_inserter(co));
+	for (auto &it : co) {
+		if (it == cm.cend()) std::cout << "end ";
+		else std::cout << it->second << " ";
+	}
+	std::cout << std::endl;
+	//	test: the one-element tree
+	sjtu::map<Integer, int, Compare> one;
+	one[Integer(5)] = 1;
+	counts.clear();
+	one.count_batch(lk.begin(), lk.end(), std::back_inserter(counts));
+	lk.clear();
+	lk.push_back(Integer(5));
+	one.count_batch(lk.begin(), lk.end(), std::back_inserter(counts));
+	for (size_t c : counts) std::cout << c;
+	std::cout << std::endl;
+}
+
+int main(void) {
+	tester();
+	std::cout << Integer::counter << std::endl;
+	return 0;
+}
@@ -0,0 +1,125 @@
+#include "btree_map.hpp"
+#include <map>
+#include <cstdlib>
+#include <iostream>
+#include <cassert>
+#include <string>
+
+class Integer {
+public:
+	static int counter;
+	int val;
+
+	Integer(int val) : val(val) {
+		counter++;
+	}
+
+	Integer(const Integer &rhs) {
+		val = rhs.val;
+		counter++;
+	}
+
+	Integer& operator = (const Integer &rhs) {
+		assert(false);
+	}
+
+	~Integer() {
+		counter--;
+	}
+};
+
+int Integer::counter = 0;
+
+class Compare {
+public:
+	bool operator () (const Integer &lhs, const Integer &rhs) const {
+		return lhs.val < rhs.val;
+	}
+};
+
+typedef sjtu::btree_map<Integer, std::string, Compare> bmap;
+
+bool same(const bmap &map, const std::map<int, std::string> &ref) {
+	if (map.size() != ref.size()) return false;
+	auto r = ref.begin();
+	for (auto p = map.cbegin(); p != map.cend(); ++p, ++r)
+		if (p->first.val != r->first || p->second != r->second) return false;
+	auto q = map.cend();
+	for (auto s = ref.rbegin(); s != ref.rend(); ++s)
+		if ((--q)->first.val != s->first) return false;
+	return q == map.cbegin();
+}
+
+void tester(void) {
+	//	test: random insert / erase against std::map, enough to split and merge nodes on every level
+	bmap map;
+	std::map<int, std::string> ref;
+	srand(2023);
+	for (int i = 0; i < 200000; ++i) {
+		int k = rand() % 20000;
+		if (rand() % 3) {
+			std::string v = std::to_string(rand());
+			bool a = map.insert(sjtu::pair<const Integer, std::string>(Integer(k), v)).second;
+			bool b = ref.insert(std::make_pair(k, v)).second;
+			if (a != b) std::cout << "insert " << k << std::endl;
+		}
+		else if (map.erase(Integer(k)) != ref.erase(k)) std::cout << "erase " << k << std::endl;
+	}
+	std::cout << map.size() << " " << same(map, ref) << std::endl;
+	//	test: operator[], at(), find(), lower_bound()
+	map[Integer(-5)] = "neg";
+	ref[-5] = "neg";
+	std::cout << map.at(Integer(-5)) << " " << (map.find(Integer(-4)) == map.end()) << " "
+		<< (map.lower_bound(Integer(-4))->first.val == ref.lower_bound(-4)->first) << std::endl;
+	try {
+		map.at(Integer(-4));
+	} catch (...) {
+		std::cout << "at throws" << std::endl;
+	}
+	//	test: copy, then erase every other element through the returned iterator
+	bmap copy(map);
+	for (auto p = copy.begin(); p != copy.end(); ) {
+		p = copy.erase(p);
+		if (p != copy.end()) ++p;
+	}
+	size_t k = 0;
+	for (auto r = ref.begin(); r != ref.end(); ++k) {
+		if (k % 2 == 0) r = ref.erase(r);
+		else ++r;
+	}
+	std::cout << copy.size() << " " << same(copy, ref) << std::endl;
+	//	test: appending sorted keys at end(), then draining from both ends
+	bmap seq;
+	for (int i = 0; i < 50000; ++i) seq.insert(seq.cend(), sjtu::pair<const Integer, std::string>(Integer(i), ""));
+	std::cout << seq.size() << " " << seq.cbegin()->first.val << " " << (--seq.cend())->first.val << std::endl;
+	while (seq.size() > 10) {
+		seq.erase(seq.begin());
+		seq.erase(--seq.end());
+	}
+	std::cout << seq.begin()->first.val << " " << (--seq.end())->first.val << std::endl;
+	//	test: invalid iterators
+	try {
+		--seq.begin();
+	} catch (...) {
+		std::cout << "begin throws" << std::endl;
+	}
+	try {
+		auto p = seq.end();
+		++p;
+	} catch (...) {
+		std::cout << "end throws" << std::endl;
+	}
+	try {
+		seq.erase(map.begin());
+	} catch (...) {
+		std::cout << "foreign throws" << std::endl;
+	}
+	map = seq;
+	seq.clear();
+	std::cout << map.size() << " " << seq.empty() << std::endl;
+}
+
+int main(void) {
+	tester();
+	std::cout << Integer::counter << std::endl;
+}
@@ -0,0 +1,87 @@
+#include "map.hpp"
+#include <iostream>
+#include <cassert>
+#include <string>
+
+class Integer {
+public:
+	static int counter;
+	int val;
+
+	Integer(int val) : val(val) {
+		counter++;
+	}
+
+	Integer(const Integer &rhs) {
+		val = rhs.val;
+		counter++;
+	}
+
+	Integer& operator = (const Integer &rhs) {
+		assert(false);
+	}
+
+	~Integer() {
+		counter--;
+	}
+};
+
+int Integer::counter = 0;
+
+class Compare {
+public:
+	bool operator () (const Integer &lhs, const Integer &rhs) const {
+		return lhs.val < rhs.val;
+	}
+};
+
+typedef sjtu::map<Integer, std::string, Compare> imap;
+
+bool check(const imap &m, int from, int to, int step) {
+	size_t n = 0;
+	int last = from - 1;
+	for (auto it = m.cbegin(); it != m.cend(); ++it, ++n) {
+		if (it->first.val <= last || (it->first.val - from) % step || it->second != std::to_string(it->first.val)) return false;
+		last = it->first.val;
+	}
+	for (int i = from; i < to; i += step)
+		if (m.count(Integer(i)) == 0) return false;
+	return n == (size_t)((to - from + step - 1) / step);
+}
+
+void tester(void) {
+	//	test: erasing leaves the slots in the pool, compact gives them back
+	imap m;
+	std::cout << (m.memory_usage() < 64) << " ";
+	m.compact();
+	std::cout << m.size() << std::endl;
+	for (int i = 0; i < 100000; ++i) m[Integer(i)] = std::to_string(i);
+	size_t full = m.memory_usage();
+	for (int i = 0; i < 100000; ++i)
+		if (i % 10) m.erase(m.find(Integer(i)));
+	size_t churned = m.memory_usage();
+	m.compact();
+	size_t packed = m.memory_usage();
+	std::cout << (churned == full) << " " << (packed * 5 < full) << " " << check(m, 0, 100000, 10) << std::endl;
+	//	test: the compacted tree is balanced and still takes insertions and erasures
+	for (int i = 5; i < 100000; i += 10) m[Integer(i)] = std::to_string(i);
+	for (int i = 0; i < 100000; i += 10) m.erase(m.find(Integer(i)));
+	std::cout << check(m, 5, 100000, 10) << " " << m.cbegin()->first.val << " " << (--m.cend())->first.val << std::endl;
+	//	test: compacting a map whose pool is shared after merge
+	imap a, b;
+	for (int i = 0; i < 1000; ++i) a[Integer(2 * i)] = std::to_string(2 * i);
+	for (int i = 0; i < 1000; ++i) b[Integer(2 * i + 1)] = std::to_string(2 * i + 1);
+	a.merge(b);
+	a.compact();
+	b[Integer(5000)] = "5000";
+	std::cout << check(a, 0, 2000, 1) << " " << b.size() << std::endl;
+	a.clear();
+	a.compact();
+	std::cout << a.size() << " " << a.empty() << std::endl;
+}
+
+int main(void) {
+	tester();
+	std::cout << Integer::counter << std::endl;
+	return 0;
+}
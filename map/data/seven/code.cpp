@@ -0,0 +1,82 @@
+#include "map.hpp"
+#include <iostream>
+#include <cassert>
+#include <string>
+#include <iterator>
+
+class Integer {
+public:
+	static int counter;
+	int val;
+
+	Integer(int val) : val(val) {
+		counter++;
+	}
+
+	Integer(const Integer &rhs) {
+		val = rhs.val;
+		counter++;
+	}
+
+	Integer& operator = (const Integer &rhs) {
+		assert(false);
+	}
+
+	~Integer() {
+		counter--;
+	}
+};
+
+int Integer::counter = 0;
+
+class Compare {
+public:
+	bool operator () (const Integer &lhs, const Integer &rhs) const {
+		return lhs.val < rhs.val;
+	}
+};
+
+typedef sjtu::map<Integer, int, Compare, std::allocator<sjtu::pair<const Integer, int>>, sjtu::order_statistics_policy> ranked_map;
+
+void tester(void) {
+	ranked_map map;
+	//	keys 0, 2, 4, ..., inserted in a scrambled order
+	for (int i = 0; i < 50000; ++i) {
+		int k = (int)((i * 7919LL) % 50000);
+		map[Integer(k * 2)] = k;
+	}
+	//	test: rank()
+	std::cout << map.rank(Integer(0)) << " " << map.rank(Integer(1)) << " " << map.rank(Integer(100)) << " " << map.rank(Integer(1000000)) << std::endl;
+	//	test: select(), nth()
+	std::cout << map.select(0)->first.val << " " << map.select(12345)->first.val << " " << map.nth(49999)->second << std::endl;
+	std::cout << (map.nth(50000) == map.end()) << std::endl;
+	try {
+		map.select(50000);
+		std::cout << "no exception" << std::endl;
+	} catch (sjtu::index_out_of_bound &) {
+		std::cout << "index_out_of_bound" << std::endl;
+	}
+	//	test: erase() keeps ranks right
+	for (int i = 0; i < 100000; i += 4) map.erase(map.find(Integer(i)));
+	std::cout << map.size() << " " << map.rank(Integer(1002)) << " " << map.select(100)->first.val << std::endl;
+	//	test: iterator arithmetic, std::distance()
+	auto it = map.begin() + 1000;
+	std::cout << it->first.val << " " << (it - map.begin()) << " " << std::distance(it, map.end()) << std::endl;
+	it -= 500;
+	std::cout << it->first.val << " " << it[10].first.val << " " << (map.begin() < it) << " " << (map.end() <= it) << std::endl;
+	const ranked_map copy(map);
+	ranked_map::const_iterator cit = copy.cbegin();
+	cit += copy.size() / 2;
+	std::cout << cit->first.val << " " << copy.rank(cit->first) << " " << (copy.cend() - cit) << std::endl;
+	try {
+		cit = copy.cend() + 1;
+		std::cout << "no exception" << std::endl;
+	} catch (sjtu::invalid_iterator &) {
+		std::cout << "invalid_iterator" << std::endl;
+	}
+}
+
+int main(void) {
+	tester();
+	std::cout << Integer::counter << std::endl;
+}
@@ -0,0 +1,145 @@
+#include "map.hpp"
+#include <iostream>
+#include <cassert>
+#include <atomic>
+#include <string>
+
+//	elements are copied and destroyed from several threads at once
+class Integer {
+public:
+	static std::atomic<int> counter, copies, fail_at;
+	int val;
+
+	Integer(int val) : val(val) {
+		counter++;
+	}
+
+	Integer(const Integer &rhs) {
+		if (++copies == fail_at) throw std::string("copy failed");
+		val = rhs.val;
+		counter++;
+	}
+
+	Integer& operator = (const Integer &rhs) {
+		assert(false);
+	}
+
+	~Integer() {
+		counter--;
+	}
+};
+
+std::atomic<int> Integer::counter(0), Integer::copies(0), Integer::fail_at(-1);
+
+class Compare {
+public:
+	bool operator () (const Integer &lhs, const Integer &rhs) const {
+		return lhs.val < rhs.val;
+	}
+};
+#include <vector>
+
+typedef sjtu::map<Integer, std::string, Compare> smap;
+typedef sjtu::pair<Integer, std::string> input;
+
+bool same(const smap &a, const smap &b) {
+	if (a.size() != b.size()) return false;
+	for (auto p = a.cbegin(), q = b.cbegin(); p != a.cend(); ++p, ++q)
+		if (p->first.val != q->first.val || p->second != q->second) return false;
+	return true;
+}
+
+void tester(void) {
+	//	test: the parallel build of an unsorted range with duplicates matches the sequential one
+	std::vector<input> in;
+	for (int i = 0; i < 100000; ++i) in.push_back(input(Integer((i * 7919) % 60000), std::to_string(i)));
+	smap expect(in.begin(), in.end());
+	bool ok = true;
+	for (size_t threads : {1, 2, 3, 8, 0}) {
+		smap m;
+		m[Integer(-1)] = "gone";
+		m.parallel_assign(in.begin(), in.end(), threads);
+		ok = ok && same(m, expect);
+	}
+	std::cout << ok << " " << expect.size() << " " << expect.at(Integer(7919)) << std::endl;
+	//	test: short ranges, more threads than elements
+	for (size_t n : {0, 1, 2, 7}) {
+		smap m;
+		m.parallel_assign(in.begin(), in.begin() + n, 8);
+		std::cout << m.size() << (m.empty() || m.cbegin()->first.val == 0 ? "" : " ?") << " ";
+	}
+	std::cout << std::endl;
+	//	test: dropping duplicates leaves fewer elements than slices were cut for
+	std::vector<input> dup;
+	for (int i = 0; i < 7; ++i) dup.push_back(input(Integer(6 - i), "x" + std::to_string(i)));
+	for (int i = 0; i < 7; ++i) dup.push_back(input(Integer(i), "y" + std::to_string(i)));
+	for (size_t threads : {1, 2, 3, 4, 8}) {
+		smap m;
+		m.parallel_assign(dup.begin(), dup.end(), threads);
+		std::cout << m.size() << ":";
+		for (auto it = m.cbegin(); it != m.cend(); ++it) std::cout << " " << it->first.val << it->second;
+		std::cout << std::endl;
+	}
+	//	test: a failing copy leaves the map empty and nothing leaks
+	{
+		smap m;
+		int before = Integer::counter;
+		Integer::copies = 0;
+		Integer::fail_at = 30000;
+		try {
+			m.parallel_assign(in.begin(), in.end(), 4);
+		}
+		catch (std::string &e) {
+			std::cout << e << " ";
+		}
+		Integer::fail_at = -1;
+		std::cout << m.size() << " " << (Integer::counter == before) << std::endl;
+		m.parallel_assign(in.begin(), in.begin() + 10, 4);
+		std::cout << m.size() << std::endl;
+	}
+	//	test: parallel_for_each visits every element once, const or not
+	smap m;
+	m.parallel_assign(in.begin(), in.end());
+	std::atomic<long long> sum(0);
+	std::atomic<int> visits(0);
+	m.parallel_for_each([&](sjtu::pair<const Integer, std::string> &v) {
+		v.second += "!";
+		visits++;
+	}, 4);
+	const smap &cm = m;
+	cm.parallel_for_each([&](const sjtu::pair<const Integer, std::string> &v) {
+		sum += v.first.val;
+	});
+	long long want = 0;
+	for (auto it = cm.cbegin(); it != cm.cend(); ++it) want += it->first.val;
+	std::cout << visits << " " << (sum == want) << " " << m.at(Integer(7919)) << " " << m.at(Integer(59999)) << std::endl;
+	//	test: an exception from fn reaches the caller
+	try {
+		m.parallel_for_each([](sjtu::pair<const Integer, std::string> &v) {
+			if (v.first.val == 12345) throw sjtu::runtime_error();
+		}, 3);
+		std::cout << "no throw" << std::endl;
+	}
+	catch (sjtu::runtime_error) {
+		std::cout << "thrown" << std::endl;
+	}
+	//	test: parallel_clear, then the map is usable again
+	m.parallel_clear(4);
+	std::cout << m.size() << " " << (m.begin() == m.end()) << " " << m.count(Integer(5)) << std::endl;
+	m[Integer(5)] = "five";
+	m.parallel_assign(in.begin(), in.begin() + 1000, 2);
+	std::cout << m.size() << " " << m.begin()->second << std::endl;
+	//	test: with nodes shared after merge it falls back to clear()
+	smap a, b;
+	for (int i = 0; i < 100; ++i) a[Integer(i)] = "a";
+	for (int i = 50; i < 150; ++i) b[Integer(i)] = "b";
+	a.merge(b);
+	a.parallel_clear(4);
+	std::cout << a.size() << " " << b.size() << " " << b.cbegin()->first.val << std::endl;
+}
+
+int main(void) {
+	tester();
+	std::cout << Integer::counter << std::endl;
+	return 0;
+}
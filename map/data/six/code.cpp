@@ -0,0 +1,86 @@
+#include "map.hpp"
+#include <iostream>
+#include <cassert>
+#include <string>
+
+class Integer {
+public:
+	static int counter;
+	int val;
+
+	Integer(int val) : val(val) {
+		counter++;
+	}
+
+	Integer(const Integer &rhs) {
+		val = rhs.val;
+		counter++;
+	}
+
+	Integer& operator = (const Integer &rhs) {
+		assert(false);
+	}
+
+	~Integer() {
+		counter--;
+	}
+};
+
+int Integer::counter = 0;
+
+class Compare {
+public:
+	bool operator () (const Integer &lhs, const Integer &rhs) const {
+		return lhs.val < rhs.val;
+	}
+};
+
+void tester(void) {
+	//	test: insert with hint at end(), keys 0, 3, 6, ...
+	sjtu::map<Integer, int, Compare> map;
+	for (int i = 0; i < 30000; ++i) {
+		map.insert(map.end(), sjtu::pair<const Integer, int>(Integer(i * 3), i));
+	}
+	//	test: emplace_hint before begin() and in the middle
+	map.emplace_hint(map.begin(), Integer(-1), -1);
+	map.emplace_hint(map.find(Integer(30)), Integer(29), 29);
+	std::cout << map.size() << std::endl;
+	//	test: lower_bound(), upper_bound(), equal_range()
+	std::cout << map.lower_bound(Integer(7))->first.val << " " << map.upper_bound(Integer(9))->first.val << std::endl;
+	std::cout << (map.lower_bound(Integer(100000)) == map.end()) << " " << (map.upper_bound(Integer(-2)) == map.begin()) << std::endl;
+	auto range = map.equal_range(Integer(12));
+	std::cout << range.first->first.val << " " << range.second->first.val << std::endl;
+	range = map.equal_range(Integer(13));
+	std::cout << (range.first == range.second) << " " << range.first->first.val << std::endl;
+	//	test: for_each_in_range()
+	long long sum = 0;
+	int cnt = 0;
+	const sjtu::map<Integer, int, Compare> &cmap = map;
+	cmap.for_each_in_range(Integer(100), Integer(1000), [&](const sjtu::pair<const Integer, int> &v) {
+		sum += v.first.val;
+		cnt++;
+	});
+	std::cout << cnt << " " << sum << std::endl;
+	//	test: erase(first, last), erase(key)
+	auto it = map.erase(map.lower_bound(Integer(300)), map.lower_bound(Integer(60000)));
+	std::cout << map.size() << " " << it->first.val << std::endl;
+	std::cout << map.erase(Integer(29)) << " " << map.erase(Integer(29)) << std::endl;
+	int last = -2;
+	bool sorted = true;
+	for (auto p = map.begin(); p != map.end(); ++p) {
+		if (p->first.val <= last) sorted = false;
+		last = p->first.val;
+	}
+	std::cout << sorted << " " << map.size() << std::endl;
+	//	test: reverse iteration from end()
+	cnt = 0;
+	for (auto p = map.end(); p != map.begin(); --p) cnt++;
+	std::cout << cnt << std::endl;
+	map.erase(map.begin(), map.end());
+	std::cout << map.empty() << " " << (map.begin() == map.end()) << std::endl;
+}
+
+int main(void) {
+	tester();
+	std::cout << Integer::counter << std::endl;
+}
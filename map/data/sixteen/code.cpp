@@ -0,0 +1,167 @@
+#include "map.hpp"
+#include <iostream>
+#include <cassert>
+#include "flat_map.hpp"
+#include <string>
+
+class Integer {
+public:
+	static int counter, created;
+	int val;
+
+	Integer(int val) : val(val) {
+		counter++;
+		created++;
+	}
+
+	Integer(const Integer &rhs) {
+		val = rhs.val;
+		counter++;
+		created++;
+	}
+
+	Integer& operator = (const Integer &rhs) {
+		assert(false);
+	}
+
+	~Integer() {
+		counter--;
+	}
+};
+
+int Integer::counter = 0, Integer::created = 0;
+
+class Compare {
+public:
+	bool operator () (const Integer &lhs, const Integer &rhs) const {
+		return lhs.val < rhs.val;
+	}
+};
+#include <vector>
+#include <new>
+
+void tester(void) {
+	//	test: built from an unsorted range with duplicates, the first one wins
+	std::vector<sjtu::pair<Integer, std::string>> in;
+	for (int i = 0; i < 1000; ++i) in.push_back(sjtu::pair<Integer, std::string>(Integer((i * 37) % 500), std::to_string(i)));
+	sjtu::flat_map<Integer, std::string, Compare> m(in.begin(), in.end());
+	in.clear();
+	std::cout << m.size() << " " << m.at(Integer(37)) << " " << m.at(Integer(0)) << " " << m[Integer(499)] << std::endl;
+	bool sorted = true;
+	int prev = -1;
+	for (auto it = m.begin(); it != m.end(); ++it) {
+		if (it->first.val <= prev) sorted = false;
+		prev = (*it).first.val;
+	}
+	std::cout << sorted << " " << (m.end() - m.begin()) << " " << (m.begin() + 10)->first.val << " " << m.begin()[499].first.val << std::endl;
+	//	test: lookups, hits and misses
+	bool ok = true;
+	for (int i = -5; i < 510; ++i) {
+		bool in = i >= 0 && i < 500;
+		if (m.count(Integer(i)) != (size_t)in || m.contains(Integer(i)) != in) ok = false;
+		if ((m.find(Integer(i)) != m.end()) != in) ok = false;
+		if (in && m.find(Integer(i))->first.val != i) ok = false;
+		auto lb = m.lower_bound(Integer(i)), ub = m.upper_bound(Integer(i));
+		if (i < 500 && lb->first.val != (i < 0 ? 0 : i)) ok = false;
+		if (i < 499 && ub->first.val != (i < 0 ? 0 : i + 1)) ok = false;
+		if (i >= 499 && ub != m.end()) ok = false;
+	}
+	std::cout << ok << std::endl;
+	//	test: inserting and erasing keep the order
+	sjtu::flat_map<Integer, std::string, Compare> g;
+	for (int i = 0; i < 300; ++i) g[Integer((i * 7) % 300)] = std::to_string(i);
+	std::cout << g.insert(sjtu::pair<const Integer, std::string>(Integer(5), "x")).second << " "
+		<< g.insert(sjtu::pair<const Integer, std::string>(Integer(300), "y")).second << " "
+		<< g.try_emplace(Integer(301), 3, 'z').first->second << std::endl;
+	for (int i = 0; i < 302; i += 2) g.erase(g.find(Integer(i)));
+	std::cout << g.erase(Integer(1)) << g.erase(Integer(2)) << " " << g.size() << " " << g.begin()->first.val << " " << (--g.end())->first.val << std::endl;
+	//	test: copies, moves and the exceptions
+	sjtu::flat_map<Integer, std::string, Compare> c(g), d;
+	d = c;
+	c.clear();
+	sjtu::flat_map<Integer, std::string, Compare> e(std::move(d));
+	std::cout << c.size() << " " << d.size() << " " << e.size() << " " << e.at(Integer(299)) << std::endl;
+	const auto &ce = e;
+	int thrown = 0;
+	try { ce.at(Integer(2)); } catch (sjtu::index_out_of_bound &) { thrown++; }
+	try { ce[Integer(2)]; } catch (sjtu::index_out_of_bound &) { thrown++; }
+	try { ++e.end(); } catch (sjtu::invalid_iterator &) { thrown++; }
+	try { --e.begin(); } catch (sjtu::invalid_iterator &) { thrown++; }
+	try { *e.end(); } catch (sjtu::invalid_iterator &) { thrown++; }
+	try { e.erase(g.begin()); } catch (sjtu::invalid_iterator &) { thrown++; }
+	try { e.begin() + 1000; } catch (sjtu::invalid_iterator &) { thrown++; }
+	std::cout << thrown << std::endl;
+	//	test: from a map, and the sorted_unique check
+	sjtu::map<Integer, std::string, Compare> tree;
+	for (int i = 0; i < 50; ++i) tree[Integer(i * 2)] = std::to_string(i);
+	sjtu::flat_map<Integer, std::string, Compare> f(tree);
+	std::cout << f.size() << " " << f.at(Integer(98)) << " " << (f.cbegin() + 3)->second << std::endl;
+	try {
+		sjtu::flat_map<Integer, std::string, Compare> bad(sjtu::sorted_unique, in.begin(), in.end());
+		std::vector<sjtu::pair<Integer, std::string>> rev;
+		rev.push_back(sjtu::pair<Integer, std::string>(Integer(2), "a"));
+		rev.push_back(sjtu::pair<Integer, std::string>(Integer(1), "b"));
+		sjtu::flat_map<Integer, std::string, Compare> worse(sjtu::sorted_unique, rev.begin(), rev.end());
+	} catch (sjtu::runtime_error &) {
+		std::cout << "not sorted" << std::endl;
+	}
+	f.shrink_to_fit();
+	std::cout << f.capacity() << std::endl;
+}
+
+//	throws from the fail_at-th allocation on
+int allocations = 0, fail_at = -1;
+template<class U>
+struct failing_allocator {
+	typedef U value_type;
+	failing_allocator() {}
+	template<class V> failing_allocator(const failing_allocator<V> &) {}
+	U *allocate(size_t n) {
+		if (++allocations == fail_at) throw std::bad_alloc();
+		return std::allocator<U>().allocate(n);
+	}
+	void deallocate(U *p, size_t n) { std::allocator<U>().deallocate(p, n); }
+	template<class V> bool operator == (const failing_allocator<V> &) const { return true; }
+	template<class V> bool operator != (const failing_allocator<V> &) const { return false; }
+};
+typedef sjtu::flat_map<Integer, std::string, Compare, failing_allocator<sjtu::pair<const Integer, std::string>>> fmap;
+
+void failed_growth(void) {
+	//	test: a failed allocation while growing keeps the map as it was
+	for (int which = 1; which <= 2; ++which) {
+		fmap f;
+		for (int i = 0; i < 8; ++i) f[Integer(i)] = std::to_string(i);
+		allocations = 0;
+		fail_at = which;
+		try {
+			f[Integer(8)] = "8";
+		} catch (std::bad_alloc &) {
+			std::cout << "bad_alloc ";
+		}
+		fail_at = -1;
+		std::cout << f.size() << " " << f.capacity() << " " << f.at(Integer(7)) << " ";
+		f[Integer(8)] = "8";
+		std::cout << f.size() << " " << f.at(Integer(8)) << std::endl;
+	}
+	//	test: also while building from an unsorted range
+	std::vector<sjtu::pair<Integer, std::string>> in;
+	for (int i = 0; i < 20; ++i) in.push_back(sjtu::pair<Integer, std::string>(Integer(19 - i), std::to_string(i)));
+	for (int which = 1; which <= 9; ++which) {
+		allocations = 0;
+		fail_at = which;
+		try {
+			fmap f(in.begin(), in.end());
+			std::cout << f.size() << " " << f.cbegin()->second;
+		} catch (std::bad_alloc &) {
+			std::cout << which << " ";
+		}
+	}
+	fail_at = -1;
+	std::cout << std::endl;
+}
+
+int main(void) {
+	tester();
+	failed_growth();
+	std::cout << Integer::counter << std::endl;
+}
@@ -0,0 +1,107 @@
+#include "concurrent_map.hpp"
+#include <atomic>
+#include <thread>
+#include <vector>
+#include <iostream>
+#include <cassert>
+#include <string>
+
+class Integer {
+public:
+	static int counter;
+	int val;
+
+	Integer(int val) : val(val) {
+		counter++;
+	}
+
+	Integer(const Integer &rhs) {
+		val = rhs.val;
+		counter++;
+	}
+
+	Integer& operator = (const Integer &rhs) {
+		assert(false);
+	}
+
+	~Integer() {
+		counter--;
+	}
+};
+
+int Integer::counter = 0;
+
+class Compare {
+public:
+	bool operator () (const Integer &lhs, const Integer &rhs) const {
+		return lhs.val < rhs.val;
+	}
+};
+
+typedef sjtu::concurrent_map<Integer, std::string, Compare> cmap;
+typedef sjtu::pair<const Integer, std::string> value;
+
+void tester(void) {
+	//	test: the map used from one thread
+	cmap map;
+	for (int i = 0; i < 1000; ++i) map.insert(value(Integer(i * 7 % 1000), std::to_string(i)));
+	std::cout << map.size() << " " << map.insert(value(Integer(7), "x")) << " " << map.at(Integer(7)) << std::endl;
+	std::cout << map.insert_or_assign(Integer(7), std::string("seven")) << " " << map.at(Integer(7)) << std::endl;
+	std::cout << map.try_emplace(Integer(1000), "new") << " " << map.erase(Integer(3)) << " " << map.erase(Integer(3)) << " " << map.count(Integer(3)) << std::endl;
+	try {
+		map.at(Integer(3));
+	} catch (...) {
+		std::cout << "at throws" << std::endl;
+	}
+	int last = -1, cnt = 0;
+	bool sorted = true;
+	map.for_each([&](const value &v) {
+		if (v.first.val <= last) sorted = false;
+		last = v.first.val;
+		cnt++;
+	});
+	std::cout << cnt << " " << sorted << " " << map.find(Integer(500), [](const value &v) { std::cout << v.second << " "; }) << std::endl;
+	//	test: lock-free readers next to one writer, with int keys since Integer::counter is not atomic
+	//	every value is the key written as a string, optionally followed by "+"
+	sjtu::concurrent_map<int, std::string> shared;
+	std::atomic<bool> stop(false);
+	std::atomic<int> bad(0);
+	std::vector<std::thread> readers;
+	for (int t = 0; t < 4; ++t) {
+		readers.emplace_back([&, t]() {
+			unsigned k = t;
+			while (!stop) {
+				k = k * 1103515245u + 12345u;
+				int key = (int)(k % 3000);
+				shared.find(key, [&](const sjtu::pair<const int, std::string> &v) {
+					if (v.first != key || v.second.compare(0, std::to_string(key).size(), std::to_string(key))) bad++;
+				});
+				if (k % 512 == 0) {
+					int prev = -1;
+					shared.for_each([&](const sjtu::pair<const int, std::string> &v) {
+						if (v.first <= prev) bad++;
+						prev = v.first;
+					});
+				}
+			}
+		});
+	}
+	for (int i = 0; i < 60000; ++i) {
+		int key = i * 7919 % 3000;
+		if (i % 3 == 0) shared.try_emplace(key, std::to_string(key));
+		else if (i % 3 == 1) shared.insert_or_assign(key, std::to_string(key) + "+");
+		else shared.erase((key + 1500) % 3000);
+	}
+	stop = true;
+	for (auto &th : readers) th.join();
+	cnt = 0;
+	shared.for_each([&](const sjtu::pair<const int, std::string> &) { cnt++; });
+	std::cout << bad << " " << shared.size() << " " << cnt << std::endl;
+	shared.clear();
+	std::cout << shared.empty() << std::endl;
+}
+
+int main(void) {
+	tester();
+	std::cout << Integer::counter << std::endl;
+}
@@ -0,0 +1,65 @@
+#include "map.hpp"
+#include <iostream>
+#include <cassert>
+#include <string>
+
+class Integer {
+public:
+	static int counter;
+	int val;
+
+	Integer(int val) : val(val) {
+		counter++;
+	}
+
+	Integer(const Integer &rhs) {
+		val = rhs.val;
+		counter++;
+	}
+
+	Integer& operator = (const Integer &rhs) {
+		assert(false);
+	}
+
+	~Integer() {
+		counter--;
+	}
+};
+
+int Integer::counter = 0;
+
+class Compare {
+public:
+	bool operator () (const Integer &lhs, const Integer &rhs) const {
+		return lhs.val < rhs.val;
+	}
+};
+
+typedef sjtu::map<Integer, int, Compare, std::allocator<sjtu::pair<const Integer, int>>, sjtu::map_stats_policy> smap;
+
+void tester(void) {
+	//	test: ascending inserts rotate, lookups do not
+	smap map;
+	for (int i = 0; i < 1023; ++i) map[Integer(i)] = i;
+	sjtu::map_stats s = map.stats();
+	std::cout << s.inserts << " " << s.erases << " " << s.node_allocations << " " << (s.insert_rotations > 500) << " " << s.erase_rotations << " " << s.height << std::endl;
+	map.reset_stats();
+	for (int i = 0; i < 2000; ++i) map.count(Integer(i));
+	s = map.stats();
+	std::cout << s.inserts << " " << s.insert_rotations << " " << s.height << std::endl;
+	//	test: erasures are counted, and at most 3 rotations each
+	for (int i = 0; i < 1023; i += 2) map.erase(map.find(Integer(i)));
+	s = map.stats();
+	std::cout << s.erases << " " << (s.erase_rotations <= 3 * s.erases) << " " << map.size() << std::endl;
+	//	test: a copy is built in one go, without rotations
+	smap copy(map);
+	s = copy.stats();
+	std::cout << s.inserts << " " << s.node_allocations << " " << s.insert_rotations << " " << (s.height <= 10) << std::endl;
+	smap empty;
+	std::cout << empty.stats().height << std::endl;
+}
+
+int main(void) {
+	tester();
+	std::cout << Integer::counter << std::endl;
+}
@@ -0,0 +1,88 @@
+#include "map.hpp"
+#include <iostream>
+#include <cassert>
+#include <string>
+#include <string_view>
+
+class Integer {
+public:
+	static int counter, created;
+	int val;
+
+	Integer(int val) : val(val) {
+		counter++;
+		created++;
+	}
+
+	Integer(const Integer &rhs) {
+		val = rhs.val;
+		counter++;
+		created++;
+	}
+
+	Integer& operator = (const Integer &rhs) {
+		assert(false);
+	}
+
+	~Integer() {
+		counter--;
+	}
+};
+
+int Integer::counter = 0, Integer::created = 0;
+
+class Compare {
+public:
+	bool operator () (const Integer &lhs, const Integer &rhs) const {
+		return lhs.val < rhs.val;
+	}
+};
+//	also compares Integer with plain int
+class TransparentCompare {
+public:
+	typedef void is_transparent;
+	bool operator () (const Integer &lhs, const Integer &rhs) const {
+		return lhs.val < rhs.val;
+	}
+	bool operator () (const Integer &lhs, int rhs) const {
+		return lhs.val < rhs;
+	}
+	bool operator () (int lhs, const Integer &rhs) const {
+		return lhs < rhs.val;
+	}
+};
+
+void tester(void) {
+	//	test: lookups by int build no Integer
+	sjtu::map<Integer, std::string, TransparentCompare> map;
+	for (int i = 0; i < 100; ++i) map[Integer(i * 3)] = std::to_string(i);
+	int before = Integer::created;
+	const auto &cmap = map;
+	std::cout << map.at(30) << " " << cmap.at(33) << " " << map.count(31) << " " << cmap.count(297) << " " << map.contains(0) << std::endl;
+	std::cout << map.find(60)->second << " " << (map.find(61) == map.end()) << " " << (cmap.find(-1) == cmap.cend()) << std::endl;
+	std::cout << map.lower_bound(61)->first.val << " " << cmap.upper_bound(63)->first.val << " " << (map.lower_bound(298) == map.end()) << std::endl;
+	auto r = map.equal_range(90);
+	auto e = cmap.equal_range(91);
+	std::cout << r.first->second << " " << r.second->first.val << " " << (e.first == e.second) << " " << e.first->first.val << std::endl;
+	try {
+		map.at(1);
+	} catch (...) {
+		std::cout << "at throws" << std::endl;
+	}
+	std::cout << Integer::created - before << std::endl;
+	//	test: a Key argument still works, with or without a transparent Compare
+	std::cout << map.count(Integer(3)) << " " << map.find(Integer(6))->second << std::endl;
+	sjtu::map<Integer, int, Compare> plain;
+	plain[Integer(1)] = 1;
+	std::cout << plain.count(1) << " " << plain.contains(Integer(2)) << std::endl;
+	//	test: std::string keys found through std::less<> with string_view and const char*
+	sjtu::map<std::string, int, std::less<>> words;
+	words["apple"] = 1, words["banana"] = 2, words["cherry"] = 3;
+	std::string_view buf = "xx banana yy";
+	std::cout << words.at(buf.substr(3, 6)) << " " << words.count("cherry") << " " << words.contains(std::string_view("dates")) << " " << words.lower_bound("b")->first << std::endl;
+}
+
+int main(void) {
+	tester();
+	std::cout << Integer::counter << std::endl;
+}
@@ -0,0 +1,106 @@
+#include "map.hpp"
+#include <iostream>
+#include <cassert>
+#include <string>
+
+class Integer {
+public:
+	static int counter;
+	int val;
+
+	Integer(int val) : val(val) {
+		counter++;
+	}
+
+	Integer(const Integer &rhs) {
+		val = rhs.val;
+		counter++;
+	}
+
+	Integer& operator = (const Integer &rhs) {
+		assert(false);
+	}
+
+	~Integer() {
+		counter--;
+	}
+};
+
+int Integer::counter = 0;
+
+class Compare {
+public:
+	bool operator () (const Integer &lhs, const Integer &rhs) const {
+		return lhs.val < rhs.val;
+	}
+};
+#include <vector>
+
+typedef sjtu::map<Integer, std::string, Compare> imap;
+typedef sjtu::pair<Integer, std::string> update;
+
+void print(const imap &m) {
+	std::cout << m.size() << ":";
+	for (auto it = m.cbegin(); it != m.cend(); ++it) std::cout << " " << it->first.val << "=" << it->second;
+	std::cout << std::endl;
+}
+
+bool check(const imap &m) {
+	int last = -1;
+	for (auto it = m.cbegin(); it != m.cend(); ++it) {
+		if (it->first.val <= last || it->second != std::to_string(it->first.val)) return false;
+		last = it->first.val;
+	}
+	return true;
+}
+
+void tester(void) {
+	//	test: an unsorted batch with duplicates, into an empty map and into a small one
+	imap m;
+	std::vector<update> b;
+	int keys[] = { 5, 3, 9, 3, 1, 7, 5 };
+	for (int i = 0; i < 7; ++i) b.push_back(update(Integer(keys[i]), std::to_string(i)));
+	std::cout << m.insert_batch(b.begin(), b.end()) << " ";
+	print(m);
+	std::cout << m.apply_batch(b.begin(), b.end()) << " ";
+	print(m);
+	b.clear();
+	for (int i = 10; i > 0; --i) b.push_back(update(Integer(i), "x"));
+	std::cout << m.insert_batch(b.begin(), b.end()) << " ";
+	print(m);
+	std::cout << m.apply_batch(b.begin(), b.begin()) << " " << m.insert_batch(b.begin(), b.begin()) << std::endl;
+	//	test: small batches into a large map keep iterators and references valid
+	imap big;
+	for (int i = 0; i < 100000; i += 2) big[Integer(i)] = std::to_string(i);
+	imap::iterator it = big.find(Integer(5000));
+	std::string &ref = big.at(Integer(70000));
+	size_t added = 0;
+	for (int round = 0; round < 10; ++round) {
+		b.clear();
+		for (int i = 0; i < 1000; ++i) {
+			int k = (i * 7919 + round * 104729) % 100000;
+			b.push_back(update(Integer(k), std::to_string(k)));
+		}
+		added += big.apply_batch(b.begin(), b.end());
+	}
+	std::cout << added << " " << big.size() << " " << check(big) << " " << it->second << " " << (&ref == &big.at(Integer(70000))) << std::endl;
+	//	test: a batch larger than the map, moved in
+	b.clear();
+	for (int i = 199999; i >= 0; --i) b.push_back(update(Integer(i), std::to_string(i)));
+	added = big.insert_batch(std::make_move_iterator(b.begin()), std::make_move_iterator(b.end()));
+	std::cout << added << " " << big.size() << " " << check(big) << " " << it->second << " " << (&ref == &big.at(Integer(70000))) << std::endl;
+	//	test: the tree is still balanced and usable
+	for (int i = 0; i < 200000; i += 3) big.erase(big.find(Integer(i)));
+	for (int i = 0; i < 200000; i += 3) big[Integer(i)] = std::to_string(i);
+	std::cout << big.size() << " " << check(big) << " " << big.cbegin()->first.val << " " << (--big.cend())->first.val << std::endl;
+	b.clear();
+	for (int i = 0; i < 300; ++i) b.push_back(update(Integer(i % 100), std::to_string(i)));
+	big.apply_batch(b.begin(), b.end());
+	std::cout << big.at(Integer(0)) << " " << big.at(Integer(99)) << " " << big.at(Integer(100)) << std::endl;
+}
+
+int main(void) {
+	tester();
+	std::cout << Integer::counter << std::endl;
+	return 0;
+}
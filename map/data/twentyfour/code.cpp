@@ -0,0 +1,148 @@
+#include "map.hpp"
+#include <iostream>
+#include <cassert>
+#include <string>
+#include <iterator>
+
+class Integer {
+public:
+	static int counter, copies, fail_at;
+	int val;
+
+	Integer(int val) : val(val) {
+		counter++;
+	}
+
+	Integer(const Integer &rhs) {
+		if (++copies == fail_at) throw std::string("copy failed");
+		val = rhs.val;
+		counter++;
+	}
+
+	Integer& operator = (const Integer &rhs) {
+		assert(false);
+	}
+
+	~Integer() {
+		counter--;
+	}
+};
+
+int Integer::counter = 0, Integer::copies = 0, Integer::fail_at = -1;
+
+class Compare {
+public:
+	bool operator () (const Integer &lhs, const Integer &rhs) const {
+		return lhs.val < rhs.val;
+	}
+};
+#include <vector>
+
+typedef sjtu::map<Integer, int, Compare, std::allocator<sjtu::pair<const Integer, int>>, sjtu::map_stats_policy> imap;
+typedef sjtu::pair<Integer, int> input;
+
+//	hands out the elements of a vector once, like an istream_iterator
+class one_pass {
+	const std::vector<input> *v;
+	size_t i;
+public:
+	typedef std::input_iterator_tag iterator_category;
+	typedef input value_type;
+	typedef std::ptrdiff_t difference_type;
+	typedef const input *pointer;
+	typedef const input &reference;
+	one_pass(const std::vector<input> *v, size_t i) : v(v), i(i) {}
+	const input &operator * () const { return (*v)[i]; }
+	one_pass &operator ++ () { ++i; return *this; }
+	bool operator == (const one_pass &rhs) const { return i == rhs.i; }
+	bool operator != (const one_pass &rhs) const { return i != rhs.i; }
+};
+
+void print(const imap &m) {
+	std::cout << m.size() << ":";
+	for (imap::const_iterator it = m.cbegin(); it != m.cend(); ++it) std::cout << " " << it->first.val << "=" << it->second;
+	std::cout << std::endl;
+}
+
+bool balanced(const imap &m) {
+	size_t h = m.stats().height, bound = 0;
+	for (size_t n = m.size() + 1; n > 1; n >>= 1) bound++;
+	return h <= 2 * (bound + 1);
+}
+
+void tester(void) {
+	std::vector<input> in;
+	for (int i = 0; i < 10; ++i) in.push_back(input(Integer(i * 3), i));
+	//	sorted input is linked bottom-up, no insertion takes place
+	imap a(sjtu::sorted_unique, in.begin(), in.end());
+	print(a);
+	std::cout << a.stats().insert_rotations << " " << a.at(Integer(27)) << " " << a.count(Integer(4)) << std::endl;
+	//	single-pass iterators are appended at the right end
+	imap b;
+	b[Integer(-1)] = -1;
+	b.assign_sorted(one_pass(&in, 0), one_pass(&in, 7));
+	print(b);
+	b.assign_sorted(in.begin(), in.begin());
+	std::cout << b.size() << " " << (b.begin() == b.end()) << std::endl;
+	//	unsorted or repeated keys throw and leave the map empty
+	std::vector<input> bad(in);
+	bad.push_back(input(Integer(27), 99));
+	int before = Integer::counter;
+	for (int pass = 0; pass < 2; ++pass) {
+		try {
+			if (pass == 0) b.assign_sorted(bad.begin(), bad.end());
+			else b.assign_sorted(one_pass(&bad, 0), one_pass(&bad, bad.size()));
+			std::cout << "no throw ";
+		} catch (sjtu::runtime_error &) {
+			std::cout << "runtime_error " << b.size() << " " << (Integer::counter == before) << " ";
+		}
+	}
+	try {
+		imap c(sjtu::sorted_unique, bad.rbegin(), bad.rend());
+		std::cout << "no throw" << std::endl;
+	} catch (sjtu::runtime_error &) {
+		std::cout << "runtime_error" << std::endl;
+	}
+	b[Integer(1)] = 1;
+	print(b);
+	//	copying walks other in order without recursion and builds a balanced tree
+	std::vector<input> big;
+	for (int i = 0; i < 300000; ++i) big.push_back(input(Integer(i), i % 7));
+	imap large(sjtu::sorted_unique, big.begin(), big.end());
+	imap copy(large);
+	bool same = copy.size() == large.size();
+	imap::const_iterator p = large.cbegin();
+	for (imap::const_iterator q = copy.cbegin(); same && q != copy.cend(); ++p, ++q)
+		same = p->first.val == q->first.val && p->second == q->second;
+	std::cout << same << " " << balanced(large) << " " << balanced(copy) << " ";
+	copy.erase(copy.find(Integer(5)));
+	copy[Integer(5)] = 100;
+	std::cout << large.at(Integer(5)) << " " << copy.at(Integer(5)) << " ";
+	a = large;
+	std::cout << a.size() << " " << balanced(a) << " " << a.cbegin()->first.val << std::endl;
+	//	a failing copy leaves nothing behind
+	before = Integer::counter;
+	Integer::copies = 0;
+	Integer::fail_at = 123456;
+	try {
+		imap broken(large);
+		std::cout << "no throw ";
+	} catch (std::string &e) {
+		std::cout << e << " ";
+	}
+	Integer::copies = 0;
+	try {
+		a = large;
+		std::cout << "no throw ";
+	} catch (std::string &e) {
+		std::cout << e << " " << a.size() << " ";
+	}
+	Integer::fail_at = -1;
+	std::cout << (Integer::counter == before - 300000) << std::endl;
+}
+
+int main(void) {
+	tester();
+	std::cout << Integer::counter << std::endl;
+	return 0;
+}
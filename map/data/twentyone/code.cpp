@@ -0,0 +1,93 @@
+#include "intrusive_map.hpp"
+#include <iostream>
+#include <cassert>
+#include <string>
+#include <vector>
+
+//	an order sits in two books at once: by id and by price, highest first
+class Order {
+public:
+	int id;
+	int price;
+	std::string owner;
+	sjtu::intrusive_map_hook by_id, by_price;
+	Order(int id, int price, std::string owner) : id(id), price(price), owner(owner) {}
+};
+
+typedef sjtu::intrusive_map<int, Order, &Order::id, &Order::by_id> IdBook;
+typedef sjtu::intrusive_map<int, Order, &Order::price, &Order::by_price, std::greater<int>> PriceBook;
+
+template<class Book>
+void print(const Book &b) {
+	std::cout << b.size() << ":";
+	for (auto it = b.cbegin(); it != b.cend(); ++it) std::cout << " " << it->id << "@" << it->price;
+	std::cout << std::endl;
+}
+
+void tester(void) {
+	std::vector<Order> orders;
+	for (int i = 0; i < 8; ++i) orders.push_back(Order(i, (i * 37) % 11, "o" + std::to_string(i)));
+	IdBook ids;
+	PriceBook prices;
+	//	test: insert links the elements themselves
+	for (int i = 7; i >= 0; --i) std::cout << ids.insert(orders[i]).second;
+	for (int i = 0; i < 8; ++i) std::cout << prices.insert(orders[i]).second;
+	std::cout << std::endl;
+	print(ids);
+	print(prices);
+	std::cout << (&ids.at(3) == &orders[3]) << " " << prices.find(4)->owner << " " << prices.lower_bound(6)->id << " " << prices.count(5) << std::endl;
+	//	test: a duplicate key leaves the element unlinked, a linked element cannot go in twice
+	Order dup(100, 4, "dup");
+	sjtu::pair<PriceBook::iterator, bool> r = prices.insert(dup);
+	std::cout << r.second << " " << r.first->id << " " << dup.by_price.is_linked() << std::endl;
+	try {
+		ids.insert(orders[0]);
+	}
+	catch (sjtu::runtime_error) {
+		std::cout << "linked" << std::endl;
+	}
+	//	test: erase by iterator, by key and by element
+	ids.erase(ids.find(5));
+	ids.erase(2);
+	prices.erase(orders[6]);
+	prices.erase(prices.iterator_to(orders[1]));
+	std::cout << ids.erase(5) << " " << orders[5].by_id.is_linked() << " " << orders[5].by_price.is_linked() << std::endl;
+	print(ids);
+	print(prices);
+	//	test: iteration both ways and bounds
+	auto it = prices.end();
+	--it;
+	std::cout << it->price << " " << (--it)->price << std::endl;
+	try {
+		--ids.begin();
+	}
+	catch (sjtu::invalid_iterator) {
+		std::cout << "begin" << std::endl;
+	}
+	//	test: move and swap keep the links valid, clearing unlinks
+	IdBook moved(std::move(ids));
+	IdBook other;
+	other.swap(moved);
+	print(ids);
+	print(other);
+	other.clear();
+	std::cout << other.size() << " " << orders[0].by_id.is_linked() << " " << orders[0].by_price.is_linked() << std::endl;
+	//	test: a large book churned in and out
+	std::vector<Order> many;
+	for (int i = 0; i < 100000; ++i) many.push_back(Order(i, i, ""));
+	IdBook big;
+	for (int i = 0; i < 100000; ++i) big.insert(many[(i * 7919) % 100000]);
+	for (int i = 0; i < 100000; i += 2) big.erase(many[i]);
+	bool ok = big.size() == 50000;
+	int last = -1;
+	for (auto &o : big) {
+		ok = ok && o.id > last && o.id % 2 == 1;
+		last = o.id;
+	}
+	std::cout << ok << " " << big.begin()->id << " " << (--big.end())->id << std::endl;
+}
+
+int main(void) {
+	tester();
+	return 0;
+}
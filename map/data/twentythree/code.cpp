@@ -0,0 +1,126 @@
+#include "map.hpp"
+#include <iostream>
+#include <cassert>
+#include <string>
+#include <utility>
+
+class Integer {
+public:
+	static int counter;
+	int val;
+
+	Integer(int val) : val(val) {
+		counter++;
+	}
+
+	Integer(const Integer &rhs) {
+		val = rhs.val;
+		counter++;
+	}
+
+	Integer& operator = (const Integer &rhs) {
+		assert(false);
+	}
+
+	~Integer() {
+		counter--;
+	}
+};
+
+int Integer::counter = 0;
+
+class Compare {
+public:
+	bool operator () (const Integer &lhs, const Integer &rhs) const {
+		return lhs.val < rhs.val;
+	}
+};
+
+//	a value that can only be moved and tells whether it was moved from
+class Token {
+public:
+	static int built;
+	std::string s;
+	explicit Token(std::string s) : s(std::move(s)) {
+		built++;
+	}
+	Token(Token &&other) : s(std::move(other.s)) {
+		other.s = "<moved>";
+	}
+	Token(const Token &) = delete;
+	Token& operator = (Token &&other) {
+		s = std::move(other.s);
+		other.s = "<moved>";
+		return *this;
+	}
+};
+
+int Token::built = 0;
+
+typedef sjtu::map<Integer, Token, Compare> tmap;
+typedef sjtu::map<Integer, std::string, Compare> smap;
+
+void print(const smap &m) {
+	std::cout << m.size() << ":";
+	for (smap::const_iterator it = m.cbegin(); it != m.cend(); ++it) std::cout << " " << it->first.val << "=" << it->second;
+	std::cout << std::endl;
+}
+
+void tester(void) {
+	//	emplace builds the element first, and destroys it again on a hit
+	smap m;
+	sjtu::pair<smap::iterator, bool> p = m.emplace(Integer(1), "one");
+	std::cout << p.second << " " << p.first->second << " ";
+	p = m.emplace(Integer(1), "uno");
+	std::cout << p.second << " " << p.first->second << " ";
+	p = m.emplace(std::piecewise_construct, std::forward_as_tuple(2), std::forward_as_tuple(3, 'x'));
+	std::cout << p.second << " " << p.first->second << " ";
+	smap::iterator h = m.emplace_hint(m.cend(), Integer(3), "three");
+	std::cout << h->second << " " << m.emplace_hint(m.cbegin(), Integer(3), "tres")->second << std::endl;
+	//	try_emplace leaves its arguments alone when the key is there
+	tmap t;
+	Token a("apple"), b("banana");
+	sjtu::pair<tmap::iterator, bool> q = t.try_emplace(Integer(5), std::move(a));
+	std::cout << q.second << " " << q.first->second.s << " " << a.s << " ";
+	q = t.try_emplace(Integer(5), std::move(b));
+	std::cout << q.second << " " << q.first->second.s << " " << b.s << " ";
+	Integer key(6);
+	q = t.try_emplace(key, "cherry");
+	std::cout << q.second << " " << t.at(Integer(6)).s << " " << key.val << " " << Token::built << std::endl;
+	//	insert_or_assign assigns on a hit and moves only then
+	Token c("cherry2"), d("date");
+	q = t.insert_or_assign(Integer(6), std::move(c));
+	std::cout << q.second << " " << q.first->second.s << " " << c.s << " ";
+	q = t.insert_or_assign(Integer(7), std::move(d));
+	std::cout << q.second << " " << q.first->second.s << " " << d.s << " " << t.size() << std::endl;
+	smap::iterator r = m.insert_or_assign(Integer(1), std::string("ONE")).first;
+	std::cout << r->second << " " << m.insert_or_assign(Integer(4), "four").second << " ";
+	print(m);
+	//	the moved-from map is empty and usable
+	smap moved(std::move(m));
+	std::cout << m.size() << " " << m.empty() << " " << (m.begin() == m.end()) << " " << m.count(Integer(1)) << " ";
+	print(moved);
+	m[Integer(9)] = "nine";
+	print(m);
+	smap target;
+	target[Integer(100)] = "gone";
+	target = std::move(moved);
+	std::cout << moved.size() << " " << target.count(Integer(100)) << " ";
+	print(target);
+	moved.emplace(Integer(8), "eight");
+	print(moved);
+	target = std::move(target);
+	print(target);
+	tmap t2(std::move(t));
+	std::cout << t.size() << " " << t2.size() << " " << t2.at(Integer(5)).s << std::endl;
+	//	the elements themselves do not move
+	const std::string *addr = &target.at(Integer(2));
+	smap other(std::move(target));
+	std::cout << (addr == &other.at(Integer(2))) << " " << *addr << std::endl;
+}
+
+int main(void) {
+	tester();
+	std::cout << Integer::counter << std::endl;
+	return 0;
+}
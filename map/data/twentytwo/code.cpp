@@ -0,0 +1,159 @@
+#include "map.hpp"
+#include <iostream>
+#include <cassert>
+#include <string>
+#include <map>
+#include <cctype>
+
+struct cached_stats_policy : sjtu::default_map_policy {
+	static constexpr bool stats = true;
+	static constexpr size_t lookup_cache = 16;
+};
+struct order_cache_policy : sjtu::default_map_policy {
+	static constexpr bool order_statistics = true;
+	static constexpr size_t lookup_cache = 64;
+};
+
+typedef sjtu::map<int, std::string, std::less<int>, std::allocator<sjtu::pair<const int, std::string>>, cached_stats_policy> cmap;
+typedef sjtu::map<int, int, std::less<int>, std::allocator<sjtu::pair<const int, int>>, order_cache_policy> omap;
+typedef sjtu::map<int, int, std::less<int>, std::allocator<sjtu::pair<const int, int>>, sjtu::lookup_cache_policy> lmap;
+
+template<class M>
+void print(const M &m) {
+	std::cout << m.size() << ":";
+	for (auto it = m.cbegin(); it != m.cend(); ++it) std::cout << " " << it->first;
+	std::cout << std::endl;
+}
+
+void tester(void) {
+	cmap m;
+	for (int i = 0; i < 100; ++i) m[i] = std::to_string(i * i);
+	m.reset_stats();
+	//	a few hot keys looked up again and again
+	long long sum = 0;
+	for (int r = 0; r < 50; ++r)
+		for (int k = 10; k < 14; ++k) sum += m.at(k).size() + m.count(k) + m.find(k)->second.size();
+	std::cout << sum << std::endl;
+	sjtu::map_stats s = m.stats();
+	std::cout << (s.cache_hits > s.cache_misses) << " " << s.cache_hits + s.cache_misses << std::endl;
+	//	absent keys never hit
+	m.reset_stats();
+	for (int r = 0; r < 5; ++r) std::cout << m.count(1000) << m.contains(-1);
+	std::cout << " " << m.stats().cache_hits << std::endl;
+	//	erasing a cached key must not leave it behind
+	std::cout << m.find(12)->second << " ";
+	m.erase(m.find(12));
+	std::cout << m.count(12) << " ";
+	try { m.at(12); } catch (...) { std::cout << "gone "; }
+	m[12] = "again";
+	std::cout << m.at(12) << std::endl;
+	//	the node is replaced behind an iterator, through a node handle and back
+	std::cout << m.at(13) << " ";
+	auto nh = m.extract(13);
+	std::cout << m.count(13) << " ";
+	m.insert(std::move(nh));
+	std::cout << m.at(13) << std::endl;
+	//	erase by key and range erase
+	for (int k = 20; k < 30; ++k) m.at(k);
+	m.erase(25);
+	m.erase(m.find(20), m.find(24));
+	for (int k = 20; k < 30; ++k) std::cout << m.count(k);
+	std::cout << std::endl;
+	//	rotations from many inserts and erases move nodes around, not their addresses
+	for (int k = 0; k < 100; k += 7) m.count(k);
+	for (int k = 100; k < 300; ++k) m[k] = "x";
+	for (int k = 1; k < 100; k += 2) m.erase(k);
+	bool ok = true;
+	for (int k = 0; k < 100; ++k) {
+		bool in = k % 2 == 0 && k != 20 && k != 22;
+		ok = ok && m.count(k) == (in ? 1u : 0u);
+		if (in) ok = ok && m.at(k).size() > 0;
+	}
+	std::cout << ok << " " << m.size() << std::endl;
+}
+
+void split_join(void) {
+	omap a;
+	for (int i = 0; i < 40; ++i) a[i] = i * 10;
+	for (int i = 0; i < 40; ++i) a.at(i);
+	omap b = a.split(25);
+	std::cout << a.count(30) << b.count(30) << a.count(10) << b.count(10) << " " << b.at(30) << std::endl;
+	b.erase(30);
+	std::cout << b.count(30) << " " << a.at(5) << std::endl;
+	a.join(b);
+	std::cout << a.count(30) << a.count(31) << b.count(31) << " " << a.at(31) << " " << a.size() << " " << b.size() << std::endl;
+	//	swap carries the cache along with the tree
+	omap c;
+	c[1000] = 1;
+	c.at(1000);
+	a.at(7);
+	a.swap(c);
+	std::cout << a.count(7) << a.count(1000) << c.count(7) << c.count(1000) << " " << c.at(7) << std::endl;
+	//	clear, assignment and merge
+	c.clear();
+	std::cout << c.count(7) << " ";
+	c = a;
+	std::cout << c.count(1000) << " ";
+	omap d;
+	d[1000] = 2;
+	d[2000] = 3;
+	d.at(2000);
+	c.merge(d);
+	std::cout << c.at(2000) << d.count(2000) << d.at(1000) << std::endl;
+	print(c);
+}
+
+void against_std(void) {
+	lmap m;
+	std::map<int, int> ref;
+	unsigned x = 12345;
+	bool ok = true;
+	for (int step = 0; step < 200000; ++step) {
+		x = x * 1103515245u + 12345u;
+		int k = (x >> 8) % 512;
+		switch ((x >> 4) % 4) {
+			case 0: m[k] = step; ref[k] = step; break;
+			case 1: m.erase(k); ref.erase(k); break;
+			default: {
+				auto it = m.find(k);
+				auto jt = ref.find(k);
+				if ((it == m.end()) != (jt == ref.end())) ok = false;
+				else if (it != m.end() && it->second != jt->second) ok = false;
+			}
+		}
+	}
+	std::cout << ok << " " << (m.size() == ref.size()) << std::endl;
+}
+
+//	equal for the comparator, but std::hash tells them apart
+struct no_case {
+	bool operator () (const std::string &a, const std::string &b) const {
+		for (size_t i = 0; i < a.size() && i < b.size(); ++i) {
+			int x = std::tolower((unsigned char)a[i]), y = std::tolower((unsigned char)b[i]);
+			if (x != y) return x < y;
+		}
+		return a.size() < b.size();
+	}
+};
+typedef sjtu::map<std::string, int, no_case, std::allocator<sjtu::pair<const std::string, int>>, sjtu::lookup_cache_policy> nmap;
+
+void no_case_keys(void) {
+	nmap m;
+	m["abc"] = 1;
+	m["Xyz"] = 2;
+	std::cout << m.count("ABC") << m.count("abc") << m.at("XYZ") << m.find("aBc")->first << " ";
+	m.erase("abc");
+	std::cout << m.count("ABC") << m.count("abc") << m.count("aBc") << " ";
+	m["ABC"] = 3;
+	std::cout << m.at("abc") << m.find("abc")->first << " ";
+	m.erase(m.find("xyz"));
+	std::cout << m.count("XYZ") << m.count("Xyz") << " " << m.size() << std::endl;
+}
+
+int main(void) {
+	tester();
+	split_join();
+	against_std();
+	no_case_keys();
+	return 0;
+}
@@ -0,0 +1,707 @@
+/**
+ * implement an ordered map on two sorted arrays
+ */
+#ifndef SJTU_FLAT_MAP_HPP
+#define SJTU_FLAT_MAP_HPP
+
+ // only for std::less<T>
+#include <functional>
+#include <algorithm>
+#include <cstddef>
+#include <iterator>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include "utility.hpp"
+#include "exceptions.hpp"
+#include "map.hpp"
+
+namespace sjtu {
+
+    /**
+     * an ordered map kept as a sorted array of keys next to an array of values,
+     *   for maps that are built once and then mostly read.
+     *
+     * a lookup is a branch-free binary search over the keys alone: they lie packed
+     *   together, so the last steps of a search share cache lines, and no value is
+     *   touched before the key is found. iteration is a linear scan. there is no
+     *   per-element allocation, only the two arrays.
+     * inserting or erasing one element shifts everything behind it, O(n); build big
+     *   maps from a range instead, which sorts once in O(n log n).
+     *
+     * the interface follows sjtu::map. as keys and values are stored apart, *it is a
+     *   pair<const Key&, T&> built on the fly (it->first and it->second work as usual).
+     *   the iterators are random access. any insertion or erasure invalidates them all,
+     *   and all references into the map.
+     */
+    template<
+        class Key,
+        class T,
+        class Compare = std::less<Key>,
+        class Allocator = std::allocator<pair<const Key, T>>
+    > class flat_map {
+    public:
+        typedef pair<const Key, T> value_type;
+        typedef pair<const Key&, T&> reference;
+        typedef pair<const Key&, const T&> const_reference;
+    private:
+        typedef typename std::allocator_traits<Allocator>::template rebind_alloc<Key> key_allocator;
+        typedef typename std::allocator_traits<Allocator>::template rebind_alloc<T> mapped_allocator;
+        typedef std::allocator_traits<key_allocator> key_traits;
+        typedef std::allocator_traits<mapped_allocator> mapped_traits;
+        static constexpr size_t MIN_CAPACITY = 8;
+
+        key_allocator key_alloc;
+        mapped_allocator mapped_alloc;
+        Key* keys;
+        T* vals;
+        size_t len;
+        size_t cap;
+
+        //reference是临时造出来的 ->要返回一个带着它的对象
+        template<class R>
+        struct arrow_proxy {
+            R r;
+            R* operator->() { return &r; }
+        };
+
+        //插入前先把值造在这里 构造抛异常时数组还没动
+        template<class U>
+        struct holder {
+            alignas(U) unsigned char storage[sizeof(U)];
+            template<class... Args>
+            explicit holder(Args&&... args) { new(storage) U(std::forward<Args>(args)...); }
+            ~holder() { get().~U(); }
+            U& get() { return *reinterpret_cast<U*>(storage); }
+        };
+
+        //两块都拿到了才换上keys vals cap 抛异常时它们都还是原来的
+        void allocate(size_t n) {
+            Key* k = n ? key_traits::allocate(key_alloc, n) : nullptr;
+            T* v;
+            try {
+                v = n ? mapped_traits::allocate(mapped_alloc, n) : nullptr;
+            }
+            catch (...) {
+                if (k) key_traits::deallocate(key_alloc, k, n);
+                throw;
+            }
+            keys = k;
+            vals = v;
+            cap = n;
+        }
+        void deallocate() {
+            if (keys) key_traits::deallocate(key_alloc, keys, cap);
+            if (vals) mapped_traits::deallocate(mapped_alloc, vals, cap);
+            keys = nullptr;
+            vals = nullptr;
+            cap = 0;
+        }
+        void destroy(size_t from, size_t to) {
+            for (size_t i = from; i < to; i++) {
+                keys[i].~Key();
+                vals[i].~T();
+            }
+        }
+        //把[from, to)移到dst的同一位置 用移动构造加析构 不需要赋值运算符
+        static void relocate(Key* ks, T* vs, size_t from, size_t to, Key* dk, T* dv, ptrdiff_t shift) {
+            for (size_t i = from; i < to; i++) {
+                new(dk + i + shift) Key(std::move_if_noexcept(ks[i]));
+                ks[i].~Key();
+                new(dv + i + shift) T(std::move_if_noexcept(vs[i]));
+                vs[i].~T();
+            }
+        }
+        static void relocate_backward(Key* ks, T* vs, size_t from, size_t to, ptrdiff_t shift) {
+            for (size_t i = to; i-- > from;) {
+                new(ks + i + shift) Key(std::move_if_noexcept(ks[i]));
+                ks[i].~Key();
+                new(vs + i + shift) T(std::move_if_noexcept(vs[i]));
+                vs[i].~T();
+            }
+        }
+        //换成n个位置的数组 在pos处留出gap个空位
+        void reallocate(size_t n, size_t pos = 0, size_t gap = 0) {
+            Key* oldk = keys;
+            T* oldv = vals;
+            size_t oldcap = cap;
+            allocate(n);
+            relocate(oldk, oldv, 0, pos, keys, vals, 0);
+            relocate(oldk, oldv, pos, len, keys, vals, (ptrdiff_t)gap);
+            if (oldk) key_traits::deallocate(key_alloc, oldk, oldcap);
+            if (oldv) mapped_traits::deallocate(mapped_alloc, oldv, oldcap);
+        }
+        //在pos处放下k和v pos以后的元素后移一位
+        template<class K, class V>
+        void insertAt(size_t pos, K&& k, V&& v) {
+            if (len == cap) reallocate(cap * 2 < MIN_CAPACITY ? MIN_CAPACITY : cap * 2, pos, 1);
+            else relocate_backward(keys, vals, pos, len, 1);
+            new(keys + pos) Key(std::forward<K>(k));
+            new(vals + pos) T(std::forward<V>(v));
+            len++;
+        }
+        void eraseAt(size_t pos) {
+            keys[pos].~Key();
+            vals[pos].~T();
+            relocate(keys, vals, pos + 1, len, keys, vals, -1);
+            len--;
+        }
+        void append(const Key& k, const T& v) {
+            if (len == cap) reallocate(cap * 2 < MIN_CAPACITY ? MIN_CAPACITY : cap * 2);
+            new(keys + len) Key(k);
+            new(vals + len) T(v);
+            len++;
+        }
+
+        //无分支的lower bound 每步只剩一半 比较结果用条件传送选边 不靠分支预测
+        //数组大时把下一步可能的两个中点先预取
+        template<class K>
+        size_t lowerBound(const K& key) const {
+            if (len == 0) return 0;
+            const Key* base = keys;
+            size_t n = len;
+            while (n > 1) {
+                size_t half = n / 2;
+                prefetch(base + half / 2);
+                prefetch(base + half + half / 2);
+                base = Compare()(base[half], key) ? base + half : base;
+                n -= half;
+            }
+            return (size_t)(base - keys) + Compare()(*base, key);
+        }
+        template<class K>
+        size_t upperBound(const K& key) const {
+            if (len == 0) return 0;
+            const Key* base = keys;
+            size_t n = len;
+            while (n > 1) {
+                size_t half = n / 2;
+                prefetch(base + half / 2);
+                prefetch(base + half + half / 2);
+                base = Compare()(key, base[half]) ? base : base + half;
+                n -= half;
+            }
+            return (size_t)(base - keys) + !Compare()(key, *base);
+        }
+        //找不到返回len
+        template<class K>
+        size_t locate(const K& key) const {
+            size_t i = lowerBound(key);
+            if (i < len && !Compare()(key, keys[i])) return i;
+            return len;
+        }
+
+        //先按输入顺序收进来 再排一个下标数组 按它搬到新数组里 相等的key只留最早的
+        //排的是下标 元素只搬一次 也不需要赋值运算符
+        template<class InputIt>
+        void build(InputIt first, InputIt last) {
+            for (; first != last; ++first) append((*first).first, (*first).second);
+            if (len < 2) return;
+            size_t* order = new size_t[len];
+            for (size_t i = 0; i < len; i++) order[i] = i;
+            try {
+                std::stable_sort(order, order + len, [this](size_t a, size_t b) { return Compare()(keys[a], keys[b]); });
+            }
+            catch (...) {
+                delete[] order;
+                throw;
+            }
+            Key* oldk = keys;
+            T* oldv = vals;
+            size_t oldlen = len, oldcap = cap, kept = 0;
+            try {
+                allocate(oldcap);
+            }
+            catch (...) {
+                delete[] order;
+                throw;
+            }
+            for (size_t i = 0; i < oldlen; i++) {
+                size_t j = order[i];
+                if (kept > 0 && !Compare()(keys[kept - 1], oldk[j])) continue;
+                new(keys + kept) Key(std::move_if_noexcept(oldk[j]));
+                new(vals + kept) T(std::move_if_noexcept(oldv[j]));
+                kept++;
+            }
+            for (size_t i = 0; i < oldlen; i++) {
+                oldk[i].~Key();
+                oldv[i].~T();
+            }
+            key_traits::deallocate(key_alloc, oldk, oldcap);
+            mapped_traits::deallocate(mapped_alloc, oldv, oldcap);
+            delete[] order;
+            len = kept;
+        }
+        void copyFrom(const flat_map& other) {
+            allocate(other.len);
+            for (; len < other.len; len++) {
+                new(keys + len) Key(other.keys[len]);
+                try {
+                    new(vals + len) T(other.vals[len]);
+                }
+                catch (...) {
+                    keys[len].~Key();
+                    throw;
+                }
+            }
+        }
+
+    public:
+        class const_iterator;
+        class iterator {
+            friend class flat_map;
+        private:
+            flat_map* map_ptr;
+            size_t pos;
+        public:
+            typedef std::ptrdiff_t difference_type;
+            typedef typename flat_map::value_type value_type;
+            typedef typename flat_map::reference reference;
+            typedef arrow_proxy<reference> pointer;
+            typedef std::random_access_iterator_tag iterator_category;
+
+            iterator(flat_map* m = nullptr, size_t p = 0) :map_ptr(m), pos(p) {}
+            iterator& operator++() {
+                if (pos >= map_ptr->len) throw invalid_iterator();
+                pos++;
+                return *this;
+            }
+            iterator operator++(int) {
+                iterator t = *this;
+                ++*this;
+                return t;
+            }
+            iterator& operator--() {
+                if (pos == 0) throw invalid_iterator();
+                pos--;
+                return *this;
+            }
+            iterator operator--(int) {
+                iterator t = *this;
+                --*this;
+                return t;
+            }
+            reference operator*() const {
+                if (pos >= map_ptr->len) throw invalid_iterator();
+                return reference(map_ptr->keys[pos], map_ptr->vals[pos]);
+            }
+            pointer operator->() const {
+                return pointer{ **this };
+            }
+            bool operator==(const iterator& rhs) const {
+                return map_ptr == rhs.map_ptr && pos == rhs.pos;
+            }
+            bool operator==(const const_iterator& rhs) const {
+                return map_ptr == rhs.map_ptr && pos == rhs.pos;
+            }
+            bool operator!=(const iterator& rhs) const {
+                return !(*this == rhs);
+            }
+            bool operator!=(const const_iterator& rhs) const {
+                return !(*this == rhs);
+            }
+            /**
+             * moving before begin() or past end() throws invalid_iterator.
+             */
+            iterator operator+(difference_type k) const {
+                difference_type i = (difference_type)pos + k;
+                if (i < 0 || i > (difference_type)map_ptr->len) throw invalid_iterator();
+                return iterator(map_ptr, (size_t)i);
+            }
+            iterator operator-(difference_type k) const {
+                return *this + (-k);
+            }
+            iterator& operator+=(difference_type k) {
+                return *this = *this + k;
+            }
+            iterator& operator-=(difference_type k) {
+                return *this = *this + (-k);
+            }
+            difference_type operator-(const iterator& rhs) const {
+                if (map_ptr != rhs.map_ptr) throw invalid_iterator();
+                return (difference_type)pos - (difference_type)rhs.pos;
+            }
+            reference operator[](difference_type k) const {
+                return *(*this + k);
+            }
+            bool operator<(const iterator& rhs) const { return *this - rhs < 0; }
+            bool operator>(const iterator& rhs) const { return rhs < *this; }
+            bool operator<=(const iterator& rhs) const { return !(rhs < *this); }
+            bool operator>=(const iterator& rhs) const { return !(*this < rhs); }
+        };
+        class const_iterator {
+            friend class flat_map;
+        private:
+            const flat_map* map_ptr;
+            size_t pos;
+        public:
+            typedef std::ptrdiff_t difference_type;
+            typedef typename flat_map::value_type value_type;
+            typedef typename flat_map::const_reference reference;
+            typedef arrow_proxy<reference> pointer;
+            typedef std::random_access_iterator_tag iterator_category;
+
+            const_iterator(const flat_map* m = nullptr, size_t p = 0) :map_ptr(m), pos(p) {}
+            const_iterator(const iterator& other) :map_ptr(other.map_ptr), pos(other.pos) {}
+            const_iterator& operator++() {
+                if (pos >= map_ptr->len) throw invalid_iterator();
+                pos++;
+                return *this;
+            }
+            const_iterator operator++(int) {
+                const_iterator t = *this;
+                ++*this;
+                return t;
+            }
+            const_iterator& operator--() {
+                if (pos == 0) throw invalid_iterator();
+                pos--;
+                return *this;
+            }
+            const_iterator operator--(int) {
+                const_iterator t = *this;
+                --*this;
+                return t;
+            }
+            reference operator*() const {
+                if (pos >= map_ptr->len) throw invalid_iterator();
+                return reference(map_ptr->keys[pos], map_ptr->vals[pos]);
+            }
+            pointer operator->() const {
+                return pointer{ **this };
+            }
+            bool operator==(const iterator& rhs) const {
+                return map_ptr == rhs.map_ptr && pos == rhs.pos;
+            }
+            bool operator==(const const_iterator& rhs) const {
+                return map_ptr == rhs.map_ptr && pos == rhs.pos;
+            }
+            bool operator!=(const iterator& rhs) const {
+                return !(*this == rhs);
+            }
+            bool operator!=(const const_iterator& rhs) const {
+                return !(*this == rhs);
+            }
+            const_iterator operator+(difference_type k) const {
+                difference_type i = (difference_type)pos + k;
+                if (i < 0 || i > (difference_type)map_ptr->len) throw invalid_iterator();
+                return const_iterator(map_ptr, (size_t)i);
+            }
+            const_iterator operator-(difference_type k) const {
+                return *this + (-k);
+            }
+            const_iterator& operator+=(difference_type k) {
+                return *this = *this + k;
+            }
+            const_iterator& operator-=(difference_type k) {
+                return *this = *this + (-k);
+            }
+            difference_type operator-(const const_iterator& rhs) const {
+                if (map_ptr != rhs.map_ptr) throw invalid_iterator();
+                return (difference_type)pos - (difference_type)rhs.pos;
+            }
+            reference operator[](difference_type k) const {
+                return *(*this + k);
+            }
+            bool operator<(const const_iterator& rhs) const { return *this - rhs < 0; }
+            bool operator>(const const_iterator& rhs) const { return rhs < *this; }
+            bool operator<=(const const_iterator& rhs) const { return !(rhs < *this); }
+            bool operator>=(const const_iterator& rhs) const { return !(*this < rhs); }
+        };
+
+        flat_map() : keys(nullptr), vals(nullptr), len(0), cap(0) {}
+        flat_map(const flat_map& other)
+            : key_alloc(other.key_alloc), mapped_alloc(other.mapped_alloc), keys(nullptr), vals(nullptr), len(0), cap(0) {
+            try {
+                copyFrom(other);
+            }
+            catch (...) {
+                clear();
+                deallocate();
+                throw;
+            }
+        }
+        /**
+         * builds the map from [first, last) of anything with .first and .second, which may
+         *   be unsorted and contain duplicates; of equal keys the first one is kept.
+         * every element is copied once and sorted once, O(n log n).
+         */
+        template<class InputIt>
+        flat_map(InputIt first, InputIt last) : flat_map() {
+            try {
+                build(first, last);
+            }
+            catch (...) {
+                clear();
+                deallocate();
+                throw;
+            }
+        }
+        /**
+         * builds the map from [first, last), whose keys must be strictly increasing, in O(n).
+         * throw runtime_error if they are not.
+         */
+        template<class InputIt>
+        flat_map(sorted_unique_t, InputIt first, InputIt last) : flat_map() {
+            try {
+                for (; first != last; ++first) {
+                    if (len > 0 && !Compare()(keys[len - 1], (*first).first)) throw runtime_error();
+                    append((*first).first, (*first).second);
+                }
+            }
+            catch (...) {
+                clear();
+                deallocate();
+                throw;
+            }
+        }
+        /**
+         * copies a map, whose elements are already in order, in O(n).
+         */
+        template<class A, class P>
+        explicit flat_map(const map<Key, T, Compare, A, P>& m) : flat_map(sorted_unique, m.cbegin(), m.cend()) {}
+        flat_map(flat_map&& other) noexcept
+            : key_alloc(other.key_alloc), mapped_alloc(other.mapped_alloc),
+            keys(other.keys), vals(other.vals), len(other.len), cap(other.cap) {
+            other.keys = nullptr;
+            other.vals = nullptr;
+            other.len = other.cap = 0;
+        }
+        flat_map& operator=(const flat_map& other) {
+            if (&other == this) return *this;
+            flat_map t(other);
+            swap(t);
+            return *this;
+        }
+        flat_map& operator=(flat_map&& other) {
+            if (&other == this) return *this;
+            clear();
+            swap(other);
+            return *this;
+        }
+        void swap(flat_map& other) {
+            std::swap(key_alloc, other.key_alloc);
+            std::swap(mapped_alloc, other.mapped_alloc);
+            std::swap(keys, other.keys);
+            std::swap(vals, other.vals);
+            std::swap(len, other.len);
+            std::swap(cap, other.cap);
+        }
+        ~flat_map() {
+            clear();
+            deallocate();
+        }
+
+        /**
+         * access specified element with bounds checking.
+         * If no such element exists, an exception of type `index_out_of_bound'
+         */
+        T& at(const Key& key) {
+            size_t i = locate(key);
+            if (i == len) throw index_out_of_bound();
+            return vals[i];
+        }
+        const T& at(const Key& key) const {
+            size_t i = locate(key);
+            if (i == len) throw index_out_of_bound();
+            return vals[i];
+        }
+        /**
+         * the lookups taking a K instead of a Key (at, count, contains, find)
+         *   only exist if Compare has a member type is_transparent, like std::less<>.
+         */
+        template<class K, class C = Compare, class = typename C::is_transparent>
+        T& at(const K& key) {
+            size_t i = locate(key);
+            if (i == len) throw index_out_of_bound();
+            return vals[i];
+        }
+        template<class K, class C = Compare, class = typename C::is_transparent>
+        const T& at(const K& key) const {
+            size_t i = locate(key);
+            if (i == len) throw index_out_of_bound();
+            return vals[i];
+        }
+        /**
+         * the value mapped to key, inserting T() if key is absent.
+         */
+        T& operator[](const Key& key) {
+            //先插入再取vals 插入可能换掉数组
+            size_t i = try_emplace(key).first.pos;
+            return vals[i];
+        }
+        T& operator[](Key&& key) {
+            size_t i = try_emplace(std::move(key)).first.pos;
+            return vals[i];
+        }
+        /**
+         * behave like at() throw index_out_of_bound if such key does not exist.
+         */
+        const T& operator[](const Key& key) const {
+            return at(key);
+        }
+
+        iterator begin() {
+            return iterator(this, 0);
+        }
+        const_iterator cbegin() const {
+            return const_iterator(this, 0);
+        }
+        iterator end() {
+            return iterator(this, len);
+        }
+        const_iterator cend() const {
+            return const_iterator(this, len);
+        }
+        bool empty() const {
+            return len == 0;
+        }
+        size_t size() const {
+            return len;
+        }
+        /**
+         * the number of elements the arrays hold without growing.
+         */
+        size_t capacity() const {
+            return cap;
+        }
+        /**
+         * grows the arrays to at least n elements.
+         */
+        void reserve(size_t n) {
+            if (n > cap) reallocate(n, len);
+        }
+        /**
+         * shrinks the arrays to size().
+         */
+        void shrink_to_fit() {
+            if (cap == len) return;
+            if (len == 0) deallocate();
+            else reallocate(len, len);
+        }
+        /**
+         * destroys every element and keeps the arrays.
+         */
+        void clear() {
+            destroy(0, len);
+            len = 0;
+        }
+
+        /**
+         * insert an element.
+         * return a pair, the first of the pair is
+         *   the iterator to the new element (or the element that prevented the insertion),
+         *   the second one is true if insert successfully, or false.
+         */
+        pair<iterator, bool> insert(const value_type& value) {
+            size_t i = lowerBound(value.first);
+            if (i < len && !Compare()(value.first, keys[i])) return pair<iterator, bool>(iterator(this, i), false);
+            holder<Key> k(value.first);
+            holder<T> v(value.second);
+            insertAt(i, std::move(k.get()), std::move(v.get()));
+            return pair<iterator, bool>(iterator(this, i), true);
+        }
+        pair<iterator, bool> insert(value_type&& value) {
+            size_t i = lowerBound(value.first);
+            if (i < len && !Compare()(value.first, keys[i])) return pair<iterator, bool>(iterator(this, i), false);
+            holder<Key> k(value.first);
+            holder<T> v(std::move(value.second));
+            insertAt(i, std::move(k.get()), std::move(v.get()));
+            return pair<iterator, bool>(iterator(this, i), true);
+        }
+        /**
+         * if key is absent, inserts key with T(args...); otherwise does nothing.
+         */
+        template<class... Args>
+        pair<iterator, bool> try_emplace(const Key& key, Args&&... args) {
+            size_t i = lowerBound(key);
+            if (i < len && !Compare()(key, keys[i])) return pair<iterator, bool>(iterator(this, i), false);
+            holder<Key> k(key);
+            holder<T> v(std::forward<Args>(args)...);
+            insertAt(i, std::move(k.get()), std::move(v.get()));
+            return pair<iterator, bool>(iterator(this, i), true);
+        }
+        template<class... Args>
+        pair<iterator, bool> try_emplace(Key&& key, Args&&... args) {
+            size_t i = lowerBound(key);
+            if (i < len && !Compare()(key, keys[i])) return pair<iterator, bool>(iterator(this, i), false);
+            holder<Key> k(std::move(key));
+            holder<T> v(std::forward<Args>(args)...);
+            insertAt(i, std::move(k.get()), std::move(v.get()));
+            return pair<iterator, bool>(iterator(this, i), true);
+        }
+
+        /**
+         * erase the element at pos.
+         * throw if pos pointed to a bad element (pos == this->end() || pos points an element out of this)
+         */
+        void erase(iterator pos) {
+            if (pos.map_ptr != this || pos.pos >= len) throw invalid_iterator();
+            eraseAt(pos.pos);
+        }
+        /**
+         * removes the element with key equivalent to key, if any.
+         * returns the number of elements removed (0 or 1).
+         */
+        size_t erase(const Key& key) {
+            size_t i = locate(key);
+            if (i == len) return 0;
+            eraseAt(i);
+            return 1;
+        }
+
+        size_t count(const Key& key) const {
+            return locate(key) < len ? 1 : 0;
+        }
+        template<class K, class C = Compare, class = typename C::is_transparent>
+        size_t count(const K& key) const {
+            return locate(key) < len ? 1 : 0;
+        }
+        bool contains(const Key& key) const {
+            return locate(key) < len;
+        }
+        template<class K, class C = Compare, class = typename C::is_transparent>
+        bool contains(const K& key) const {
+            return locate(key) < len;
+        }
+        /**
+         * Finds an element with key equivalent to key.
+         *   If no such element is found, past-the-end (see end()) iterator is returned.
+         */
+        iterator find(const Key& key) {
+            return iterator(this, locate(key));
+        }
+        const_iterator find(const Key& key) const {
+            return const_iterator(this, locate(key));
+        }
+        template<class K, class C = Compare, class = typename C::is_transparent>
+        iterator find(const K& key) {
+            return iterator(this, locate(key));
+        }
+        template<class K, class C = Compare, class = typename C::is_transparent>
+        const_iterator find(const K& key) const {
+            return const_iterator(this, locate(key));
+        }
+        /**
+         * the first element whose key is not less than key, or end().
+         */
+        iterator lower_bound(const Key& key) {
+            return iterator(this, lowerBound(key));
+        }
+        const_iterator lower_bound(const Key& key) const {
+            return const_iterator(this, lowerBound(key));
+        }
+        /**
+         * the first element whose key is greater than key, or end().
+         */
+        iterator upper_bound(const Key& key) {
+            return iterator(this, upperBound(key));
+        }
+        const_iterator upper_bound(const Key& key) const {
+            return const_iterator(this, upperBound(key));
+        }
+    };
+
+}
+
+#endif
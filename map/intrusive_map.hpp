@@ -0,0 +1,626 @@
+/**
+ * implement an ordered map over elements that carry their own tree links
+ */
+#ifndef SJTU_INTRUSIVE_MAP_HPP
+#define SJTU_INTRUSIVE_MAP_HPP
+
+ // only for std::less<T>
+#include <functional>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <type_traits>
+#include "utility.hpp"
+#include "exceptions.hpp"
+
+namespace sjtu {
+
+    /**
+     * the links an element embeds to sit in an intrusive_map: the parent, with the
+     *   colour in its lowest bit, and the two children.
+     * a hook can be in one map at a time. an element may embed several hooks and sit
+     *   in as many maps at once, each map naming its own hook.
+     * copying an element does not copy its links: the copy starts outside every map.
+     */
+    class intrusive_map_hook {
+        template<class Key, class T, Key T::* KeyField, intrusive_map_hook T::* Hook, class Compare>
+        friend class intrusive_map;
+
+        uintptr_t parent_color;//不在map里时是0 在的话parent至少是header 不会是0
+        intrusive_map_hook* left;
+        intrusive_map_hook* right;
+    public:
+        intrusive_map_hook() noexcept : parent_color(0), left(nullptr), right(nullptr) {}
+        intrusive_map_hook(const intrusive_map_hook&) noexcept : intrusive_map_hook() {}
+        intrusive_map_hook& operator=(const intrusive_map_hook&) noexcept {
+            return *this;
+        }
+        /**
+         * whether the element is in a map through this hook.
+         */
+        bool is_linked() const noexcept {
+            return parent_color != 0;
+        }
+    };
+
+    /**
+     * an ordered map of elements the caller owns, keyed by the member KeyField and
+     *   linked through their member Hook.
+     *
+     * inserting links the element itself into the tree: no node is allocated and
+     *   nothing is copied, so insert and erase never allocate and never throw on
+     *   account of memory. the tree is the red-black tree of map, with the same
+     *   one comparison per level on the way down and amortized O(1) rebalancing.
+     * the map does not own its elements. an element must stay alive, and its key
+     *   unchanged, for as long as it is linked; erase() or clear() unlinks it, and
+     *   the destructor unlinks them all. iterators dereference to the elements.
+     */
+    template<
+        class Key,
+        class T,
+        Key T::* KeyField,
+        intrusive_map_hook T::* Hook,
+        class Compare = std::less<Key>
+    > class intrusive_map : private functor_holder<Compare> {
+    public:
+        typedef T value_type;
+        typedef Key key_type;
+    private:
+        typedef intrusive_map_hook hook;
+        static constexpr uintptr_t BLACK = 1;
+
+        //header只用left 指向根 根的parent是header 空树时begin和end都是header
+        hook header;
+        hook* minNode;
+        hook* maxNode;
+        size_t len;
+
+        const Compare& comp() const noexcept {
+            return this->functor();
+        }
+
+        //hook在T里的偏移 拿一个凑好对齐的假地址算 不会真的去读它
+        static size_t hook_offset() noexcept {
+            const uintptr_t fake = alignof(T) * 64;
+            const T* p = reinterpret_cast<const T*>(fake);
+            return reinterpret_cast<uintptr_t>(&(p->*Hook)) - fake;
+        }
+        static T* owner(hook* h) noexcept {
+            return reinterpret_cast<T*>(reinterpret_cast<char*>(h) - hook_offset());
+        }
+        static const Key& key(hook* h) noexcept {
+            return owner(h)->*KeyField;
+        }
+
+        static hook* parent(const hook* h) noexcept {
+            return reinterpret_cast<hook*>(h->parent_color & ~BLACK);
+        }
+        static void setParent(hook* h, hook* p) noexcept {
+            h->parent_color = reinterpret_cast<uintptr_t>(p) | (h->parent_color & BLACK);
+        }
+        //空孩子算黑的
+        static bool isBlack(const hook* h) noexcept {
+            return !h || (h->parent_color & BLACK);
+        }
+        static void setBlack(hook* h) noexcept {
+            h->parent_color |= BLACK;
+        }
+        static void setRed(hook* h) noexcept {
+            h->parent_color &= ~BLACK;
+        }
+        static void copyColor(hook* to, const hook* from) noexcept {
+            to->parent_color = (to->parent_color & ~BLACK) | (from->parent_color & BLACK);
+        }
+        hook* root() const noexcept {
+            return header.left;
+        }
+
+        //中序后继 最大结点的后继是header
+        hook* nextNode(hook* h) const noexcept {
+            if (h->right) {
+                h = h->right;
+                while (h->left) h = h->left;
+                return h;
+            }
+            hook* p = parent(h);
+            while (p != &header && h == p->right) {
+                h = p;
+                p = parent(h);
+            }
+            return p;
+        }
+        //header的前驱是最大结点 最小结点没有前驱 调用前要先判断
+        hook* prevNode(hook* h) const noexcept {
+            if (h == &header) return maxNode;
+            if (h->left) {
+                h = h->left;
+                while (h->right) h = h->right;
+                return h;
+            }
+            hook* p = parent(h);
+            while (h == p->left) {
+                h = p;
+                p = parent(h);
+            }
+            return p;
+        }
+
+        //把u在父结点里的位置换成v 根的父结点是header 它的left就是根 不用特判
+        void transplant(hook* u, hook* v) noexcept {
+            hook* p = parent(u);
+            if (u == p->left) p->left = v;
+            else p->right = v;
+            if (v) setParent(v, p);
+        }
+        void rotateLeft(hook* x) noexcept {
+            hook* y = x->right;
+            x->right = y->left;
+            if (y->left) setParent(y->left, x);
+            transplant(x, y);
+            y->left = x;
+            setParent(x, y);
+        }
+        void rotateRight(hook* x) noexcept {
+            hook* y = x->left;
+            x->left = y->right;
+            if (y->right) setParent(y->right, x);
+            transplant(x, y);
+            y->right = x;
+            setParent(x, y);
+        }
+
+        //新挂上的红结点z 父结点也红时向上修 叔叔红就变色上移 否则一两次旋转结束
+        void maintainAfterInsert(hook* z) noexcept {
+            while (z != root() && !isBlack(parent(z))) {
+                hook* p = parent(z);
+                hook* g = parent(p);
+                if (p == g->left) {
+                    hook* u = g->right;
+                    if (!isBlack(u)) {
+                        setBlack(p);
+                        setBlack(u);
+                        setRed(g);
+                        z = g;
+                        continue;
+                    }
+                    if (z == p->right) {
+                        rotateLeft(p);
+                        z = p;
+                        p = parent(z);
+                    }
+                    setBlack(p);
+                    setRed(g);
+                    rotateRight(g);
+                }
+                else {
+                    hook* u = g->left;
+                    if (!isBlack(u)) {
+                        setBlack(p);
+                        setBlack(u);
+                        setRed(g);
+                        z = g;
+                        continue;
+                    }
+                    if (z == p->left) {
+                        rotateRight(p);
+                        z = p;
+                        p = parent(z);
+                    }
+                    setBlack(p);
+                    setRed(g);
+                    rotateLeft(g);
+                }
+            }
+            setBlack(root());
+        }
+
+        //x顶替了一个黑结点 少了一层黑 x可能是空的 所以父结点单独传
+        void maintainAfterRemove(hook* x, hook* xp) noexcept {
+            while (x != root() && isBlack(x)) {
+                if (x == xp->left) {
+                    hook* w = xp->right;
+                    if (!isBlack(w)) {
+                        setBlack(w);
+                        setRed(xp);
+                        rotateLeft(xp);
+                        w = xp->right;
+                    }
+                    if (isBlack(w->left) && isBlack(w->right)) {
+                        setRed(w);
+                        x = xp;
+                        xp = parent(x);
+                        continue;
+                    }
+                    if (isBlack(w->right)) {
+                        setBlack(w->left);
+                        setRed(w);
+                        rotateRight(w);
+                        w = xp->right;
+                    }
+                    copyColor(w, xp);
+                    setBlack(xp);
+                    setBlack(w->right);
+                    rotateLeft(xp);
+                }
+                else {
+                    hook* w = xp->left;
+                    if (!isBlack(w)) {
+                        setBlack(w);
+                        setRed(xp);
+                        rotateRight(xp);
+                        w = xp->left;
+                    }
+                    if (isBlack(w->left) && isBlack(w->right)) {
+                        setRed(w);
+                        x = xp;
+                        xp = parent(x);
+                        continue;
+                    }
+                    if (isBlack(w->left)) {
+                        setBlack(w->right);
+                        setRed(w);
+                        rotateLeft(w);
+                        w = xp->left;
+                    }
+                    copyColor(w, xp);
+                    setBlack(xp);
+                    setBlack(w->left);
+                    rotateRight(xp);
+                }
+                x = root();
+            }
+            if (x) setBlack(x);
+        }
+
+        //从树上摘下z 两个孩子都在时用后继结点顶替z的位置和颜色 元素本身都不动
+        void unlink(hook* z) noexcept {
+            if (z == minNode) minNode = nextNode(z);
+            if (z == maxNode) maxNode = (len == 1) ? &header : prevNode(z);
+            hook* x;
+            hook* xp;
+            bool removedBlack = isBlack(z);
+            if (!z->left || !z->right) {
+                x = z->left ? z->left : z->right;
+                xp = parent(z);
+                transplant(z, x);
+            }
+            else {
+                hook* y = z->right;
+                while (y->left) y = y->left;
+                removedBlack = isBlack(y);
+                x = y->right;
+                if (parent(y) == z) xp = y;
+                else {
+                    xp = parent(y);
+                    transplant(y, x);
+                    y->right = z->right;
+                    setParent(y->right, y);
+                }
+                transplant(z, y);
+                y->left = z->left;
+                setParent(y->left, y);
+                copyColor(y, z);
+            }
+            if (removedBlack) maintainAfterRemove(x, xp);
+            z->parent_color = 0;
+            z->left = z->right = nullptr;
+            len--;
+        }
+
+        //第一个不小于k的结点 没有就是header
+        hook* lowerBound(const Key& k) const {
+            hook* node = root();
+            hook* candidate = const_cast<hook*>(&header);
+            while (node) {
+                if (comp()(key(node), k)) node = node->right;
+                else {
+                    candidate = node;
+                    node = node->left;
+                }
+            }
+            return candidate;
+        }
+        hook* upperBound(const Key& k) const {
+            hook* node = root();
+            hook* candidate = const_cast<hook*>(&header);
+            while (node) {
+                if (comp()(k, key(node))) {
+                    candidate = node;
+                    node = node->left;
+                }
+                else node = node->right;
+            }
+            return candidate;
+        }
+        hook* findNode(const Key& k) const {
+            hook* p = lowerBound(k);
+            if (p != &header && !comp()(k, key(p))) return p;
+            return nullptr;
+        }
+
+        //沿parent指针后序走一遍 把每个hook都恢复成没挂上的样子
+        void unlinkAll() noexcept {
+            hook* node = root();
+            while (node) {
+                if (node->left) node = node->left;
+                else if (node->right) node = node->right;
+                else {
+                    hook* up = parent(node);
+                    if (up != &header) {
+                        if (up->left == node) up->left = nullptr;
+                        else up->right = nullptr;
+                    }
+                    node->parent_color = 0;
+                    node = (up == &header) ? nullptr : up;
+                }
+            }
+            header.left = nullptr;
+            minNode = maxNode = &header;
+            len = 0;
+        }
+        //other的树整个接到自己的header上 other留下空树
+        void takeOver(intrusive_map& other) noexcept {
+            header.left = other.header.left;
+            if (header.left) setParent(header.left, &header);
+            minNode = other.len ? other.minNode : &header;
+            maxNode = other.len ? other.maxNode : &header;
+            len = other.len;
+            other.header.left = nullptr;
+            other.minNode = other.maxNode = &other.header;
+            other.len = 0;
+        }
+
+        template<bool Const>
+        class basic_iterator {
+            friend class intrusive_map;
+            template<bool> friend class basic_iterator;
+            typedef typename std::conditional<Const, const intrusive_map*, intrusive_map*>::type map_pointer;
+            map_pointer map_ptr;
+            hook* ptr;
+            basic_iterator(map_pointer m, hook* p) : map_ptr(m), ptr(p) {}
+        public:
+            typedef std::ptrdiff_t difference_type;
+            typedef typename std::conditional<Const, const T, T>::type value_type;
+            typedef value_type* pointer;
+            typedef value_type& reference;
+            typedef std::bidirectional_iterator_tag iterator_category;
+
+            basic_iterator() : map_ptr(nullptr), ptr(nullptr) {}
+            //iterator可以转成const_iterator
+            template<bool C, class = typename std::enable_if<Const && !C>::type>
+            basic_iterator(const basic_iterator<C>& other) : map_ptr(other.map_ptr), ptr(other.ptr) {}
+
+            basic_iterator& operator++() {
+                if (!map_ptr || ptr == &map_ptr->header) throw invalid_iterator();
+                ptr = map_ptr->nextNode(ptr);
+                return *this;
+            }
+            basic_iterator operator++(int) {
+                basic_iterator cur = *this;
+                ++*this;
+                return cur;
+            }
+            basic_iterator& operator--() {
+                if (!map_ptr || ptr == map_ptr->minNode) throw invalid_iterator();
+                ptr = map_ptr->prevNode(ptr);
+                return *this;
+            }
+            basic_iterator operator--(int) {
+                basic_iterator cur = *this;
+                --*this;
+                return cur;
+            }
+            /**
+             * throw invalid_iterator at end().
+             */
+            reference operator*() const {
+                if (!map_ptr || ptr == &map_ptr->header) throw invalid_iterator();
+                return *owner(ptr);
+            }
+            pointer operator->() const {
+                return &**this;
+            }
+            template<bool C>
+            bool operator==(const basic_iterator<C>& rhs) const {
+                return ptr == rhs.ptr;
+            }
+            template<bool C>
+            bool operator!=(const basic_iterator<C>& rhs) const {
+                return ptr != rhs.ptr;
+            }
+        };
+
+    public:
+        typedef basic_iterator<false> iterator;
+        typedef basic_iterator<true> const_iterator;
+
+        intrusive_map() : minNode(&header), maxNode(&header), len(0) {}
+        explicit intrusive_map(const Compare& comp)
+            : functor_holder<Compare>(comp), minNode(&header), maxNode(&header), len(0) {}
+        //元素只能挂在一棵树上 不能复制
+        intrusive_map(const intrusive_map&) = delete;
+        intrusive_map& operator=(const intrusive_map&) = delete;
+        intrusive_map(intrusive_map&& other) noexcept : functor_holder<Compare>(other) {
+            takeOver(other);
+        }
+        /**
+         * unlinks the current elements, then takes over those of other.
+         */
+        intrusive_map& operator=(intrusive_map&& other) {
+            if (&other == this) return *this;
+            unlinkAll();
+            swap(other);
+            return *this;
+        }
+        /**
+         * unlinks every element; the elements themselves are left alone.
+         */
+        ~intrusive_map() {
+            unlinkAll();
+        }
+        /**
+         * exchanges the contents with other in O(1). the elements stay where they are, but
+         *   iterators taken before remain tied to the map they came from and must not be
+         *   used with either map afterwards; iterator_to() gives a new one.
+         */
+        void swap(intrusive_map& other) {
+            intrusive_map tmp(std::move(other));
+            other.takeOver(*this);
+            takeOver(tmp);
+            this->swap_functor(other);
+        }
+
+        iterator begin() {
+            return iterator(this, minNode);
+        }
+        const_iterator begin() const {
+            return const_iterator(this, minNode);
+        }
+        const_iterator cbegin() const {
+            return begin();
+        }
+        iterator end() {
+            return iterator(this, &header);
+        }
+        const_iterator end() const {
+            return const_iterator(this, const_cast<hook*>(&header));
+        }
+        const_iterator cend() const {
+            return end();
+        }
+        bool empty() const {
+            return len == 0;
+        }
+        size_t size() const {
+            return len;
+        }
+        Compare key_comp() const {
+            return comp();
+        }
+
+        /**
+         * links x into the map if no element has an equivalent key, in O(log n).
+         * returns an iterator to x, or to the element that prevented the insertion
+         *   (x is then left unlinked), and whether x was inserted.
+         * throw runtime_error if x is already linked through Hook, into this map or another.
+         */
+        pair<iterator, bool> insert(T& x) {
+            hook* h = &(x.*Hook);
+            if (h->is_linked()) throw runtime_error();
+            const Key& k = x.*KeyField;
+            //和map一样每层只比较一次 最后再反过来比一次判断相等
+            hook* node = root();
+            hook* parentNode = &header;
+            hook* candidate = nullptr;
+            bool toLeft = true;
+            while (node) {
+                parentNode = node;
+                toLeft = comp()(k, key(node));
+                if (toLeft) node = node->left;
+                else {
+                    candidate = node;
+                    node = node->right;
+                }
+            }
+            if (candidate && !comp()(key(candidate), k)) return pair<iterator, bool>(iterator(this, candidate), false);
+            h->left = h->right = nullptr;
+            h->parent_color = reinterpret_cast<uintptr_t>(parentNode);
+            if (toLeft) parentNode->left = h;
+            else parentNode->right = h;
+            if (parentNode == &header) minNode = maxNode = h;
+            else if (toLeft && parentNode == minNode) minNode = h;
+            else if (!toLeft && parentNode == maxNode) maxNode = h;
+            maintainAfterInsert(h);
+            len++;
+            return pair<iterator, bool>(iterator(this, h), true);
+        }
+
+        /**
+         * unlinks the element at pos and returns the iterator after it.
+         * throw invalid_iterator if pos is end() or belongs to another map.
+         */
+        iterator erase(const_iterator pos) {
+            if (pos.map_ptr != this || pos.ptr == &header) throw invalid_iterator();
+            hook* next = nextNode(pos.ptr);
+            unlink(pos.ptr);
+            return iterator(this, next);
+        }
+        /**
+         * unlinks the element with key k, if any. returns the number unlinked.
+         */
+        size_t erase(const Key& k) {
+            hook* p = findNode(k);
+            if (!p) return 0;
+            unlink(p);
+            return 1;
+        }
+        /**
+         * unlinks x, which must be linked into this map, without searching for it.
+         * throw runtime_error if x is not linked through Hook at all.
+         */
+        void erase(T& x) {
+            hook* h = &(x.*Hook);
+            if (!h->is_linked()) throw runtime_error();
+            unlink(h);
+        }
+        /**
+         * unlinks every element in O(n).
+         */
+        void clear() {
+            unlinkAll();
+        }
+
+        /**
+         * the iterator to x, which must be linked into this map. O(1).
+         */
+        iterator iterator_to(T& x) {
+            return iterator(this, &(x.*Hook));
+        }
+        const_iterator iterator_to(const T& x) const {
+            return const_iterator(this, const_cast<hook*>(&(x.*Hook)));
+        }
+
+        iterator find(const Key& k) {
+            hook* p = findNode(k);
+            return iterator(this, p ? p : &header);
+        }
+        const_iterator find(const Key& k) const {
+            hook* p = findNode(k);
+            return const_iterator(this, p ? p : const_cast<hook*>(&header));
+        }
+        size_t count(const Key& k) const {
+            return findNode(k) ? 1 : 0;
+        }
+        bool contains(const Key& k) const {
+            return findNode(k) != nullptr;
+        }
+        /**
+         * throw index_out_of_bound if k is absent.
+         */
+        T& at(const Key& k) {
+            hook* p = findNode(k);
+            if (!p) throw index_out_of_bound();
+            return *owner(p);
+        }
+        const T& at(const Key& k) const {
+            hook* p = findNode(k);
+            if (!p) throw index_out_of_bound();
+            return *owner(p);
+        }
+        iterator lower_bound(const Key& k) {
+            return iterator(this, lowerBound(k));
+        }
+        const_iterator lower_bound(const Key& k) const {
+            return const_iterator(this, lowerBound(k));
+        }
+        iterator upper_bound(const Key& k) {
+            return iterator(this, upperBound(k));
+        }
+        const_iterator upper_bound(const Key& k) const {
+            return const_iterator(this, upperBound(k));
+        }
+    };
+
+}
+
+#endif
@@ -0,0 +1,149 @@
+#ifndef SJTU_KEY_SEARCH_HPP
+#define SJTU_KEY_SEARCH_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <type_traits>
+
+//定义SJTU_NO_SIMD就只用下面的标量循环
+#ifndef SJTU_NO_SIMD
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define SJTU_SIMD_AVX2
+#elif defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#if defined(__SSE4_2__)
+#include <nmmintrin.h>
+#endif
+#define SJTU_SIMD_SSE2
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#define SJTU_SIMD_NEON
+#endif
+#endif
+
+namespace sjtu {
+
+/**
+ * searches a short sorted array of keys inside a tree node.
+ *
+ * count_less(keys, n, key) is the number of keys less than key (the lower bound position),
+ *   count_not_greater(keys, n, key) the number not greater than key (the upper bound position).
+ *
+ * only std::less over 32- and 64-bit integers is supported: vectorized is true there.
+ *   the keys are compared several at a time with SSE2 / AVX2 / NEON and the matching
+ *   lanes are counted with a popcount. the whole array is scanned, but no branch depends
+ *   on a key, which beats a binary search for the few dozen keys of a node.
+ * for any other key type or comparator vectorized is false and the caller keeps its own search.
+ */
+template<class Key, bool = std::is_integral<Key>::value && !std::is_same<Key, bool>::value
+    && (sizeof(Key) == 4 || sizeof(Key) == 8)>
+struct integer_key_search {
+    static constexpr bool vectorized = false;
+};
+
+template<class Key>
+struct integer_key_search<Key, true> {
+    static constexpr bool vectorized = true;
+
+    static size_t count_less(const Key* keys, size_t n, Key key) noexcept {
+        return count<false>(keys, n, key);
+    }
+    static size_t count_not_greater(const Key* keys, size_t n, Key key) noexcept {
+        return n - count<true>(keys, n, key);
+    }
+
+private:
+    typedef typename std::conditional<sizeof(Key) == 4, int32_t, int64_t>::type lane;
+    //无符号数把最高位翻过来 就可以按有符号数比较
+    static constexpr lane FLIP = std::is_signed<Key>::value ? 0 : std::numeric_limits<lane>::min();
+
+    static lane toLane(Key k) noexcept { return (lane)k ^ FLIP; }
+
+    //Greater时数大于key的 否则数小于key的
+    template<bool Greater>
+    static size_t count(const Key* keys, size_t n, Key key) noexcept {
+        size_t c = 0, i = 0;
+        lane k = toLane(key);
+#if defined(SJTU_SIMD_AVX2)
+        const size_t W = 32 / sizeof(Key);
+        __m256i kv, fv;
+        if (sizeof(Key) == 4) {
+            kv = _mm256_set1_epi32((int32_t)k);
+            fv = _mm256_set1_epi32((int32_t)FLIP);
+        }
+        else {
+            kv = _mm256_set1_epi64x((int64_t)k);
+            fv = _mm256_set1_epi64x((int64_t)FLIP);
+        }
+        for (; i + W <= n; i += W) {
+            __m256i a = _mm256_xor_si256(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(keys + i)), fv);
+            __m256i m;
+            if (sizeof(Key) == 4) m = Greater ? _mm256_cmpgt_epi32(a, kv) : _mm256_cmpgt_epi32(kv, a);
+            else m = Greater ? _mm256_cmpgt_epi64(a, kv) : _mm256_cmpgt_epi64(kv, a);
+            //每个命中的lane在掩码里占sizeof(Key)位
+            c += __builtin_popcount((unsigned)_mm256_movemask_epi8(m)) / sizeof(Key);
+        }
+#elif defined(SJTU_SIMD_SSE2)
+        //SSE2没有64位比较 要到SSE4.2才有
+#if !defined(__SSE4_2__)
+        if (sizeof(Key) == 4)
+#endif
+        {
+            const size_t W = 16 / sizeof(Key);
+            __m128i kv, fv;
+            if (sizeof(Key) == 4) {
+                kv = _mm_set1_epi32((int32_t)k);
+                fv = _mm_set1_epi32((int32_t)FLIP);
+            }
+            else {
+                kv = _mm_set1_epi64x((int64_t)k);
+                fv = _mm_set1_epi64x((int64_t)FLIP);
+            }
+            for (; i + W <= n; i += W) {
+                __m128i a = _mm_xor_si128(_mm_loadu_si128(reinterpret_cast<const __m128i*>(keys + i)), fv);
+                __m128i m;
+#if defined(__SSE4_2__)
+                if (sizeof(Key) == 8) m = Greater ? _mm_cmpgt_epi64(a, kv) : _mm_cmpgt_epi64(kv, a);
+                else
+#endif
+                m = Greater ? _mm_cmpgt_epi32(a, kv) : _mm_cmpgt_epi32(kv, a);
+                c += __builtin_popcount((unsigned)_mm_movemask_epi8(m)) / sizeof(Key);
+            }
+        }
+#elif defined(SJTU_SIMD_NEON)
+        if (sizeof(Key) == 4) {
+            int32x4_t kv = vdupq_n_s32((int32_t)k), fv = vdupq_n_s32((int32_t)FLIP);
+            for (; i + 4 <= n; i += 4) {
+                int32x4_t a = veorq_s32(vld1q_s32(reinterpret_cast<const int32_t*>(keys + i)), fv);
+                uint32x4_t m = Greater ? vcgtq_s32(a, kv) : vcltq_s32(a, kv);
+                c += vaddvq_u32(vshrq_n_u32(m, 31));
+            }
+        }
+        else {
+            int64x2_t kv = vdupq_n_s64((int64_t)k), fv = vdupq_n_s64((int64_t)FLIP);
+            for (; i + 2 <= n; i += 2) {
+                int64x2_t a = veorq_s64(vld1q_s64(reinterpret_cast<const int64_t*>(keys + i)), fv);
+                uint64x2_t m = Greater ? vcgtq_s64(a, kv) : vcltq_s64(a, kv);
+                c += vaddvq_u64(vshrq_n_u64(m, 63));
+            }
+        }
+#endif
+        for (; i < n; i++) c += Greater ? (toLane(keys[i]) > k) : (toLane(keys[i]) < k);
+        return c;
+    }
+};
+
+template<class Key, class Compare>
+struct key_search {
+    static constexpr bool vectorized = false;
+};
+
+template<class Key>
+struct key_search<Key, std::less<Key>> : integer_key_search<Key> {};
+
+}
+
+#endif
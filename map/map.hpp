@@ -6,9 +6,15 @@
 
  // only for std::less<T>
 #include <functional>
+#include <algorithm>
 #include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <type_traits>
+#include <vector>
 #include "utility.hpp"
 #include "exceptions.hpp"
+#include "node_pool.hpp"
 #include <cassert>
 
 namespace sjtu {
@@ -23,11 +29,61 @@ namespace sjtu {
         RIGHT,
         ROOT
     };
+    /**
+     * compile-time switches of sjtu::map.
+     * derive from default_map_policy and override only the flags you need.
+     */
+    struct default_map_policy {
+        // keep the subtree size in every node:
+        //   enables rank/select/nth and makes the iterators random access in O(log n)
+        static constexpr bool order_statistics = false;
+        // count insertions, erasures, rotations and node allocations, read back with stats().
+        //   when off the counters are not even compiled in
+        static constexpr bool stats = false;
+        // slots of a direct-mapped cache of recently found key -> node results, consulted by
+        //   find, at, count and contains before descending the tree. a power of two, 0 turns it off.
+        //   Key needs std::hash<Key>; hits and misses show up in stats(). the hash need not agree
+        //   with Compare: a key only hits when it hashes like the one stored in the map
+        static constexpr size_t lookup_cache = 0;
+    };
+    struct order_statistics_policy : default_map_policy {
+        static constexpr bool order_statistics = true;
+    };
+    struct map_stats_policy : default_map_policy {
+        static constexpr bool stats = true;
+    };
+    struct lookup_cache_policy : default_map_policy {
+        static constexpr size_t lookup_cache = 256;
+    };
+    /**
+     * what map::stats() returns. the counters run from construction or reset_stats().
+     */
+    struct map_stats {
+        unsigned long long inserts = 0;//挂到树上的结点 包括merge和insert(node)
+        unsigned long long erases = 0;//从树上摘下的结点 包括extract
+        unsigned long long insert_rotations = 0;
+        unsigned long long erase_rotations = 0;
+        unsigned long long node_allocations = 0;
+        unsigned long long cache_hits = 0;//查找缓存命中 没开lookup_cache时一直是0
+        unsigned long long cache_misses = 0;
+        size_t height = 0;//调用stats()时现算 空树是0
+    };
+    /**
+     * tag telling the constructor that the input is sorted and has no duplicate keys.
+     */
+    struct sorted_unique_t {
+        explicit sorted_unique_t() = default;
+    };
+    inline constexpr sorted_unique_t sorted_unique{};
+    //定义在mapped_map.hpp 用save和open_mapped时要包含它
+    template<class Key, class T, class Compare> class mapped_map;
     template<
         class Key,
         class T,
-        class Compare = std::less<Key>
-    > class map {
+        class Compare = std::less<Key>,
+        class Allocator = std::allocator<pair<const Key, T>>,
+        class Policy = default_map_policy
+    > class map : private functor_holder<Compare> {
     public:
         /**
          * the internal type of data.
@@ -46,48 +102,68 @@ namespace sjtu {
 
 
 
-        struct RBTNode {
-            Color color = Color::RED;
-            value_type* data;
+        static constexpr bool ORDER_STATISTICS = Policy::order_statistics;
+        static constexpr bool STATS = Policy::stats;
+        static constexpr size_t CACHE = Policy::lookup_cache;
+        static_assert((CACHE & (CACHE - 1)) == 0, "lookup_cache must be 0 or a power of two");
+        //值不需要析构时 clear和析构不用逐个走结点
+        static constexpr bool TRIVIAL_DESTROY = std::is_trivially_destructible<value_type>::value;
+        //比较器存在基类里 空的比较器不占空间 也不用每次比较都现造一个
+        const Compare& comp() const noexcept {
+            return this->functor();
+        }
+
+        //开了order_statistics才在结点里存子树大小 否则基类是空的 不占空间
+        struct NoSubtreeSize {};
+        struct SubtreeSize { size_t count = 1; };
+        typedef typename std::conditional<ORDER_STATISTICS, SubtreeSize, NoSubtreeSize>::type SizeBase;
+
+        //哨兵只有RBTNode部分 不带value 真正的结点是ValueNode 一次分配 value就在结点里
+        //颜色放在parent指针的最低位 结点至少按指针对齐 最低位一定是0
+        struct RBTNode : SizeBase {
+            uintptr_t parent_color;
             RBTNode* left;    // 左孩子
             RBTNode* right;    // 右孩子
-            RBTNode* parent; // 父结点
 
             RBTNode()
-                : data(nullptr), left(nullptr), right(nullptr), parent(nullptr) {}
+                : parent_color(0), left(nullptr), right(nullptr) {}
+
+            RBTNode(RBTNode* _parent, RBTNode* _left = nullptr, RBTNode* _right = nullptr, Color _color = Color::RED)
+                : parent_color(reinterpret_cast<uintptr_t>(_parent) | (uintptr_t)_color), left(_left), right(_right) {}
 
-            RBTNode(const value_type& x, RBTNode* _parent = nullptr, RBTNode* _left = nullptr, RBTNode* _right = nullptr, Color _color = Color::RED)
-                : parent(_parent), left(_left), right(_right), color(_color) {
-                data = (value_type*)malloc(sizeof(value_type));
-                new(data) value_type(x.first, x.second);
+            // 父结点
+            inline RBTNode* parent() const noexcept {
+                return reinterpret_cast<RBTNode*>(parent_color & ~(uintptr_t)1);
             }
 
+            inline void setParent(RBTNode* p) noexcept {
+                parent_color = reinterpret_cast<uintptr_t>(p) | (parent_color & 1);
+            }
 
+            inline Color color() const noexcept { return (Color)(parent_color & 1); }
 
-            ~RBTNode() {
-                // 释放data指向的内存（如果是动态分配的）
-                if (data) {
-                      data->first.~Key();
-                data->second.~T();
-                free(data);
-                }
+            inline void setColor(Color c) noexcept {
+                parent_color = (parent_color & ~(uintptr_t)1) | (uintptr_t)c;
+            }
 
-                // 注意：通常不需要在析构函数中释放 left, right, parent，因为它们通常是由树结构管理的
+            //只能在非哨兵结点上调用
+            inline value_type* data() noexcept {
+                return reinterpret_cast<value_type*>(static_cast<ValueNode*>(this)->storage);
             }
 
             inline bool isLeaf() const noexcept {
                 return this->left == nullptr && this->right == nullptr;
             }
 
-            inline bool isRoot() const noexcept { return this->parent && this->parent->parent == nullptr; }
+            inline bool isRoot() const noexcept { return this->parent() && this->parent()->parent() == nullptr; }
 
-            inline bool isRed() const noexcept { return this->color == Color::RED; }
+            inline bool isRed() const noexcept { return this->color() == Color::RED; }
 
-            inline bool isBlack() const noexcept { return this->color == Color::BLACK; }
+            inline bool isBlack() const noexcept { return this->color() == Color::BLACK; }
 
             inline Direction direction() const noexcept {
                 if (!this->isRoot()) {
-                    if (this == this->parent->left) {
+                    if (this == this->parent()->left) {
                         return Direction::LEFT;
                     }
                     else {
@@ -102,10 +178,10 @@ namespace sjtu {
             inline RBTNode* sibling() const noexcept {
                 assert(!this->isRoot());
                 if (this->direction() == Direction::LEFT) {
-                    return this->parent->right;
+                    return this->parent()->right;
                 }
                 else {
-                    return this->parent->left;
+                    return this->parent()->left;
                 }
             }
 
@@ -115,51 +191,282 @@ namespace sjtu {
 
             inline RBTNode* uncle() const noexcept {
                 assert(!this->isRoot());
-                return parent->sibling();
+                return parent()->sibling();
             }
 
             inline bool hasUncle() const noexcept {
-                return !this->isRoot() && this->parent->hasSibling();
+                return !this->isRoot() && this->parent()->hasSibling();
             }
 
             inline RBTNode* grandParent() const noexcept {
-                assert(!this->parent->isRoot());
-                return this->parent->parent;
+                assert(!this->parent()->isRoot());
+                return this->parent()->parent();
             }
 
             inline bool hasGrandParent() const noexcept {
-                return !this->isRoot() && !this->parent->isRoot();
+                return !this->isRoot() && !this->parent()->isRoot();
             }
 
 
         };
 
-        inline bool equal_key(Key x, Key y) const { return !(Compare()(x, y) || Compare()(y, x)); }
+        struct ValueNode : RBTNode {
+            alignas(value_type) unsigned char storage[sizeof(value_type)];
+
+            //args原样转发给value_type的构造函数 直接在结点里构造 不经过临时对象
+            template<class... Args>
+            ValueNode(RBTNode* _parent, Color _color, Args&&... args)
+                : RBTNode(_parent, nullptr, nullptr, _color) {
+                new(storage) value_type(std::forward<Args>(args)...);
+            }
+
+            ~ValueNode() {
+                reinterpret_cast<value_type*>(storage)->~value_type();
+            }
+        };
+
+        //结点都从pool里拿 删除时还回pool的空闲链表 clear和析构时整块slab一起释放
+        typedef node_pool<ValueNode, Allocator> pool_type;
+        pool_type pool;
+
+        template<class... Args>
+        RBTNode* createNode(RBTNode* _parent, Color _color, Args&&... args) {
+            if constexpr (STATS) counters.node_allocations++;
+            void* mem = pool.allocate();
+            try {
+                return new(mem) ValueNode(_parent, _color, std::forward<Args>(args)...);
+            }
+            catch (...) {
+                pool.deallocate(mem);
+                throw;
+            }
+        }
+
+        void destroyNode(RBTNode* node) {
+            static_cast<ValueNode*>(node)->~ValueNode();
+            pool.deallocate(node);
+        }
 
        // using Direction = typename RBTNode::Direction;
 
-       void clear(RBTNode* node) {
-            if (!node)return;
-            node->parent = nullptr;
-            if (node->left)clear(node->left);
-            if (node->right)clear(node->right);
-            delete node;
-            node = nullptr;
-            //注：这里只需要delete node即可 这样node会调用RBTnode的析构函数，自动释放data指针的空间 所以只要写好析构函数就可以
+        //析构所有value 不逐个释放结点 最后把pool的slab整块还掉
+        //沿着parent指针往回走 不用递归 也不用额外的栈
+        void clear(RBTNode* node) {
+            bool shared = !pool.unique();
+            if (TRIVIAL_DESTROY && !shared) node = nullptr;
+            while (node) {
+                if (node->left) {
+                    RBTNode* l = node->left;
+                    node->left = nullptr;
+                    node = l;
+                }
+                else if (node->right) {
+                    RBTNode* r = node->right;
+                    node->right = nullptr;
+                    node = r;
+                }
+                else {
+                    RBTNode* up = node->parent();
+                    static_cast<ValueNode*>(node)->~ValueNode();
+                    //slab和别的map共用时 只能一个个还回去
+                    if (shared) pool.deallocate(node);
+                    node = (up == sentinel) ? nullptr : up;
+                }
+            }
+            sentinel->left = nullptr;
+            minNode = maxNode = sentinel;
+            forgetAll();
+            pool.release();
         }
 
         RBTNode* sentinel;
         size_t len;
+        //最小和最大结点 插入删除时顺手维护 旋转不改变中序 不用管 空树时都指向sentinel
+        RBTNode* minNode;
+        RBTNode* maxNode;
+        struct NoStats {};
+        typename std::conditional<STATS, map_stats, NoStats>::type counters;
+
+        //直接映射的查找缓存 每个slot记一个找到过的结点和它key的hash
+        //结点从创建到销毁地址不变 旋转和swapNode只改指针 所以只有结点离开这棵树时要作废它的slot
+        //const的查找也会写它 所以是mutable
+        struct CacheSlot {
+            size_t hash;
+            RBTNode* node;
+        };
+        struct NoCache {};
+        struct Cache {
+            CacheSlot slot[CACHE ? CACHE : 1] = {};
+            unsigned long long hits = 0, misses = 0;
+        };
+        mutable typename std::conditional<(CACHE > 0), Cache, NoCache>::type cache;
+
+        static size_t slotOf(size_t h) noexcept {
+            //乘法散列取高位 std::hash对整数往往是恒等映射 直接取低位会扎堆
+            return static_cast<size_t>((static_cast<uint64_t>(h) * 0x9E3779B97F4A7C15ull) >> 32) & (CACHE - 1);
+        }
+        //node要离开这棵树了 缓存里如果有它就清掉
+        void forget(RBTNode* node) noexcept {
+            if constexpr (CACHE > 0) {
+                //结点只可能在它自己key对应的slot里
+                CacheSlot& s = cache.slot[slotOf(std::hash<Key>()(node->data()->first))];
+                if (s.node == node) s.node = nullptr;
+            }
+        }
+        void forgetAll() noexcept {
+            if constexpr (CACHE > 0)
+                for (CacheSlot& s : cache.slot) s.node = nullptr;
+        }
+
+        static size_t heightOf(RBTNode* node) {
+            if (!node) return 0;
+            size_t l = heightOf(node->left), r = heightOf(node->right);
+            return 1 + (l > r ? l : r);
+        }
+
+
+        //从空树开始 用next()依次给出的n个严格递增的值直接搭一棵平衡的树 O(n)
+        //结点一次性从pool要一整块 按中序排在一起 每个区间取中点当根 左右子树大小最多差1
+        //这样除了最深一层其他层都是满的 最深一层涂红(正好满的时候全黑) 黑高就处处相同
+        //用显式栈代替递归 栈深不超过树高
+        //check为true时顺便检查是否严格递增 不是就清空并抛runtime_error
+        template<class Next>
+        void buildSorted(size_t n, Next next, bool check) {
+            if (n == 0) return;
+            char* block = static_cast<char*>(pool.allocate_block(n));
+            if constexpr (STATS) counters.node_allocations += n;
+            auto at = [block](size_t i) { return reinterpret_cast<ValueNode*>(block + i * pool_type::STRIDE); };
+            size_t built = 0;
+            try {
+                for (; built < n; built++) {
+                    new(at(built)) ValueNode(nullptr, Color::BLACK, next());
+                    if (check && built > 0 && !comp()(at(built - 1)->data()->first, at(built)->data()->first)) {
+                        built++;
+                        throw runtime_error();
+                    }
+                }
+            }
+            catch (...) {
+                for (size_t i = 0; i < n; i++) {
+                    if (i < built) at(i)->~ValueNode();
+                    pool.deallocate(at(i));
+                }
+                throw;
+            }
+            linkBlock(block, n);
+            if constexpr (STATS) counters.inserts += n;
+        }
+        //block里已经按中序造好了n个结点 把它们搭成树
+        void linkBlock(char* block, size_t n) {
+            linkSorted(n, [block](size_t i) -> RBTNode* { return reinterpret_cast<ValueNode*>(block + i * pool_type::STRIDE); });
+        }
+        //at(i)按中序给出n个结点 搭成buildSorted说的那种平衡树
+        //结点原来的孩子和颜色都重新设 已经在树上的结点也可以拿来重搭
+        template<class At>
+        void linkSorted(size_t n, At at) {
+            size_t maxDepth = 0;
+            while ((size_t(2) << maxDepth) - 1 < n) maxDepth++;
+            bool full = ((size_t(2) << maxDepth) - 1 == n);
+            struct Range {
+                size_t lo, hi, depth;
+                RBTNode* parent;
+                bool toLeft;
+            };
+            Range stack[2 * sizeof(size_t) * 8 + 2];
+            size_t top = 0;
+            stack[top++] = Range{ 0, n, 0, sentinel, true };
+            while (top) {
+                Range r = stack[--top];
+                size_t mid = r.lo + (r.hi - r.lo) / 2;
+                RBTNode* node = at(mid);
+                node->setParent(r.parent);
+                if (r.toLeft) r.parent->left = node;
+                else r.parent->right = node;
+                node->left = node->right = nullptr;
+                node->setColor(r.depth == maxDepth && !full ? Color::RED : Color::BLACK);
+                if constexpr (ORDER_STATISTICS) node->count = r.hi - r.lo;
+                if (mid + 1 < r.hi) stack[top++] = Range{ mid + 1, r.hi, r.depth + 1, node, false };
+                if (r.lo < mid) stack[top++] = Range{ r.lo, mid, r.depth + 1, node, true };
+            }
+            minNode = at(0);
+            maxNode = at(n - 1);
+            len = n;
+        }
+
+        template<class InputIt>
+        void assignSorted(InputIt first, InputIt last, std::input_iterator_tag) {
+            //只能走一遍 不知道长度 就逐个接在最右边
+            for (; first != last; ++first) {
+                RBTNode* n = createNode(nullptr, Color::RED, *first);
+                if (len > 0 && !comp()(maxNode->data()->first, n->data()->first)) {
+                    destroyNode(n);
+                    clear();
+                    throw runtime_error();
+                }
+                if (len == 0) linkNode(n, sentinel, true);
+                else linkNode(n, maxNode, false);
+                maintainAfterInsert(n);
+                len++;
+            }
+        }
 
+        template<class ForwardIt>
+        void assignSorted(ForwardIt first, ForwardIt last, std::forward_iterator_tag) {
+            size_t n = std::distance(first, last);
+            buildSorted(n, [&first]() -> decltype(auto) { return *first++; }, true);
+        }
 
-        void copy(RBTNode*& node, RBTNode* ori) {
-            if (!ori)return;
-            node = new RBTNode(*(ori->data),nullptr,nullptr,nullptr,ori->color);
-            copy(node->left, ori->left);
-            if (node->left)node->left->parent = node;
-            copy(node->right, ori->right);
-            if (node->right)node->right->parent = node;
+        //复制other 它的中序就是现成的有序序列 不需要检查
+        void copyFrom(const map& other) {
+            RBTNode* p = other.minNode;
+            buildSorted(other.len, [&p]() -> const value_type& {
+                const value_type& v = *(p->data());
+                p = nextNode(p);
+                return v;
+            }, false);
+        }
 
+        //整棵树切成按中序排列 互不重叠的几段 每段是一棵子树或者单独一个结点
+        //从根往下切depth层 得到最多2^depth棵子树 和它们之间的那些结点
+        struct Piece {
+            RBTNode* root;
+            bool whole;//false时只有root这一个结点
+        };
+        static void splitPieces(RBTNode* node, size_t depth, std::vector<Piece>& out) {
+            if (!node) return;
+            if (depth == 0) {
+                out.push_back(Piece{ node, true });
+                return;
+            }
+            splitPieces(node->left, depth - 1, out);
+            out.push_back(Piece{ node, false });
+            splitPieces(node->right, depth - 1, out);
+        }
+        //切成至少4 * threads棵子树 每段交给一个线程按中序走 对每个结点调用fn
+        //fn可以析构结点里的值 走下一步用的指针在调用fn之前就取好了
+        template<class Fn>
+        void parallelNodes(size_t threads, Fn fn) const {
+            threads = thread_count(threads);
+            size_t depth = 0;
+            while (threads > 1 && (size_t(1) << depth) < 4 * threads) depth++;
+            std::vector<Piece> pieces;
+            splitPieces(sentinel->left, depth, pieces);
+            parallel_run(pieces.size(), threads, [&pieces, &fn](size_t i) {
+                RBTNode* p = pieces[i].root;
+                if (!pieces[i].whole) {
+                    fn(p);
+                    return;
+                }
+                RBTNode* last = p;
+                while (last->right) last = last->right;
+                RBTNode* stop = nextNode(last);
+                while (p->left) p = p->left;
+                while (p != stop) {
+                    RBTNode* q = nextNode(p);
+                    fn(p);
+                    p = q;
+                }
+            });
         }
 
 
@@ -167,10 +474,10 @@ namespace sjtu {
         // 根据左右孩子 更新左右孩子的parent指针位置
         void maintainRelationship(RBTNode* node) {
             if (node->left != nullptr) {
-                node->left->parent = node;
+                node->left->setParent(node);
             }
             if (node->right != nullptr) {
-                node->right->parent = node;
+                node->right->setParent(node);
             }
         }
 
@@ -178,6 +485,22 @@ namespace sjtu {
 
 
 
+        //子树大小 只在ORDER_STATISTICS时使用
+        static size_t subtreeSize(const RBTNode* node) noexcept {
+            if constexpr (ORDER_STATISTICS) return node ? node->count : 0;
+            else return 0;
+        }
+
+        static void updateSize(RBTNode* node) noexcept {
+            if constexpr (ORDER_STATISTICS) node->count = subtreeSize(node->left) + subtreeSize(node->right) + 1;
+        }
+
+        //从node的父亲到根 每个祖先的子树大小加上delta 只有哨兵没有父亲
+        static void adjustAncestors(RBTNode* node, ptrdiff_t delta) noexcept {
+            if constexpr (ORDER_STATISTICS)
+                for (RBTNode* p = node->parent(); p->parent(); p = p->parent()) p->count += delta;
+        }
+
         void rotateLeft(RBTNode* node) {
             // clang-format off
             //     |                       |
@@ -188,7 +511,7 @@ namespace sjtu {
             //     M   R               L   M
             assert(node != nullptr && node->right != nullptr);
             // clang-format on
-            RBTNode* parent = node->parent;
+            RBTNode* parent = node->parent();
             Direction direction = node->direction();
 
             RBTNode* successor = node->right;
@@ -200,8 +523,8 @@ namespace sjtu {
 
             switch (direction) {
             case Direction::ROOT:
-                //this->root = successor;
-                sentinel->left = successor;
+                //根的父亲就是所在树的哨兵 split/join时可能是临时的哨兵
+                parent->left = successor;
                 break;
             case Direction::LEFT:
                 parent->left = successor;
@@ -211,7 +534,12 @@ namespace sjtu {
                 break;
             }
 
-            successor->parent = parent;
+            successor->setParent(parent);
+            //旋转前node的大小就是整棵子树的大小
+            if constexpr (ORDER_STATISTICS) {
+                successor->count = node->count;
+                updateSize(node);
+            }
         }
 
         void rotateRight(RBTNode* node) {
@@ -225,7 +553,7 @@ namespace sjtu {
             assert(node != nullptr && node->left != nullptr);
             // clang-format on
 
-            RBTNode* parent = node->parent;
+            RBTNode* parent = node->parent();
             Direction direction = node->direction();
 
             RBTNode* successor = node->left;
@@ -237,8 +565,8 @@ namespace sjtu {
 
             switch (direction) {
             case Direction::ROOT:
-                //this->root = successor;
-                sentinel->left = successor;
+                //根的父亲就是所在树的哨兵 split/join时可能是临时的哨兵
+                parent->left = successor;
                 break;
             case Direction::LEFT:
                 parent->left = successor;
@@ -248,12 +576,19 @@ namespace sjtu {
                 break;
             }
 
-            successor->parent = parent;
+            successor->setParent(parent);
+            //旋转前node的大小就是整棵子树的大小
+            if constexpr (ORDER_STATISTICS) {
+                successor->count = node->count;
+                updateSize(node);
+            }
         }
 
 
 
+        //这两个只在删除后调整时用
         void rotateSameDirection(RBTNode* node, Direction direction) {
+            if constexpr (STATS) counters.erase_rotations++;
             switch (direction)
             {
             case Direction::LEFT:
@@ -267,6 +602,7 @@ namespace sjtu {
         }
 
         void rotateOppositeDirection(RBTNode* node, Direction direction) {
+            if constexpr (STATS) counters.erase_rotations++;
             switch (direction)
             {
             case Direction::LEFT:
@@ -280,7 +616,8 @@ namespace sjtu {
         }
 
 
-        void maintainAfterInsert(RBTNode* node) {
+        //返回值表示最后是否把红色的根涂黑了 也就是黑高是否加了1 join要用
+        bool maintainAfterInsert(RBTNode* node) {
             assert(node != nullptr);
 
             if (node->isRoot()) {
@@ -289,14 +626,15 @@ namespace sjtu {
                 //  No need to fix.
 
                 // maybe i need to paint it to black
-                node->color = Color::BLACK;
-                return;
+                bool wasRed = node->isRed();
+                node->setColor(Color::BLACK);
+                return wasRed;
             }
 
-            if (node->parent->isBlack()) {
+            if (node->parent()->isBlack()) {
                 // Case 2: Parent is BLACK
                 //  No need to fix.
-                return;
+                return false;
             }
 
 
@@ -311,12 +649,11 @@ namespace sjtu {
                 //      /               /
                 //    <N>             <N>
                 // clang-format on
-                assert(node->parent->isRed());
-                node->parent->color = Color::BLACK;
-                node->uncle()->color = Color::BLACK;
-                node->grandParent()->color = Color::RED;
-                maintainAfterInsert(node->grandParent());
-                return;
+                assert(node->parent()->isRed());
+                node->parent()->setColor(Color::BLACK);
+                node->uncle()->setColor(Color::BLACK);
+                node->grandParent()->setColor(Color::RED);
+                return maintainAfterInsert(node->grandParent());
             }
 
             if (!node->hasUncle() || node->uncle()->isBlack()) {
@@ -324,7 +661,7 @@ namespace sjtu {
                 //   p.s. NIL nodes are also considered BLACK
                 assert(!node->isRoot());
 
-                if (node->direction() != node->parent->direction()) {
+                if (node->direction() != node->parent()->direction()) {
                     // clang-format off
                     // Case 5: Current node is the opposite direction as parent
                     //   Step 1. If node is a LEFT child, perform l-rotate to parent;
@@ -338,13 +675,14 @@ namespace sjtu {
                     // clang-format on
 
                     // Step 1: Rotation
-                    RBTNode* parent = node->parent;
+                    RBTNode* parent = node->parent();
                     if (node->direction() == Direction::LEFT) {
-                        rotateRight(node->parent);
+                        rotateRight(node->parent());
                     }
                     else /* node->direction() == Direction::RIGHT */ {
-                        rotateLeft(node->parent);
+                        rotateLeft(node->parent());
                     }
+                    if constexpr (STATS) counters.insert_rotations++;
                     node = parent;
                     // Step 2: vvv
                 }
@@ -365,45 +703,479 @@ namespace sjtu {
                 assert(node->grandParent() != nullptr);
 
                 // Step 1
-                if (node->parent->direction() == Direction::LEFT) {
+                if (node->parent()->direction() == Direction::LEFT) {
                     rotateRight(node->grandParent());
                 }
                 else {
                     rotateLeft(node->grandParent());
                 }
+                if constexpr (STATS) counters.insert_rotations++;
 
                 // Step 2
-                node->parent->color = Color::BLACK;
-                node->sibling()->color = Color::RED;
+                node->parent()->setColor(Color::BLACK);
+                node->sibling()->setColor(Color::RED);
 
-                return;
+                return false;
+            }
+            return false;
+        }
+        //只用key < node判断往哪走 每层比较一次 往右走时记下结点
+        //最后记下的那个是不大于key的最大结点 再反过来比一次就知道是否相等
+        //key已存在时返回那个结点 否则返回nullptr 并给出新结点该挂的位置
+        RBTNode* findInsertPos(const Key& key, RBTNode*& parent, bool& toLeft) const {
+            RBTNode* node = sentinel->left;
+            RBTNode* candidate = nullptr;
+            parent = sentinel;
+            toLeft = true;
+            while (node) {
+                parent = node;
+                toLeft = comp()(key, node->data()->first);
+                if (toLeft) node = node->left;
+                else {
+                    candidate = node;
+                    node = node->right;
+                }
+            }
+            if (candidate && !comp()(candidate->data()->first, key)) return candidate;
+            return nullptr;
+        }
+
+        //hint是插入位置附近的结点 key正好落在hint和它前驱(或后继)之间时不用从根找
+        //hint为sentinel(end)时和最大结点比较 顺序追加的情况每次只比较一两次
+        RBTNode* findHintPos(RBTNode* hint, const Key& key, RBTNode*& parent, bool& toLeft) const {
+            if (hint == sentinel) {
+                if (len > 0) {
+                    RBTNode* last = maxNode;
+                    if (comp()(last->data()->first, key)) {
+                        parent = last;
+                        toLeft = false;
+                        return nullptr;
+                    }
+                }
+                return findInsertPos(key, parent, toLeft);
+            }
+            if (comp()(key, hint->data()->first)) {
+                //key < hint 看前驱
+                if (hint == minNode) {
+                    parent = hint;
+                    toLeft = true;
+                    return nullptr;
+                }
+                RBTNode* before = prevNode(hint);
+                if (comp()(before->data()->first, key)) {
+                    //前驱和hint相邻 两者之中必有一个在这一侧是空的
+                    if (!before->right) { parent = before; toLeft = false; }
+                    else { parent = hint; toLeft = true; }
+                    return nullptr;
+                }
+                return findInsertPos(key, parent, toLeft);
+            }
+            if (comp()(hint->data()->first, key)) {
+                //key > hint 看后继
+                RBTNode* after = nextNode(hint);
+                if (after == sentinel || comp()(key, after->data()->first)) {
+                    if (!hint->right) { parent = hint; toLeft = false; }
+                    else { parent = after; toLeft = true; }
+                    return nullptr;
+                }
+                return findInsertPos(key, parent, toLeft);
+            }
+            return hint;
+        }
+
+        //把新结点n挂到parent下面 不做颜色调整
+        void linkNode(RBTNode* n, RBTNode* parent, bool toLeft) {
+            n->setParent(parent);
+            if (toLeft) parent->left = n;
+            else parent->right = n;
+            if (parent == sentinel) minNode = maxNode = n;
+            else if (toLeft && parent == minNode) minNode = n;
+            else if (!toLeft && parent == maxNode) maxNode = n;
+            adjustAncestors(n, 1);
+            if constexpr (STATS) counters.inserts++;
+        }
+
+        //只有找到空位时才用args构造结点 key已存在时什么都不构造
+        template<class... Args>
+        pair<RBTNode*, bool> insertUnique(const Key& key, Args&&... args) {
+            RBTNode* parent;
+            bool toLeft;
+            RBTNode* node = findInsertPos(key, parent, toLeft);
+            if (node) return pair<RBTNode*, bool>(node, false);
+            node = createNode(parent, Color::RED, std::forward<Args>(args)...);
+            linkNode(node, parent, toLeft);
+            return pair<RBTNode*, bool>(node, true);
+        }
+
+        template<class... Args>
+        pair<RBTNode*, bool> insertUniqueHint(RBTNode* hint, const Key& key, Args&&... args) {
+            RBTNode* parent;
+            bool toLeft;
+            RBTNode* node = findHintPos(hint, key, parent, toLeft);
+            if (node) return pair<RBTNode*, bool>(node, false);
+            node = createNode(parent, Color::RED, std::forward<Args>(args)...);
+            linkNode(node, parent, toLeft);
+            return pair<RBTNode*, bool>(node, true);
+        }
+
+        //把已经构造好的结点n挂到树上 key已存在时返回那个结点 n不动
+        pair<RBTNode*, bool> insertNode(RBTNode* n, RBTNode* hint = nullptr) {
+            const Key& key = n->data()->first;
+            RBTNode* parent;
+            bool toLeft;
+            RBTNode* node = hint ? findHintPos(hint, key, parent, toLeft) : findInsertPos(key, parent, toLeft);
+            if (node) return pair<RBTNode*, bool>(node, false);
+            linkNode(n, parent, toLeft);
+            return pair<RBTNode*, bool>(n, true);
+        }
+
+        //下面几个查找对K做成模板 Compare透明时可以直接拿别的类型来比
+        //第一个不小于key的结点 没有就是sentinel 每层只比较一次
+        template<class K>
+        RBTNode* lowerBound(const K& key) const {
+            RBTNode* node = sentinel->left;
+            RBTNode* candidate = sentinel;
+            while (node) {
+                if (comp()(node->data()->first, key)) node = node->right;
+                else {
+                    candidate = node;
+                    node = node->left;
+                }
+            }
+            return candidate;
+        }
+
+        //第一个大于key的结点 没有就是sentinel
+        template<class K>
+        RBTNode* upperBound(const K& key) const {
+            RBTNode* node = sentinel->left;
+            RBTNode* candidate = sentinel;
+            while (node) {
+                if (comp()(key, node->data()->first)) {
+                    candidate = node;
+                    node = node->left;
+                }
+                else node = node->right;
+            }
+            return candidate;
+        }
+
+        //lower bound再反过来比一次就知道是否相等
+        template<class K>
+        RBTNode* findNode(const K& key) const {
+            if constexpr (CACHE > 0 && std::is_same<K, Key>::value) {
+                size_t h = std::hash<Key>()(key);
+                CacheSlot& s = cache.slot[slotOf(h)];
+                //hash相同还要两边各比一次 才能确定key等价
+                if (s.node && s.hash == h && !comp()(key, s.node->data()->first) && !comp()(s.node->data()->first, key)) {
+                    if constexpr (STATS) cache.hits++;
+                    return s.node;
+                }
+                if constexpr (STATS) cache.misses++;
+                RBTNode* candidate = lowerBound(key);
+                if (candidate == sentinel || comp()(key, candidate->data()->first)) return nullptr;
+                //找不到的key不进缓存 不然要在插入时也作废
+                //按树里那个key的hash放 比较器认为等价的key hash不一定相同 forget也按它找
+                size_t stored = std::hash<Key>()(candidate->data()->first);
+                CacheSlot& t = stored == h ? s : cache.slot[slotOf(stored)];
+                t.hash = stored;
+                t.node = candidate;
+                return candidate;
+            }
+            else {
+                RBTNode* candidate = lowerBound(key);
+                if (candidate != sentinel && !comp()(key, candidate->data()->first)) return candidate;
+                return nullptr;
+            }
+        }
+
+        //批量查找时一起下降的路径数
+        static constexpr size_t BATCH = 16;
+        //AMAC式的批量lower bound 一组路径轮流每条下降一层 下一层的结点先预取
+        //轮回来时它已经在缓存里了 各条路径的访存就重叠起来 结果按输入顺序交给emit
+        template<class It, class Emit>
+        void lowerBoundBatch(It first, It last, Emit emit) const {
+            It keys[BATCH];
+            RBTNode* node[BATCH];
+            RBTNode* candidate[BATCH];
+            while (first != last) {
+                size_t n = 0;
+                for (; n < BATCH && first != last; ++first, ++n) {
+                    keys[n] = first;
+                    node[n] = sentinel->left;
+                    candidate[n] = sentinel;
+                }
+                for (bool active = true; active;) {
+                    active = false;
+                    for (size_t i = 0; i < n; i++) {
+                        RBTNode* x = node[i];
+                        if (!x) continue;
+                        if (comp()(x->data()->first, *keys[i])) x = x->right;
+                        else {
+                            candidate[i] = x;
+                            x = x->left;
+                        }
+                        if (x) {
+                            prefetch(x);
+                            active = true;
+                        }
+                        node[i] = x;
+                    }
+                }
+                for (size_t i = 0; i < n; i++) emit(*keys[i], candidate[i]);
+            }
+        }
+
+        //把指向元素的迭代器当成指向key的 给lowerBoundBatch用
+        template<class It>
+        struct KeyOf {
+            const It* p;
+            const Key& operator*() const { return (**p).first; }
+            KeyOf& operator++() { ++p; return *this; }
+            bool operator!=(const KeyOf& other) const { return p != other.p; }
+        };
+        //批量写入 its按key排好了序 没有重复 assign为true时已有的key把值换成新的
+        //批量比树小时 每BATCH个key一起用lowerBoundBatch下降 各条路径的缓存缺失重叠起来
+        //再按顺序插入 组里先插的key都更小 下界还是对的 拿它当hint 它的前驱就在刚走过的路径上
+        //否则把树的结点和新结点按中序合成一列 整棵重搭 O(n + k)
+        template<class It>
+        size_t insertSorted(const std::vector<It>& its, bool assign) {
+            size_t k = its.size(), added = 0;
+            if (k == 0) return 0;
+            if (k < len) {
+                RBTNode* bound[BATCH];
+                for (size_t lo = 0; lo < k; lo += BATCH) {
+                    size_t hi = lo + BATCH < k ? lo + BATCH : k, m = 0;
+                    lowerBoundBatch(KeyOf<It>{ its.data() + lo }, KeyOf<It>{ its.data() + hi },
+                        [&bound, &m](const Key&, RBTNode* c) { bound[m++] = c; });
+                    for (size_t i = lo; i < hi; i++) {
+                        const It& it = its[i];
+                        RBTNode* c = bound[i - lo];
+                        if (c != sentinel && !comp()((*it).first, c->data()->first)) {
+                            if (assign) c->data()->second = (*it).second;
+                            continue;
+                        }
+                        RBTNode* parent;
+                        bool toLeft;
+                        findHintPos(c, (*it).first, parent, toLeft);
+                        RBTNode* node = createNode(parent, Color::RED, *it);
+                        linkNode(node, parent, toLeft);
+                        maintainAfterInsert(node);
+                        len++;
+                        added++;
+                    }
+                }
+                return added;
+            }
+            //先留够位置 push_back不会在结点造好之后才失败
+            std::vector<RBTNode*> order;
+            order.reserve(len + k);
+            RBTNode* p = minNode;
+            try {
+                for (const It& it : its) {
+                    const Key& key = (*it).first;
+                    for (; p != sentinel && comp()(p->data()->first, key); p = nextNode(p)) order.push_back(p);
+                    if (p != sentinel && !comp()(key, p->data()->first)) {
+                        if (assign) p->data()->second = (*it).second;
+                        continue;
+                    }
+                    order.push_back(createNode(nullptr, Color::BLACK, *it));
+                    added++;
+                }
+            }
+            catch (...) {
+                //树还没动过 只要把新造的结点销毁
+                for (RBTNode* q : order)
+                    if (!q->parent()) destroyNode(q);
+                throw;
+            }
+            for (; p != sentinel; p = nextNode(p)) order.push_back(p);
+            linkSorted(order.size(), [&order](size_t i) { return order[i]; });
+            if constexpr (STATS) counters.inserts += added;
+            return added;
+        }
+        //把[first, last)按key稳定排序 相等的key只留一个 keepLast为false时留第一个
+        template<class ForwardIt>
+        std::vector<ForwardIt> sortBatch(ForwardIt first, ForwardIt last, bool keepLast) const {
+            std::vector<ForwardIt> its;
+            for (; first != last; ++first) its.push_back(first);
+            auto less = [this](const ForwardIt& a, const ForwardIt& b) { return comp()((*a).first, (*b).first); };
+            std::stable_sort(its.begin(), its.end(), less);
+            size_t n = 0;
+            for (size_t i = 0; i < its.size(); i++) {
+                if (n && !less(its[n - 1], its[i])) {
+                    if (keepLast) its[n - 1] = its[i];
+                }
+                else its[n++] = its[i];
+            }
+            its.resize(n);
+            return its;
+        }
+
+        //中序后继 最大结点的后继是sentinel
+        static RBTNode* nextNode(RBTNode* node) {
+            if (node->right) {
+                node = node->right;
+                while (node->left) node = node->left;
+                return node;
             }
+            while (node->direction() == Direction::RIGHT) node = node->parent();
+            return node->parent();
         }
-        //内部用来递归的插入函数
-        //注意这个指针引用 如果我把x->left(nullptr)传进来 给他赋予一个node x->left就也修改了
-        pair<RBTNode*, bool> insert(const value_type& value, RBTNode*& node, RBTNode* p) {
 
-            //找到合适的位置 插入 调整留着到外面的函数用
-            if (!node) {
-                node = new RBTNode(value, p);
-                return pair<RBTNode*, bool>(node, true);
+        //中序前驱 调用前保证node不是最小结点 sentinel的前驱是最大结点
+        RBTNode* prevNode(RBTNode* node) const {
+            if (node == sentinel) return maxNode;
+            if (node->left) {
+                node = node->left;
+                while (node->right) node = node->right;
+                return node;
             }
-            //key已经被使用了
-            if (equal_key(node->data->first, value.first))return pair<RBTNode*, bool>(node, false);
-            if (Compare()(value.first, node->data->first)) {
-                return insert(value, node->left, node);
+            while (node->direction() == Direction::LEFT) node = node->parent();
+            return node->parent();
+        }
+
+
+        //黑高 从node(含)往下任意一条路径上黑结点的个数 空树为0
+        static size_t blackHeight(RBTNode* node) noexcept {
+            size_t h = 0;
+            for (; node; node = node->left)
+                if (node->isBlack()) h++;
+            return h;
+        }
+
+        //把黑高为lbh的树l 结点k 黑高为rbh的树r 接成一棵树 要求l < k < r 三者都已经从原来的树上摘下 l r的根是黑的
+        //黑高相同时k直接当根 否则沿着高的那棵靠近矮树的一侧往下 找到黑高等于矮树的黑结点c
+        //红色的k顶替c c和矮树当k的两个孩子 再照插入的办法向上调整 只走黑高之差那么多层
+        //新的黑高写回bh 返回的根是黑的 它的parent没有意义 由调用者挂到哨兵下面
+        RBTNode* joinTrees(RBTNode* l, size_t lbh, RBTNode* k, RBTNode* r, size_t rbh, size_t& bh) {
+            if (lbh == rbh) {
+                k->left = l;
+                k->right = r;
+                if (l) l->setParent(k);
+                if (r) r->setParent(k);
+                k->setColor(Color::BLACK);
+                updateSize(k);
+                bh = lbh + 1;
+                return k;
+            }
+            bool intoLeft = lbh > rbh;
+            RBTNode* big = intoLeft ? l : r;
+            RBTNode* small = intoLeft ? r : l;
+            size_t h = intoLeft ? lbh : rbh;
+            size_t target = intoLeft ? rbh : lbh;
+            //临时的哨兵 调整时旋转到根也只会改它
+            RBTNode tmp;
+            tmp.left = big;
+            big->setParent(&tmp);
+            RBTNode* p = &tmp;
+            RBTNode* c = big;
+            while (c && !(c->isBlack() && h == target)) {
+                if (c->isBlack()) h--;
+                p = c;
+                c = intoLeft ? c->right : c->left;
+            }
+            k->setParent(p);
+            if (intoLeft) {
+                p->right = k;
+                k->left = c;
+                k->right = small;
             }
             else {
-                return insert(value, node->right, node);
+                p->left = k;
+                k->left = small;
+                k->right = c;
+            }
+            if (c) c->setParent(k);
+            if (small) small->setParent(k);
+            k->setColor(Color::RED);
+            updateSize(k);
+            adjustAncestors(k, subtreeSize(small) + 1);
+            bool grew = maintainAfterInsert(k);
+            bh = (intoLeft ? lbh : rbh) + (grew ? 1 : 0);
+            return tmp.left;
+        }
+
+        //摘下来当独立的树用 根涂黑 返回它的黑高 h是它原来(含自己)的黑高
+        static size_t detachSubtree(RBTNode* node, size_t h) noexcept {
+            if (node && node->isRed()) {
+                node->setColor(Color::BLACK);
+                return h + 1;
+            }
+            return h;
+        }
+
+        //把以root为根的整棵树拆成 <key 和 >=key 两棵独立的树
+        //先记下查找路径 再从下往上 每个路径结点连同它另一侧的子树和已拆出的那一半做一次join
+        //相邻两次join的黑高差之和是O(log n) 所以总共也是O(log n)
+        void splitTree(RBTNode* root, const Key& key, RBTNode*& lroot, size_t& lbh, RBTNode*& rroot, size_t& rbh) {
+            const size_t MAX_HEIGHT = 2 * sizeof(size_t) * 8 + 2;
+            RBTNode* path[MAX_HEIGHT];
+            size_t heights[MAX_HEIGHT];
+            bool toRight[MAX_HEIGHT];
+            size_t depth = 0;
+            size_t h = blackHeight(root);
+            for (RBTNode* t = root; t; depth++) {
+                path[depth] = t;
+                heights[depth] = h;
+                //key <= t时t属于右半边 往左找
+                toRight[depth] = !comp()(t->data()->first, key);
+                if (t->isBlack()) h--;
+                t = toRight[depth] ? t->left : t->right;
+            }
+            lroot = rroot = nullptr;
+            lbh = rbh = 0;
+            while (depth--) {
+                RBTNode* t = path[depth];
+                size_t ch = heights[depth] - (t->isBlack() ? 1 : 0);
+                RBTNode* sub = toRight[depth] ? t->right : t->left;
+                size_t subBh = detachSubtree(sub, ch);
+                resetNode(t);
+                if (toRight[depth]) rroot = joinTrees(rroot, rbh, t, sub, subBh, rbh);
+                else lroot = joinTrees(sub, subBh, t, lroot, lbh, lbh);
+            }
+        }
+
+        //中序在b前面的结点个数 从两头同时数 走min(前半, 后半)那么多步
+        size_t countBefore(RBTNode* b) const noexcept {
+            if (b == minNode) return 0;
+            if (b == sentinel) return len;
+            RBTNode* x = minNode;
+            RBTNode* y = maxNode;
+            size_t nx = 0, ny = 0;
+            while (true) {
+                x = nextNode(x);
+                nx++;
+                if (x == b) return nx;
+                ny++;
+                if (y == b) return len - ny;
+                y = prevNode(y);
             }
         }
 
-        RBTNode* find(Key key, RBTNode* node)const {
-            if (!node || equal_key(key, node->data->first))return node;
-            if (Compare()(key, node->data->first))return find(key, node->left);
-            return find(key, node->right);
+        //node在中序里的下标 sentinel的下标是len
+        size_t indexOf(const RBTNode* node) const noexcept {
+            if (node == sentinel) return len;
+            size_t k = subtreeSize(node->left);
+            for (; node->parent() != sentinel; node = node->parent())
+                if (node == node->parent()->right) k += subtreeSize(node->parent()->left) + 1;
+            return k;
         }
 
+        //下标为k的结点 k >= len时返回sentinel
+        RBTNode* selectNode(size_t k) const noexcept {
+            if (k >= len) return sentinel;
+            RBTNode* node = sentinel->left;
+            while (true) {
+                size_t l = subtreeSize(node->left);
+                if (k < l) node = node->left;
+                else if (k == l) return node;
+                else {
+                    k -= l + 1;
+                    node = node->right;
+                }
+            }
+        }
 
         static void swapNode(RBTNode* lhs, RBTNode* rhs) {
             if (lhs == rhs) return; // 如果两个节点相同，直接返回
@@ -413,35 +1185,41 @@ namespace sjtu {
             std::swap(lhs->right, rhs->right);
 
             // 更新左右孩子的父指针
-            if (lhs->left) lhs->left->parent = lhs;
-            if (lhs->right) lhs->right->parent = lhs;
-            if (rhs->left) rhs->left->parent = rhs;
-            if (rhs->right) rhs->right->parent = rhs;
+            if (lhs->left) lhs->left->setParent(lhs);
+            if (lhs->right) lhs->right->setParent(lhs);
+            if (rhs->left) rhs->left->setParent(rhs);
+            if (rhs->right) rhs->right->setParent(rhs);
 
             // 交换父指针
-            std::swap(lhs->parent, rhs->parent);
+            RBTNode* lp = lhs->parent();
+            lhs->setParent(rhs->parent());
+            rhs->setParent(lp);
 
             // 更新父节点的指针，确保父节点正确指向新位置的节点
-            if (lhs->parent) {
-                if (lhs->parent->left == rhs) {
-                    lhs->parent->left = lhs;
+            if (lhs->parent()) {
+                if (lhs->parent()->left == rhs) {
+                    lhs->parent()->left = lhs;
                 }
-                else if (lhs->parent->right == rhs) {
-                    lhs->parent->right = lhs;
+                else if (lhs->parent()->right == rhs) {
+                    lhs->parent()->right = lhs;
                 }
             }
 
-            if (rhs->parent) {
-                if (rhs->parent->left == lhs) {
-                    rhs->parent->left = rhs;
+            if (rhs->parent()) {
+                if (rhs->parent()->left == lhs) {
+                    rhs->parent()->left = rhs;
                 }
-                else if (rhs->parent->right == lhs) {
-                    rhs->parent->right = rhs;
+                else if (rhs->parent()->right == lhs) {
+                    rhs->parent()->right = rhs;
                 }
             }
 
             // 交换节点颜色（因为红黑树的平衡取决于颜色）
-            std::swap(lhs->color, rhs->color);
+            Color lc = lhs->color();
+            lhs->setColor(rhs->color());
+            rhs->setColor(lc);
+            //子树大小和颜色一样属于位置 跟着交换
+            if constexpr (ORDER_STATISTICS) std::swap(lhs->count, rhs->count);
         }
 
 
@@ -469,15 +1247,15 @@ namespace sjtu {
                 //        / \               / \               / \
                 //      [C] [D]           [N] [C]           [N] [C]
                 // clang-format on
-                RBTNode* parent = node->parent;
+                RBTNode* parent = node->parent();
                 assert(parent != nullptr && parent->isBlack());
                 assert(sibling->left != nullptr && sibling->left->isBlack());
                 assert(sibling->right != nullptr && sibling->right->isBlack());
                 // Step 1
-                rotateSameDirection(node->parent, direction);
+                rotateSameDirection(node->parent(), direction);
                 // Step 2
-                sibling->color = Color::BLACK;
-                parent->color = Color::RED;
+                sibling->setColor(Color::BLACK);
+                parent->setColor(Color::RED);
                 // Update sibling after rotation
                 sibling = node->sibling();
                 // Step 3: vvv
@@ -497,7 +1275,7 @@ namespace sjtu {
             if (closeNephewIsBlack && distantNephewIsBlack) {
                 //兄弟的孩子都是黑色
 
-                if (node->parent->isRed()) {
+                if (node->parent()->isRed()) {
                     //父为红 变单黑 直接结束
                     // clang-format off
                     // Case 2: Sibling and nephews are BLACK, parent is RED
@@ -508,8 +1286,8 @@ namespace sjtu {
                     //        / \             / \
                     //      [C] [D]         [C] [D]
                     // clang-format on
-                    sibling->color = Color::RED;
-                    node->parent->color = Color::BLACK;
+                    sibling->setColor(Color::RED);
+                    node->parent()->setColor(Color::BLACK);
                     return;
                 }
                 else {
@@ -524,8 +1302,8 @@ namespace sjtu {
                     //        / \             / \
                     //      [C] [D]         [C] [D]
                     // clang-format on
-                    sibling->color = Color::RED;
-                    maintainAfterRemove(node->parent);
+                    sibling->setColor(Color::RED);
+                    maintainAfterRemove(node->parent());
                     return;
                 }
             }
@@ -551,8 +1329,8 @@ namespace sjtu {
                     // Step 1
                     rotateOppositeDirection(sibling, direction);
                     // Step 2
-                    closeNephew->color = Color::BLACK;
-                    sibling->color = Color::RED;
+                    closeNephew->setColor(Color::BLACK);
+                    sibling->setColor(Color::RED);
                     // Update sibling and nephews after rotation
                     sibling = node->sibling();
                     closeNephew =
@@ -576,12 +1354,12 @@ namespace sjtu {
                 // clang-format on
                 assert(distantNephew->isRed());
                 // Step 1
-                rotateSameDirection(node->parent, direction);
+                rotateSameDirection(node->parent(), direction);
                 // Step 2
-                sibling->color = node->parent->color;
-                node->parent->color = Color::BLACK;
+                sibling->setColor(node->parent()->color());
+                node->parent()->setColor(Color::BLACK);
                 if (distantNephew != nullptr) {
-                    distantNephew->color = Color::BLACK;
+                    distantNephew->setColor(Color::BLACK);
                 }
                 return;
             }
@@ -595,142 +1373,27 @@ namespace sjtu {
 
 
 
-        bool remove(RBTNode* node, Key key) {
-            assert(node != nullptr);
-
-            if (!equal_key(key , node->data->first)) {
-                if (Compare()(key, node->data->first)) {
-                    /* key < node->key */
-                    RBTNode*& left = node->left;
-                    if (left != nullptr && remove(left, key)) {
-                        maintainRelationship(node);
-                        return true;
-                    }
-                    else {
-                        return false;
-                    }
-                }
-                else {
-                    /* key > node->key */
-                    RBTNode* right = node->right;
-                    if (right != nullptr && remove(right, key)) {
-                        maintainRelationship(node);
-                        return true;
-                    }
-                    else {
-                        return false;
-                    }
-                }
-            }
-
-            assert(equal_key(key, node->data->first));
-            //action(node);
-
-            if (this->size() == 1) {
-                // Current node is the only node of the tree
-                sentinel->left = nullptr;
-                delete node;
-                return true;
-            }
-
-            if (node->left != nullptr && node->right != nullptr) {
-                // clang-format off
-                // Case 1: If the node is strictly internal
-                //   Step 1. Find the successor S with the smallest key
-                //           and its parent P on the right subtree.
-                //   Step 2. Swap the data (key and value) of S and N,
-                //           S is the node that will be deleted in place of N.
-                //   Step 3. N = S, goto Case 2, 3
-                //     |                    |
-                //     N                    S
-                //    / \                  / \
-                //   L  ..   swap(N, S)   L  ..
-                //       |   =========>       |
-                //       P                    P
-                //      / \                  / \
-                //     S  ..                N  ..
-                // clang-format on
-
-                // Step 1
-                RBTNode* p = node->parent;//
-                RBTNode* successor = node->right;
-                RBTNode* parent = node;
-                while (successor->left != nullptr) {
-                    parent = successor;
-                    successor = parent->left;
-                }
-                // Step 2
-                swapNode(node, successor);
-                maintainRelationship(parent);
-                maintainRelationship(p);//
-               // node = successor;
-                // Step 3: vvv
-            }
-
-            if (node->isLeaf()) {
-                // Current node must not be the root
-                assert(!node->isRoot());
-
-                // Case 2: Current node is a leaf
-                //   Step 1. Unlink and remove it.
-                //   Step 2. If N is BLACK, maintain N;
-                //           If N is RED, do nothing.
-
-                // The maintain operation won't change the node itself,
-                //  so we can perform maintain operation before unlink the node.
-                if (node->isBlack()) {
-                    maintainAfterRemove(node);
-                }
-                if (node->direction() == Direction::LEFT) {
-                    node->parent->left = nullptr;
-                }
-                else /* node->direction() == Direction::RIGHT */ {
-                    node->parent->right = nullptr;
-                }
-            }
-            else /* !node->isLeaf() */ {
-                assert(node->left == nullptr || node->right == nullptr);
-                // Case 3: Current node has a single left or right child
-                //   Step 1. Replace N with its child
-                //   Step 2. If N is BLACK, maintain N
-                RBTNode* parent = node->parent;
-                RBTNode* replacement = (node->left != nullptr ? node->left : node->right);
-                switch (node->direction()) {
-                case Direction::ROOT:
-                    sentinel->left = replacement;
-                    break;
-                case Direction::LEFT:
-                    parent->left = replacement;
-                    break;
-                case Direction::RIGHT:
-                    parent->right = replacement;
-                    break;
-                }
-                replacement->parent = parent;
-
-                if (node->isBlack()) {
-                    if (replacement->isRed()) {
-                        replacement->color = Color::BLACK;
-                    }
-                    else {
-                        maintainAfterRemove(replacement);
-                    }
-                }
-            }
-
-            delete node;
-            node = nullptr;
-            return true;
+        void remove(RBTNode* node) {
+            unlink(node);
+            destroyNode(node);
         }
 
-         void remove(RBTNode* node) {
+        //把node从树上摘下来并调整好 不销毁 len由调用者维护
+        //摘下的结点恢复成刚创建时的样子 可以直接再挂到另一棵树上
+        void unlink(RBTNode* node) {
             assert(node != nullptr);
+            if constexpr (STATS) counters.erases++;
+            forget(node);
             if (this->size() == 1) {
                 // Current node is the only node of the tree
                 sentinel->left = nullptr;
-                delete node;
+                minNode = maxNode = sentinel;
+                resetNode(node);
                 return;
             }
+            //下面的swapNode只交换位置 结点本身不变 先把边界挪到相邻结点上
+            if (node == minNode) minNode = nextNode(node);
+            if (node == maxNode) maxNode = prevNode(node);
 
             if (node->left != nullptr && node->right != nullptr) {
                 // clang-format off
@@ -751,7 +1414,7 @@ namespace sjtu {
                 // clang-format on
 
                 // Step 1
-                RBTNode* p = node->parent;//
+                RBTNode* p = node->parent();//
                 RBTNode* successor = node->right;
                 RBTNode* parent = node;
                 while (successor->left != nullptr) {
@@ -766,6 +1429,13 @@ namespace sjtu {
                 // Step 3: vvv
             }
 
+            //node马上要被摘掉 先把它从祖先的子树大小里减掉
+            //叶子要等调整完才摘 这期间把它的大小当成0 旋转重新计算大小时就不会算上它
+            if constexpr (ORDER_STATISTICS) {
+                adjustAncestors(node, -1);
+                node->count = 0;
+            }
+
             if (node->isLeaf()) {
                 // Current node must not be the root
                 assert(!node->isRoot());
@@ -781,10 +1451,10 @@ namespace sjtu {
                     maintainAfterRemove(node);
                 }
                 if (node->direction() == Direction::LEFT) {
-                    node->parent->left = nullptr;
+                    node->parent()->left = nullptr;
                 }
                 else /* node->direction() == Direction::RIGHT */ {
-                    node->parent->right = nullptr;
+                    node->parent()->right = nullptr;
                 }
             }
             else /* !node->isLeaf() */ {
@@ -792,7 +1462,7 @@ namespace sjtu {
                 // Case 3: Current node has a single left or right child
                 //   Step 1. Replace N with its child
                 //   Step 2. If N is BLACK, maintain N
-                RBTNode* parent = node->parent;
+                RBTNode* parent = node->parent();
                 RBTNode* replacement = (node->left != nullptr ? node->left : node->right);
                 switch (node->direction()) {
                 case Direction::ROOT:
@@ -805,11 +1475,11 @@ namespace sjtu {
                     parent->right = replacement;
                     break;
                 }
-                replacement->parent = parent;
+                replacement->setParent(parent);
 
                 if (node->isBlack()) {
                     if (replacement->isRed()) {
-                        replacement->color = Color::BLACK;
+                        replacement->setColor(Color::BLACK);
                     }
                     else {
                         maintainAfterRemove(replacement);
@@ -817,9 +1487,13 @@ namespace sjtu {
                 }
             }
 
-            delete node;
-            node = nullptr;
-            return;
+            resetNode(node);
+        }
+
+        static void resetNode(RBTNode* node) noexcept {
+            node->left = node->right = nullptr;
+            node->parent_color = 0;
+            if constexpr (ORDER_STATISTICS) node->count = 1;
         }
 
 
@@ -851,6 +1525,13 @@ namespace sjtu {
              */
             map* map_ptr;
             RBTNode* ptr;
+        public:
+            typedef std::ptrdiff_t difference_type;
+            typedef typename map::value_type value_type;
+            typedef value_type* pointer;
+            typedef value_type& reference;
+            typedef typename std::conditional<ORDER_STATISTICS,
+                std::random_access_iterator_tag, std::bidirectional_iterator_tag>::type iterator_category;
 
 
 
@@ -880,18 +1561,7 @@ namespace sjtu {
             iterator operator++(int) {
                 if (ptr == map_ptr->sentinel) throw invalid_iterator();
                 RBTNode* cur = ptr;
-                //先找右子树
-                if (ptr->right) {
-                    ptr = ptr->right;
-                    while (ptr->left)ptr = ptr->left;
-                }
-                //右子树没有 就找第一个在左子树的第一个祖先
-                else {
-                    while (ptr->parent->left != ptr) {
-                       ptr = ptr->parent;
-                    }
-                    ptr = ptr->parent;
-                }
+                ptr = nextNode(ptr);
                 return iterator(map_ptr, cur);
             }
             /**
@@ -899,53 +1569,25 @@ namespace sjtu {
              */
             iterator& operator++() {
                 if (ptr == map_ptr->sentinel) throw invalid_iterator();
-                //先找右子树
-                if (ptr->right) {
-                    ptr = ptr->right;
-                    while (ptr->left)ptr = ptr->left;
-                }
-                //右子树没有 就找第一个在左子树的第一个祖先
-                else
-                    while (1) {
-                        if (ptr->direction() == Direction::RIGHT)ptr = ptr->parent;
-                        else { ptr = ptr->parent; break; }
-                    }
+                ptr = nextNode(ptr);
                 return *this;
             }
             /**
              * TODO iter--
              */
             iterator operator--(int) {
-                RBTNode* begin_ptr = map_ptr->sentinel;
-                while (begin_ptr->left)begin_ptr = begin_ptr->left;
-                if (ptr == begin_ptr)throw invalid_iterator();
+                //最小结点缓存在map里 判断越界是O(1)的
+                if (ptr == map_ptr->minNode)throw invalid_iterator();
                 RBTNode* cur = ptr;
-                if (ptr->left) {
-                    ptr = ptr->left;
-                    while (ptr->right)ptr = ptr->right;
-                }
-                else {
-                    //只有begin才会一路回到根 这种情况已经被排除
-                    while (ptr->direction() == Direction::LEFT)ptr = ptr->parent;
-                    ptr = ptr->parent;
-                }
+                ptr = map_ptr->prevNode(ptr);
                 return iterator(map_ptr, cur);
             }
             /**
              * TODO --iter
              */
             iterator& operator--() {
-                RBTNode* begin_ptr = map_ptr->sentinel;
-                while (begin_ptr->left)begin_ptr = begin_ptr->left;
-                if (ptr == begin_ptr)throw invalid_iterator();
-                if (ptr->left) {
-                    ptr = ptr->left;
-                    while (ptr->right)ptr = ptr->right;
-                }
-                else {
-                    while (ptr->direction() == Direction::LEFT)ptr = ptr->parent;
-                    ptr = ptr->parent;
-                }
+                if (ptr == map_ptr->minNode)throw invalid_iterator();
+                ptr = map_ptr->prevNode(ptr);
                 return *this;
             }
             /**
@@ -953,7 +1595,7 @@ namespace sjtu {
              */
             value_type& operator*() const {
                 if (ptr == map_ptr->sentinel) throw invalid_iterator();
-                return *(ptr->data);
+                return *(ptr->data());
             }
             bool operator==(const iterator& rhs) const {
                 return map_ptr == rhs.map_ptr && ptr == rhs.ptr;
@@ -977,8 +1619,39 @@ namespace sjtu {
              */
              //为什么不要判定异常 还是不太理解这个运算符
             value_type* operator->() const noexcept {
-                return ptr->data;
+                return ptr->data();
+            }
+            /**
+             * random access, only with order_statistics: each step is O(log n).
+             * moving before begin() or past end() throws invalid_iterator.
+             */
+            iterator operator+(difference_type k) const {
+                static_assert(ORDER_STATISTICS, "needs a map with order_statistics");
+                difference_type i = (difference_type)map_ptr->indexOf(ptr) + k;
+                if (i < 0 || i > (difference_type)map_ptr->len) throw invalid_iterator();
+                return iterator(map_ptr, map_ptr->selectNode((size_t)i));
+            }
+            iterator operator-(difference_type k) const {
+                return *this + (-k);
+            }
+            iterator& operator+=(difference_type k) {
+                return *this = *this + k;
+            }
+            iterator& operator-=(difference_type k) {
+                return *this = *this + (-k);
+            }
+            difference_type operator-(const iterator& rhs) const {
+                static_assert(ORDER_STATISTICS, "needs a map with order_statistics");
+                if (map_ptr != rhs.map_ptr) throw invalid_iterator();
+                return (difference_type)map_ptr->indexOf(ptr) - (difference_type)map_ptr->indexOf(rhs.ptr);
+            }
+            value_type& operator[](difference_type k) const {
+                return *(*this + k);
             }
+            bool operator<(const iterator& rhs) const { return *this - rhs < 0; }
+            bool operator>(const iterator& rhs) const { return rhs < *this; }
+            bool operator<=(const iterator& rhs) const { return !(rhs < *this); }
+            bool operator>=(const iterator& rhs) const { return !(*this < rhs); }
         };
         class const_iterator {
             // it should has similar member method as iterator.
@@ -989,6 +1662,12 @@ namespace sjtu {
             const map* map_ptr;
             RBTNode* ptr;
         public:
+            typedef std::ptrdiff_t difference_type;
+            typedef typename map::value_type value_type;
+            typedef const value_type* pointer;
+            typedef const value_type& reference;
+            typedef typename std::conditional<ORDER_STATISTICS,
+                std::random_access_iterator_tag, std::bidirectional_iterator_tag>::type iterator_category;
             const_iterator(const map* _m = nullptr, RBTNode* _n = nullptr){
                 // TODO
                 map_ptr = _m;
@@ -1012,17 +1691,7 @@ namespace sjtu {
             const_iterator operator++(int) {
                 if (ptr == map_ptr->sentinel) throw invalid_iterator();
                 RBTNode* cur = ptr;
-                //先找右子树
-                if (ptr->right) {
-                    ptr = ptr->right;
-                    while (ptr->left)ptr = ptr->left;
-                }
-                //右子树没有 就找第一个在左子树的第一个祖先
-                else
-                    while (1) {
-                        if (ptr->direction() == Direction::RIGHT)ptr = ptr->parent;
-                        else { ptr = ptr->parent; break; }
-                    }
+                ptr = nextNode(ptr);
                 return const_iterator(map_ptr, cur);
             }
             /**
@@ -1030,55 +1699,24 @@ namespace sjtu {
              */
             const_iterator& operator++() {
                 if (ptr == map_ptr->sentinel) throw invalid_iterator();
-                //先找右子树
-                if (ptr->right) {
-                    ptr = ptr->right;
-                    while (ptr->left)ptr = ptr->left;
-                }
-                //右子树没有 就找第一个在左子树的第一个祖先
-                else
-                    while (1) {
-                        if (ptr->direction() == Direction::RIGHT)ptr = ptr->parent;
-                        else { ptr = ptr->parent; break; }
-                    }
+                ptr = nextNode(ptr);
                 return *this;
             }
             /**
              * TODO iter--
              */
             const_iterator operator--(int) {
-                RBTNode* begin_ptr = map_ptr->sentinel;
-                while (begin_ptr->left)begin_ptr = begin_ptr->left;
-                if (ptr == begin_ptr)throw invalid_iterator();
+                if (ptr == map_ptr->minNode)throw invalid_iterator();
                 RBTNode* cur = ptr;
-                if (ptr->left) {
-                    ptr = ptr->left;
-                    while (ptr->right)ptr = ptr->right;
-                }
-                else {
-                    //只有begin才会一路回到根 这种情况已经被排除
-                    while (ptr->direction() == Direction::LEFT)ptr = ptr->parent;
-                    ptr = ptr->parent;
-                }
+                ptr = map_ptr->prevNode(ptr);
                 return const_iterator(map_ptr, cur);
             }
             /**
              * TODO --iter
              */
             const_iterator& operator--() {
-                RBTNode* begin_ptr = map_ptr->sentinel;
-                while (begin_ptr->left)begin_ptr = begin_ptr->left;
-                if (ptr == begin_ptr)throw invalid_iterator();
-                RBTNode* cur = ptr;
-                if (ptr->left) {
-                    ptr = ptr->left;
-                    while (ptr->right)ptr = ptr->right;
-                }
-                else {
-                    //只有begin才会一路回到根 这种情况已经被排除
-                    while (ptr->direction() == Direction::LEFT)ptr = ptr->parent;
-                    ptr = ptr->parent;
-                }
+                if (ptr == map_ptr->minNode)throw invalid_iterator();
+                ptr = map_ptr->prevNode(ptr);
                 return *this;
             }
             /**
@@ -1086,7 +1724,7 @@ namespace sjtu {
              */
             const value_type& operator*() const {
                 if (ptr == map_ptr->sentinel) throw invalid_iterator();
-                return *(ptr->data);
+                return *(ptr->data());
             }
             bool operator==(const iterator& rhs) const {
                 return map_ptr == rhs.map_ptr && ptr == rhs.ptr;
@@ -1109,8 +1747,39 @@ namespace sjtu {
              * See <http://kelvinh.github.io/blog/2013/11/20/overloading-of-member-access-operator-dash-greater-than-symbol-in-cpp/> for help.
              */
             const value_type* operator->() const noexcept {
-                return ptr->data;
+                return ptr->data();
+            }
+            /**
+             * random access, only with order_statistics: each step is O(log n).
+             * moving before begin() or past end() throws invalid_iterator.
+             */
+            const_iterator operator+(difference_type k) const {
+                static_assert(ORDER_STATISTICS, "needs a map with order_statistics");
+                difference_type i = (difference_type)map_ptr->indexOf(ptr) + k;
+                if (i < 0 || i > (difference_type)map_ptr->len) throw invalid_iterator();
+                return const_iterator(map_ptr, map_ptr->selectNode((size_t)i));
+            }
+            const_iterator operator-(difference_type k) const {
+                return *this + (-k);
+            }
+            const_iterator& operator+=(difference_type k) {
+                return *this = *this + k;
             }
+            const_iterator& operator-=(difference_type k) {
+                return *this = *this + (-k);
+            }
+            difference_type operator-(const const_iterator& rhs) const {
+                static_assert(ORDER_STATISTICS, "needs a map with order_statistics");
+                if (map_ptr != rhs.map_ptr) throw invalid_iterator();
+                return (difference_type)map_ptr->indexOf(ptr) - (difference_type)map_ptr->indexOf(rhs.ptr);
+            }
+            const value_type& operator[](difference_type k) const {
+                return *(*this + k);
+            }
+            bool operator<(const const_iterator& rhs) const { return *this - rhs < 0; }
+            bool operator>(const const_iterator& rhs) const { return rhs < *this; }
+            bool operator<=(const const_iterator& rhs) const { return !(rhs < *this); }
+            bool operator>=(const const_iterator& rhs) const { return !(*this < rhs); }
 
 
 
@@ -1129,14 +1798,53 @@ namespace sjtu {
         map() {
             len = 0;
             sentinel = new RBTNode();
+            minNode = maxNode = sentinel;
+        }
+        /**
+         * an empty map ordered by a copy of comp. only maps whose comparators order
+         *   the keys alike may be merged, joined or compared.
+         */
+        explicit map(const Compare& comp) : functor_holder<Compare>(comp) {
+            len = 0;
+            sentinel = new RBTNode();
+            minNode = maxNode = sentinel;
+        }
+        map(const map& other) : functor_holder<Compare>(other), pool(other.pool) {
+            len = 0;
+            sentinel = new RBTNode();
+            minNode = maxNode = sentinel;
+            //按中序走一遍other 一次分配 直接搭成平衡树 不递归
+            try {
+                copyFrom(other);
+            }
+            catch (...) {
+                delete sentinel;
+                throw;
+            }
+        }
+        /**
+         * builds the map from [first, last), which may be unsorted and contain duplicates;
+         *   of equal keys the first one is kept.
+         * each element is inserted with end() as hint, so sorted input costs O(1) amortized per element.
+         */
+        template<class InputIt>
+        map(InputIt first, InputIt last) : map() {
+            for (; first != last; ++first) insert(cend(), *first);
         }
-        map(const map& other) {
-            len = other.len;
+        /**
+         * builds the map from [first, last), whose keys must be strictly increasing.
+         * O(n) if the iterators are at least forward iterators; see assign_sorted.
+         */
+        template<class InputIt>
+        map(sorted_unique_t, InputIt first, InputIt last) : map() {
+            assign_sorted(first, last);
+        }
+        //先造一个空的 再整个交换过来 other留下一个空树
+        map(map&& other) : functor_holder<Compare>(other), pool(other.pool) {
+            len = 0;
             sentinel = new RBTNode();
-            //dfs一遍 走到哪复制到哪
-            copy(sentinel->left, other.sentinel->left);
-            //copy一个节点只会更新其子节点的父信息 所以sentinel的子节点要额外连起来
-            if (sentinel->left)sentinel->left->parent = sentinel;
+            minNode = maxNode = sentinel;
+            swap(other);
         }
         /**
          * TODO assignment operator
@@ -1145,12 +1853,34 @@ namespace sjtu {
             //先判断是否赋值自己
             if (this == &other)return *this;
             //清除当前内容
-            clear(sentinel->left);
-            copy(sentinel->left, other.sentinel->left);
-            if (sentinel->left)sentinel->left->parent = sentinel;
-            len = other.len;
+            clear();
+            functor_holder<Compare>::operator=(other);
+            copyFrom(other);
+            return *this;
+        }
+        map& operator=(map&& other) {
+            if (this == &other)return *this;
+            clear();
+            swap(other);
             return *this;
         }
+        /**
+         * exchanges the contents with other in O(1).
+         * the elements do not move, so references and pointers to them stay valid.
+         *   iterators still reach their elements, but remain tied to the map they came
+         *   from: stepping them, comparing them with the other map's iterators or passing
+         *   them to either map is not allowed afterwards (erase throws invalid_iterator).
+         */
+        void swap(map& other) {
+            this->swap_functor(other);
+            pool.swap(other.pool);
+            std::swap(sentinel, other.sentinel);
+            std::swap(len, other.len);
+            std::swap(minNode, other.minNode);
+            std::swap(maxNode, other.maxNode);
+            //缓存里的结点跟着树一起换过去
+            std::swap(cache, other.cache);
+        }
         /**
          * TODO Destructors
          */
@@ -1166,13 +1896,32 @@ namespace sjtu {
          * If no such element exists, an exception of type `index_out_of_bound'
          */
         T& at(const Key& key) {
-            RBTNode* p = find(key, sentinel->left);
-            if (p)return p->data->second;
+            RBTNode* p = findNode(key);
+            if (p)return p->data()->second;
             throw index_out_of_bound();
         }
         const T& at(const Key& key) const {
-            RBTNode* p = find(key, sentinel->left);
-            if (p)return p->data->second;
+            RBTNode* p = findNode(key);
+            if (p)return p->data()->second;
+            throw index_out_of_bound();
+        }
+        /**
+         * the lookups taking a K instead of a Key (at, count, contains, find,
+         *   lower_bound, upper_bound, equal_range) only exist if Compare has a
+         *   member type is_transparent, like std::less<>. key is then compared with
+         *   the stored keys directly, e.g. a string_view against std::string keys,
+         *   without building a temporary Key.
+         */
+        template<class K, class C = Compare, class = typename C::is_transparent>
+        T& at(const K& key) {
+            RBTNode* p = findNode(key);
+            if (p)return p->data()->second;
+            throw index_out_of_bound();
+        }
+        template<class K, class C = Compare, class = typename C::is_transparent>
+        const T& at(const K& key) const {
+            RBTNode* p = findNode(key);
+            if (p)return p->data()->second;
             throw index_out_of_bound();
         }
         /**
@@ -1182,35 +1931,27 @@ namespace sjtu {
          *   performing an insertion if such key does not already exist.
          */
         T& operator[](const Key& key) {
-            pair<iterator, bool> tmp = insert(value_type(key, T()));
-            return tmp.first->second;
-
-            /*RBTNode* p = find(key, sentinel->left);
-            if (p) return p->data->second;
-            pair<RBTNode*, bool> tmp = insert(value_type(key, T()), sentinel->left, sentinel);
-            ++len;
-            return tmp.first->data->second;*/
+            return try_emplace(key).first->second;
+        }
+        T& operator[](Key&& key) {
+            return try_emplace(std::move(key)).first->second;
         }
         /**
          * behave like at() throw index_out_of_bound if such key does not exist.
          */
         const T& operator[](const Key& key) const {
-            RBTNode* p = find(key, sentinel->left);
-            if (p)return p->data->second;
+            RBTNode* p = findNode(key);
+            if (p)return p->data()->second;
             throw index_out_of_bound();
         }
         /**
          * return a iterator to the beginning
          */
         iterator begin() {
-            RBTNode* node = sentinel;
-            while (node->left)node = node->left;
-            return iterator(this, node);
+            return iterator(this, minNode);
         }
         const_iterator cbegin() const {
-            RBTNode* node = sentinel;
-            while (node->left)node = node->left;
-            return const_iterator(this, node);
+            return const_iterator(this, minNode);
         }
         /**
          * return a iterator to the end
@@ -1235,6 +1976,51 @@ namespace sjtu {
         size_t size() const {
             return len;
         }
+        /**
+         * bytes of heap the map holds: the sentinel and every slab of its node pool,
+         *   free slots left by erasures included (compact() gives those back).
+         *   memory owned by the elements themselves is not counted. slabs shared with
+         *   another map after merge, join, split or a node handle insertion count in full.
+         */
+        size_t memory_usage() const {
+            return sizeof(RBTNode) + pool.memory();
+        }
+        /**
+         * moves every element into one new block of nodes laid out in key order and
+         *   rebuilds the tree balanced, in O(n). the old slabs are given back, with the
+         *   free slots left by erasures, and iteration reads memory in order again.
+         * invalidates all iterators, pointers and references. elements are moved if
+         *   that cannot throw and copied otherwise; if a copy throws, nothing changes.
+         */
+        void compact() {
+            if (len == 0) {
+                clear();
+                return;
+            }
+            pool_type fresh(pool.get_allocator());
+            char* block = static_cast<char*>(fresh.allocate_block(len));
+            if constexpr (STATS) counters.node_allocations += len;
+            auto at = [block](size_t i) { return reinterpret_cast<ValueNode*>(block + i * pool_type::STRIDE); };
+            size_t built = 0;
+            try {
+                for (RBTNode* p = minNode; p != sentinel; p = nextNode(p), built++)
+                    new(at(built)) ValueNode(nullptr, Color::BLACK, std::move_if_noexcept(*p->data()));
+            }
+            catch (...) {
+                while (built) at(--built)->~ValueNode();
+                throw;
+            }
+            //旧树照clear的办法析构和归还 再换上新的pool
+            clear(sentinel->left);
+            pool.swap(fresh);
+            linkBlock(block, built);
+        }
+        /**
+         * a copy of the comparator ordering the keys.
+         */
+        Compare key_comp() const {
+            return comp();
+        }
         /**
          * clears the contents
          */
@@ -1243,6 +2029,125 @@ namespace sjtu {
             sentinel->left = nullptr;
             len = 0;
         }
+        /**
+         * replaces the contents with [first, last), whose keys must be strictly increasing.
+         * with forward iterators the tree is built bottom-up in O(n):
+         *   no comparisons beyond the order check, no rebalancing, and all nodes in one block.
+         * single-pass input iterators are appended at the right end one by one instead.
+         *
+         * throw runtime_error if the keys are not strictly increasing; the map is left empty.
+         */
+        template<class InputIt>
+        void assign_sorted(InputIt first, InputIt last) {
+            clear();
+            assignSorted(first, last, typename std::iterator_traits<InputIt>::iterator_category());
+        }
+        /**
+         * replaces the contents with [first, last), which may be unsorted and contain
+         *   duplicates; of equal keys the first one is kept, as in map(first, last).
+         * uses up to threads threads (0: one per hardware thread):
+         *   slices of the range are sorted in parallel and merged pairwise, stably;
+         *   the elements are copied into one block of nodes in parallel;
+         *   the tree is then built bottom-up in O(n) as in assign_sorted.
+         * ForwardIt must be at least a forward iterator.
+         * if copying an element throws, the map is left empty and the exception rethrown.
+         */
+        template<class ForwardIt>
+        void parallel_assign(ForwardIt first, ForwardIt last, size_t threads = 0) {
+            clear();
+            //只排迭代器 元素到建树时才复制
+            std::vector<ForwardIt> its;
+            for (; first != last; ++first) its.push_back(first);
+            size_t n = its.size();
+            if (n == 0) return;
+            threads = thread_count(threads);
+            auto less = [this](const ForwardIt& a, const ForwardIt& b) { return comp()((*a).first, (*b).first); };
+            size_t parts = threads < n ? threads : n;
+            size_t width = (n + parts - 1) / parts;
+            //按引用取n 去重之后n变小 复制结点时分段要按去重后的长度
+            auto slice = [&n](size_t lo, size_t w) { return lo + w < n ? lo + w : n; };
+            parallel_run(parts, threads, [&](size_t i) {
+                if (i * width < n) std::stable_sort(its.begin() + i * width, its.begin() + slice(i * width, width), less);
+            });
+            for (size_t w = width; w < n; w *= 2) {
+                parallel_run((n + 2 * w - 1) / (2 * w), threads, [&](size_t i) {
+                    size_t lo = i * 2 * w;
+                    std::inplace_merge(its.begin() + lo, its.begin() + slice(lo, w), its.begin() + slice(lo, 2 * w), less);
+                });
+            }
+            //稳定排序后相等的key挨在一起 原来在前的也在前 每组留第一个
+            n = std::unique(its.begin(), its.end(), [&less](const ForwardIt& a, const ForwardIt& b) { return !less(a, b); }) - its.begin();
+            char* block = static_cast<char*>(pool.allocate_block(n));
+            if constexpr (STATS) counters.node_allocations += n;
+            auto at = [block](size_t i) { return reinterpret_cast<ValueNode*>(block + i * pool_type::STRIDE); };
+            //每段自己造完 失败时自己析构已经造好的 整段造完才记下来
+            width = (n + parts - 1) / parts;
+            std::vector<char> done(parts, 0);
+            try {
+                parallel_run(parts, threads, [&](size_t i) {
+                    size_t lo = i * width, hi = slice(lo, width), k = lo;
+                    try {
+                        for (; k < hi; k++) new(at(k)) ValueNode(nullptr, Color::BLACK, *its[k]);
+                    }
+                    catch (...) {
+                        while (k > lo) at(--k)->~ValueNode();
+                        throw;
+                    }
+                    done[i] = 1;
+                });
+            }
+            catch (...) {
+                for (size_t i = 0; i < parts; i++)
+                    if (done[i])
+                        for (size_t k = i * width; k < slice(i * width, width); k++) at(k)->~ValueNode();
+                for (size_t i = 0; i < n; i++) pool.deallocate(at(i));
+                throw;
+            }
+            linkBlock(block, n);
+            if constexpr (STATS) counters.inserts += n;
+        }
+        /**
+         * calls fn on every element from up to threads threads (0: one per hardware thread).
+         * the tree is cut into at least 4 * threads subtrees, and the nodes between them;
+         *   each piece is walked in order by one thread. fn is shared by all threads and
+         *   sees the elements concurrently, in no particular order. it must not insert or
+         *   erase. the first exception thrown by fn is rethrown once all threads have
+         *   stopped; some elements may not have been visited then.
+         */
+        template<class Fn>
+        void parallel_for_each(Fn fn, size_t threads = 0) {
+            parallelNodes(threads, [&fn](RBTNode* p) { fn(*p->data()); });
+        }
+        template<class Fn>
+        void parallel_for_each(Fn fn, size_t threads = 0) const {
+            parallelNodes(threads, [&fn](RBTNode* p) { fn(*static_cast<const value_type*>(p->data())); });
+        }
+        /**
+         * clears the contents like clear(), running the destructors of the elements on
+         *   up to threads threads (0: one per hardware thread). meant for huge maps whose
+         *   elements are costly to destroy. while the nodes share their slabs with another
+         *   map (after merge, join, split or a node handle insertion) it is a plain clear().
+         */
+        void parallel_clear(size_t threads = 0) {
+            if (!pool.unique()) {
+                clear();
+                return;
+            }
+            if (!TRIVIAL_DESTROY)
+                parallelNodes(threads, [](RBTNode* p) { static_cast<ValueNode*>(p)->~ValueNode(); });
+            sentinel->left = nullptr;
+            minNode = maxNode = sentinel;
+            len = 0;
+            forgetAll();
+            pool.release();
+        }
+    private:
+        //插入成功后统一做调整和计数
+        pair<iterator, bool> afterInsert(pair<RBTNode*, bool> p) {
+            if (p.second) { maintainAfterInsert(p.first); len++; }
+            return pair<iterator, bool>(iterator(this, p.first), p.second);
+        }
+    public:
         /**
          * insert an element.
          * return a pair, the first of the pair is
@@ -1255,9 +2160,102 @@ namespace sjtu {
 
 
         pair<iterator, bool> insert(const value_type& value) {
-            pair<RBTNode*, bool>p = insert(value, sentinel->left, sentinel);
-            if (p.second) { maintainAfterInsert(p.first); len++; }
-            return pair<iterator, bool>(iterator(this, p.first), p.second);
+            return afterInsert(insertUnique(value.first, value));
+        }
+        pair<iterator, bool> insert(value_type&& value) {
+            return afterInsert(insertUnique(value.first, std::move(value)));
+        }
+        /**
+         * insert value as close as possible to the position just before hint.
+         * amortized O(1) if value belongs right before hint (or at end() when hint is end()),
+         *   otherwise falls back to an ordinary descent from the root.
+         * returns an iterator to the inserted element, or to the element that prevented the insertion.
+         */
+        iterator insert(const_iterator hint, const value_type& value) {
+            if (hint.map_ptr != this)throw invalid_iterator();
+            return afterInsert(insertUniqueHint(hint.ptr, value.first, value)).first;
+        }
+        iterator insert(const_iterator hint, value_type&& value) {
+            if (hint.map_ptr != this)throw invalid_iterator();
+            return afterInsert(insertUniqueHint(hint.ptr, value.first, std::move(value))).first;
+        }
+        /**
+         * constructs the element from args and inserts it if its key is not present.
+         * the element has to be built first to learn its key; it is destroyed again
+         *   if the key turns out to be taken.
+         */
+        template<class... Args>
+        pair<iterator, bool> emplace(Args&&... args) {
+            RBTNode* n = createNode(nullptr, Color::RED, std::forward<Args>(args)...);
+            pair<RBTNode*, bool> p = insertNode(n);
+            if (!p.second) destroyNode(n);
+            return afterInsert(p);
+        }
+        /**
+         * like emplace, but uses hint to find the position as insert(hint, value) does.
+         */
+        template<class... Args>
+        iterator emplace_hint(const_iterator hint, Args&&... args) {
+            if (hint.map_ptr != this)throw invalid_iterator();
+            RBTNode* n = createNode(nullptr, Color::RED, std::forward<Args>(args)...);
+            pair<RBTNode*, bool> p = insertNode(n, hint.ptr);
+            if (!p.second) destroyNode(n);
+            return afterInsert(p).first;
+        }
+        /**
+         * if key is absent, inserts value_type(key, T(args...)) built in place;
+         *   otherwise does nothing, and args are left untouched.
+         */
+        template<class... Args>
+        pair<iterator, bool> try_emplace(const Key& key, Args&&... args) {
+            return afterInsert(insertUnique(key, std::piecewise_construct,
+                std::forward_as_tuple(key), std::forward_as_tuple(std::forward<Args>(args)...)));
+        }
+        template<class... Args>
+        pair<iterator, bool> try_emplace(Key&& key, Args&&... args) {
+            return afterInsert(insertUnique(key, std::piecewise_construct,
+                std::forward_as_tuple(std::move(key)), std::forward_as_tuple(std::forward<Args>(args)...)));
+        }
+        /**
+         * assigns obj to the mapped value of key, inserting it if key is absent.
+         * the second of the returned pair is true if an insertion took place.
+         */
+        template<class M>
+        pair<iterator, bool> insert_or_assign(const Key& key, M&& obj) {
+            pair<iterator, bool> p = try_emplace(key, std::forward<M>(obj));
+            if (!p.second) p.first->second = std::forward<M>(obj);
+            return p;
+        }
+        template<class M>
+        pair<iterator, bool> insert_or_assign(Key&& key, M&& obj) {
+            pair<iterator, bool> p = try_emplace(std::move(key), std::forward<M>(obj));
+            if (!p.second) p.first->second = std::forward<M>(obj);
+            return p;
+        }
+        /**
+         * inserts the elements of [first, last) whose keys are not present yet; of equal
+         *   keys in the batch the first one is kept, as with one insert() after another.
+         * the batch is sorted first. a batch smaller than the map is then inserted in key
+         *   order, its searches run 16 at a time with their cache misses overlapping;
+         *   rebalancing is amortized O(1) per insertion. a larger batch is merged with the
+         *   elements in one in-order pass and the tree relinked, in O(n + k).
+         * returns the number of elements inserted. iterators and references stay valid.
+         * if copying an element throws, some of the batch may have been inserted.
+         */
+        template<class ForwardIt>
+        size_t insert_batch(ForwardIt first, ForwardIt last) {
+            return insertSorted(sortBatch(first, last, false), false);
+        }
+        /**
+         * like insert_or_assign for every element of [first, last): present keys get the
+         *   new mapped value, absent ones are inserted. of equal keys in the batch the
+         *   last one wins. costs and guarantees are those of insert_batch; if an element
+         *   throws, some of the batch may have been applied.
+         * returns the number of elements inserted.
+         */
+        template<class ForwardIt>
+        size_t apply_batch(ForwardIt first, ForwardIt last) {
+            return insertSorted(sortBatch(first, last, true), true);
         }
         /**
          * erase the element at pos.
@@ -1271,6 +2269,267 @@ namespace sjtu {
             remove(pos.ptr);
             len--;
         }
+        /**
+         * removes the element with key equivalent to key, if any.
+         * returns the number of elements removed (0 or 1).
+         */
+        size_t erase(const Key& key) {
+            RBTNode* node = findNode(key);
+            if (!node)return 0;
+            remove(node);
+            len--;
+            return 1;
+        }
+        /**
+         * removes the elements in [first, last) and returns last.
+         * the removed nodes are unlinked one by one without searching the tree again;
+         *   erasing everything is the same as clear().
+         *
+         * throw invalid_iterator if first or last does not belong to this map.
+         */
+        iterator erase(const_iterator first, const_iterator last) {
+            if (first.map_ptr != this || last.map_ptr != this)throw invalid_iterator();
+            if (first.ptr == minNode && last.ptr == sentinel) {
+                clear();
+                return end();
+            }
+            //swapNode交换的是结点位置 结点本身不动 所以提前取好的后继一直有效
+            RBTNode* node = first.ptr;
+            while (node != last.ptr) {
+                if (node == sentinel)throw invalid_iterator();
+                RBTNode* next = nextNode(node);
+                remove(node);
+                len--;
+                node = next;
+            }
+            return iterator(this, last.ptr);
+        }
+        /**
+         * owns an element taken out of a map by extract().
+         * it can be inserted into any map of the same type, which relinks the node
+         *   without allocating it again or copying the element.
+         * the maps the node passes through share their node slabs from then on; they can
+         *   still be used from different threads, each of them by one thread at a time.
+         * an empty handle owns nothing; key() and mapped() throw container_is_empty on it.
+         */
+        class node_type {
+            friend class map;
+        private:
+            RBTNode* node;
+            //和结点所在的slab共用 handle活着时结点的内存不会被释放
+            pool_type pool;
+
+            void reset() noexcept {
+                if (!node) return;
+                static_cast<ValueNode*>(node)->~ValueNode();
+                pool.deallocate(node);
+                node = nullptr;
+            }
+        public:
+            node_type() : node(nullptr) {}
+            node_type(node_type&& other) noexcept : node(other.node), pool(std::move(other.pool)) {
+                other.node = nullptr;
+            }
+            node_type& operator=(node_type&& other) noexcept {
+                if (this == &other) return *this;
+                reset();
+                node = other.node;
+                other.node = nullptr;
+                pool.swap(other.pool);
+                return *this;
+            }
+            ~node_type() {
+                reset();
+            }
+            bool empty() const noexcept { return node == nullptr; }
+            explicit operator bool() const noexcept { return node != nullptr; }
+            const Key& key() const {
+                if (!node) throw container_is_empty();
+                return node->data()->first;
+            }
+            T& mapped() const {
+                if (!node) throw container_is_empty();
+                return node->data()->second;
+            }
+        };
+        struct insert_return_type {
+            iterator position;
+            bool inserted;
+            node_type node;
+        };
+    private:
+        //handle里的结点挂到parent下面 结点的内存从此和handle的slab共用
+        iterator linkHandle(node_type& nh, RBTNode* parent, bool toLeft) {
+            pool.share_with(nh.pool);
+            RBTNode* n = nh.node;
+            nh.node = nullptr;
+            linkNode(n, parent, toLeft);
+            return afterInsert(pair<RBTNode*, bool>(n, true)).first;
+        }
+    public:
+        /**
+         * unlinks the element at pos and hands it over in a node handle.
+         * other iterators stay valid.
+         */
+        node_type extract(const_iterator pos) {
+            if (pos.map_ptr != this || pos.ptr == sentinel)throw invalid_iterator();
+            node_type nh;
+            nh.pool.share_with(pool);
+            unlink(pos.ptr);
+            len--;
+            nh.node = pos.ptr;
+            return nh;
+        }
+        /**
+         * extracts the element with key equivalent to key; the handle is empty if there is none.
+         */
+        node_type extract(const Key& key) {
+            RBTNode* node = findNode(key);
+            if (!node)return node_type();
+            return extract(const_iterator(this, node));
+        }
+        /**
+         * inserts the element owned by nh if its key is not present yet.
+         * on success nh is emptied; otherwise the element is handed back in the returned node.
+         */
+        insert_return_type insert(node_type&& nh) {
+            if (nh.empty())return insert_return_type{ end(), false, node_type() };
+            RBTNode* parent;
+            bool toLeft;
+            RBTNode* e = findInsertPos(nh.node->data()->first, parent, toLeft);
+            if (e)return insert_return_type{ iterator(this, e), false, std::move(nh) };
+            return insert_return_type{ linkHandle(nh, parent, toLeft), true, node_type() };
+        }
+        /**
+         * like insert(nh), using hint as insert(hint, value) does.
+         * returns the inserted element, or the one that prevented the insertion (nh keeps its element then).
+         */
+        iterator insert(const_iterator hint, node_type&& nh) {
+            if (hint.map_ptr != this)throw invalid_iterator();
+            if (nh.empty())return end();
+            RBTNode* parent;
+            bool toLeft;
+            RBTNode* e = findHintPos(hint.ptr, nh.node->data()->first, parent, toLeft);
+            if (e)return iterator(this, e);
+            return linkHandle(nh, parent, toLeft);
+        }
+        /**
+         * moves every element of other whose key is not present in this map into this map;
+         *   the others stay in other. nodes are relinked, nothing is allocated or copied.
+         * when the key ranges do not overlap it is a single join in O(log n).
+         * the two maps share their node slabs afterwards, which does not stop them
+         *   from being used from different threads.
+         */
+        void merge(map& other) {
+            if (&other == this || other.len == 0)return;
+            if (len == 0) {
+                swap(other);
+                return;
+            }
+            if (comp()(maxNode->data()->first, other.minNode->data()->first)) {
+                join(other);
+                return;
+            }
+            if (comp()(other.maxNode->data()->first, minNode->data()->first)) {
+                other.join(*this);
+                swap(other);
+                return;
+            }
+            pool.share_with(other.pool);
+            //other是有序的 上一个结点的后继多半就是下一个结点的位置 拿它当hint
+            RBTNode* hint = nullptr;
+            RBTNode* node = other.minNode;
+            while (node != other.sentinel) {
+                RBTNode* next = nextNode(node);
+                const Key& key = node->data()->first;
+                RBTNode* parent;
+                bool toLeft;
+                RBTNode* e = hint ? findHintPos(hint, key, parent, toLeft) : findInsertPos(key, parent, toLeft);
+                if (!e) {
+                    other.unlink(node);
+                    other.len--;
+                    linkNode(node, parent, toLeft);
+                    afterInsert(pair<RBTNode*, bool>(node, true));
+                    e = node;
+                }
+                hint = nextNode(e);
+                node = next;
+            }
+        }
+        void merge(map&& other) {
+            merge(other);
+        }
+        /**
+         * moves every element whose key is not less than key into a new map and returns it;
+         *   this map keeps the smaller ones. the tree is cut along one search path and
+         *   glued back with joins, in O(log n); without order_statistics the sizes of
+         *   the two halves are counted as well, which walks min(left, right) elements.
+         * the two halves share their node slabs but can be handed to different threads.
+         */
+        map split(const Key& key) {
+            map result(comp());
+            RBTNode* b = lowerBound(key);
+            if (b == sentinel)return result;
+            if (b == minNode) {
+                swap(result);
+                return result;
+            }
+            size_t leftLen = ORDER_STATISTICS ? 0 : countBefore(b);
+            RBTNode* leftMax = prevNode(b);
+            RBTNode* rightMax = maxNode;
+            result.pool.share_with(pool);
+            RBTNode* l, * r;
+            size_t lbh, rbh;
+            splitTree(sentinel->left, key, l, lbh, r, rbh);
+            //后一半的结点到了result里 它们的slot不能留在这边
+            forgetAll();
+            if constexpr (ORDER_STATISTICS) leftLen = l->count;
+            sentinel->left = l;
+            l->setParent(sentinel);
+            maxNode = leftMax;
+            result.sentinel->left = r;
+            r->setParent(result.sentinel);
+            result.minNode = b;
+            result.maxNode = rightMax;
+            result.len = len - leftLen;
+            len = leftLen;
+            return result;
+        }
+        /**
+         * appends all elements of other, whose keys must all be greater than the keys
+         *   in this map, in O(log n); other is left empty.
+         * this undoes split: a.join(b) after b = a.split(key) gives back the original map.
+         * the two maps share their node slabs afterwards, which does not stop them
+         *   from being used from different threads.
+         *
+         * throw runtime_error if the key ranges overlap.
+         */
+        void join(map& other) {
+            if (&other == this || other.len == 0)return;
+            if (len == 0) {
+                swap(other);
+                return;
+            }
+            if (!comp()(maxNode->data()->first, other.minNode->data()->first))throw runtime_error();
+            pool.share_with(other.pool);
+            //other的最小结点当中间结点
+            RBTNode* k = other.minNode;
+            RBTNode* rightMax = other.maxNode;
+            other.unlink(k);
+            size_t rightLen = other.len - 1;
+            RBTNode* l = sentinel->left;
+            RBTNode* r = other.sentinel->left;
+            size_t bh;
+            RBTNode* root = joinTrees(l, blackHeight(l), k, r, blackHeight(r), bh);
+            other.sentinel->left = nullptr;
+            other.minNode = other.maxNode = other.sentinel;
+            other.len = 0;
+            other.forgetAll();
+            sentinel->left = root;
+            root->setParent(sentinel);
+            maxNode = rightMax;
+            len += rightLen + 1;
+        }
         /**
          * Returns the number of elements with key
          *   that compares equivalent to the specified argument,
@@ -1279,27 +2538,243 @@ namespace sjtu {
          * The default method of check the equivalence is !(a < b || b > a)
          */
         size_t count(const Key& key) const {
-            RBTNode* node = find(key,sentinel->left);
+            RBTNode* node = findNode(key);
             if (node) return 1;
             return 0;
         }
+        template<class K, class C = Compare, class = typename C::is_transparent>
+        size_t count(const K& key) const {
+            return findNode(key) ? 1 : 0;
+        }
+        /**
+         * whether an element with key equivalent to key exists.
+         */
+        bool contains(const Key& key) const {
+            return findNode(key) != nullptr;
+        }
+        template<class K, class C = Compare, class = typename C::is_transparent>
+        bool contains(const K& key) const {
+            return findNode(key) != nullptr;
+        }
         /**
          * Finds an element with key equivalent to key.
          * key value of the element to search for.
          * Iterator to an element with key equivalent to key.
          *   If no such element is found, past-the-end (see end()) iterator is returned.
+         * with Policy::lookup_cache a found key is remembered, so repeated lookups of a hot
+         *   key skip the tree; the cache is written even through const, so a map read by several
+         *   threads at once needs lookup_cache = 0 or a lock.
          */
 
         iterator find(const Key& key) {
-            RBTNode* node = find(key, sentinel->left);
+            RBTNode* node = findNode(key);
             if (node)return iterator(this, node);
             return end();
         }
         const_iterator find(const Key& key) const {
-            RBTNode* node = find(key, sentinel->left);
+            RBTNode* node = findNode(key);
+            if (node)return const_iterator(this, node);
+            return cend();
+        }
+        template<class K, class C = Compare, class = typename C::is_transparent>
+        iterator find(const K& key) {
+            RBTNode* node = findNode(key);
+            if (node)return iterator(this, node);
+            return end();
+        }
+        template<class K, class C = Compare, class = typename C::is_transparent>
+        const_iterator find(const K& key) const {
+            RBTNode* node = findNode(key);
             if (node)return const_iterator(this, node);
             return cend();
         }
+        /**
+         * looks up every key of [first, last) and writes to out, in the same order,
+         *   an iterator to its element or end(). returns out past the last one written.
+         * up to 16 lookups descend the tree together, one level each in turn, and
+         *   prefetch the next node on their path, so their cache misses overlap
+         *   instead of adding up. It must be a forward iterator: every key is read
+         *   once per level.
+         */
+        template<class It, class Out>
+        Out find_batch(It first, It last, Out out) {
+            lowerBoundBatch(first, last, [&](const auto& key, RBTNode* c) {
+                *out++ = (c != sentinel && !comp()(key, c->data()->first)) ? iterator(this, c) : end();
+            });
+            return out;
+        }
+        template<class It, class Out>
+        Out find_batch(It first, It last, Out out) const {
+            lowerBoundBatch(first, last, [&](const auto& key, RBTNode* c) {
+                *out++ = (c != sentinel && !comp()(key, c->data()->first)) ? const_iterator(this, c) : cend();
+            });
+            return out;
+        }
+        /**
+         * like find_batch, but writes count(key) (0 or 1) for every key.
+         */
+        template<class It, class Out>
+        Out count_batch(It first, It last, Out out) const {
+            lowerBoundBatch(first, last, [&](const auto& key, RBTNode* c) {
+                *out++ = (size_t)(c != sentinel && !comp()(key, c->data()->first));
+            });
+            return out;
+        }
+        /**
+         * returns an iterator to the first element whose key is not less than key,
+         *   or end() if there is none.
+         */
+        iterator lower_bound(const Key& key) {
+            return iterator(this, lowerBound(key));
+        }
+        const_iterator lower_bound(const Key& key) const {
+            return const_iterator(this, lowerBound(key));
+        }
+        template<class K, class C = Compare, class = typename C::is_transparent>
+        iterator lower_bound(const K& key) {
+            return iterator(this, lowerBound(key));
+        }
+        template<class K, class C = Compare, class = typename C::is_transparent>
+        const_iterator lower_bound(const K& key) const {
+            return const_iterator(this, lowerBound(key));
+        }
+        /**
+         * returns an iterator to the first element whose key is greater than key,
+         *   or end() if there is none.
+         */
+        iterator upper_bound(const Key& key) {
+            return iterator(this, upperBound(key));
+        }
+        const_iterator upper_bound(const Key& key) const {
+            return const_iterator(this, upperBound(key));
+        }
+        template<class K, class C = Compare, class = typename C::is_transparent>
+        iterator upper_bound(const K& key) {
+            return iterator(this, upperBound(key));
+        }
+        template<class K, class C = Compare, class = typename C::is_transparent>
+        const_iterator upper_bound(const K& key) const {
+            return const_iterator(this, upperBound(key));
+        }
+        /**
+         * returns [lower_bound(key), upper_bound(key)), which holds at most one element.
+         * only one descent is made: the upper bound is the next node when the key is present.
+         */
+        pair<iterator, iterator> equal_range(const Key& key) {
+            RBTNode* lo = lowerBound(key);
+            RBTNode* hi = (lo != sentinel && !comp()(key, lo->data()->first)) ? nextNode(lo) : lo;
+            return pair<iterator, iterator>(iterator(this, lo), iterator(this, hi));
+        }
+        pair<const_iterator, const_iterator> equal_range(const Key& key) const {
+            RBTNode* lo = lowerBound(key);
+            RBTNode* hi = (lo != sentinel && !comp()(key, lo->data()->first)) ? nextNode(lo) : lo;
+            return pair<const_iterator, const_iterator>(const_iterator(this, lo), const_iterator(this, hi));
+        }
+        template<class K, class C = Compare, class = typename C::is_transparent>
+        pair<iterator, iterator> equal_range(const K& key) {
+            RBTNode* lo = lowerBound(key);
+            RBTNode* hi = (lo != sentinel && !comp()(key, lo->data()->first)) ? nextNode(lo) : lo;
+            return pair<iterator, iterator>(iterator(this, lo), iterator(this, hi));
+        }
+        template<class K, class C = Compare, class = typename C::is_transparent>
+        pair<const_iterator, const_iterator> equal_range(const K& key) const {
+            RBTNode* lo = lowerBound(key);
+            RBTNode* hi = (lo != sentinel && !comp()(key, lo->data()->first)) ? nextNode(lo) : lo;
+            return pair<const_iterator, const_iterator>(const_iterator(this, lo), const_iterator(this, hi));
+        }
+        /**
+         * calls fn(value) for every element whose key lies in [lo, hi), in ascending order.
+         * walks the nodes directly, without iterator objects or their bounds checks.
+         * fn must not insert into or erase from this map.
+         */
+        template<class Fn>
+        void for_each_in_range(const Key& lo, const Key& hi, Fn fn) {
+            for (RBTNode* node = lowerBound(lo); node != sentinel && comp()(node->data()->first, hi); node = nextNode(node))
+                fn(*(node->data()));
+        }
+        template<class Fn>
+        void for_each_in_range(const Key& lo, const Key& hi, Fn fn) const {
+            for (RBTNode* node = lowerBound(lo); node != sentinel && comp()(node->data()->first, hi); node = nextNode(node))
+                fn(static_cast<const value_type&>(*(node->data())));
+        }
+        /**
+         * the following need Policy::order_statistics, all O(log n).
+         *
+         * rank(key) is the number of elements whose key is less than key,
+         *   i.e. the position of lower_bound(key).
+         */
+        size_t rank(const Key& key) const {
+            static_assert(ORDER_STATISTICS, "rank needs a map with order_statistics");
+            size_t k = 0;
+            RBTNode* node = sentinel->left;
+            while (node) {
+                if (comp()(node->data()->first, key)) {
+                    k += subtreeSize(node->left) + 1;
+                    node = node->right;
+                }
+                else node = node->left;
+            }
+            return k;
+        }
+        /**
+         * returns an iterator to the k-th smallest element (counting from 0).
+         * throw index_out_of_bound if k >= size().
+         */
+        iterator select(size_t k) {
+            static_assert(ORDER_STATISTICS, "select needs a map with order_statistics");
+            if (k >= len)throw index_out_of_bound();
+            return iterator(this, selectNode(k));
+        }
+        const_iterator select(size_t k) const {
+            static_assert(ORDER_STATISTICS, "select needs a map with order_statistics");
+            if (k >= len)throw index_out_of_bound();
+            return const_iterator(this, selectNode(k));
+        }
+        /**
+         * like select, but returns end() instead of throwing when k >= size().
+         */
+        iterator nth(size_t k) {
+            static_assert(ORDER_STATISTICS, "nth needs a map with order_statistics");
+            return iterator(this, selectNode(k));
+        }
+        const_iterator nth(size_t k) const {
+            static_assert(ORDER_STATISTICS, "nth needs a map with order_statistics");
+            return const_iterator(this, selectNode(k));
+        }
+        /**
+         * writes the map to path as a flat, pointer-free file that open_mapped() maps
+         *   back in O(1). Key and T must be trivially copyable. needs mapped_map.hpp.
+         */
+        void save(const char* path) const {
+            mapped_map<Key, T, Compare>::save(*this, path);
+        }
+        /**
+         * opens a file written by save() as a read-only mapped_map, without parsing or
+         *   inserting anything; to_map() on it gives a mutable map again. needs mapped_map.hpp.
+         */
+        static mapped_map<Key, T, Compare> open_mapped(const char* path) {
+            return mapped_map<Key, T, Compare>(path);
+        }
+        /**
+         * the counters of a map whose Policy has stats (see map_stats_policy).
+         * the height is measured on each call, in O(n).
+         * cache_hits and cache_misses count the by-key lookups when Policy::lookup_cache is on too.
+         */
+        map_stats stats() const {
+            static_assert(STATS, "stats needs a map with stats");
+            map_stats s = counters;
+            if constexpr (CACHE > 0) {
+                s.cache_hits = cache.hits;
+                s.cache_misses = cache.misses;
+            }
+            s.height = heightOf(sentinel->left);
+            return s;
+        }
+        void reset_stats() {
+            static_assert(STATS, "reset_stats needs a map with stats");
+            counters = map_stats();
+            if constexpr (CACHE > 0) cache.hits = cache.misses = 0;
+        }
     };
 
 }
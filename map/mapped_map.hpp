@@ -0,0 +1,277 @@
+/**
+ * implement a read-only ordered map served straight from a file written by map::save()
+ */
+#ifndef SJTU_MAPPED_MAP_HPP
+#define SJTU_MAPPED_MAP_HPP
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <functional>
+#include <new>
+#include <type_traits>
+#include "utility.hpp"
+#include "exceptions.hpp"
+#include "map.hpp"
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define SJTU_MAPPED_MMAP
+#endif
+
+namespace sjtu {
+
+    /**
+     * the file layout shared by map::save() and mapped_map.
+     *
+     * a 64-byte header, then the elements as an array of pair<const Key, T> in key
+     *   order, byte for byte as they sit in memory. the array has no pointers, so it is
+     *   usable wherever the file is mapped, and a search is a binary search over it.
+     * the header records the sizes and alignment of the element types and the byte
+     *   order; opening a file written for other types or on another machine fails.
+     *   the comparator cannot be checked: it has to be the one the file was saved with.
+     */
+    struct mapped_map_header {
+        char magic[8];
+        uint32_t version;
+        uint32_t byte_order;//按写入机器的字节序存的0x01020304
+        uint32_t key_size;
+        uint32_t mapped_size;
+        uint32_t entry_size;
+        uint32_t entry_align;
+        uint64_t count;
+        uint64_t offset;//第一个元素在文件里的位置
+        unsigned char reserved[16];
+    };
+    static_assert(sizeof(mapped_map_header) == 64, "the header is 64 bytes on disk");
+
+    /**
+     * a read-only view of a map saved with map::save(), opened in O(1).
+     *
+     * the file is mmapped (read into memory where there is no mmap), so opening it
+     *   costs no parsing and no allocation per element: pages are read on first touch.
+     *   lookups are O(log n) binary searches, iterators are plain pointers into the file.
+     * Key and T must be trivially copyable. to_map() copies the contents into a
+     *   mutable map in O(n).
+     */
+    template<class Key, class T, class Compare = std::less<Key>>
+    class mapped_map {
+    public:
+        typedef pair<const Key, T> value_type;
+        typedef const value_type* const_iterator;
+        static_assert(std::is_trivially_copyable<Key>::value && std::is_trivially_copyable<T>::value,
+            "mapped_map needs trivially copyable keys and values");
+    private:
+        static constexpr uint32_t VERSION = 1;
+        static constexpr uint32_t ORDER_MARK = 0x01020304;
+        static constexpr size_t OFFSET = 64;
+        static_assert(alignof(value_type) <= OFFSET, "elements must fit the 64-byte alignment of the file");
+
+        const char* base;
+        size_t bytes;
+        const value_type* first;
+        size_t len;
+
+        static mapped_map_header header_for(size_t n) {
+            mapped_map_header h;
+            std::memset(&h, 0, sizeof(h));
+            std::memcpy(h.magic, "SJTUMAP", 8);
+            h.version = VERSION;
+            h.byte_order = ORDER_MARK;
+            h.key_size = sizeof(Key);
+            h.mapped_size = sizeof(T);
+            h.entry_size = sizeof(value_type);
+            h.entry_align = alignof(value_type);
+            h.count = n;
+            h.offset = OFFSET;
+            return h;
+        }
+        //没有mmap时整个读进来 operator new的对齐对元素够用
+        void load(const char* path) {
+#ifdef SJTU_MAPPED_MMAP
+            int fd = ::open(path, O_RDONLY);
+            if (fd < 0) throw runtime_error();
+            struct stat st;
+            if (fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(mapped_map_header)) {
+                ::close(fd);
+                throw runtime_error();
+            }
+            bytes = (size_t)st.st_size;
+            void* p = mmap(nullptr, bytes, PROT_READ, MAP_PRIVATE, fd, 0);
+            ::close(fd);
+            if (p == MAP_FAILED) throw runtime_error();
+            base = static_cast<const char*>(p);
+#else
+            std::FILE* f = std::fopen(path, "rb");
+            if (!f) throw runtime_error();
+            long n = -1;
+            if (std::fseek(f, 0, SEEK_END) == 0) n = std::ftell(f);
+            if (n < (long)sizeof(mapped_map_header) || std::fseek(f, 0, SEEK_SET) != 0) {
+                std::fclose(f);
+                throw runtime_error();
+            }
+            bytes = (size_t)n;
+            char* buf = static_cast<char*>(::operator new(bytes));
+            bool ok = std::fread(buf, 1, bytes, f) == bytes;
+            std::fclose(f);
+            base = buf;
+            if (!ok) {
+                unload();
+                throw runtime_error();
+            }
+#endif
+        }
+        void unload() {
+            if (!base) return;
+#ifdef SJTU_MAPPED_MMAP
+            munmap(const_cast<char*>(base), bytes);
+#else
+            ::operator delete(const_cast<char*>(base));
+#endif
+            base = nullptr;
+        }
+        //头部和期望的不一致或者文件被截断 都当作打不开
+        bool valid() const {
+            mapped_map_header h;
+            std::memcpy(&h, base, sizeof(h));
+            mapped_map_header want = header_for(h.count);
+            if (std::memcmp(&h, &want, offsetof(mapped_map_header, count)) != 0 || h.offset != OFFSET) return false;
+            return h.count <= (bytes - OFFSET) / sizeof(value_type);
+        }
+        const_iterator lowerBound(const Key& key) const {
+            return std::lower_bound(first, first + len, key,
+                [](const value_type& v, const Key& k) { return Compare()(v.first, k); });
+        }
+
+    public:
+        /**
+         * opens a file written by map::save() with the same Key, T and Compare.
+         * throws runtime_error if it cannot be opened or does not hold such a map.
+         */
+        explicit mapped_map(const char* path) : base(nullptr), bytes(0) {
+            load(path);
+            if (!valid()) {
+                unload();
+                throw runtime_error();
+            }
+            len = (size_t)reinterpret_cast<const mapped_map_header*>(base)->count;
+            first = reinterpret_cast<const value_type*>(base + OFFSET);
+        }
+        mapped_map(const mapped_map&) = delete;
+        mapped_map& operator=(const mapped_map&) = delete;
+        mapped_map(mapped_map&& other) noexcept
+            : base(other.base), bytes(other.bytes), first(other.first), len(other.len) {
+            other.base = nullptr;
+            other.first = nullptr;
+            other.len = 0;
+        }
+        mapped_map& operator=(mapped_map&& other) noexcept {
+            if (&other == this) return *this;
+            unload();
+            base = other.base;
+            bytes = other.bytes;
+            first = other.first;
+            len = other.len;
+            other.base = nullptr;
+            other.first = nullptr;
+            other.len = 0;
+            return *this;
+        }
+        ~mapped_map() {
+            unload();
+        }
+
+        /**
+         * writes m to path in the layout above, replacing the file. O(n), one pass.
+         * throws runtime_error if the file cannot be written; a partial file is removed.
+         */
+        template<class Allocator, class Policy>
+        static void save(const map<Key, T, Compare, Allocator, Policy>& m, const char* path) {
+            std::FILE* f = std::fopen(path, "wb");
+            if (!f) throw runtime_error();
+            mapped_map_header h = header_for(m.size());
+            bool ok = std::fwrite(&h, sizeof(h), 1, f) == 1;
+            //攒满一块再写 块先清零 结构里的填充字节也写成0
+            static constexpr size_t CHUNK = 4096 / sizeof(value_type) + 1;
+            alignas(value_type) unsigned char buf[CHUNK * sizeof(value_type)];
+            size_t n = 0;
+            for (auto it = m.cbegin(); ok && it != m.cend(); ++it) {
+                if (n == 0) std::memset(buf, 0, sizeof(buf));
+                std::memcpy(buf + n * sizeof(value_type), &*it, sizeof(value_type));
+                if (++n == CHUNK) {
+                    ok = std::fwrite(buf, sizeof(value_type), n, f) == n;
+                    n = 0;
+                }
+            }
+            if (ok && n) ok = std::fwrite(buf, sizeof(value_type), n, f) == n;
+            if (std::fclose(f) != 0) ok = false;
+            if (!ok) {
+                std::remove(path);
+                throw runtime_error();
+            }
+        }
+
+        size_t size() const {
+            return len;
+        }
+        bool empty() const {
+            return len == 0;
+        }
+        const_iterator begin() const {
+            return first;
+        }
+        const_iterator end() const {
+            return first + len;
+        }
+        const_iterator cbegin() const {
+            return first;
+        }
+        const_iterator cend() const {
+            return first + len;
+        }
+        /**
+         * the element with key equivalent to key, or end().
+         */
+        const_iterator find(const Key& key) const {
+            const_iterator p = lowerBound(key);
+            if (p != end() && !Compare()(key, p->first)) return p;
+            return end();
+        }
+        size_t count(const Key& key) const {
+            return find(key) != end() ? 1 : 0;
+        }
+        bool contains(const Key& key) const {
+            return find(key) != end();
+        }
+        /**
+         * throws index_out_of_bound if key is absent.
+         */
+        const T& at(const Key& key) const {
+            const_iterator p = find(key);
+            if (p == end()) throw index_out_of_bound();
+            return p->second;
+        }
+        const_iterator lower_bound(const Key& key) const {
+            return lowerBound(key);
+        }
+        const_iterator upper_bound(const Key& key) const {
+            return std::upper_bound(first, first + len, key,
+                [](const Key& k, const value_type& v) { return Compare()(k, v.first); });
+        }
+
+        /**
+         * copies the contents into a mutable map, building the tree in O(n).
+         */
+        template<class Allocator = std::allocator<value_type>, class Policy = default_map_policy>
+        map<Key, T, Compare, Allocator, Policy> to_map() const {
+            return map<Key, T, Compare, Allocator, Policy>(sorted_unique, first, first + len);
+        }
+    };
+
+}
+
+#endif
@@ -0,0 +1,529 @@
+/**
+ * implement an ordered map with O(1) immutable snapshots
+ */
+#ifndef SJTU_PERSISTENT_MAP_HPP
+#define SJTU_PERSISTENT_MAP_HPP
+
+ // only for std::less<T>
+#include <functional>
+#include <atomic>
+#include <cstddef>
+#include <iterator>
+#include <memory>
+#include "utility.hpp"
+#include "exceptions.hpp"
+
+namespace sjtu {
+
+    /**
+     * an ordered map whose snapshot() is O(1): the snapshot shares every node with the map.
+     *
+     * nodes are reference counted. while a node is referenced only by the map, writes change
+     *   it in place; once a snapshot (or a copy of the map) also holds it, the next write
+     *   copies the nodes on its root-to-leaf path instead, plus at most a few siblings for
+     *   rotations. so a write after a snapshot allocates O(log n) nodes and the snapshot
+     *   never changes. copying a persistent_map is O(1) the same way.
+     * the tree is an AVL tree without parent pointers, since a node shared by several
+     *   versions has no single parent; iterators find the next element from the root, so
+     *   ++ and -- are O(log n). for_each visits everything in O(n).
+     *
+     * the counts are atomic: snapshots may be read, copied and destroyed on other threads
+     *   while the map keeps changing. the map itself is not thread safe.
+     * any write invalidates the iterators and references into the map, not into snapshots.
+     */
+    template<
+        class Key,
+        class T,
+        class Compare = std::less<Key>,
+        class Allocator = std::allocator<pair<const Key, T>>
+    > class persistent_map {
+    public:
+        typedef pair<const Key, T> value_type;
+        class const_iterator;
+        class snapshot_type;
+    private:
+        struct Node {
+            std::atomic<size_t> refs;
+            Node* left;
+            Node* right;
+            int height;
+            value_type value;
+
+            template<class... Args>
+            Node(Node* l, Node* r, int h, Args&&... args)
+                : refs(1), left(l), right(r), height(h), value(std::forward<Args>(args)...) {}
+        };
+        typedef typename std::allocator_traits<Allocator>::template rebind_alloc<Node> node_allocator;
+        typedef std::allocator_traits<node_allocator> node_traits;
+
+        template<class... Args>
+        static Node* create(node_allocator& a, Node* l, Node* r, int h, Args&&... args) {
+            Node* n = node_traits::allocate(a, 1);
+            try {
+                node_traits::construct(a, n, l, r, h, std::forward<Args>(args)...);
+            }
+            catch (...) {
+                node_traits::deallocate(a, n, 1);
+                throw;
+            }
+            return n;
+        }
+        static Node* acquire(Node* n) noexcept {
+            if (n) n->refs.fetch_add(1, std::memory_order_relaxed);
+            return n;
+        }
+        //放掉一个引用 没人用了就释放 再放掉它对孩子的引用
+        static void release(node_allocator& a, Node* n) noexcept {
+            while (n && n->refs.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+                release(a, n->left);
+                Node* r = n->right;
+                node_traits::destroy(a, n);
+                node_traits::deallocate(a, n, 1);
+                n = r;
+            }
+        }
+
+        static int height(const Node* n) noexcept {
+            return n ? n->height : 0;
+        }
+        static Node* findNode(Node* n, const Key& key) {
+            while (n) {
+                if (Compare()(key, n->value.first)) n = n->left;
+                else if (Compare()(n->value.first, key)) n = n->right;
+                else return n;
+            }
+            return nullptr;
+        }
+        static Node* lowerBound(Node* n, const Key& key) {
+            Node* res = nullptr;
+            while (n) {
+                if (Compare()(n->value.first, key)) n = n->right;
+                else {
+                    res = n;
+                    n = n->left;
+                }
+            }
+            return res;
+        }
+        static Node* upperBound(Node* n, const Key& key) {
+            Node* res = nullptr;
+            while (n) {
+                if (Compare()(key, n->value.first)) {
+                    res = n;
+                    n = n->left;
+                }
+                else n = n->right;
+            }
+            return res;
+        }
+        static Node* lastNode(Node* n) {
+            if (n) while (n->right) n = n->right;
+            return n;
+        }
+        //没有parent指针 前驱也从根往下找
+        static Node* lessThan(Node* n, const Key& key) {
+            Node* res = nullptr;
+            while (n) {
+                if (Compare()(n->value.first, key)) {
+                    res = n;
+                    n = n->right;
+                }
+                else n = n->left;
+            }
+            return res;
+        }
+        //AVL树高不超过1.44log(n) 96层的栈足够
+        template<class Fn>
+        static void walk(Node* n, Fn& fn) {
+            Node* stack[96];
+            size_t top = 0;
+            while (n || top) {
+                while (n) {
+                    stack[top++] = n;
+                    n = n->left;
+                }
+                n = stack[--top];
+                fn(static_cast<const value_type&>(n->value));
+                n = n->right;
+            }
+        }
+
+    public:
+        /**
+         * a bidirectional iterator over one version of the tree.
+         * it keeps the root of that version to find the neighbours, so each step is O(log n).
+         */
+        class const_iterator {
+            friend class persistent_map;
+        private:
+            Node* root;
+            Node* node;//end()是nullptr
+        public:
+            typedef std::ptrdiff_t difference_type;
+            typedef const typename persistent_map::value_type value_type;
+            typedef value_type* pointer;
+            typedef value_type& reference;
+            typedef std::bidirectional_iterator_tag iterator_category;
+
+            const_iterator() : root(nullptr), node(nullptr) {}
+            const_iterator(Node* _root, Node* _node) : root(_root), node(_node) {}
+
+            const_iterator operator++(int) {
+                const_iterator cur = *this;
+                ++*this;
+                return cur;
+            }
+            const_iterator& operator++() {
+                if (!node) throw invalid_iterator();
+                node = upperBound(root, node->value.first);
+                return *this;
+            }
+            const_iterator operator--(int) {
+                const_iterator cur = *this;
+                --*this;
+                return cur;
+            }
+            const_iterator& operator--() {
+                Node* prev = node ? lessThan(root, node->value.first) : lastNode(root);
+                if (!prev) throw invalid_iterator();
+                node = prev;
+                return *this;
+            }
+            const value_type& operator*() const {
+                if (!node) throw invalid_iterator();
+                return node->value;
+            }
+            const value_type* operator->() const noexcept {
+                return &node->value;
+            }
+            bool operator==(const const_iterator& rhs) const {
+                return root == rhs.root && node == rhs.node;
+            }
+            bool operator!=(const const_iterator& rhs) const {
+                return !(*this == rhs);
+            }
+        };
+
+        /**
+         * an immutable view of the map at the moment snapshot() was called.
+         * copying one is O(1); it stays valid after the map changes or is destroyed.
+         */
+        class snapshot_type {
+            friend class persistent_map;
+        private:
+            node_allocator alloc;
+            Node* root;
+            size_t len;
+
+            snapshot_type(const node_allocator& a, Node* r, size_t n) : alloc(a), root(acquire(r)), len(n) {}
+        public:
+            snapshot_type() : root(nullptr), len(0) {}
+            snapshot_type(const snapshot_type& other) : alloc(other.alloc), root(acquire(other.root)), len(other.len) {}
+            snapshot_type(snapshot_type&& other) noexcept : alloc(other.alloc), root(other.root), len(other.len) {
+                other.root = nullptr;
+                other.len = 0;
+            }
+            snapshot_type& operator=(snapshot_type other) noexcept {
+                std::swap(alloc, other.alloc);
+                std::swap(root, other.root);
+                std::swap(len, other.len);
+                return *this;
+            }
+            ~snapshot_type() {
+                release(alloc, root);
+            }
+
+            size_t size() const { return len; }
+            bool empty() const { return len == 0; }
+            size_t count(const Key& key) const {
+                return findNode(root, key) ? 1 : 0;
+            }
+            /**
+             * throw index_out_of_bound if such key does not exist.
+             */
+            const T& at(const Key& key) const {
+                Node* n = findNode(root, key);
+                if (!n) throw index_out_of_bound();
+                return n->value.second;
+            }
+            const T& operator[](const Key& key) const {
+                return at(key);
+            }
+            const_iterator find(const Key& key) const {
+                return const_iterator(root, findNode(root, key));
+            }
+            const_iterator lower_bound(const Key& key) const {
+                return const_iterator(root, lowerBound(root, key));
+            }
+            const_iterator upper_bound(const Key& key) const {
+                return const_iterator(root, upperBound(root, key));
+            }
+            const_iterator cbegin() const {
+                Node* n = root;
+                if (n) while (n->left) n = n->left;
+                return const_iterator(root, n);
+            }
+            const_iterator cend() const {
+                return const_iterator(root, nullptr);
+            }
+            /**
+             * calls fn(const value_type&) for every element in ascending order, in O(n).
+             */
+            template<class Fn>
+            void for_each(Fn fn) const {
+                walk(root, fn);
+            }
+        };
+
+    private:
+        node_allocator alloc;
+        Node* root;
+        size_t len;
+
+        //要改slot指向的结点 先保证它只被这里引用 被快照共享着就复制一份
+        Node* own(Node*& slot) {
+            Node* n = slot;
+            if (n->refs.load(std::memory_order_acquire) == 1) return n;
+            Node* c = create(alloc, n->left, n->right, n->height, n->value);
+            acquire(c->left);
+            acquire(c->right);
+            slot = c;
+            release(alloc, n);
+            return c;
+        }
+        static void updateHeight(Node* n) noexcept {
+            int hl = height(n->left), hr = height(n->right);
+            n->height = 1 + (hl > hr ? hl : hr);
+        }
+        //slot和它的左孩子都已经归这里所有
+        static void rotateRight(Node*& slot) noexcept {
+            Node* n = slot;
+            Node* l = n->left;
+            n->left = l->right;
+            l->right = n;
+            updateHeight(n);
+            updateHeight(l);
+            slot = l;
+        }
+        static void rotateLeft(Node*& slot) noexcept {
+            Node* n = slot;
+            Node* r = n->right;
+            n->right = r->left;
+            r->left = n;
+            updateHeight(n);
+            updateHeight(r);
+            slot = r;
+        }
+        //slot已经归这里所有 子树改完之后重新平衡
+        //要转动的孩子不在刚才走过的路上时(只有删除会这样) 先把它复制过来
+        void rebalance(Node*& slot) {
+            Node* n = slot;
+            int hl = height(n->left), hr = height(n->right);
+            if (hl > hr + 1) {
+                Node* l = own(n->left);
+                if (height(l->left) < height(l->right)) {
+                    own(l->right);
+                    rotateLeft(n->left);
+                }
+                rotateRight(slot);
+            }
+            else if (hr > hl + 1) {
+                Node* r = own(n->right);
+                if (height(r->right) < height(r->left)) {
+                    own(r->left);
+                    rotateRight(n->right);
+                }
+                rotateLeft(slot);
+            }
+            else updateHeight(n);
+        }
+        //只在key不存在时调用 返回新结点
+        template<class... Args>
+        Node* insert(Node*& slot, const Key& key, Args&&... args) {
+            if (!slot) {
+                slot = create(alloc, nullptr, nullptr, 1, std::forward<Args>(args)...);
+                return slot;
+            }
+            Node* n = own(slot);
+            Node* res = Compare()(key, n->value.first) ? insert(n->left, key, std::forward<Args>(args)...)
+                : insert(n->right, key, std::forward<Args>(args)...);
+            rebalance(slot);
+            return res;
+        }
+        //只在key存在时调用 把根到它的路径都变成自己的 返回它
+        Node* ownPath(Node*& slot, const Key& key) {
+            Node* n = own(slot);
+            if (Compare()(key, n->value.first)) return ownPath(n->left, key);
+            if (Compare()(n->value.first, key)) return ownPath(n->right, key);
+            return n;
+        }
+        //摘下最小的结点 它的孩子指针清空后返回
+        Node* removeMin(Node*& slot) {
+            Node* n = own(slot);
+            if (!n->left) {
+                slot = n->right;
+                n->right = nullptr;
+                return n;
+            }
+            Node* m = removeMin(n->left);
+            rebalance(slot);
+            return m;
+        }
+        //只在key存在时调用
+        void remove(Node*& slot, const Key& key) {
+            Node* n = own(slot);
+            if (Compare()(key, n->value.first)) remove(n->left, key);
+            else if (Compare()(n->value.first, key)) remove(n->right, key);
+            else {
+                if (!n->left || !n->right) slot = n->left ? n->left : n->right;
+                else {
+                    Node* m = removeMin(n->right);
+                    m->left = n->left;
+                    m->right = n->right;
+                    slot = m;
+                }
+                n->left = n->right = nullptr;
+                release(alloc, n);
+                len--;
+                if (!slot) return;
+            }
+            rebalance(slot);
+        }
+
+    public:
+        persistent_map() : root(nullptr), len(0) {}
+        /**
+         * O(1): both maps share the nodes until one of them writes.
+         */
+        persistent_map(const persistent_map& other) : alloc(other.alloc), root(acquire(other.root)), len(other.len) {}
+        persistent_map(persistent_map&& other) noexcept : alloc(other.alloc), root(other.root), len(other.len) {
+            other.root = nullptr;
+            other.len = 0;
+        }
+        /**
+         * makes the map equal to snapshot s again, in O(1).
+         */
+        explicit persistent_map(const snapshot_type& s) : alloc(s.alloc), root(acquire(s.root)), len(s.len) {}
+        persistent_map& operator=(persistent_map other) noexcept {
+            swap(other);
+            return *this;
+        }
+        void swap(persistent_map& other) noexcept {
+            std::swap(alloc, other.alloc);
+            std::swap(root, other.root);
+            std::swap(len, other.len);
+        }
+        ~persistent_map() {
+            release(alloc, root);
+        }
+
+        /**
+         * returns an immutable view of the current contents in O(1).
+         */
+        snapshot_type snapshot() const {
+            return snapshot_type(alloc, root, len);
+        }
+
+        size_t size() const { return len; }
+        bool empty() const { return len == 0; }
+        size_t count(const Key& key) const {
+            return findNode(root, key) ? 1 : 0;
+        }
+        /**
+         * access specified element with bounds checking.
+         * throw index_out_of_bound if such key does not exist.
+         * the non-const version first copies the path to the element if a snapshot shares it.
+         */
+        T& at(const Key& key) {
+            if (!findNode(root, key)) throw index_out_of_bound();
+            return ownPath(root, key)->value.second;
+        }
+        const T& at(const Key& key) const {
+            Node* n = findNode(root, key);
+            if (!n) throw index_out_of_bound();
+            return n->value.second;
+        }
+        T& operator[](const Key& key) {
+            return try_emplace(key).first->second;
+        }
+        const T& operator[](const Key& key) const {
+            return at(key);
+        }
+        const_iterator find(const Key& key) const {
+            return const_iterator(root, findNode(root, key));
+        }
+        const_iterator lower_bound(const Key& key) const {
+            return const_iterator(root, lowerBound(root, key));
+        }
+        const_iterator upper_bound(const Key& key) const {
+            return const_iterator(root, upperBound(root, key));
+        }
+        const_iterator cbegin() const {
+            Node* n = root;
+            if (n) while (n->left) n = n->left;
+            return const_iterator(root, n);
+        }
+        const_iterator cend() const {
+            return const_iterator(root, nullptr);
+        }
+        template<class Fn>
+        void for_each(Fn fn) const {
+            walk(root, fn);
+        }
+
+        /**
+         * insert an element.
+         * return a pair, the first of the pair is
+         *   a pointer to the new element (or the element that prevented the insertion),
+         *   the second one is true if insert successfully, or false.
+         * pointers and references stay valid until the next write to the map.
+         */
+        pair<value_type*, bool> insert(const value_type& value) {
+            return try_insert(value.first, value);
+        }
+        pair<value_type*, bool> insert(value_type&& value) {
+            return try_insert(value.first, std::move(value));
+        }
+        template<class... Args>
+        pair<value_type*, bool> try_emplace(const Key& key, Args&&... args) {
+            return try_insert(key, std::piecewise_construct,
+                std::forward_as_tuple(key), std::forward_as_tuple(std::forward<Args>(args)...));
+        }
+        template<class M>
+        pair<value_type*, bool> insert_or_assign(const Key& key, M&& obj) {
+            pair<value_type*, bool> p = try_emplace(key, std::forward<M>(obj));
+            if (!p.second) p.first->second = std::forward<M>(obj);
+            return p;
+        }
+        /**
+         * removes the element with key equivalent to key, if any.
+         * returns the number of elements removed (0 or 1).
+         */
+        size_t erase(const Key& key) {
+            if (!findNode(root, key)) return 0;
+            remove(root, key);
+            return 1;
+        }
+        /**
+         * O(1) plus freeing the nodes no snapshot holds.
+         */
+        void clear() {
+            release(alloc, root);
+            root = nullptr;
+            len = 0;
+        }
+
+    private:
+        //key已经在的话不复制任何结点 返回它时也要先把路径变成自己的 调用方可能要改它
+        template<class... Args>
+        pair<value_type*, bool> try_insert(const Key& key, Args&&... args) {
+            if (findNode(root, key)) return pair<value_type*, bool>(&ownPath(root, key)->value, false);
+            Node* n = insert(root, key, std::forward<Args>(args)...);
+            len++;
+            return pair<value_type*, bool>(&n->value, true);
+        }
+    };
+
+}
+
+#endif